@@ -0,0 +1,57 @@
+/**
+ * @file bench.h
+ * @brief 基准测试程序共用的辅助函数
+ *
+ * 基准测试程序只链接数据模块，不依赖GTK。每个程序在一个带有data/子目录的空目录中运行
+ * （由Makefile的bench目标准备），自行生成数据，把结果打印到标准输出。
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/resource.h>
+
+/**
+ * @brief 检查条件，不成立时输出位置并以失败退出
+ */
+#define BENCH_CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+/**
+ * @brief 取单调时钟的当前时间
+ * @return 秒数
+ */
+static inline double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief 取进程的内存峰值
+ * @return MB
+ */
+static inline long bench_peak_rss_mb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;
+}
+
+/**
+ * @brief 线性同余伪随机数，各程序每次运行生成相同的数据
+ * @param state 状态
+ * @return 31位随机数
+ */
+static inline unsigned int bench_rand(unsigned int *state) {
+    *state = *state * 1103515245u + 12345u;
+    return (*state >> 1) & 0x7FFFFFFFu;
+}
+
+#endif /* BENCH_H */
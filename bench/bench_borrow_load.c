@@ -0,0 +1,86 @@
+/**
+ * @file bench_borrow_load.c
+ * @brief 借阅数据并行加载的基准测试
+ *
+ * 生成指定条数（默认200万条）的borrows.csv，分别用1、2、4、8个线程从CSV加载
+ * （每次都删除快照），输出加载用时和相对单线程的加速比。加速比受CPU核心数限制，
+ * 线程数超过核心数时不会再变快；单核机器上只能看到多线程的额外开销。
+ *
+ * 用法：bench_borrow_load [记录条数]
+ */
+
+#include "bench.h"
+#include "../borrow.h"
+#include <unistd.h>
+
+#define BENCH_DEFAULT_ROWS 2000000L
+#define BENCH_ROUNDS 3
+
+/**
+ * @brief 生成借阅数据文件
+ * @param rows 记录条数
+ */
+static void bench_write_csv(long rows) {
+    FILE *file = fopen("data/borrows.csv", "w");
+    BENCH_CHECK(file != NULL);
+    
+    fprintf(file, "id,book_id,reader_id,borrow_date,due_date,return_date,status,renew_count\n");
+    for (long i = 0; i < rows; i++) {
+        fprintf(file, "BR%08ld,B%06ld,R%06ld,%ld,%ld,%ld,%d,%ld\n", i, i * 7919 % 200000, i * 104729 % 50000,
+                1700000000L + i, 1702592000L + i, i % 3 ? 0L : 1700086400L + i, i % 3 ? 0 : 1, i % 3);
+    }
+    
+    BENCH_CHECK(fclose(file) == 0);
+}
+
+/**
+ * @brief 用指定线程数从CSV加载，取几轮中的最短用时
+ * @param threads 线程数
+ * @param rows 记录条数
+ * @return 秒数
+ */
+static double bench_load(int threads, long rows) {
+    double best = 0;
+    
+    borrow_set_load_threads(threads);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        unlink("data/borrows.snap");
+        double start = bench_now();
+        BENCH_CHECK(borrow_init() == 0);
+        double elapsed = bench_now() - start;
+        
+        // 最后一条记录必须已加载
+        char id[32];
+        BorrowRecord record;
+        snprintf(id, sizeof(id), "BR%08ld", rows - 1);
+        BENCH_CHECK(borrow_find_by_id(id, &record) == 0);
+        borrow_cleanup();
+        
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    long rows = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_ROWS;
+    BENCH_CHECK(rows > 0);
+    
+    bench_write_csv(rows);
+    printf("borrows.csv: %ld rows, %ld CPUs, best of %d (snapshot removed before each load)\n",
+           rows, sysconf(_SC_NPROCESSORS_ONLN), BENCH_ROUNDS);
+    
+    double single = 0;
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        double elapsed = bench_load(threads, rows);
+        if (threads == 1) {
+            single = elapsed;
+        }
+        printf("%d thread%s  %7.0f ms  %5.2fM rows/s  speedup %.2fx\n", threads, threads > 1 ? "s" : " ",
+               elapsed * 1e3, rows / elapsed / 1e6, single / elapsed);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,253 @@
+/**
+ * @file bench_csv_load.c
+ * @brief CSV解析速度的基准测试
+ *
+ * 生成指定行数（默认100万行）的books.csv，比较每秒解析的行数：
+ * 原来的fgets + parse_csv_line（每个字段malloc一次，这里补上了原调用方缺少的free），
+ * 与原地解析的csv_read_record在逐字节、SSE2、AVX2三种扫描方式下的表现。
+ * 两者都把字段填进同一个Book结构体，与加载函数的工作量相同。
+ *
+ * 用法：bench_csv_load [行数]
+ */
+
+#include "bench.h"
+#include "../book.h"
+#include "../csv.h"
+#include <string.h>
+
+#define BENCH_FILE "data/books.csv"
+#define BENCH_DEFAULT_ROWS 1000000
+#define BENCH_LINE_SIZE 1024
+#define BENCH_ROUNDS 3
+
+/**
+ * @brief 原来utils.c中的parse_csv_line（已从代码中删除，保留在这里作为对照）
+ * @param line CSV行
+ * @param fields 用于存储字段的数组
+ * @param max_fields 最大字段数
+ * @return 返回解析的字段数
+ */
+static int bench_old_parse_csv_line(const char *line, char **fields, int max_fields) {
+    if (line == NULL || fields == NULL || max_fields <= 0) {
+        return 0;
+    }
+    
+    int field_count = 0;
+    const char *p = line;
+    const char *field_start = p;
+    int in_quotes = 0;
+    
+    // 为每个字段分配内存
+    for (int i = 0; i < max_fields; i++) {
+        fields[i] = (char *)malloc(strlen(line) + 1);
+        if (fields[i] == NULL) {
+            for (int j = 0; j < i; j++) {
+                free(fields[j]);
+                fields[j] = NULL;
+            }
+            return 0;
+        }
+        fields[i][0] = '\0';
+    }
+    
+    while (*p && field_count < max_fields) {
+        if (*p == '"') {
+            in_quotes = !in_quotes;
+        } else if (*p == ',' && !in_quotes) {
+            int len = (int)(p - field_start);
+            memcpy(fields[field_count], field_start, (size_t)len);
+            fields[field_count][len] = '\0';
+            
+            // 去除引号
+            if (fields[field_count][0] == '"' && fields[field_count][len - 1] == '"') {
+                memmove(fields[field_count], fields[field_count] + 1, (size_t)len - 2);
+                fields[field_count][len - 2] = '\0';
+            }
+            
+            field_count++;
+            field_start = p + 1;
+        }
+        
+        p++;
+    }
+    
+    // 处理最后一个字段
+    if (field_count < max_fields) {
+        int len = (int)(p - field_start);
+        memcpy(fields[field_count], field_start, (size_t)len);
+        fields[field_count][len] = '\0';
+        
+        if (len >= 2 && fields[field_count][0] == '"' && fields[field_count][len - 1] == '"') {
+            memmove(fields[field_count], fields[field_count] + 1, (size_t)len - 2);
+            fields[field_count][len - 2] = '\0';
+        }
+        
+        field_count++;
+    }
+    
+    return field_count;
+}
+
+/**
+ * @brief 生成图书数据文件（约1%的标题带引号和逗号）
+ * @param rows 行数
+ * @return 文件字节数
+ */
+static long bench_write_csv(int rows) {
+    FILE *file = fopen(BENCH_FILE, "w");
+    BENCH_CHECK(file != NULL);
+    
+    fprintf(file, "id,title,author,publisher,isbn,publish_year,total_count,available_count\n");
+    for (int i = 0; i < rows; i++) {
+        if (i % 100 == 0) {
+            fprintf(file, "B%08d,\"Collected Works, Volume %d\",作者%d,出版社%d,978%010d,%d,5,3\n",
+                    i, i, i % 5000, i % 300, i, 1950 + i % 70);
+        } else {
+            fprintf(file, "B%08d,数据结构与算法 Some Book Title Number %d,作者%d,出版社%d,978%010d,%d,5,3\n",
+                    i, i, i % 5000, i % 300, i, 1950 + i % 70);
+        }
+    }
+    
+    long size = ftell(file);
+    BENCH_CHECK(fclose(file) == 0);
+    return size;
+}
+
+/**
+ * @brief 用原来的fgets + parse_csv_line解析一遍
+ * @return 解析的行数
+ */
+static int bench_old_load(void) {
+    FILE *file = fopen(BENCH_FILE, "r");
+    BENCH_CHECK(file != NULL);
+    
+    static Book book;
+    char line[BENCH_LINE_SIZE];
+    char *fields[8];
+    int rows = 0;
+    
+    BENCH_CHECK(fgets(line, sizeof(line), file) != NULL);
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        int count = bench_old_parse_csv_line(line, fields, 8);
+        if (count == 8) {
+            strncpy(book.id, fields[0], sizeof(book.id) - 1);
+            strncpy(book.title, fields[1], sizeof(book.title) - 1);
+            strncpy(book.author, fields[2], sizeof(book.author) - 1);
+            strncpy(book.publisher, fields[3], sizeof(book.publisher) - 1);
+            strncpy(book.isbn, fields[4], sizeof(book.isbn) - 1);
+            book.publish_year = atoi(fields[5]);
+            book.total_count = atoi(fields[6]);
+            book.available_count = atoi(fields[7]);
+            rows++;
+        }
+        for (int i = 0; i < count; i++) {
+            free(fields[i]);
+        }
+    }
+    
+    fclose(file);
+    return rows;
+}
+
+/**
+ * @brief 用csv_read_record解析一遍
+ * @param mode 扫描方式
+ * @return 解析的行数，当前CPU不支持该扫描方式返回-1
+ */
+static int bench_new_load(CsvScanMode mode) {
+    CsvFile file;
+    BENCH_CHECK(csv_file_open(BENCH_FILE, &file) == 0);
+    
+    CsvReader reader;
+    csv_reader_init(&reader, file.data, file.len);
+    if (csv_reader_set_scan_mode(&reader, mode) != 0) {
+        csv_file_close(&file);
+        return -1;
+    }
+    
+    static Book book;
+    CsvField fields[8];
+    int rows = 0;
+    
+    csv_read_record(&reader, fields, 8);
+    while (csv_read_record(&reader, fields, 8) == 8) {
+        csv_field_copy(&fields[0], book.id, sizeof(book.id));
+        csv_field_copy(&fields[1], book.title, sizeof(book.title));
+        csv_field_copy(&fields[2], book.author, sizeof(book.author));
+        csv_field_copy(&fields[3], book.publisher, sizeof(book.publisher));
+        csv_field_copy(&fields[4], book.isbn, sizeof(book.isbn));
+        book.publish_year = (int)csv_field_to_long(&fields[5]);
+        book.total_count = (int)csv_field_to_long(&fields[6]);
+        book.available_count = (int)csv_field_to_long(&fields[7]);
+        rows++;
+    }
+    
+    csv_file_close(&file);
+    return rows;
+}
+
+/**
+ * @brief 输出一种解析方式的最好成绩
+ * @param name 解析方式
+ * @param rows 行数
+ * @param bytes 文件字节数
+ * @param seconds 最短用时
+ */
+static void bench_report(const char *name, int rows, long bytes, double seconds) {
+    printf("%-28s %8.3f s  %6.2fM rows/s  %7.0f MB/s\n",
+           name, seconds, rows / seconds / 1e6, bytes / seconds / 1e6);
+}
+
+int main(int argc, char *argv[]) {
+    int rows = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_ROWS;
+    BENCH_CHECK(rows > 0);
+    
+    long bytes = bench_write_csv(rows);
+    printf("books.csv: %d rows, %.1f MB, best of %d\n", rows, bytes / 1e6, BENCH_ROUNDS);
+    
+    double best = 0;
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        double start = bench_now();
+        BENCH_CHECK(bench_old_load() == rows);
+        double elapsed = bench_now() - start;
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    bench_report("fgets + parse_csv_line", rows, bytes, best);
+    
+    static const struct {
+        CsvScanMode mode;
+        const char *name;
+    } modes[] = {
+        {CSV_SCAN_SCALAR, "csv_read_record (scalar)"},
+        {CSV_SCAN_SSE2, "csv_read_record (SSE2)"},
+        {CSV_SCAN_AVX2, "csv_read_record (AVX2)"},
+    };
+    
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        int supported = 1;
+        for (int r = 0; r < BENCH_ROUNDS && supported; r++) {
+            double start = bench_now();
+            int parsed = bench_new_load(modes[m].mode);
+            double elapsed = bench_now() - start;
+            if (parsed < 0) {
+                supported = 0;
+                break;
+            }
+            BENCH_CHECK(parsed == rows);
+            if (r == 0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+        
+        if (supported) {
+            bench_report(modes[m].name, rows, bytes, best);
+        } else {
+            printf("%-28s not supported on this CPU\n", modes[m].name);
+        }
+    }
+    
+    return 0;
+}
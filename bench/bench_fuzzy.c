@@ -0,0 +1,296 @@
+/**
+ * @file bench_fuzzy.c
+ * @brief 容错查找的基准测试
+ *
+ * 生成指定数量（默认100万本）的图书：标题由按Zipf分布抽取的西文词和中文词组成，
+ * 作者从8000个姓名中抽取。加载后用500个带拼写错误的1到3词查询调用book_find_fuzzy，
+ * 输出平均和最长用时（目标是每次查询不超过20毫秒），
+ * 并给出逐本计算编辑距离的朴素做法作为对照。
+ *
+ * 用法：bench_fuzzy [图书数量]
+ */
+
+#include "bench.h"
+#include "../book.h"
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_DEFAULT_BOOKS 1000000
+#define BENCH_VOCABULARY 60000
+#define BENCH_NAMES 8000
+#define BENCH_WORD_SIZE 24
+#define BENCH_QUERIES 500
+#define BENCH_RESULTS 20
+#define BENCH_TARGET_MS 20.0
+
+static char bench_vocabulary[BENCH_VOCABULARY][BENCH_WORD_SIZE];
+static char bench_names[BENCH_NAMES][BENCH_WORD_SIZE];
+static double bench_cdf[BENCH_VOCABULARY];
+static unsigned int bench_seed = 7;
+
+/**
+ * @brief 按Zipf分布抽取一个词
+ * @return 词在词表中的位置
+ */
+static int bench_zipf(void) {
+    double u = (bench_rand(&bench_seed) % 1000000) / 1e6;
+    int lo = 0;
+    int hi = BENCH_VOCABULARY - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (bench_cdf[mid] < u) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief 生成一个西文词（1到4个音节）
+ * @param word 用于存储词
+ */
+static void bench_make_word(char *word) {
+    static const char *const syllables[] = {
+        "ka", "lo", "ri", "an", "te", "mon", "ser", "pro", "gra", "ming", "da", "ta", "al", "go",
+        "rith", "sys", "tem", "net", "work", "the", "of", "and", "in", "de", "sign", "struc",
+        "ture", "lin", "ux", "pat", "tern", "code", "com", "pi", "ler"
+    };
+    const unsigned int count = (unsigned int)(sizeof(syllables) / sizeof(syllables[0]));
+    
+    word[0] = '\0';
+    int parts = 1 + (int)(bench_rand(&bench_seed) % 4);
+    for (int i = 0; i < parts; i++) {
+        strcat(word, syllables[bench_rand(&bench_seed) % count]);
+    }
+}
+
+/**
+ * @brief 生成一个中文词（2到4个汉字）
+ * @param word 用于存储词
+ */
+static void bench_make_han(char *word) {
+    static const char han[] = "数据结构算法程序设计网络系统编译原理操作计算机科学技术人工智能"
+                              "学习深度分布式存储引擎语言基础应用开发实践导论高级教程方法理论模型工程管理";
+    const unsigned int count = (unsigned int)(sizeof(han) - 1) / 3;
+    
+    word[0] = '\0';
+    int parts = 2 + (int)(bench_rand(&bench_seed) % 3);
+    for (int i = 0; i < parts; i++) {
+        strncat(word, han + 3 * (bench_rand(&bench_seed) % count), 3);
+    }
+}
+
+/**
+ * @brief 生成词表、姓名表和图书数据文件
+ * @param books 图书数量
+ */
+static void bench_write_csv(int books) {
+    for (int i = 0; i < BENCH_VOCABULARY; i++) {
+        if (i % 5 == 4) {
+            bench_make_han(bench_vocabulary[i]);
+        } else {
+            bench_make_word(bench_vocabulary[i]);
+        }
+    }
+    for (int i = 0; i < BENCH_NAMES; i++) {
+        bench_make_word(bench_names[i]);
+        bench_names[i][0] = (char)(bench_names[i][0] - 'a' + 'A');
+    }
+    
+    double total = 0;
+    for (int i = 0; i < BENCH_VOCABULARY; i++) {
+        total += 1.0 / (i + 1);
+        bench_cdf[i] = total;
+    }
+    for (int i = 0; i < BENCH_VOCABULARY; i++) {
+        bench_cdf[i] /= total;
+    }
+    
+    FILE *file = fopen("data/books.csv", "w");
+    BENCH_CHECK(file != NULL);
+    fprintf(file, "id,title,author,publisher,isbn,publish_year,total_count,available_count\n");
+    
+    for (int i = 0; i < books; i++) {
+        char title[160] = "";
+        int words = 2 + (int)(bench_rand(&bench_seed) % 5);
+        for (int j = 0; j < words; j++) {
+            if (j > 0) {
+                strcat(title, " ");
+            }
+            strcat(title, bench_vocabulary[bench_zipf()]);
+        }
+        fprintf(file, "B%08d,%s,%s %s,出版社%d,978%010d,%d,3,3\n", i, title,
+                bench_names[bench_rand(&bench_seed) % BENCH_NAMES],
+                bench_names[bench_rand(&bench_seed) % BENCH_NAMES], i % 300, i, 1950 + i % 70);
+    }
+    
+    BENCH_CHECK(fclose(file) == 0);
+    unlink("data/books.snap");
+}
+
+/**
+ * @brief 给西文词制造一处拼写错误（替换、删除或插入一个字母）
+ * @param word 词
+ */
+static void bench_typo(char *word) {
+    int len = (int)strlen(word);
+    if (len <= 4 || (unsigned char)word[0] >= 0x80) {
+        return;
+    }
+    
+    int pos = 1 + (int)(bench_rand(&bench_seed) % (unsigned int)(len - 2));
+    switch (bench_rand(&bench_seed) % 3) {
+        case 0:
+            word[pos] = 'x';
+            break;
+        case 1:
+            memmove(word + pos, word + pos + 1, (size_t)(len - pos));
+            break;
+        default:
+            memmove(word + pos + 1, word + pos, (size_t)(len - pos + 1));
+            word[pos] = 'q';
+            break;
+    }
+}
+
+/**
+ * @brief 两个词的编辑距离（按字节，朴素对照用）
+ * @param a 词
+ * @param a_len 长度
+ * @param b 词
+ * @param b_len 长度
+ * @return 编辑距离
+ */
+static int bench_levenshtein(const char *a, int a_len, const char *b, int b_len) {
+    int row[64];
+    for (int j = 0; j <= b_len; j++) {
+        row[j] = j;
+    }
+    for (int i = 1; i <= a_len; i++) {
+        int diagonal = row[0];
+        row[0] = i;
+        for (int j = 1; j <= b_len; j++) {
+            int up = row[j];
+            int best = diagonal + (a[i - 1] != b[j - 1]);
+            if (up + 1 < best) {
+                best = up + 1;
+            }
+            if (row[j - 1] + 1 < best) {
+                best = row[j - 1] + 1;
+            }
+            row[j] = best;
+            diagonal = up;
+        }
+    }
+    return row[b_len];
+}
+
+/**
+ * @brief 朴素做法：逐本图书逐词计算编辑距离（book_foreach的回调函数）
+ * @param book 图书
+ * @param user_data 找到的图书数
+ * @return 总是返回0
+ */
+static int bench_naive_visit(const Book *book, void *user_data) {
+    static const char query[] = "progamming";
+    const char *p = book->title;
+    
+    while (*p != '\0') {
+        while (*p == ' ') {
+            p++;
+        }
+        const char *end = p;
+        while (*end != '\0' && *end != ' ') {
+            end++;
+        }
+        int len = (int)(end - p);
+        if (len > 0 && len < 63 && bench_levenshtein(query, (int)sizeof(query) - 1, p, len) <= 2) {
+            (*(long *)user_data)++;
+            break;
+        }
+        p = end;
+    }
+    
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int books = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_BOOKS;
+    BENCH_CHECK(books > 0);
+    
+    bench_write_csv(books);
+    double start = bench_now();
+    BENCH_CHECK(book_init() == 0);
+    printf("%d books loaded in %.2f s (all indexes), peak RSS %ld MB\n",
+           books, bench_now() - start, bench_peak_rss_mb());
+    
+    static BookFuzzyMatch matches[BENCH_RESULTS];
+    double total[3] = {0, 0, 0};
+    double longest[3] = {0, 0, 0};
+    int counts[3] = {0, 0, 0};
+    long results = 0;
+    
+    for (int q = 0; q < BENCH_QUERIES; q++) {
+        // 1到3个词，其中部分是常见词、部分是作者姓名，西文词都带一处拼写错误
+        int kind = q % 3;
+        char query[200] = "";
+        for (int i = 0; i <= kind; i++) {
+            char word[64];
+            if (i == kind && q % 2) {
+                strcpy(word, bench_names[bench_rand(&bench_seed) % BENCH_NAMES]);
+            } else {
+                unsigned int range = q % 4 == 0 ? 100 : BENCH_VOCABULARY;
+                strcpy(word, bench_vocabulary[bench_rand(&bench_seed) % range]);
+            }
+            bench_typo(word);
+            strcat(query, word);
+            strcat(query, " ");
+        }
+        
+        start = bench_now();
+        int found = book_find_fuzzy(query, matches, BENCH_RESULTS);
+        double elapsed = (bench_now() - start) * 1e3;
+        BENCH_CHECK(found >= 0);
+        
+        results += found;
+        total[kind] += elapsed;
+        counts[kind]++;
+        if (elapsed > longest[kind]) {
+            longest[kind] = elapsed;
+        }
+    }
+    
+    double all_total = total[0] + total[1] + total[2];
+    double all_longest = longest[0];
+    for (int k = 1; k < 3; k++) {
+        if (longest[k] > all_longest) {
+            all_longest = longest[k];
+        }
+    }
+    printf("%d typo'd queries: avg %.2f ms, max %.2f ms, avg %.1f results\n",
+           BENCH_QUERIES, all_total / BENCH_QUERIES, all_longest, (double)results / BENCH_QUERIES);
+    for (int k = 0; k < 3; k++) {
+        printf("  %d-word queries: avg %.2f ms, max %.2f ms\n", k + 1, total[k] / counts[k], longest[k]);
+    }
+    
+    start = bench_now();
+    int found = book_find_fuzzy(bench_vocabulary[0], matches, BENCH_RESULTS);
+    printf("most frequent word \"%s\": %d results in %.2f ms\n",
+           bench_vocabulary[0], found, (bench_now() - start) * 1e3);
+    
+    start = bench_now();
+    found = book_find_fuzzy("xyzzyq", matches, BENCH_RESULTS);
+    printf("no match: %d results in %.2f ms\n", found, (bench_now() - start) * 1e3);
+    
+    long naive = 0;
+    start = bench_now();
+    book_foreach(NULL, 0, 0, bench_naive_visit, &naive);
+    printf("naive per-book Levenshtein scan for \"progamming\": %ld books in %.0f ms\n",
+           naive, (bench_now() - start) * 1e3);
+    
+    printf("target %.0f ms per query: %s\n", BENCH_TARGET_MS, all_longest <= BENCH_TARGET_MS ? "met" : "MISSED");
+    book_cleanup();
+    return 0;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file bench_memory.c
+ * @brief 作者、出版社字符串池的内存对比
+ *
+ * 生成指定数量（默认30万本）的图书，作者取自3000个姓名、出版社取自2000个名称，
+ * 加载后用book_memory_usage输出按定长数组逐本存放（改用字符串池之前）
+ * 与各图书只存编号加字符串池（之后）所需的字节数，以及加载后整个图书模块占用的堆内存。
+ *
+ * 用法：bench_memory [图书数量]
+ */
+
+#include "bench.h"
+#include "../book.h"
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#define BENCH_DEFAULT_BOOKS 300000
+#define BENCH_AUTHORS 3000
+#define BENCH_PUBLISHERS 2000
+
+/**
+ * @brief 取当前已分配的堆内存
+ * @return 字节数，无法统计时返回0
+ */
+static size_t bench_heap_bytes(void) {
+#ifdef __GLIBC__
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief 生成图书数据文件
+ * @param books 图书数量
+ */
+static void bench_write_csv(int books) {
+    FILE *file = fopen("data/books.csv", "w");
+    BENCH_CHECK(file != NULL);
+    
+    unsigned int seed = 11;
+    fprintf(file, "id,title,author,publisher,isbn,publish_year,total_count,available_count\n");
+    for (int i = 0; i < books; i++) {
+        fprintf(file, "B%08d,图书标题 Book Title %d,作者%04u Author,出版社%04u Publishing House,978%010d,%d,3,3\n",
+                i, i, bench_rand(&seed) % BENCH_AUTHORS, bench_rand(&seed) % BENCH_PUBLISHERS, i, 1950 + i % 70);
+    }
+    
+    BENCH_CHECK(fclose(file) == 0);
+    unlink("data/books.snap");
+}
+
+int main(int argc, char *argv[]) {
+    int books = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_BOOKS;
+    BENCH_CHECK(books > 0);
+    
+    bench_write_csv(books);
+    
+    size_t heap_before = bench_heap_bytes();
+    BENCH_CHECK(book_init() == 0);
+    size_t heap_after = bench_heap_bytes();
+    
+    BookMemoryUsage usage;
+    book_memory_usage(&usage);
+    BENCH_CHECK(usage.book_count == books);
+    
+    printf("%d books, %d distinct authors/publishers\n", usage.book_count, usage.string_count);
+    printf("author+publisher, inline char[50] arrays (before): %8zu KB  %6.1f B/book\n",
+           usage.inline_bytes / 1024, (double)usage.inline_bytes / books);
+    printf("author+publisher, pool IDs + string pool (after):  %8zu KB  %6.1f B/book\n",
+           usage.interned_bytes / 1024, (double)usage.interned_bytes / books);
+    printf("saved:                                             %8lld KB\n",
+           ((long long)usage.inline_bytes - (long long)usage.interned_bytes) / 1024);
+    if (heap_after > heap_before) {
+        printf("whole book module after load (heap, all indexes):  %8zu KB  %6.1f B/book\n",
+               (heap_after - heap_before) / 1024, (double)(heap_after - heap_before) / books);
+    }
+    
+    book_cleanup();
+    return 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file bench_reader_lookup.c
+ * @brief 按ID查找读者的基准测试
+ *
+ * 分别加载1千、1万、10万、100万名读者，测量reader_lookup（ID哈希索引）
+ * 和reader_find_by_id（查找并复制出读者）的平均延迟；不超过10万名读者时，
+ * 再测量原来逐个strcmp的线性查找作为对照。查找延迟应基本不随读者数增长。
+ *
+ * 用法：bench_reader_lookup [最大读者数]
+ */
+
+#include "bench.h"
+#include "../reader.h"
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_DEFAULT_MAX 1000000
+#define BENCH_LOOKUPS 2000000
+#define BENCH_LINEAR_MAX 100000
+
+/**
+ * @brief 生成第i名读者的ID（打乱顺序，避免ID与存储位置同序）
+ * @param i 序号
+ * @param n 读者总数
+ * @param id 用于存储ID
+ * @param size 缓冲区大小
+ */
+static void bench_reader_id(int i, int n, char *id, size_t size) {
+    snprintf(id, size, "R%09d%04d", (int)((long long)i * 7919 % n), i % 9973);
+}
+
+/**
+ * @brief 生成读者数据文件
+ * @param n 读者数
+ */
+static void bench_write_csv(int n) {
+    FILE *file = fopen("data/readers.csv", "w");
+    BENCH_CHECK(file != NULL);
+    
+    fprintf(file, "id,name,gender,phone,email,address,max_borrow_count,current_borrow_count\n");
+    for (int i = 0; i < n; i++) {
+        char id[32];
+        bench_reader_id(i, n, id, sizeof(id));
+        fprintf(file, "%s,读者%d,%s,138%08d,user%d@example.com,某市某区某路%d号,10,0\n",
+                id, i, i % 2 ? "男" : "女", i, i, i % 500);
+    }
+    
+    BENCH_CHECK(fclose(file) == 0);
+    unlink("data/readers.snap");
+}
+
+/**
+ * @brief 测量一种读者数下的查找延迟
+ * @param n 读者数
+ */
+static void bench_size(int n) {
+    bench_write_csv(n);
+    
+    double start = bench_now();
+    BENCH_CHECK(reader_init() == 0);
+    double load = bench_now() - start;
+    
+    // 预先生成要查找的ID，计时只包含查找本身
+    enum { BENCH_KEYS = 1 << 20 };
+    static char ids[BENCH_KEYS][32];
+    unsigned int seed = 12345;
+    for (int k = 0; k < BENCH_KEYS; k++) {
+        bench_reader_id((int)(bench_rand(&seed) % (unsigned int)n), n, ids[k], sizeof(ids[k]));
+    }
+    
+    long hits = 0;
+    start = bench_now();
+    for (int q = 0; q < BENCH_LOOKUPS; q++) {
+        hits += reader_lookup(ids[(q * 7) & (BENCH_KEYS - 1)]) != -1;
+    }
+    double lookup = (bench_now() - start) / BENCH_LOOKUPS;
+    BENCH_CHECK(hits == BENCH_LOOKUPS);
+    
+    Reader reader;
+    start = bench_now();
+    for (int q = 0; q < BENCH_LOOKUPS; q++) {
+        BENCH_CHECK(reader_find_by_id(ids[(q * 7) & (BENCH_KEYS - 1)], &reader) == 0);
+    }
+    double find = (bench_now() - start) / BENCH_LOOKUPS;
+    
+    printf("%8d readers  load %7.1f ms  reader_lookup %5.0f ns  reader_find_by_id %5.0f ns",
+           n, load * 1e3, lookup * 1e9, find * 1e9);
+    
+    // 原来的实现：在Reader数组中逐个strcmp
+    if (n <= BENCH_LINEAR_MAX) {
+        Reader *all = (Reader *)malloc(sizeof(Reader) * (size_t)n);
+        BENCH_CHECK(all != NULL && reader_get_all(all, n) == n);
+        
+        int queries = n >= BENCH_LINEAR_MAX ? 200 : 20000;
+        volatile long found = 0;
+        start = bench_now();
+        for (int q = 0; q < queries; q++) {
+            const char *id = ids[q & (BENCH_KEYS - 1)];
+            for (int i = 0; i < n; i++) {
+                if (strcmp(all[i].id, id) == 0) {
+                    found += i;
+                    break;
+                }
+            }
+        }
+        printf("  linear scan %9.0f ns", (bench_now() - start) / queries * 1e9);
+        free(all);
+    }
+    
+    printf("\n");
+    reader_cleanup();
+}
+
+int main(int argc, char *argv[]) {
+    int max = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_MAX;
+    BENCH_CHECK(max >= 1000);
+    
+    for (int n = 1000; n <= max; n *= 10) {
+        bench_size(n);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,208 @@
+/**
+ * @file bitmap.c
+ * @brief 位图相关函数的实现
+ */
+
+#include "bitmap.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 求64位整数最低置位的位置
+ * @param word 非0整数
+ * @return 位置
+ */
+static int bitmap_lowest_bit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while ((word & 1) == 0) {
+        word >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+/**
+ * @brief 确保容量足够
+ * @param bitmap 位图
+ * @param needed 需要的位数
+ * @return 成功返回0，失败返回非0值
+ */
+static int bitmap_reserve(Bitmap *bitmap, int needed) {
+    if (needed <= bitmap->capacity) {
+        return 0;
+    }
+    
+    int capacity = bitmap->capacity > 0 ? bitmap->capacity : 64;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    
+    uint64_t *grown = (uint64_t *)realloc(bitmap->words, sizeof(uint64_t) * (capacity / 64));
+    if (grown == NULL) {
+        return -1;
+    }
+    
+    // 新增部分清零，保证超出位数的位始终为0
+    memset(grown + bitmap->capacity / 64, 0, sizeof(uint64_t) * ((capacity - bitmap->capacity) / 64));
+    bitmap->words = grown;
+    bitmap->capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief 初始化位图
+ * @param bitmap 位图
+ * @param capacity 初始容量（位数）
+ * @return 成功返回0，失败返回非0值
+ */
+int bitmap_init(Bitmap *bitmap, int capacity) {
+    if (bitmap == NULL) {
+        return -1;
+    }
+    
+    bitmap->words = NULL;
+    bitmap->count = 0;
+    bitmap->capacity = 0;
+    bitmap->ones = 0;
+    return bitmap_reserve(bitmap, capacity > 0 ? capacity : 64);
+}
+
+/**
+ * @brief 释放位图
+ * @param bitmap 位图
+ */
+void bitmap_free(Bitmap *bitmap) {
+    if (bitmap == NULL) {
+        return;
+    }
+    
+    free(bitmap->words);
+    bitmap->words = NULL;
+    bitmap->count = 0;
+    bitmap->capacity = 0;
+    bitmap->ones = 0;
+}
+
+/**
+ * @brief 清空位图（保留内存）
+ * @param bitmap 位图
+ */
+void bitmap_clear(Bitmap *bitmap) {
+    memset(bitmap->words, 0, sizeof(uint64_t) * ((bitmap->count + 63) / 64));
+    bitmap->count = 0;
+    bitmap->ones = 0;
+}
+
+/**
+ * @brief 设置一位
+ * @param bitmap 位图
+ * @param index 位置，等于位数时追加
+ * @param value 非0置位，0清除
+ * @return 成功返回0，失败返回非0值
+ */
+int bitmap_set(Bitmap *bitmap, int index, int value) {
+    if (index < 0 || index > bitmap->count) {
+        return -1;
+    }
+    
+    if (index == bitmap->count) {
+        if (bitmap_reserve(bitmap, bitmap->count + 1) != 0) {
+            return -1;
+        }
+        bitmap->count++;
+    }
+    
+    uint64_t mask = (uint64_t)1 << (index % 64);
+    uint64_t *word = &bitmap->words[index / 64];
+    int old = (*word & mask) != 0;
+    
+    if (value && !old) {
+        *word |= mask;
+        bitmap->ones++;
+    } else if (!value && old) {
+        *word &= ~mask;
+        bitmap->ones--;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 读取一位
+ * @param bitmap 位图
+ * @param index 位置
+ * @return 置位返回1，否则返回0
+ */
+int bitmap_get(const Bitmap *bitmap, int index) {
+    if (index < 0 || index >= bitmap->count) {
+        return 0;
+    }
+    
+    return (bitmap->words[index / 64] >> (index % 64)) & 1;
+}
+
+/**
+ * @brief 删除一位，后面的位整体前移
+ * @param bitmap 位图
+ * @param index 位置
+ */
+void bitmap_delete(Bitmap *bitmap, int index) {
+    if (index < 0 || index >= bitmap->count) {
+        return;
+    }
+    
+    if (bitmap_get(bitmap, index)) {
+        bitmap->ones--;
+    }
+    
+    int words = (bitmap->count + 63) / 64;
+    int first = index / 64;
+    int bit = index % 64;
+    
+    // 所在的组：低于index的位不动，高于index的位右移一位
+    uint64_t word = bitmap->words[first];
+    uint64_t low = bit > 0 ? word & (((uint64_t)1 << bit) - 1) : 0;
+    uint64_t high = bit < 63 ? (word >> (bit + 1)) << bit : 0;
+    bitmap->words[first] = low | high;
+    
+    // 后面的组整体右移一位，最低位移入前一组的最高位
+    for (int i = first + 1; i < words; i++) {
+        bitmap->words[i - 1] |= bitmap->words[i] << 63;
+        bitmap->words[i] >>= 1;
+    }
+    
+    bitmap->count--;
+}
+
+/**
+ * @brief 查找下一个置位
+ * @param bitmap 位图
+ * @param start 从该位置开始查找
+ * @return 找到返回位置，否则返回-1
+ */
+int bitmap_next(const Bitmap *bitmap, int start) {
+    if (start < 0) {
+        start = 0;
+    }
+    
+    if (start >= bitmap->count) {
+        return -1;
+    }
+    
+    int words = (bitmap->count + 63) / 64;
+    int i = start / 64;
+    uint64_t word = bitmap->words[i] & (~(uint64_t)0 << (start % 64));
+    
+    while (word == 0) {
+        if (++i >= words) {
+            return -1;
+        }
+        word = bitmap->words[i];
+    }
+    
+    return i * 64 + bitmap_lowest_bit(word);
+}
@@ -0,0 +1,76 @@
+/**
+ * @file bitmap.h
+ * @brief 位图相关函数和数据结构的声明
+ *
+ * 每条记录占一位，按64位一组存放，统计置位数和查找下一个置位都按组进行。
+ * 记录数组删除元素后，后面的位整体前移一位。
+ */
+
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <stdint.h>
+
+/**
+ * @brief 位图
+ */
+typedef struct {
+    uint64_t *words;   /**< 位数组 */
+    int count;         /**< 位数（记录数量） */
+    int capacity;      /**< 容量（位数，64的倍数） */
+    int ones;          /**< 置位的个数 */
+} Bitmap;
+
+/**
+ * @brief 初始化位图
+ * @param bitmap 位图
+ * @param capacity 初始容量（位数）
+ * @return 成功返回0，失败返回非0值
+ */
+int bitmap_init(Bitmap *bitmap, int capacity);
+
+/**
+ * @brief 释放位图
+ * @param bitmap 位图
+ */
+void bitmap_free(Bitmap *bitmap);
+
+/**
+ * @brief 清空位图（保留内存）
+ * @param bitmap 位图
+ */
+void bitmap_clear(Bitmap *bitmap);
+
+/**
+ * @brief 设置一位
+ * @param bitmap 位图
+ * @param index 位置，等于位数时追加
+ * @param value 非0置位，0清除
+ * @return 成功返回0，失败返回非0值
+ */
+int bitmap_set(Bitmap *bitmap, int index, int value);
+
+/**
+ * @brief 读取一位
+ * @param bitmap 位图
+ * @param index 位置
+ * @return 置位返回1，否则返回0
+ */
+int bitmap_get(const Bitmap *bitmap, int index);
+
+/**
+ * @brief 删除一位，后面的位整体前移
+ * @param bitmap 位图
+ * @param index 位置
+ */
+void bitmap_delete(Bitmap *bitmap, int index);
+
+/**
+ * @brief 查找下一个置位
+ * @param bitmap 位图
+ * @param start 从该位置开始查找
+ * @return 找到返回位置，否则返回-1
+ */
+int bitmap_next(const Bitmap *bitmap, int start);
+
+#endif /* BITMAP_H */
@@ -4,177 +4,2041 @@
  */
 
 #include "book.h"
+#include "bitmap.h"
+#include "chunk_array.h"
+#include "csv.h"
+#include "fold_column.h"
+#include "fuzzy_index.h"
+#include "id_index.h"
+#include "journal.h"
+#include "range_index.h"
+#include "snapshot.h"
+#include "string_pool.h"
+#include "text_arena.h"
+#include "text_index.h"
+#include "trigram.h"
 #include "utils.h"
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define MAX_BOOKS 1000
 #define BOOKS_FILE "data/books.csv"
-#define MAX_LINE_SIZE 1024
+#define BOOKS_TMP_FILE "data/books.csv.tmp"
+#define BOOKS_SNAPSHOT_FILE "data/books.snap"
+#define BOOK_SNAPSHOT_TYPE 0x4B4F4F42u // "BOOK"
+#define BOOKS_JOURNAL_FILE "data/books.journal"
+#define BOOK_JOURNAL_MIN_COMPACT 256 // 日志至少累积多少条才合并
+#define BOOK_FIELD_COUNT 8
+#define BOOK_COMPACT_MIN_DELETED 1024 // 已删除的位置至少多少个才整理
+#define BOOK_COMPACT_STEP 2 // 超过整理条件时每次删除顺带移动的图书数
+#define BOOK_GENERATION_MAX 0x7FFFFFFFu // 代数的上限，句柄因此总是非负
 
-// 图书数组
-static Book *books = NULL;
-// 图书数量
+/**
+ * @brief 图书的热数据：借还时访问的ID和数量
+ */
+typedef struct {
+    char id[sizeof(((Book *)0)->id)];   /**< 图书ID */
+    int total_count;                    /**< 总数量 */
+    int available_count;                /**< 可借数量 */
+    unsigned int generation;            /**< 写入该位置时分配的代数，句柄据此判断是否过期 */
+} BookHot;
+
+/**
+ * @brief 图书的冷数据：描述性字段，只在检索和展示时访问
+ *
+ * 标题和ISBN存放在文本区中，按实际长度占用空间，不截断；
+ * 作者和出版社在大量图书之间重复，只存字符串池中的编号。
+ */
+typedef struct {
+    TextRef title;      /**< 图书标题在文本区中的位置 */
+    int author;         /**< 作者在字符串池中的编号 */
+    int publisher;      /**< 出版社在字符串池中的编号 */
+    TextRef isbn;       /**< ISBN在文本区中的位置 */
+    int publish_year;   /**< 出版年份 */
+} BookCold;
+
+/**
+ * @brief 一本待写入的图书，只在转换和写入时临时使用（标题和ISBN引用调用方的文本）
+ */
+typedef struct {
+    BookHot hot;        /**< 热数据 */
+    TextSpan title;     /**< 图书标题 */
+    TextSpan isbn;      /**< ISBN */
+    int author;         /**< 作者在字符串池中的编号 */
+    int publisher;      /**< 出版社在字符串池中的编号 */
+    int publish_year;   /**< 出版年份 */
+} BookRecord;
+
+// 图书的热数据和冷数据分两个数组存放，同一下标是同一本图书（分块存放，扩容时已有图书的地址不变）。
+// 借还只访问热数据，一百万本图书的热数据约32MB，扫描时不必把标题等字段带进缓存
+static ChunkArray book_hot;
+static ChunkArray book_cold;
+// 图书数组中已使用的位置数（含已删除的位置）
 static int book_count = 0;
-// 图书容量
-static int book_capacity = 0;
+// 已删除的位置数
+static int book_deleted = 0;
+// 位置占用位图：置位表示存放着有效图书，清零表示已删除
+static Bitmap book_used;
+// 最近分配的代数（重新加载数据时不清零，旧句柄不会与新数据碰巧相符）
+static unsigned int book_generation = 0;
+// 空闲位置栈，新增图书时优先复用
+static int *book_free_slots = NULL;
+static int book_free_count = 0;
+static int book_free_capacity = 0;
+// 作者和出版社的字符串池（只增不减，重新加载数据时清空）
+static StringPool book_strings;
+// 标题和ISBN的文本区（修改和删除留下的废弃文本过多时整理，重新加载数据时清空）
+static TextArena book_text;
+// 图书变更日志
+static Journal book_journal;
+// 图书ID索引
+static IdIndex book_id_index;
+// 图书标题三元组索引
+static TrigramIndex book_title_index;
+// 标题、作者、出版社的折叠列
+static FoldColumn book_title_folded;
+static FoldColumn book_author_folded;
+static FoldColumn book_publisher_folded;
+// 出版年份有序索引
+static RangeIndex book_year_index;
+// 可借（可借数量大于0）位图
+static Bitmap book_available;
+// 标题和作者的模糊查找索引
+static FuzzyIndex book_fuzzy_index;
+// 标题、作者、出版社的全文检索索引
+static TextIndex book_text_index;
+// 全文检索中标题、作者、出版社的权重
+static const int book_text_weights[3] = {3, 2, 1};
+
+/**
+ * @brief 写出数据文件时使用的图书数据副本（与模块内部的存储形式相同，快照直接写出这几部分）
+ */
+typedef struct {
+    ChunkArray hot;       /**< 热数据副本（BookHot） */
+    ChunkArray cold;      /**< 冷数据副本（BookCold，标题和ISBN引用副本自己的文本区） */
+    TextArena text;       /**< 副本中的标题和ISBN */
+    StringPool strings;   /**< 作者和出版社字符串池的副本（编号与原池相同） */
+    int count;            /**< 图书数量 */
+} BookSnapshot;
+
+/**
+ * @brief 取指定位置图书的热数据
+ * @param index 图书下标
+ * @return 热数据指针
+ */
+static BookHot *book_hot_at(int index) {
+    return (BookHot *)CHUNK_ARRAY_AT(&book_hot, index);
+}
+
+/**
+ * @brief 取指定位置图书的冷数据
+ * @param index 图书下标
+ * @return 冷数据指针
+ */
+static BookCold *book_cold_at(int index) {
+    return (BookCold *)CHUNK_ARRAY_AT(&book_cold, index);
+}
+
+/**
+ * @brief 确保热数据和冷数据数组都能容纳指定数量的图书
+ * @param count 图书数量
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int book_reserve(int count) {
+    if (chunk_array_reserve(&book_hot, count) != 0 || chunk_array_reserve(&book_cold, count) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 把图书记录写入指定位置（标题和ISBN追加到文本区，不更新索引）
+ * @param index 图书下标
+ * @param record 图书记录
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int book_write_at(int index, const BookRecord *record) {
+    BookCold *cold = book_cold_at(index);
+    TextRef title;
+    TextRef isbn;
+    
+    if (text_arena_append(&book_text, record->title, &title) != 0) {
+        return -1;
+    }
+    if (text_arena_append(&book_text, record->isbn, &isbn) != 0) {
+        text_arena_release(&book_text, title);
+        return -1;
+    }
+    
+    cold->title = title;
+    cold->isbn = isbn;
+    cold->author = record->author;
+    cold->publisher = record->publisher;
+    cold->publish_year = record->publish_year;
+    memcpy(book_hot_at(index), &record->hot, sizeof(BookHot));
+    
+    // 每次写入新图书都分配新的代数，指向该位置旧图书的句柄随之失效
+    book_generation = book_generation % BOOK_GENERATION_MAX + 1;
+    book_hot_at(index)->generation = book_generation;
+    return 0;
+}
+
+/**
+ * @brief 取指定位置图书的标题
+ * @param cold 图书的冷数据
+ * @return 标题（在下一次向文本区追加之前有效）
+ */
+static const char *book_title_of(const BookCold *cold) {
+    return text_arena_get(&book_text, cold->title);
+}
+
+/**
+ * @brief 取字符串池中编号对应的作者或出版社
+ * @param id 字符串编号
+ * @return 字符串
+ */
+static const char *book_string(int id) {
+    return string_pool_get(&book_strings, id);
+}
+
+/**
+ * @brief 取定长字段中的文本（字段不一定以'\0'结尾，例如来自快照文件）
+ * @param text 字段
+ * @param size 字段大小
+ * @return 文本
+ */
+static TextSpan book_span(const char *text, size_t size) {
+    TextSpan span;
+    span.data = text;
+    span.length = strnlen(text, size);
+    return span;
+}
+
+/**
+ * @brief 把图书转换为存储形式（作者和出版社加入字符串池，标题和ISBN引用图书中的文本）
+ * @param record 用于存储转换结果
+ * @param book 图书
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int book_record_from(BookRecord *record, const Book *book) {
+    char text[sizeof(book->author) > sizeof(book->publisher) ? sizeof(book->author) : sizeof(book->publisher)];
+    
+    text_copy(text, sizeof(text), book->author, strnlen(book->author, sizeof(book->author)));
+    record->author = string_pool_intern(&book_strings, text);
+    text_copy(text, sizeof(text), book->publisher, strnlen(book->publisher, sizeof(book->publisher)));
+    record->publisher = string_pool_intern(&book_strings, text);
+    if (record->author == -1 || record->publisher == -1) {
+        return -1;
+    }
+    
+    memcpy(record->hot.id, book->id, sizeof(record->hot.id));
+    record->hot.id[sizeof(record->hot.id) - 1] = '\0';
+    record->hot.total_count = book->total_count;
+    record->hot.available_count = book->available_count;
+    record->title = book_span(book->title, sizeof(book->title));
+    record->isbn = book_span(book->isbn, sizeof(book->isbn));
+    record->publish_year = book->publish_year;
+    return 0;
+}
+
+/**
+ * @brief 把指定位置的热数据和冷数据还原到反复使用的图书结构体中
+ *
+ * 超出Book中定长字段的文本在完整的UTF-8字符处截断，存储中的文本不受影响。
+ *
+ * @param index 图书下标
+ * @param book 用于存储图书
+ * @param used 标题、作者、出版社、ISBN上一次写入的字节数，返回时更新（见text_copy_over）；
+ *             为NULL时补齐全部文本字段
+ */
+static void book_materialize_over(int index, Book *book, size_t used[4]) {
+    const BookHot *hot = book_hot_at(index);
+    const BookCold *cold = book_cold_at(index);
+    const char *author = book_string(cold->author);
+    const char *publisher = book_string(cold->publisher);
+    
+    memcpy(book->id, hot->id, sizeof(book->id));
+    text_arena_copy_over(&book_text, cold->title, book->title, sizeof(book->title), used ? &used[0] : NULL);
+    text_copy_over(book->author, sizeof(book->author), author, strlen(author), used ? &used[1] : NULL);
+    text_copy_over(book->publisher, sizeof(book->publisher), publisher, strlen(publisher), used ? &used[2] : NULL);
+    text_arena_copy_over(&book_text, cold->isbn, book->isbn, sizeof(book->isbn), used ? &used[3] : NULL);
+    book->publish_year = cold->publish_year;
+    book->total_count = hot->total_count;
+    book->available_count = hot->available_count;
+}
+
+/**
+ * @brief 把指定位置的热数据和冷数据还原为图书
+ * @param index 图书下标
+ * @param book 用于存储图书
+ */
+static void book_materialize(int index, Book *book) {
+    book_materialize_over(index, book, NULL);
+}
+
+/**
+ * @brief 将图书转换为字段数组
+ * @param book 图书
+ * @param numbers 用于存放数字字段文本的缓冲区
+ * @param fields 用于存储字段的数组
+ */
+static void book_to_fields(const Book *book, char numbers[3][16], char **fields) {
+    snprintf(numbers[0], sizeof(numbers[0]), "%d", book->publish_year);
+    snprintf(numbers[1], sizeof(numbers[1]), "%d", book->total_count);
+    snprintf(numbers[2], sizeof(numbers[2]), "%d", book->available_count);
+    
+    fields[0] = (char *)book->id;
+    fields[1] = (char *)book->title;
+    fields[2] = (char *)book->author;
+    fields[3] = (char *)book->publisher;
+    fields[4] = (char *)book->isbn;
+    fields[5] = numbers[0];
+    fields[6] = numbers[1];
+    fields[7] = numbers[2];
+}
+
+/**
+ * @brief 把CSV字段加入字符串池（不截断，较长的字段临时分配缓冲区）
+ * @param field 字段
+ * @return 返回编号，内存不足返回-1
+ */
+static int book_intern_field(const CsvField *field) {
+    char buffer[256];
+    char *text = field->len < sizeof(buffer) ? buffer : (char *)malloc(field->len + 1);
+    if (text == NULL) {
+        return -1;
+    }
+    
+    csv_field_copy(field, text, field->len + 1);
+    int id = string_pool_intern(&book_strings, text);
+    if (text != buffer) {
+        free(text);
+    }
+    return id;
+}
+
+/**
+ * @brief 用字段数组填充图书记录（作者和出版社加入字符串池，标题和ISBN引用字段中的文本）
+ * @param record 图书记录
+ * @param fields 字段数组（id,title,author,publisher,isbn,publish_year,total_count,available_count）
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int book_from_fields(BookRecord *record, const CsvField *fields) {
+    record->author = book_intern_field(&fields[2]);
+    record->publisher = book_intern_field(&fields[3]);
+    if (record->author == -1 || record->publisher == -1) {
+        return -1;
+    }
+    
+    csv_field_copy(&fields[0], record->hot.id, sizeof(record->hot.id));
+    record->title.data = fields[1].data;
+    record->title.length = fields[1].len;
+    record->isbn.data = fields[4].data;
+    record->isbn.length = fields[4].len;
+    
+    record->publish_year = (int)csv_field_to_long(&fields[5]);
+    record->hot.total_count = (int)csv_field_to_long(&fields[6]);
+    record->hot.available_count = (int)csv_field_to_long(&fields[7]);
+    return 0;
+}
+
+/**
+ * @brief 取图书ID（ID索引的回调函数）
+ * @param index 图书下标
+ * @param user_data 未使用
+ * @return 图书ID
+ */
+static const char *book_key_of(int index, void *user_data) {
+    (void)user_data;
+    return book_hot_at(index)->id;
+}
+
+/**
+ * @brief 取图书出版年份（年份索引的回调函数）
+ * @param row 图书下标
+ * @param user_data 未使用
+ * @return 出版年份
+ */
+static int book_year_of(int row, void *user_data) {
+    (void)user_data;
+    return book_cold_at(row)->publish_year;
+}
+
+/**
+ * @brief 查找图书在数组中的位置
+ * @param id 图书ID
+ * @return 找到返回下标，否则返回-1
+ */
+static int book_index_of(const char *id) {
+    return id_index_find(&book_id_index, id);
+}
+
+/**
+ * @brief 把图书的标题和作者加入模糊查找索引
+ *
+ * 两个字段分别加入，不拼接到定长缓冲区，长标题末尾的词也能查到。
+ *
+ * @param index 图书下标
+ * @param cold 图书的冷数据
+ */
+static void book_fuzzy_add(int index, const BookCold *cold) {
+    fuzzy_index_add(&book_fuzzy_index, index, book_title_of(cold));
+    fuzzy_index_add(&book_fuzzy_index, index, book_string(cold->author));
+}
+
+/**
+ * @brief 把图书的标题和作者从模糊查找索引中移除
+ * @param index 图书下标
+ * @param cold 图书的冷数据（与加入时相同）
+ */
+static void book_fuzzy_remove(int index, const BookCold *cold) {
+    fuzzy_index_remove(&book_fuzzy_index, index, book_title_of(cold));
+    fuzzy_index_remove(&book_fuzzy_index, index, book_string(cold->author));
+}
+
+/**
+ * @brief 取全文检索索引使用的字段（标题、作者、出版社）
+ * @param cold 图书的冷数据
+ * @param fields 用于存储字段
+ */
+static void book_text_fields(const BookCold *cold, const char *fields[3]) {
+    fields[0] = book_title_of(cold);
+    fields[1] = book_string(cold->author);
+    fields[2] = book_string(cold->publisher);
+}
+
+/**
+ * @brief 更新指定位置图书的折叠列
+ * @param index 图书下标，等于折叠列中的记录数时追加
+ * @param cold 图书的冷数据
+ */
+static void book_fold_at(int index, const BookCold *cold) {
+    fold_column_set(&book_title_folded, index, book_title_of(cold));
+    fold_column_set(&book_author_folded, index, book_string(cold->author));
+    fold_column_set(&book_publisher_folded, index, book_string(cold->publisher));
+}
+
+/**
+ * @brief 整理文本区：废弃的文本过多时，把有效图书的标题和ISBN按顺序搬到新的文本区
+ */
+static void book_maybe_compact_text() {
+    if (!text_arena_needs_compaction(&book_text)) {
+        return;
+    }
+    
+    // 容量按有效文本的字节数预留，搬移时不会再扩容，也就不会中途失败
+    TextArena text;
+    if (text_arena_init(&text, book_text.used - book_text.garbage) != 0) {
+        return;
+    }
+    
+    for (int i = bitmap_next(&book_used, 0); i != -1; i = bitmap_next(&book_used, i + 1)) {
+        BookCold *cold = book_cold_at(i);
+        text_arena_move(&text, &book_text, &cold->title);
+        text_arena_move(&text, &book_text, &cold->isbn);
+    }
+    
+    text_arena_free(&book_text);
+    book_text = text;
+}
+
+/**
+ * @brief 用新内容覆盖指定位置的图书，并同步各个索引
+ *
+ * 作者和出版社都已加入字符串池，比较编号即可判断是否变化；
+ * 标题和ISBN只有变化时才追加到文本区，旧文本在索引更新之后废弃。
+ *
+ * @param index 图书下标
+ * @param record 新的图书记录
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int book_store_at(int index, const BookRecord *record) {
+    BookCold *current = book_cold_at(index);
+    BookCold next = *current;
+    int title_changed = !text_arena_equals(&book_text, current->title, record->title);
+    int isbn_changed = !text_arena_equals(&book_text, current->isbn, record->isbn);
+    int author_changed = current->author != record->author;
+    int publisher_changed = current->publisher != record->publisher;
+    
+    if (title_changed && text_arena_append(&book_text, record->title, &next.title) != 0) {
+        return -1;
+    }
+    if (isbn_changed && text_arena_append(&book_text, record->isbn, &next.isbn) != 0) {
+        if (title_changed) {
+            text_arena_release(&book_text, next.title);
+        }
+        return -1;
+    }
+    next.author = record->author;
+    next.publisher = record->publisher;
+    next.publish_year = record->publish_year;
+    
+    if (title_changed) {
+        trigram_index_remove(&book_title_index, index, book_title_of(current));
+        trigram_index_add(&book_title_index, index, book_title_of(&next));
+    }
+    
+    if (title_changed || author_changed) {
+        book_fuzzy_remove(index, current);
+        book_fuzzy_add(index, &next);
+    }
+    
+    if (title_changed || author_changed || publisher_changed) {
+        const char *fields[3];
+        book_text_fields(current, fields);
+        text_index_remove(&book_text_index, index, fields);
+        book_text_fields(&next, fields);
+        text_index_add(&book_text_index, index, fields);
+    }
+    
+    if (current->publish_year != next.publish_year) {
+        range_index_remove(&book_year_index, current->publish_year, index);
+        range_index_insert(&book_year_index, next.publish_year, index);
+    }
+    
+    book_fold_at(index, &next);
+    bitmap_set(&book_available, index, record->hot.available_count > 0);
+    
+    if (title_changed) {
+        text_arena_release(&book_text, current->title);
+    }
+    if (isbn_changed) {
+        text_arena_release(&book_text, current->isbn);
+    }
+    *current = next;
+    
+    // 修改的是同一本图书（ID不变），代数保持不变，已有句柄仍然有效
+    BookHot *hot = book_hot_at(index);
+    hot->total_count = record->hot.total_count;
+    hot->available_count = record->hot.available_count;
+    
+    book_maybe_compact_text();
+    return 0;
+}
+
+/**
+ * @brief 取空闲栈顶的位置
+ *
+ * 整理时数组末尾的空位直接截掉，它们留在栈中的记录已经过期，这里顺带丢弃。
+ *
+ * @return 空位下标，没有空位时返回-1
+ */
+static int book_free_slot_top() {
+    while (book_free_count > 0 && book_free_slots[book_free_count - 1] >= book_count) {
+        book_free_count--;
+    }
+    
+    return book_free_count > 0 ? book_free_slots[book_free_count - 1] : -1;
+}
+
+/**
+ * @brief 把指定位置的图书加入除ID索引之外的各个索引
+ * @param index 图书下标
+ */
+static void book_index_at(int index) {
+    const BookCold *cold = book_cold_at(index);
+    const char *fields[3];
+    
+    bitmap_set(&book_used, index, 1);
+    trigram_index_add(&book_title_index, index, book_title_of(cold));
+    book_fuzzy_add(index, cold);
+    book_text_fields(cold, fields);
+    text_index_add(&book_text_index, index, fields);
+    book_fold_at(index, cold);
+    range_index_insert(&book_year_index, cold->publish_year, index);
+    bitmap_set(&book_available, index, book_hot_at(index)->available_count > 0);
+}
+
+/**
+ * @brief 把指定位置的图书从各个索引中移除，并标记为空位（不修改图书本身）
+ * @param index 图书下标
+ */
+static void book_unindex_at(int index) {
+    const BookCold *current = book_cold_at(index);
+    const char *fields[3];
+    
+    // ID索引移除时还要读取ID，先于其他操作
+    id_index_remove(&book_id_index, index);
+    book_fuzzy_remove(index, current);
+    book_text_fields(current, fields);
+    text_index_remove(&book_text_index, index, fields);
+    trigram_index_remove(&book_title_index, index, book_title_of(current));
+    range_index_remove(&book_year_index, current->publish_year, index);
+    
+    // 空位的折叠文本置空，扫描时再按占用位图跳过
+    fold_column_set(&book_title_folded, index, "");
+    fold_column_set(&book_author_folded, index, "");
+    fold_column_set(&book_publisher_folded, index, "");
+    bitmap_set(&book_available, index, 0);
+    bitmap_set(&book_used, index, 0);
+}
+
+/**
+ * @brief 加入图书，并加入各个索引
+ *
+ * 优先复用已删除的位置，没有空位时追加到数组末尾（容量不足时追加一块）。
+ *
+ * @param record 图书记录
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int book_insert(const BookRecord *record) {
+    int index = book_free_slot_top();
+    if (index == -1) {
+        index = book_count;
+        if (book_reserve(book_count + 1) != 0) {
+            return -1;
+        }
+    }
+    
+    const BookCold *cold = book_cold_at(index);
+    
+    if (book_write_at(index, record) != 0) {
+        return -1;
+    }
+    if (id_index_insert(&book_id_index, index) != 0) {
+        text_arena_release(&book_text, cold->isbn);
+        text_arena_release(&book_text, cold->title);
+        return -1;
+    }
+    
+    if (index == book_count) {
+        book_count++;
+    } else {
+        book_free_count--;
+        book_deleted--;
+    }
+    
+    book_index_at(index);
+    return 0;
+}
+
+/**
+ * @brief 根据图书数组重建各个索引（数组中不能有已删除的位置）
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int book_rebuild_indexes() {
+    const char *fields[3];
+    
+    if (id_index_rebuild(&book_id_index, book_count) != 0) {
+        return -1;
+    }
+    range_index_rebuild(&book_year_index, book_count, book_year_of, NULL);
+    
+    trigram_index_clear(&book_title_index);
+    fuzzy_index_clear(&book_fuzzy_index);
+    text_index_clear(&book_text_index);
+    fold_column_clear(&book_title_folded);
+    fold_column_clear(&book_author_folded);
+    fold_column_clear(&book_publisher_folded);
+    bitmap_clear(&book_available);
+    bitmap_clear(&book_used);
+    
+    for (int i = 0; i < book_count; i++) {
+        bitmap_set(&book_used, i, 1);
+        const BookCold *cold = book_cold_at(i);
+        trigram_index_add(&book_title_index, i, book_title_of(cold));
+        book_fuzzy_add(i, cold);
+        book_text_fields(cold, fields);
+        text_index_add(&book_text_index, i, fields);
+        book_fold_at(i, cold);
+        bitmap_set(&book_available, i, book_hot_at(i)->available_count > 0);
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 取有效图书数量（不含已删除的位置）
+ * @return 图书数量
+ */
+static int book_live_count() {
+    return book_count - book_deleted;
+}
+
+/**
+ * @brief 整理图书数组：有效图书按原顺序前移填满已删除的位置，释放多余的块并重建各个索引
+ *
+ * 需要线性时间，只在保存数据时调用；删除时由book_compact_step逐步整理。
+ */
+static void book_compact_slots() {
+    int count = 0;
+    
+    for (int i = bitmap_next(&book_used, 0); i != -1; i = bitmap_next(&book_used, i + 1)) {
+        if (i != count) {
+            memcpy(book_hot_at(count), book_hot_at(i), sizeof(BookHot));
+            memcpy(book_cold_at(count), book_cold_at(i), sizeof(BookCold));
+        }
+        count++;
+    }
+    
+    book_count = count;
+    book_deleted = 0;
+    book_free_count = 0;
+    chunk_array_shrink(&book_hot, book_count);
+    chunk_array_shrink(&book_cold, book_count);
+    book_rebuild_indexes();
+}
+
+/**
+ * @brief 逐步整理图书数组：把末尾的图书移到空位上，截掉末尾的空位并释放多余的块
+ *
+ * 每移动一本图书只需把它从各个索引中移除再加入，与一次删除加一次新增的开销相当，
+ * 不必像book_compact_slots那样重建全部索引。
+ *
+ * @param moves 最多移动的图书数
+ */
+static void book_compact_step(int moves) {
+    while (moves > 0) {
+        // 末尾的空位直接截掉
+        while (book_count > 0 && !bitmap_get(&book_used, book_count - 1)) {
+            book_count--;
+            book_deleted--;
+        }
+        
+        int hole = book_free_slot_top();
+        if (hole == -1) {
+            break;
+        }
+        book_free_count--;
+        
+        // 移除后再加入，ID索引的记录数不变，不会扩容，也就不会失败
+        int last = book_count - 1;
+        book_unindex_at(last);
+        memcpy(book_hot_at(hole), book_hot_at(last), sizeof(BookHot));
+        memcpy(book_cold_at(hole), book_cold_at(last), sizeof(BookCold));
+        id_index_insert(&book_id_index, hole);
+        book_index_at(hole);
+        
+        book_count--;
+        book_deleted--;
+        moves--;
+    }
+    
+    chunk_array_shrink(&book_hot, book_count);
+    chunk_array_shrink(&book_cold, book_count);
+}
+
+/**
+ * @brief 删除指定位置的图书
+ *
+ * 只把图书从各个索引中移除、位置标记为已删除并放入空闲栈，不移动其他图书，
+ * 其他图书的下标保持不变。已删除的位置超过总数的1/4后，每次删除再把末尾的
+ * 几本图书移到空位上，空位的比例因此保持在1/4左右，每次删除的开销都有上限。
+ *
+ * @param index 图书下标
+ */
+static void book_remove_at(int index) {
+    BookCold *current = book_cold_at(index);
+    
+    book_unindex_at(index);
+    
+    // 标题和ISBN废弃，已删除的位置不再引用文本区
+    text_arena_release(&book_text, current->isbn);
+    text_arena_release(&book_text, current->title);
+    current->title.length = 0;
+    current->title.offset = 0;
+    current->isbn = current->title;
+    book_deleted++;
+    
+    // 空闲栈扩容失败时该位置只是暂不复用，整理时仍会回收
+    if (book_free_count >= book_free_capacity) {
+        int capacity = book_free_capacity > 0 ? book_free_capacity * 2 : 64;
+        int *grown = (int *)realloc(book_free_slots, sizeof(int) * capacity);
+        if (grown != NULL) {
+            book_free_slots = grown;
+            book_free_capacity = capacity;
+        }
+    }
+    if (book_free_count < book_free_capacity) {
+        book_free_slots[book_free_count++] = index;
+    }
+    
+    if (book_deleted >= BOOK_COMPACT_MIN_DELETED && book_deleted > book_count / 4) {
+        book_compact_step(BOOK_COMPACT_STEP);
+    }
+    book_maybe_compact_text();
+}
+
+/**
+ * @brief 分配折叠列、年份索引、可借位图、占用位图、模糊查找索引和全文检索索引
+ * @return 成功返回0，失败返回非0值
+ */
+static int book_secondary_init() {
+    if (fold_column_init(&book_title_folded, CHUNK_ARRAY_RECORDS, sizeof(((Book *)0)->title)) != 0) {
+        return -1;
+    }
+    
+    if (fold_column_init(&book_author_folded, CHUNK_ARRAY_RECORDS, sizeof(((Book *)0)->author)) != 0) {
+        fold_column_free(&book_title_folded);
+        return -1;
+    }
+    
+    if (fold_column_init(&book_publisher_folded, CHUNK_ARRAY_RECORDS, sizeof(((Book *)0)->publisher)) != 0) {
+        fold_column_free(&book_author_folded);
+        fold_column_free(&book_title_folded);
+        return -1;
+    }
+    
+    if (range_index_init(&book_year_index, CHUNK_ARRAY_RECORDS) != 0) {
+        fold_column_free(&book_publisher_folded);
+        fold_column_free(&book_author_folded);
+        fold_column_free(&book_title_folded);
+        return -1;
+    }
+    
+    if (bitmap_init(&book_available, CHUNK_ARRAY_RECORDS) != 0) {
+        range_index_free(&book_year_index);
+        fold_column_free(&book_publisher_folded);
+        fold_column_free(&book_author_folded);
+        fold_column_free(&book_title_folded);
+        return -1;
+    }
+    
+    if (bitmap_init(&book_used, CHUNK_ARRAY_RECORDS) != 0) {
+        bitmap_free(&book_available);
+        range_index_free(&book_year_index);
+        fold_column_free(&book_publisher_folded);
+        fold_column_free(&book_author_folded);
+        fold_column_free(&book_title_folded);
+        return -1;
+    }
+    
+    if (fuzzy_index_init(&book_fuzzy_index) != 0) {
+        bitmap_free(&book_used);
+        bitmap_free(&book_available);
+        range_index_free(&book_year_index);
+        fold_column_free(&book_publisher_folded);
+        fold_column_free(&book_author_folded);
+        fold_column_free(&book_title_folded);
+        return -1;
+    }
+    
+    if (text_index_init(&book_text_index, book_text_weights, 3) != 0) {
+        fuzzy_index_free(&book_fuzzy_index);
+        bitmap_free(&book_used);
+        bitmap_free(&book_available);
+        range_index_free(&book_year_index);
+        fold_column_free(&book_publisher_folded);
+        fold_column_free(&book_author_folded);
+        fold_column_free(&book_title_folded);
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 释放折叠列、年份索引、可借位图、占用位图、模糊查找索引和全文检索索引
+ */
+static void book_secondary_free() {
+    fold_column_free(&book_title_folded);
+    fold_column_free(&book_author_folded);
+    fold_column_free(&book_publisher_folded);
+    range_index_free(&book_year_index);
+    bitmap_free(&book_available);
+    bitmap_free(&book_used);
+    fuzzy_index_free(&book_fuzzy_index);
+    text_index_free(&book_text_index);
+}
+
+/**
+ * @brief 将图书数据副本写成二进制快照
+ *
+ * 快照按存储形式保存热数据、冷数据、标题和ISBN的文本区以及作者和出版社的字符串池，
+ * 文本不截断，加载时整块复制回来即可。
+ *
+ * @param copy 图书数据副本
+ * @return 成功返回0，失败返回非0值
+ */
+static int book_write_binary(const BookSnapshot *copy) {
+    char *strings = (char *)malloc(copy->strings.bytes > 0 ? copy->strings.bytes : 1);
+    if (strings == NULL) {
+        return -1;
+    }
+    string_pool_write(&copy->strings, strings);
+    
+    const void *text = copy->text.data;
+    const void *pool = strings;
+    SnapshotSection sections[4] = {
+        {(const void *const *)copy->hot.chunks, CHUNK_ARRAY_RECORDS, sizeof(BookHot), (size_t)copy->count},
+        {(const void *const *)copy->cold.chunks, CHUNK_ARRAY_RECORDS, sizeof(BookCold), (size_t)copy->count},
+        {&text, 0, 1, copy->text.used},
+        {&pool, 0, 1, copy->strings.bytes}
+    };
+    
+    int result = snapshot_write(BOOKS_SNAPSHOT_FILE, BOOKS_FILE, BOOK_SNAPSHOT_TYPE, sections, 4);
+    free(strings);
+    return result;
+}
+
+/**
+ * @brief 将图书数据副本写入CSV文件和二进制快照（先写临时文件再替换）
+ * @param copy 图书数据副本
+ * @return 成功返回0，失败返回非0值
+ */
+static int book_write_file(const BookSnapshot *copy) {
+    FILE *file = fopen(BOOKS_TMP_FILE, "w");
+    if (file == NULL) {
+        return -1;
+    }
+    
+    // 写入标题行
+    fprintf(file, "id,title,author,publisher,isbn,publish_year,total_count,available_count\n");
+    
+    // 写入数据（文本不截断）
+    char numbers[3][16];
+    char *fields[BOOK_FIELD_COUNT];
+    for (int i = 0; i < copy->count; i++) {
+        const BookHot *hot = (const BookHot *)CHUNK_ARRAY_AT(&copy->hot, i);
+        const BookCold *cold = (const BookCold *)CHUNK_ARRAY_AT(&copy->cold, i);
+        snprintf(numbers[0], sizeof(numbers[0]), "%d", cold->publish_year);
+        snprintf(numbers[1], sizeof(numbers[1]), "%d", hot->total_count);
+        snprintf(numbers[2], sizeof(numbers[2]), "%d", hot->available_count);
+        fields[0] = (char *)hot->id;
+        fields[1] = (char *)text_arena_get(&copy->text, cold->title);
+        fields[2] = (char *)string_pool_get(&copy->strings, cold->author);
+        fields[3] = (char *)string_pool_get(&copy->strings, cold->publisher);
+        fields[4] = (char *)text_arena_get(&copy->text, cold->isbn);
+        fields[5] = numbers[0];
+        fields[6] = numbers[1];
+        fields[7] = numbers[2];
+        csv_write_record(file, fields, BOOK_FIELD_COUNT);
+    }
+    
+    if (fclose(file) != 0) {
+        remove(BOOKS_TMP_FILE);
+        return -1;
+    }
+    
+    if (rename(BOOKS_TMP_FILE, BOOKS_FILE) != 0) {
+        return -1;
+    }
+    
+    // 快照在CSV之后写出，记下刚写好的CSV的大小和修改时间，加载时据此判断快照是否仍然有效
+    return book_write_binary(copy);
+}
+
+/**
+ * @brief 释放图书数据副本中的数组、文本区和字符串池
+ * @param copy 图书数据副本
+ */
+static void book_release_copy(BookSnapshot *copy) {
+    chunk_array_free(&copy->hot);
+    chunk_array_free(&copy->cold);
+    text_arena_free(&copy->text);
+    string_pool_free(&copy->strings);
+}
+
+/**
+ * @brief 释放后台合并使用的图书数据副本
+ * @param snapshot 图书数据副本
+ */
+static void book_free_snapshot(void *snapshot) {
+    BookSnapshot *copy = (BookSnapshot *)snapshot;
+    book_release_copy(copy);
+    free(copy);
+}
+
+/**
+ * @brief 在后台线程中写出图书数据副本
+ * @param snapshot 图书数据副本
+ * @return 成功返回0，失败返回非0值
+ */
+static int book_write_snapshot(void *snapshot) {
+    BookSnapshot *copy = (BookSnapshot *)snapshot;
+    int result = book_write_file(copy);
+    book_free_snapshot(copy);
+    return result;
+}
+
+/**
+ * @brief 把有效图书按顺序复制到数据副本（跳过已删除的位置）
+ *
+ * 标题和ISBN搬到副本自己的文本区，字符串池整体复制（编号不变），
+ * 副本不再引用模块中的数据，后台线程写出时不受之后增删改的影响。
+ *
+ * @param copy 数据副本（未初始化）
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int book_copy_live(BookSnapshot *copy) {
+    memset(copy, 0, sizeof(BookSnapshot));
+    if (chunk_array_init(&copy->hot, sizeof(BookHot)) != 0 || chunk_array_init(&copy->cold, sizeof(BookCold)) != 0) {
+        book_release_copy(copy);
+        return -1;
+    }
+    
+    // 文本区的容量按有效文本的字节数预留，复制时不会再扩容
+    if (chunk_array_reserve(&copy->hot, book_live_count()) != 0 ||
+        chunk_array_reserve(&copy->cold, book_live_count()) != 0 ||
+        text_arena_init(&copy->text, book_text.used - book_text.garbage) != 0 ||
+        string_pool_copy(&copy->strings, &book_strings) != 0) {
+        book_release_copy(copy);
+        return -1;
+    }
+    
+    int count = 0;
+    for (int i = bitmap_next(&book_used, 0); i != -1; i = bitmap_next(&book_used, i + 1)) {
+        BookCold *cold = (BookCold *)CHUNK_ARRAY_AT(&copy->cold, count);
+        
+        memcpy(CHUNK_ARRAY_AT(&copy->hot, count), book_hot_at(i), sizeof(BookHot));
+        *cold = *book_cold_at(i);
+        if (text_arena_move(&copy->text, &book_text, &cold->title) != 0 ||
+            text_arena_move(&copy->text, &book_text, &cold->isbn) != 0) {
+            book_release_copy(copy);
+            return -1;
+        }
+        count++;
+    }
+    
+    copy->count = count;
+    return 0;
+}
+
+/**
+ * @brief 日志过长时在后台合并回数据文件
+ */
+static void book_maybe_compact() {
+    if (!journal_needs_compaction(&book_journal, book_live_count())) {
+        return;
+    }
+    
+    BookSnapshot *copy = (BookSnapshot *)malloc(sizeof(BookSnapshot));
+    if (copy == NULL) {
+        return;
+    }
+    
+    if (book_copy_live(copy) != 0) {
+        free(copy);
+        return;
+    }
+    
+    journal_compact(&book_journal, book_write_snapshot, copy, book_free_snapshot);
+}
+
+/**
+ * @brief 记录一条图书写入日志
+ * @param book 写入后的图书
+ * @return 成功返回0，失败返回非0值
+ */
+static int book_log_put(const Book *book) {
+    char numbers[3][16];
+    char *fields[BOOK_FIELD_COUNT];
+    
+    book_to_fields(book, numbers, fields);
+    if (journal_append(&book_journal, JOURNAL_OP_PUT, fields, BOOK_FIELD_COUNT) != 0) {
+        return -1;
+    }
+    
+    book_maybe_compact();
+    return 0;
+}
+
+/**
+ * @brief 记录一条图书数量日志（只含ID和数量，借还时不必还原整本图书）
+ * @param hot 写入后的热数据
+ * @return 成功返回0，失败返回非0值
+ */
+static int book_log_count(const BookHot *hot) {
+    char numbers[2][16];
+    char *fields[3];
+    
+    snprintf(numbers[0], sizeof(numbers[0]), "%d", hot->total_count);
+    snprintf(numbers[1], sizeof(numbers[1]), "%d", hot->available_count);
+    fields[0] = (char *)hot->id;
+    fields[1] = numbers[0];
+    fields[2] = numbers[1];
+    
+    if (journal_append(&book_journal, JOURNAL_OP_COUNT, fields, 3) != 0) {
+        return -1;
+    }
+    
+    book_maybe_compact();
+    return 0;
+}
+
+/**
+ * @brief 记录一条图书删除日志
+ * @param id 图书ID
+ * @return 成功返回0，失败返回非0值
+ */
+static int book_log_delete(const char *id) {
+    char *fields[1] = {(char *)id};
+    
+    if (journal_append(&book_journal, JOURNAL_OP_DELETE, fields, 1) != 0) {
+        return -1;
+    }
+    
+    book_maybe_compact();
+    return 0;
+}
+
+/**
+ * @brief 重放一条图书日志
+ * @param op 操作类型
+ * @param fields 记录字段
+ * @param num_fields 字段数
+ * @param user_data 未使用
+ * @return 成功返回0，失败返回非0值
+ */
+static int book_apply_journal(char op, const CsvField *fields, int num_fields, void *user_data) {
+    (void)user_data;
+    if (op == JOURNAL_OP_DELETE) {
+        char id[sizeof(((Book *)0)->id)];
+        csv_field_copy(&fields[0], id, sizeof(id));
+        
+        int index = book_index_of(id);
+        if (index != -1) {
+            book_remove_at(index);
+        }
+        return 0;
+    }
+    
+    if (op == JOURNAL_OP_COUNT && num_fields == 3) {
+        char id[sizeof(((Book *)0)->id)];
+        csv_field_copy(&fields[0], id, sizeof(id));
+        
+        int index = book_index_of(id);
+        if (index != -1) {
+            BookHot *hot = book_hot_at(index);
+            hot->total_count = (int)csv_field_to_long(&fields[1]);
+            hot->available_count = (int)csv_field_to_long(&fields[2]);
+            bitmap_set(&book_available, index, hot->available_count > 0);
+        }
+        return 0;
+    }
+    
+    if (op != JOURNAL_OP_PUT || num_fields != BOOK_FIELD_COUNT) {
+        return -1;
+    }
+    
+    BookRecord record;
+    if (book_from_fields(&record, fields) != 0) {
+        return -1;
+    }
+    
+    int index = book_index_of(record.hot.id);
+    if (index == -1) {
+        return book_insert(&record);
+    }
+    
+    return book_store_at(index, &record);
+}
+
+/**
+ * @brief 初始化图书管理模块
+ * @return 成功返回0，失败返回非0值
+ */
+int book_init() {
+    // 热数据和冷数据数组按需分块分配
+    if (chunk_array_init(&book_hot, sizeof(BookHot)) != 0) {
+        return -1;
+    }
+    
+    if (chunk_array_init(&book_cold, sizeof(BookCold)) != 0) {
+        chunk_array_free(&book_hot);
+        return -1;
+    }
+    
+    book_count = 0;
+    book_deleted = 0;
+    book_free_count = 0;
+    
+    // 分配作者和出版社的字符串池
+    if (string_pool_init(&book_strings) != 0) {
+        chunk_array_free(&book_cold);
+        chunk_array_free(&book_hot);
+        return -1;
+    }
+    
+    // 分配标题和ISBN的文本区
+    if (text_arena_init(&book_text, 0) != 0) {
+        string_pool_free(&book_strings);
+        chunk_array_free(&book_cold);
+        chunk_array_free(&book_hot);
+        return -1;
+    }
+    
+    // 分配ID索引
+    if (id_index_init(&book_id_index, CHUNK_ARRAY_RECORDS, book_key_of, NULL) != 0) {
+        text_arena_free(&book_text);
+        string_pool_free(&book_strings);
+        chunk_array_free(&book_cold);
+        chunk_array_free(&book_hot);
+        return -1;
+    }
+    
+    // 分配标题索引
+    if (trigram_index_init(&book_title_index) != 0) {
+        id_index_free(&book_id_index);
+        text_arena_free(&book_text);
+        string_pool_free(&book_strings);
+        chunk_array_free(&book_cold);
+        chunk_array_free(&book_hot);
+        return -1;
+    }
+    
+    // 分配折叠列、年份索引、可借位图、模糊查找索引和全文检索索引
+    if (book_secondary_init() != 0) {
+        trigram_index_free(&book_title_index);
+        id_index_free(&book_id_index);
+        text_arena_free(&book_text);
+        string_pool_free(&book_strings);
+        chunk_array_free(&book_cold);
+        chunk_array_free(&book_hot);
+        return -1;
+    }
+    
+    // 打开变更日志
+    if (journal_open(&book_journal, BOOKS_JOURNAL_FILE, BOOK_JOURNAL_MIN_COMPACT) != 0) {
+        book_secondary_free();
+        trigram_index_free(&book_title_index);
+        id_index_free(&book_id_index);
+        text_arena_free(&book_text);
+        string_pool_free(&book_strings);
+        chunk_array_free(&book_cold);
+        chunk_array_free(&book_hot);
+        return -1;
+    }
+    
+    // 加载数据
+    return book_load_data();
+}
+
+/**
+ * @brief 添加新图书
+ * @param book 要添加的图书信息
+ * @return 成功返回0，失败返回非0值
+ */
+int book_add(Book *book) {
+    if (book == NULL) {
+        return -1;
+    }
+    
+    // 生成ID（如果没有）
+    if (strlen(book->id) == 0) {
+        generate_id("B", book->id, sizeof(book->id));
+    }
+    
+    // 添加图书（优先复用已删除的位置）
+    BookRecord record;
+    if (book_record_from(&record, book) != 0 || book_insert(&record) != 0) {
+        return -1;
+    }
+    
+    // 记录日志
+    return book_log_put(book);
+}
+
+/**
+ * @brief 根据ID删除图书
+ * @param id 图书ID
+ * @return 成功返回0，失败返回非0值
+ */
+int book_delete(const char *id) {
+    if (id == NULL) {
+        return -1;
+    }
+    
+    // 查找图书
+    int index = book_index_of(id);
+    if (index == -1) {
+        return -1;
+    }
+    
+    // 删除图书（只标记位置，不移动其他图书）
+    book_remove_at(index);
+    
+    // 记录日志
+    return book_log_delete(id);
+}
+
+/**
+ * @brief 更新图书信息
+ * @param book 更新后的图书信息
+ * @return 成功返回0，失败返回非0值
+ */
+int book_update(Book *book) {
+    if (book == NULL) {
+        return -1;
+    }
+    
+    // 查找图书
+    int index = book_index_of(book->id);
+    if (index == -1) {
+        return -1;
+    }
+    
+    // 更新图书
+    BookRecord record;
+    if (book_record_from(&record, book) != 0 || book_store_at(index, &record) != 0) {
+        return -1;
+    }
+    
+    // 记录日志
+    return book_log_put(book);
+}
+
+/**
+ * @brief 根据ID查找图书
+ * @param id 图书ID
+ * @param book 用于存储查找结果的图书结构体指针
+ * @return 成功返回0，失败返回非0值
+ */
+int book_find_by_id(const char *id, Book *book) {
+    if (id == NULL || book == NULL) {
+        return -1;
+    }
+    
+    // 通过ID索引查找图书
+    int index = book_index_of(id);
+    if (index == -1) {
+        return -1;
+    }
+    
+    book_materialize(index, book);
+    return 0;
+}
+
+/**
+ * @brief 根据ID取图书句柄
+ * @param id 图书ID
+ * @return 找到返回句柄，否则返回-1
+ */
+BookHandle book_lookup(const char *id) {
+    if (id == NULL) {
+        return -1;
+    }
+    
+    int index = book_index_of(id);
+    if (index == -1) {
+        return -1;
+    }
+    
+    // 高32位是代数，低32位是下标
+    return (BookHandle)book_hot_at(index)->generation << 32 | index;
+}
+
+/**
+ * @brief 取句柄指向的图书下标
+ *
+ * 图书被删除、位置被复用、整理时被移走或数据重新加载后，
+ * 该位置的代数与句柄中的不再相同，句柄随之失效。
+ *
+ * @param handle 图书句柄
+ * @return 有效返回下标，句柄无效或已过期返回-1
+ */
+static int book_handle_index(BookHandle handle) {
+    if (handle < 0 || (handle & 0xFFFFFFFF) >= book_count) {
+        return -1;
+    }
+    
+    int index = (int)(handle & 0xFFFFFFFF);
+    if (!bitmap_get(&book_used, index) || book_hot_at(index)->generation != (unsigned int)(handle >> 32)) {
+        return -1;
+    }
+    return index;
+}
+
+/**
+ * @brief 取句柄对应的图书
+ * @param handle 图书句柄
+ * @param book 用于存储图书信息
+ * @return 成功返回0，句柄无效时返回非0值
+ */
+int book_get(BookHandle handle, Book *book) {
+    int index = book_handle_index(handle);
+    if (book == NULL || index == -1) {
+        return -1;
+    }
+    
+    book_materialize(index, book);
+    return 0;
+}
+
+/**
+ * @brief 取句柄对应图书的可借数量，不复制图书
+ * @param handle 图书句柄
+ * @return 可借数量，句柄无效时返回-1
+ */
+int book_available_count(BookHandle handle) {
+    int index = book_handle_index(handle);
+    if (index == -1) {
+        return -1;
+    }
+    
+    return book_hot_at(index)->available_count;
+}
+
+/**
+ * @brief 原地调整图书的可借数量并记录日志
+ *
+ * 只有可借位图依赖可借数量，不必像book_update那样重新建立各个文本索引；
+ * 日志也只记ID和数量，整个过程不访问标题等冷数据。
+ *
+ * @param handle 图书句柄
+ * @param delta 可借数量的增量（借出为-1，归还为1）
+ * @return 成功返回0，句柄无效或可借数量将小于0时返回非0值
+ */
+int book_adjust_available(BookHandle handle, int delta) {
+    int index = book_handle_index(handle);
+    if (index == -1) {
+        return -1;
+    }
+    
+    BookHot *current = book_hot_at(index);
+    if (current->available_count + delta < 0) {
+        return -1;
+    }
+    
+    current->available_count += delta;
+    bitmap_set(&book_available, index, current->available_count > 0);
+    
+    // 记录日志（只访问热数据）
+    return book_log_count(current);
+}
+
+/**
+ * @brief 在折叠列中逐条查找包含查询串的图书
+ * @param column 折叠列
+ * @param text 查询串
+ * @param result_books 用于存储查找结果的图书结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的图书数量
+ */
+static int book_find_in_column(const FoldColumn *column, const char *text, Book *result_books, int max_count) {
+    if (text == NULL || result_books == NULL || max_count <= 0) {
+        return 0;
+    }
+    
+    FoldPattern pattern;
+    if (fold_pattern_init(&pattern, text) != 0) {
+        return 0;
+    }
+    
+    int count = 0;
+    for (int i = fold_column_next(column, 0, &pattern); i != -1 && count < max_count;
+         i = fold_column_next(column, i + 1, &pattern)) {
+        // 已删除位置的折叠文本为空串，空查询串也会命中
+        if (!bitmap_get(&book_used, i)) {
+            continue;
+        }
+        book_materialize(i, &result_books[count]);
+        count++;
+    }
+    
+    fold_pattern_free(&pattern);
+    return count;
+}
+
+/**
+ * @brief 根据标题查找图书
+ * @param title 图书标题
+ * @param result_books 用于存储查找结果的图书结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的图书数量
+ */
+int book_find_by_title(const char *title, Book *result_books, int max_count) {
+    if (title == NULL || result_books == NULL || max_count <= 0) {
+        return 0;
+    }
+    
+    int *candidates;
+    int candidate_count = trigram_index_query(&book_title_index, title, &candidates);
+    
+    // 查询串太短无法使用索引时扫描整个折叠列
+    if (candidate_count < 0) {
+        return book_find_in_column(&book_title_folded, title, result_books, max_count);
+    }
+    
+    FoldPattern pattern;
+    if (fold_pattern_init(&pattern, title) != 0) {
+        free(candidates);
+        return 0;
+    }
+    
+    // 候选按下标升序，逐个验证
+    int count = 0;
+    for (int i = 0; i < candidate_count && count < max_count; i++) {
+        if (fold_column_match(&book_title_folded, candidates[i], &pattern)) {
+            book_materialize(candidates[i], &result_books[count]);
+            count++;
+        }
+    }
+    
+    fold_pattern_free(&pattern);
+    free(candidates);
+    return count;
+}
+
+/**
+ * @brief 根据作者查找图书
+ * @param author 作者
+ * @param result_books 用于存储查找结果的图书结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的图书数量
+ */
+int book_find_by_author(const char *author, Book *result_books, int max_count) {
+    return book_find_in_column(&book_author_folded, author, result_books, max_count);
+}
+
+/**
+ * @brief 根据出版社查找图书
+ * @param publisher 出版社
+ * @param result_books 用于存储查找结果的图书结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的图书数量
+ */
+int book_find_by_publisher(const char *publisher, Book *result_books, int max_count) {
+    return book_find_in_column(&book_publisher_folded, publisher, result_books, max_count);
+}
+
+/**
+ * @brief 查找出版年份在指定范围内的图书
+ * @param min_year 起始年份（含）
+ * @param max_year 结束年份（含）
+ * @param result_books 用于存储查找结果的图书结构体数组，按出版年份升序，同年按存储顺序
+ * @param max_count 最大返回数量
+ * @return 返回找到的图书数量
+ */
+int book_find_by_year_range(int min_year, int max_year, Book *result_books, int max_count) {
+    if (result_books == NULL || max_count <= 0) {
+        return 0;
+    }
+    
+    int first;
+    int count = range_index_find(&book_year_index, min_year, max_year, &first);
+    if (count > max_count) {
+        count = max_count;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        book_materialize(book_year_index.entries[first + i].row, &result_books[i]);
+    }
+    
+    return count;
+}
+
+/**
+ * @brief 统计出版年份在指定范围内的图书数量
+ * @param min_year 起始年份（含）
+ * @param max_year 结束年份（含）
+ * @return 图书数量
+ */
+int book_count_by_year_range(int min_year, int max_year) {
+    int first;
+    return range_index_find(&book_year_index, min_year, max_year, &first);
+}
+
+/**
+ * @brief 查找当前可借（可借数量大于0）的图书
+ * @param result_books 用于存储查找结果的图书结构体数组，按存储顺序
+ * @param max_count 最大返回数量
+ * @return 返回找到的图书数量
+ */
+int book_find_available(Book *result_books, int max_count) {
+    if (result_books == NULL || max_count <= 0) {
+        return 0;
+    }
+    
+    int count = 0;
+    for (int i = bitmap_next(&book_available, 0); i != -1 && count < max_count;
+         i = bitmap_next(&book_available, i + 1)) {
+        book_materialize(i, &result_books[count]);
+        count++;
+    }
+    
+    return count;
+}
+
+/**
+ * @brief 按标题和作者模糊查找图书，容忍拼写错误
+ * @param query 查询串
+ * @param matches 用于存储查找结果，按编辑距离之和升序，同距离按存储顺序
+ * @param max_count 最大返回数量
+ * @return 返回找到的图书数量
+ */
+int book_find_fuzzy(const char *query, BookFuzzyMatch *matches, int max_count) {
+    if (query == NULL || matches == NULL || max_count <= 0) {
+        return 0;
+    }
+    
+    FuzzyMatch *found = (FuzzyMatch *)malloc(sizeof(FuzzyMatch) * max_count);
+    if (found == NULL) {
+        return 0;
+    }
+    
+    int count = fuzzy_index_search(&book_fuzzy_index, query, found, max_count);
+    for (int i = 0; i < count; i++) {
+        book_materialize(found[i].doc, &matches[i].book);
+        matches[i].distance = found[i].distance;
+    }
+    
+    free(found);
+    return count > 0 ? count : 0;
+}
+
+/**
+ * @brief 在标题、作者、出版社中全文检索图书，按相关度排序
+ * @param query 查询串
+ * @param cursor 翻页游标，为NULL时返回第一页
+ * @param hits 用于存储查找结果，按评分降序，同分按存储顺序
+ * @param max_count 本页最大返回数量
+ * @return 返回本页的图书数量
+ */
+int book_search(const char *query, BookSearchCursor *cursor, BookSearchHit *hits, int max_count) {
+    if (query == NULL || hits == NULL || max_count <= 0) {
+        return 0;
+    }
+    
+    // 取前offset + max_count名，再跳过前几页
+    int offset = cursor != NULL && cursor->offset > 0 ? cursor->offset : 0;
+    int live = book_live_count();
+    if (offset >= live) {
+        return 0;
+    }
+    
+    int wanted = offset + max_count < live ? offset + max_count : live;
+    TextHit *top = (TextHit *)malloc(sizeof(TextHit) * wanted);
+    if (top == NULL) {
+        return 0;
+    }
+    
+    int count = 0;
+    int found = text_index_search(&book_text_index, query, top, wanted);
+    for (int i = offset; i < found; i++) {
+        book_materialize(top[i].doc, &hits[count].book);
+        hits[count].score = top[i].score;
+        count++;
+    }
+    
+    free(top);
+    if (cursor != NULL) {
+        cursor->offset = offset + count;
+    }
+    return count;
+}
+
+/**
+ * @brief 查询的访问路径
+ */
+typedef enum {
+    BOOK_ACCESS_SCAN = 0,   /**< 逐条扫描图书数组 */
+    BOOK_ACCESS_COLUMN,     /**< 在折叠列上用memmem跳到下一条命中的图书 */
+    BOOK_ACCESS_ID,         /**< ID哈希索引 */
+    BOOK_ACCESS_TITLE,      /**< 标题三元组索引 */
+    BOOK_ACCESS_YEAR,       /**< 出版年份有序索引 */
+    BOOK_ACCESS_AVAILABLE   /**< 可借位图 */
+} BookAccess;
+
+/**
+ * @brief 查询结果游标
+ */
+struct BookCursor {
+    BookPredicate *predicates;  /**< 条件副本（文本也已复制） */
+    FoldPattern *patterns;      /**< 各条件折叠后的查询串（只有BOOK_OP_CONTAINS使用） */
+    int *strings;               /**< 各条件的比较值在字符串池中的编号，-1表示没有（只有作者、出版社的BOOK_OP_EQUALS使用） */
+    int predicate_count;        /**< 条件个数 */
+    BookAccess access;          /**< 访问路径 */
+    int driver;                 /**< 驱动扫描的条件下标，逐条扫描时为-1 */
+    int *rows;                  /**< 索引给出的候选下标（升序） */
+    int row_count;              /**< 候选数量 */
+    int estimate;               /**< 计划时估计的候选数量 */
+    int position;               /**< 扫描位置 */
+    int examined;               /**< 已检查的图书数 */
+    int matched;                /**< 已返回的图书数 */
+};
+
+static const char *book_field_names[] = {
+    "id", "title", "author", "publisher", "isbn", "publish_year", "total_count", "available_count"
+};
 
 /**
- * @brief 初始化图书管理模块
- * @return 成功返回0，失败返回非0值
+ * @brief 判断字段是否是文本字段
+ * @param field 字段
+ * @return 是返回1，否则返回0
  */
-int book_init() {
-    // 分配内存
-    books = (Book *)malloc(sizeof(Book) * MAX_BOOKS);
-    if (books == NULL) {
-        return -1;
-    }
-    
-    book_capacity = MAX_BOOKS;
-    book_count = 0;
+static int book_field_is_text(BookField field) {
+    return field >= BOOK_FIELD_ID && field <= BOOK_FIELD_ISBN;
+}
+
+/**
+ * @brief 取图书的文本字段
+ * @param row 图书下标
+ * @param field 字段（必须是文本字段）
+ * @return 字段内容
+ */
+static const char *book_text_field(int row, BookField field) {
+    const BookCold *cold = book_cold_at(row);
     
-    // 加载数据
-    return book_load_data();
+    switch (field) {
+        case BOOK_FIELD_ID: return book_hot_at(row)->id;
+        case BOOK_FIELD_TITLE: return book_title_of(cold);
+        case BOOK_FIELD_AUTHOR: return book_string(cold->author);
+        case BOOK_FIELD_PUBLISHER: return book_string(cold->publisher);
+        default: return text_arena_get(&book_text, cold->isbn);
+    }
 }
 
 /**
- * @brief 添加新图书
- * @param book 要添加的图书信息
- * @return 成功返回0，失败返回非0值
+ * @brief 取图书的数值字段（数量在热数据中，只有出版年份需要访问冷数据）
+ * @param row 图书下标
+ * @param field 字段（必须是数值字段）
+ * @return 字段值
  */
-int book_add(Book *book) {
-    if (book == NULL) {
-        return -1;
+static int book_number_field(int row, BookField field) {
+    switch (field) {
+        case BOOK_FIELD_PUBLISH_YEAR: return book_cold_at(row)->publish_year;
+        case BOOK_FIELD_TOTAL_COUNT: return book_hot_at(row)->total_count;
+        default: return book_hot_at(row)->available_count;
+    }
+}
+
+/**
+ * @brief 取字段对应的折叠列
+ * @param field 字段
+ * @return 有折叠列返回折叠列，否则返回NULL
+ */
+static const FoldColumn *book_fold_column_of(BookField field) {
+    switch (field) {
+        case BOOK_FIELD_TITLE: return &book_title_folded;
+        case BOOK_FIELD_AUTHOR: return &book_author_folded;
+        case BOOK_FIELD_PUBLISHER: return &book_publisher_folded;
+        default: return NULL;
     }
+}
+
+/**
+ * @brief 检查图书是否满足一个条件
+ * @param cursor 游标
+ * @param i 条件下标
+ * @param row 图书下标
+ * @return 满足返回1，否则返回0
+ */
+static int book_predicate_match(const BookCursor *cursor, int i, int row) {
+    const BookPredicate *predicate = &cursor->predicates[i];
     
-    // 检查容量
-    if (book_count >= book_capacity) {
-        return -1;
+    if (!book_field_is_text(predicate->field)) {
+        int value = book_number_field(row, predicate->field);
+        if (predicate->op == BOOK_OP_EQUALS) {
+            return value == predicate->min;
+        }
+        return value >= predicate->min && value <= predicate->max;
     }
     
-    // 生成ID（如果没有）
-    if (strlen(book->id) == 0) {
-        generate_id("B", book->id, sizeof(book->id));
+    // 作者和出版社只需比较字符串池中的编号
+    if (predicate->op == BOOK_OP_EQUALS && predicate->field == BOOK_FIELD_AUTHOR) {
+        return book_cold_at(row)->author == cursor->strings[i];
+    }
+    if (predicate->op == BOOK_OP_EQUALS && predicate->field == BOOK_FIELD_PUBLISHER) {
+        return book_cold_at(row)->publisher == cursor->strings[i];
+    }
+    if (predicate->op == BOOK_OP_EQUALS) {
+        return strcmp(book_text_field(row, predicate->field), predicate->text) == 0;
     }
     
-    // 添加图书
-    memcpy(&books[book_count], book, sizeof(Book));
-    book_count++;
+    const FoldColumn *column = book_fold_column_of(predicate->field);
+    if (column != NULL) {
+        return fold_column_match(column, row, &cursor->patterns[i]);
+    }
     
-    // 保存数据
-    return book_save_data();
+    return contains_ignore_case(book_text_field(row, predicate->field), predicate->text);
 }
 
 /**
- * @brief 根据ID删除图书
- * @param id 图书ID
+ * @brief 比较两个整数（qsort回调）
+ */
+static int book_compare_rows(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/**
+ * @brief 为查询选择访问路径：取候选最少的索引，没有可用索引时在折叠列上扫描或逐条扫描
+ * @param cursor 游标
  * @return 成功返回0，失败返回非0值
  */
-int book_delete(const char *id) {
-    if (id == NULL) {
-        return -1;
-    }
+static int book_query_plan(BookCursor *cursor) {
+    cursor->access = BOOK_ACCESS_SCAN;
+    cursor->driver = -1;
+    cursor->rows = NULL;
+    cursor->row_count = book_count;
+    cursor->estimate = book_live_count();
+    int year_first = 0;
     
-    // 查找图书
-    int index = -1;
-    for (int i = 0; i < book_count; i++) {
-        if (strcmp(books[i].id, id) == 0) {
-            index = i;
-            break;
+    for (int i = 0; i < cursor->predicate_count; i++) {
+        const BookPredicate *predicate = &cursor->predicates[i];
+        int *rows = NULL;
+        int count = -1;
+        BookAccess access = BOOK_ACCESS_SCAN;
+        
+        if (predicate->field == BOOK_FIELD_ID && predicate->op == BOOK_OP_EQUALS) {
+            int index = book_index_of(predicate->text);
+            rows = (int *)malloc(sizeof(int));
+            if (rows == NULL) {
+                return -1;
+            }
+            rows[0] = index;
+            count = index == -1 ? 0 : 1;
+            access = BOOK_ACCESS_ID;
+        } else if (predicate->field == BOOK_FIELD_TITLE) {
+            // 完全相同也意味着包含，同样可以用三元组索引缩小范围
+            count = trigram_index_query(&book_title_index, predicate->text, &rows);
+            access = BOOK_ACCESS_TITLE;
+        } else if (predicate->field == BOOK_FIELD_PUBLISH_YEAR) {
+            // 先只用二分查找估计数量，选中后再取出候选
+            int max = predicate->op == BOOK_OP_EQUALS ? predicate->min : predicate->max;
+            int first;
+            count = range_index_find(&book_year_index, predicate->min, max, &first);
+            if (cursor->driver == -1 || count < cursor->estimate) {
+                year_first = first;
+            }
+            access = BOOK_ACCESS_YEAR;
+        } else if (predicate->field == BOOK_FIELD_AVAILABLE_COUNT && predicate->min >= 1) {
+            // 可借数量至少为1的条件只会命中位图中置位的图书
+            count = book_available.ones;
+            access = BOOK_ACCESS_AVAILABLE;
+        }
+        
+        if (count < 0) {
+            continue;
         }
+        
+        if (cursor->driver != -1 && count >= cursor->estimate) {
+            free(rows);
+            continue;
+        }
+        
+        free(cursor->rows);
+        cursor->access = access;
+        cursor->driver = i;
+        cursor->rows = rows;
+        cursor->row_count = count;
+        cursor->estimate = count;
     }
     
-    if (index == -1) {
-        return -1;
+    // 年份索引按年份排列，取出候选后按下标排序，结果仍按图书顺序返回
+    if (cursor->access == BOOK_ACCESS_YEAR && cursor->row_count > 0) {
+        cursor->rows = (int *)malloc(sizeof(int) * cursor->row_count);
+        if (cursor->rows == NULL) {
+            return -1;
+        }
+        for (int i = 0; i < cursor->row_count; i++) {
+            cursor->rows[i] = book_year_index.entries[year_first + i].row;
+        }
+        qsort(cursor->rows, cursor->row_count, sizeof(int), book_compare_rows);
     }
     
-    // 删除图书（移动后面的元素）
-    for (int i = index; i < book_count - 1; i++) {
-        memcpy(&books[i], &books[i + 1], sizeof(Book));
+    // 没有可用的索引时，若有对标题、作者、出版社的包含条件，用memmem在折叠列上跳过不命中的图书
+    if (cursor->driver == -1) {
+        for (int i = 0; i < cursor->predicate_count; i++) {
+            if (cursor->predicates[i].op == BOOK_OP_CONTAINS && book_fold_column_of(cursor->predicates[i].field) != NULL) {
+                cursor->access = BOOK_ACCESS_COLUMN;
+                cursor->driver = i;
+                break;
+            }
+        }
     }
     
-    book_count--;
-    
-    // 保存数据
-    return book_save_data();
+    return 0;
 }
 
 /**
- * @brief 更新图书信息
- * @param book 更新后的图书信息
- * @return 成功返回0，失败返回非0值
+ * @brief 按条件查询图书
+ * @param predicates 条件数组（内容会被复制）
+ * @param count 条件个数，0表示查询全部图书
+ * @return 成功返回游标，条件不合法或失败返回NULL
  */
-int book_update(Book *book) {
-    if (book == NULL) {
-        return -1;
+BookCursor *book_query_open(const BookPredicate *predicates, int count) {
+    if (count < 0 || (count > 0 && predicates == NULL)) {
+        return NULL;
     }
     
-    // 查找图书
-    int index = -1;
-    for (int i = 0; i < book_count; i++) {
-        if (strcmp(books[i].id, book->id) == 0) {
-            index = i;
-            break;
+    // 检查条件
+    for (int i = 0; i < count; i++) {
+        const BookPredicate *predicate = &predicates[i];
+        int is_text = book_field_is_text(predicate->field);
+        
+        if (predicate->field < BOOK_FIELD_ID || predicate->field > BOOK_FIELD_AVAILABLE_COUNT) {
+            return NULL;
+        }
+        if (is_text && (predicate->text == NULL || predicate->op == BOOK_OP_BETWEEN)) {
+            return NULL;
+        }
+        if (!is_text && predicate->op == BOOK_OP_CONTAINS) {
+            return NULL;
         }
     }
     
-    if (index == -1) {
-        return -1;
+    BookCursor *cursor = (BookCursor *)calloc(1, sizeof(BookCursor));
+    if (cursor == NULL) {
+        return NULL;
     }
     
-    // 更新图书
-    memcpy(&books[index], book, sizeof(Book));
+    cursor->predicates = (BookPredicate *)calloc(count > 0 ? count : 1, sizeof(BookPredicate));
+    cursor->patterns = (FoldPattern *)calloc(count > 0 ? count : 1, sizeof(FoldPattern));
+    cursor->strings = (int *)calloc(count > 0 ? count : 1, sizeof(int));
+    if (cursor->predicates == NULL || cursor->patterns == NULL || cursor->strings == NULL) {
+        book_query_close(cursor);
+        return NULL;
+    }
+    
+    // 复制条件，包含条件预先折叠，相等条件预先查出字符串编号
+    for (int i = 0; i < count; i++) {
+        cursor->predicates[i] = predicates[i];
+        cursor->predicates[i].text = NULL;
+        cursor->predicate_count++;
+        
+        if (predicates[i].text == NULL) {
+            continue;
+        }
+        
+        cursor->predicates[i].text = strdup(predicates[i].text);
+        if (cursor->predicates[i].text == NULL) {
+            book_query_close(cursor);
+            return NULL;
+        }
+        
+        if (predicates[i].op == BOOK_OP_CONTAINS && fold_pattern_init(&cursor->patterns[i], predicates[i].text) != 0) {
+            book_query_close(cursor);
+            return NULL;
+        }
+        
+        // 池中没有的作者或出版社不会与任何图书相同，编号-1也不会与任何图书相等
+        cursor->strings[i] = string_pool_find(&book_strings, predicates[i].text);
+    }
+    
+    if (book_query_plan(cursor) != 0) {
+        book_query_close(cursor);
+        return NULL;
+    }
     
-    // 保存数据
-    return book_save_data();
+    return cursor;
 }
 
 /**
- * @brief 根据ID查找图书
- * @param id 图书ID
- * @param book 用于存储查找结果的图书结构体指针
- * @return 成功返回0，失败返回非0值
+ * @brief 取下一条查询结果
+ * @param cursor 游标
+ * @param book 用于存储图书信息
+ * @return 取到返回1，没有更多结果返回0
  */
-int book_find_by_id(const char *id, Book *book) {
-    if (id == NULL || book == NULL) {
-        return -1;
+int book_query_next(BookCursor *cursor, Book *book) {
+    if (cursor == NULL || book == NULL) {
+        return 0;
     }
     
-    // 查找图书
-    for (int i = 0; i < book_count; i++) {
-        if (strcmp(books[i].id, id) == 0) {
-            memcpy(book, &books[i], sizeof(Book));
-            return 0;
+    for (;;) {
+        int row;
+        
+        if (cursor->access == BOOK_ACCESS_COLUMN || cursor->access == BOOK_ACCESS_AVAILABLE) {
+            int driver = cursor->driver;
+            if (cursor->access == BOOK_ACCESS_COLUMN) {
+                row = fold_column_next(book_fold_column_of(cursor->predicates[driver].field),
+                                       cursor->position, &cursor->patterns[driver]);
+            } else {
+                row = bitmap_next(&book_available, cursor->position);
+            }
+            if (row == -1) {
+                cursor->position = book_count;
+                return 0;
+            }
+            cursor->position = row + 1;
+        } else {
+            int limit = cursor->access == BOOK_ACCESS_SCAN ? book_count : cursor->row_count;
+            if (cursor->position >= limit) {
+                return 0;
+            }
+            row = cursor->rows != NULL ? cursor->rows[cursor->position] : cursor->position;
+            cursor->position++;
+        }
+        
+        // 逐条扫描时跳过已删除的位置（索引中已没有这些位置）
+        if (!bitmap_get(&book_used, row)) {
+            continue;
+        }
+        
+        // 驱动条件也重新检查：三元组索引给出的只是候选
+        cursor->examined++;
+        int matched = 1;
+        for (int i = 0; i < cursor->predicate_count && matched; i++) {
+            matched = book_predicate_match(cursor, i, row);
+        }
+        
+        if (matched) {
+            book_materialize(row, book);
+            cursor->matched++;
+            return 1;
         }
     }
-    
-    return -1;
 }
 
 /**
- * @brief 根据标题查找图书
- * @param title 图书标题
- * @param result_books 用于存储查找结果的图书结构体数组
- * @param max_count 最大返回数量
- * @return 返回找到的图书数量
+ * @brief 输出查询计划（所选索引、估计候选数、过滤条件以及已扫描的记录数）
+ * @param cursor 游标
+ * @param buffer 用于存储说明文字
+ * @param size 缓冲区大小
  */
-int book_find_by_title(const char *title, Book *result_books, int max_count) {
-    if (title == NULL || result_books == NULL || max_count <= 0) {
-        return 0;
+void book_query_explain(const BookCursor *cursor, char *buffer, size_t size) {
+    static const char *access_names[] = {
+        "full scan", "folded column scan", "id hash index", "title trigram index",
+        "publish_year range index", "availability bitmap"
+    };
+    static const char *op_names[] = {"equals", "contains", "between"};
+    
+    if (cursor == NULL || buffer == NULL || size == 0) {
+        return;
     }
     
-    int count = 0;
+    size_t len = 0;
+    len += snprintf(buffer + len, size - len, "access: %s", access_names[cursor->access]);
     
-    // 查找图书
-    for (int i = 0; i < book_count && count < max_count; i++) {
-        if (contains_ignore_case(books[i].title, title)) {
-            memcpy(&result_books[count], &books[i], sizeof(Book));
-            count++;
+    if (cursor->driver != -1 && len < size) {
+        len += snprintf(buffer + len, size - len, " on #%d", cursor->driver);
+    }
+    if (len < size) {
+        len += snprintf(buffer + len, size - len, ", estimated %d of %d books\n", cursor->estimate, book_live_count());
+    }
+    
+    for (int i = 0; i < cursor->predicate_count && len < size; i++) {
+        const BookPredicate *predicate = &cursor->predicates[i];
+        const char *field = book_field_names[predicate->field];
+        const char *op = op_names[predicate->op];
+        
+        if (book_field_is_text(predicate->field)) {
+            len += snprintf(buffer + len, size - len, "filter #%d: %s %s \"%s\"\n", i, field, op, predicate->text);
+        } else if (predicate->op == BOOK_OP_EQUALS) {
+            len += snprintf(buffer + len, size - len, "filter #%d: %s %s %d\n", i, field, op, predicate->min);
+        } else {
+            len += snprintf(buffer + len, size - len, "filter #%d: %s %s %d and %d\n", i, field, op,
+                            predicate->min, predicate->max);
         }
     }
     
-    return count;
+    if (len < size) {
+        snprintf(buffer + len, size - len, "examined %d, matched %d\n", cursor->examined, cursor->matched);
+    }
+}
+
+/**
+ * @brief 关闭游标
+ * @param cursor 游标
+ */
+void book_query_close(BookCursor *cursor) {
+    if (cursor == NULL) {
+        return;
+    }
+    
+    for (int i = 0; i < cursor->predicate_count; i++) {
+        free((char *)cursor->predicates[i].text);
+        fold_pattern_free(&cursor->patterns[i]);
+    }
+    
+    free(cursor->predicates);
+    free(cursor->patterns);
+    free(cursor->strings);
+    free(cursor->rows);
+    free(cursor);
 }
 
 /**
@@ -188,103 +2052,281 @@ int book_get_all(Book *result_books, int max_count) {
         return 0;
     }
     
-    int count = (book_count < max_count) ? book_count : max_count;
-    
-    // 复制图书
-    memcpy(result_books, books, sizeof(Book) * count);
+    int count = 0;
+    for (int i = bitmap_next(&book_used, 0); i != -1 && count < max_count; i = bitmap_next(&book_used, i + 1)) {
+        book_materialize(i, &result_books[count]);
+        count++;
+    }
     
     return count;
 }
 
 /**
- * @brief 保存图书数据到文件
- * @return 成功返回0，失败返回非0值
+ * @brief 按存储顺序遍历图书，逐条还原到同一个临时结构体中，不分配内存
+ *
+ * 回调函数拿到的不是存储中的数据：每条图书都从热数据、冷数据和文本区重新还原为完整的Book
+ * （复制全部文本字段），只是不再为所有图书分配数组。
+ * 删除图书空出的位置会被之后新增的图书复用，存储顺序不一定是录入顺序。
+ * 遍历期间（包括回调函数中）不能增删改图书。
+ *
+ * @param filter 过滤函数，返回非0的图书才交给visit，为NULL时不过滤
+ * @param offset 跳过前offset条符合条件的图书（用于翻页）
+ * @param limit 最多访问的数量（页大小），不大于0时不限
+ * @param visit 访问函数，返回非0时停止遍历
+ * @param user_data 传给filter和visit的用户数据
+ * @return 返回访问的图书数量
  */
-int book_save_data() {
-    FILE *file = fopen(BOOKS_FILE, "w");
-    if (file == NULL) {
-        return -1;
+int book_foreach(BookFilterFunc filter, int offset, int limit, BookVisitFunc visit, void *user_data) {
+    if (visit == NULL) {
+        return 0;
     }
     
-    // 写入标题行
-    fprintf(file, "id,title,author,publisher,isbn,publish_year,total_count,available_count\n");
+    // 结构体只清零一次，之后每条只补齐上一条多写的部分（见text_copy_over）
+    Book book;
+    size_t used[4] = {0};
+    memset(&book, 0, sizeof(book));
     
-    // 写入数据
-    for (int i = 0; i < book_count; i++) {
-        fprintf(file, "%s,%s,%s,%s,%s,%d,%d,%d\n",
-                books[i].id,
-                books[i].title,
-                books[i].author,
-                books[i].publisher,
-                books[i].isbn,
-                books[i].publish_year,
-                books[i].total_count,
-                books[i].available_count);
-    }
-    
-    fclose(file);
-    return 0;
+    int visited = 0;
+    for (int i = bitmap_next(&book_used, 0); i != -1; i = bitmap_next(&book_used, i + 1)) {
+        // 不过滤时，前面几页不必还原
+        if (filter == NULL && offset > 0) {
+            offset--;
+            continue;
+        }
+        
+        book_materialize_over(i, &book, used);
+        if (filter != NULL && !filter(&book, user_data)) {
+            continue;
+        }
+        
+        // 跳过前面几页
+        if (offset > 0) {
+            offset--;
+            continue;
+        }
+        
+        visited++;
+        if (visit(&book, user_data) != 0 || visited == limit) {
+            break;
+        }
+    }
+    
+    return visited;
 }
 
 /**
- * @brief 从文件加载图书数据
+ * @brief 统计作者、出版社字符串池节省的内存
+ * @param usage 用于存储统计结果
+ */
+void book_memory_usage(BookMemoryUsage *usage) {
+    if (usage == NULL) {
+        return;
+    }
+    
+    size_t slots = (size_t)book_count;
+    usage->book_count = book_live_count();
+    usage->string_count = book_strings.count;
+    usage->inline_bytes = slots * (sizeof(((Book *)0)->author) + sizeof(((Book *)0)->publisher));
+    usage->interned_bytes = slots * (sizeof(((BookCold *)0)->author) + sizeof(((BookCold *)0)->publisher)) +
+                            string_pool_memory(&book_strings);
+}
+
+/**
+ * @brief 从CSV文件加载图书数据
  * @return 成功返回0，失败返回非0值
  */
-int book_load_data() {
+static int book_load_csv() {
     // 如果文件不存在，直接返回成功
     if (!file_exists(BOOKS_FILE)) {
         return 0;
     }
     
-    FILE *file = fopen(BOOKS_FILE, "r");
-    if (file == NULL) {
+    CsvFile file;
+    if (csv_file_open(BOOKS_FILE, &file) != 0) {
         return -1;
     }
     
-    char line[MAX_LINE_SIZE];
-    char *fields[8]; // id,title,author,publisher,isbn,publish_year,total_count,available_count
+    CsvReader csv;
+    CsvField fields[BOOK_FIELD_COUNT];
+    int num_fields;
+    
+    csv_reader_init(&csv, file.data, file.len);
     
     // 跳过标题行
-    if (fgets(line, sizeof(line), file) == NULL) {
-        fclose(file);
-        return 0;
-    }
+    csv_read_record(&csv, fields, BOOK_FIELD_COUNT);
     
     // 读取数据
-    book_count = 0;
-    while (fgets(line, sizeof(line), file) != NULL && book_count < book_capacity) {
-        // 去除换行符
-        line[strcspn(line, "\n")] = '\0';
-        
-        // 解析CSV行
-        if (parse_csv_line(line, fields, 8) != 8) {
+    while ((num_fields = csv_read_record(&csv, fields, BOOK_FIELD_COUNT)) >= 0) {
+        if (num_fields != BOOK_FIELD_COUNT) {
             continue;
         }
         
-        // 填充图书结构体
-        strncpy(books[book_count].id, fields[0], sizeof(books[book_count].id) - 1);
-        books[book_count].id[sizeof(books[book_count].id) - 1] = '\0';
-        
-        strncpy(books[book_count].title, fields[1], sizeof(books[book_count].title) - 1);
-        books[book_count].title[sizeof(books[book_count].title) - 1] = '\0';
-        
-        strncpy(books[book_count].author, fields[2], sizeof(books[book_count].author) - 1);
-        books[book_count].author[sizeof(books[book_count].author) - 1] = '\0';
-        
-        strncpy(books[book_count].publisher, fields[3], sizeof(books[book_count].publisher) - 1);
-        books[book_count].publisher[sizeof(books[book_count].publisher) - 1] = '\0';
-        
-        strncpy(books[book_count].isbn, fields[4], sizeof(books[book_count].isbn) - 1);
-        books[book_count].isbn[sizeof(books[book_count].isbn) - 1] = '\0';
-        
-        books[book_count].publish_year = atoi(fields[5]);
-        books[book_count].total_count = atoi(fields[6]);
-        books[book_count].available_count = atoi(fields[7]);
+        // 容量不足时追加一块，内存耗尽时报告失败而不是丢弃后面的记录
+        if (book_reserve(book_count + 1) != 0) {
+            csv_file_close(&file);
+            return -1;
+        }
         
+        // 填充图书记录
+        BookRecord record;
+        if (book_from_fields(&record, fields) != 0 || book_write_at(book_count, &record) != 0) {
+            csv_file_close(&file);
+            return -1;
+        }
         book_count++;
     }
     
-    fclose(file);
+    csv_file_close(&file);
+    return 0;
+}
+
+/**
+ * @brief 检查快照中的文本引用是否落在文本区内
+ * @param ref 文本引用
+ * @return 有效返回非0值，越界返回0
+ */
+static int book_text_valid(TextRef ref) {
+    return (size_t)ref.offset + ref.length < book_text.used;
+}
+
+/**
+ * @brief 清空文本区和字符串池（快照加载失败、改从CSV加载之前调用）
+ */
+static void book_clear_storage() {
+    string_pool_clear(&book_strings);
+    text_arena_clear(&book_text);
+}
+
+/**
+ * @brief 从二进制快照加载图书数据
+ *
+ * 热数据和冷数据按块整块复制，文本区和字符串池各复制一次，不逐本转换；
+ * 只为每本图书分配新的代数，并检查文本和字符串的引用没有越界。
+ *
+ * @return 成功返回0，快照不存在、已过期或校验失败返回非0值
+ */
+static int book_load_snapshot() {
+    if (!file_exists(BOOKS_SNAPSHOT_FILE)) {
+        return -1;
+    }
+    
+    // CSV在快照写出后被修改或替换过（例如手工编辑了CSV文件）时快照失效，以CSV为准
+    static const uint32_t sizes[4] = {sizeof(BookHot), sizeof(BookCold), 1, 1};
+    SnapshotView view;
+    if (snapshot_open(BOOKS_SNAPSHOT_FILE, BOOKS_FILE, BOOK_SNAPSHOT_TYPE, sizes, 4, &view) != 0) {
+        return -1;
+    }
+    
+    size_t count = view.sections[0].count;
+    if (count > (size_t)INT_MAX || view.sections[1].count != count || book_reserve((int)count) != 0 ||
+        text_arena_load(&book_text, (const char *)view.sections[2].records, view.sections[2].count) != 0 ||
+        string_pool_load(&book_strings, (const char *)view.sections[3].records, view.sections[3].count) != 0) {
+        snapshot_close(&view);
+        book_clear_storage();
+        return -1;
+    }
+    
+    chunk_array_write(&book_hot, 0, view.sections[0].records, (int)count);
+    chunk_array_write(&book_cold, 0, view.sections[1].records, (int)count);
+    snapshot_close(&view);
+    
+    // 每本图书都分配新的代数，加载前发出的句柄随之失效
+    for (int i = 0; i < (int)count; i++) {
+        BookHot *hot = book_hot_at(i);
+        const BookCold *cold = book_cold_at(i);
+        if (!book_text_valid(cold->title) || !book_text_valid(cold->isbn) ||
+            cold->author < 0 || cold->author >= book_strings.count ||
+            cold->publisher < 0 || cold->publisher >= book_strings.count) {
+            book_clear_storage();
+            return -1;
+        }
+        
+        hot->id[sizeof(hot->id) - 1] = '\0';
+        book_generation = book_generation % BOOK_GENERATION_MAX + 1;
+        hot->generation = book_generation;
+    }
+    
+    book_count = (int)count;
+    return 0;
+}
+
+/**
+ * @brief 保存图书数据到文件
+ * @return 成功返回0，失败返回非0值
+ */
+int book_save_data() {
+    // 等待后台合并结束，避免同时写同一个文件
+    journal_wait(&book_journal);
+    
+    // 数据文件中不保留已删除的位置，先整理
+    if (book_deleted > 0) {
+        book_compact_slots();
+    }
+    
+    // 连同全部文本复制出来再写出
+    BookSnapshot copy;
+    if (book_copy_live(&copy) != 0) {
+        return -1;
+    }
+    
+    int result = book_write_file(&copy);
+    book_release_copy(&copy);
+    if (result != 0) {
+        return -1;
+    }
+    
+    // 数据文件已包含全部变更，日志可以清空
+    return journal_reset(&book_journal);
+}
+
+/**
+ * @brief 从文件加载图书数据
+ * @return 成功返回0，失败返回非0值
+ */
+int book_load_data() {
+    book_count = 0;
+    book_deleted = 0;
+    book_free_count = 0;
+    
+    // 字符串池和文本区随数据一起重建，回收已不再被引用的文本
+    string_pool_clear(&book_strings);
+    text_arena_clear(&book_text);
+    
+    // 先加载最近一次完整写出的数据：优先使用二进制快照，没有可用快照时解析CSV
+    int from_csv = 0;
+    if (book_load_snapshot() != 0) {
+        book_count = 0;
+        if (book_load_csv() != 0) {
+            return -1;
+        }
+        from_csv = 1;
+    }
+    
+    // 建立索引，重放日志时按ID定位图书
+    if (book_rebuild_indexes() != 0) {
+        return -1;
+    }
+    
+    // 从CSV加载时顺便生成快照，下次启动即可直接映射（快照只对应CSV的内容，在重放日志之前写出）
+    BookSnapshot copy;
+    if (from_csv && file_exists(BOOKS_FILE) && book_copy_live(&copy) == 0) {
+        book_write_binary(&copy);
+        book_release_copy(&copy);
+    }
+    
+    // 再在其上重放变更日志
+    int replayed = journal_replay(&book_journal, book_apply_journal, NULL);
+    if (replayed < 0) {
+        return -1;
+    }
+    
+    // 日志保留下来，按与运行时相同的条件在后台合并回数据文件，启动时不重写整个数据文件；
+    // 上次合并中断留下了旧日志时无法启动新的合并，才同步写回
+    if (replayed > 0 && journal_has_old_log(&book_journal)) {
+        return book_save_data();
+    }
+    book_maybe_compact();
+    
     return 0;
 }
 
@@ -292,11 +2334,20 @@ int book_load_data() {
  * @brief 清理图书管理模块资源
  */
 void book_cleanup() {
-    if (books != NULL) {
-        free(books);
-        books = NULL;
-    }
+    journal_close(&book_journal);
+    
+    chunk_array_free(&book_hot);
+    chunk_array_free(&book_cold);
+    string_pool_free(&book_strings);
+    text_arena_free(&book_text);
+    id_index_free(&book_id_index);
+    trigram_index_free(&book_title_index);
+    book_secondary_free();
     
+    free(book_free_slots);
+    book_free_slots = NULL;
+    book_free_capacity = 0;
+    book_free_count = 0;
+    book_deleted = 0;
     book_count = 0;
-    book_capacity = 0;
 }
\ No newline at end of file
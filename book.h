@@ -9,9 +9,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 /**
  * @brief 图书结构体
+ *
+ * 模块内部按实际长度存放文本，不截断；取出到结构体时超出字段长度的文本
+ * 在完整的UTF-8字符处截断。
  */
 typedef struct {
     char id[20];          /**< 图书ID */
@@ -24,6 +28,105 @@ typedef struct {
     int available_count;  /**< 可借数量 */
 } Book;
 
+/**
+ * @brief 遍历图书时的过滤函数
+ * @param book 遍历时还原出的图书副本（只读，只在回调期间有效）
+ * @param user_data 用户数据
+ * @return 符合条件返回非0值，否则返回0
+ */
+typedef int (*BookFilterFunc)(const Book *book, void *user_data);
+
+/**
+ * @brief 遍历图书时的访问函数
+ * @param book 遍历时还原出的图书副本（只读，只在回调期间有效）
+ * @param user_data 用户数据
+ * @return 返回0继续遍历，返回非0值停止
+ */
+typedef int (*BookVisitFunc)(const Book *book, void *user_data);
+
+/**
+ * @brief 查询条件涉及的图书字段
+ */
+typedef enum {
+    BOOK_FIELD_ID = 0,           /**< 图书ID */
+    BOOK_FIELD_TITLE,            /**< 标题 */
+    BOOK_FIELD_AUTHOR,           /**< 作者 */
+    BOOK_FIELD_PUBLISHER,        /**< 出版社 */
+    BOOK_FIELD_ISBN,             /**< ISBN */
+    BOOK_FIELD_PUBLISH_YEAR,     /**< 出版年份 */
+    BOOK_FIELD_TOTAL_COUNT,      /**< 总数量 */
+    BOOK_FIELD_AVAILABLE_COUNT   /**< 可借数量 */
+} BookField;
+
+/**
+ * @brief 查询条件的比较方式
+ */
+typedef enum {
+    BOOK_OP_EQUALS = 0,   /**< 文本完全相同，或数值等于min */
+    BOOK_OP_CONTAINS,     /**< 文本包含text（不区分大小写），只用于文本字段 */
+    BOOK_OP_BETWEEN       /**< 数值在[min, max]之间，只用于数值字段 */
+} BookOp;
+
+/**
+ * @brief 查询条件，多个条件之间是“并且”的关系
+ *
+ * 例如“可借数量大于0”可以写成 {BOOK_FIELD_AVAILABLE_COUNT, BOOK_OP_BETWEEN, NULL, 1, INT_MAX}。
+ */
+typedef struct {
+    BookField field;    /**< 字段 */
+    BookOp op;          /**< 比较方式 */
+    const char *text;   /**< 文本字段的比较值 */
+    int min;            /**< 数值下限（BOOK_OP_EQUALS时为比较值） */
+    int max;            /**< 数值上限 */
+} BookPredicate;
+
+/**
+ * @brief 查询结果游标
+ */
+typedef struct BookCursor BookCursor;
+
+/**
+ * @brief 模糊查找结果
+ */
+typedef struct {
+    Book book;      /**< 图书 */
+    int distance;   /**< 查询中各词与标题、作者中最接近的词的编辑距离之和，越小越相关 */
+} BookFuzzyMatch;
+
+/**
+ * @brief 全文检索结果
+ */
+typedef struct {
+    Book book;      /**< 图书 */
+    double score;   /**< 相关度评分（BM25），越大越相关 */
+} BookSearchHit;
+
+/**
+ * @brief 全文检索翻页游标，首次查询前清零，每次查询后自动指向下一页
+ */
+typedef struct {
+    int offset;   /**< 下一页第一条结果的名次（从0开始） */
+} BookSearchCursor;
+
+/**
+ * @brief 作者、出版社字符串池的内存统计
+ */
+typedef struct {
+    int book_count;          /**< 有效图书数量 */
+    int string_count;        /**< 字符串池中不同作者、出版社的数量 */
+    size_t inline_bytes;     /**< 按定长数组逐本存放作者、出版社所需的字节数 */
+    size_t interned_bytes;   /**< 实际占用的字节数（各图书的编号加上字符串池） */
+} BookMemoryUsage;
+
+/**
+ * @brief 图书句柄（图书在内部数组中的位置及该位置的代数），-1表示不存在
+ *
+ * 新增、修改图书不会使已有句柄失效。图书被删除、所在位置被其他图书复用、
+ * 整理时被移动或数据重新加载后，句柄过期，以句柄为参数的函数返回失败，
+ * 不会访问到其他图书，此时应重新调用book_lookup。
+ */
+typedef int64_t BookHandle;
+
 /**
  * @brief 初始化图书管理模块
  * @return 成功返回0，失败返回非0值
@@ -59,6 +162,39 @@ int book_update(Book *book);
  */
 int book_find_by_id(const char *id, Book *book);
 
+/**
+ * @brief 根据ID取图书句柄
+ * @param id 图书ID
+ * @return 找到返回句柄，否则返回-1
+ */
+BookHandle book_lookup(const char *id);
+
+/**
+ * @brief 取句柄对应的图书
+ *
+ * 内部只存作者、出版社在字符串池中的编号，取出时还原为完整的Book。
+ *
+ * @param handle 图书句柄
+ * @param book 用于存储图书信息
+ * @return 成功返回0，句柄无效时返回非0值
+ */
+int book_get(BookHandle handle, Book *book);
+
+/**
+ * @brief 取句柄对应图书的可借数量，不复制图书
+ * @param handle 图书句柄
+ * @return 可借数量，句柄无效时返回-1
+ */
+int book_available_count(BookHandle handle);
+
+/**
+ * @brief 原地调整图书的可借数量并记录日志
+ * @param handle 图书句柄
+ * @param delta 可借数量的增量（借出为-1，归还为1）
+ * @return 成功返回0，句柄无效或可借数量将小于0时返回非0值
+ */
+int book_adjust_available(BookHandle handle, int delta);
+
 /**
  * @brief 根据标题查找图书
  * @param title 图书标题
@@ -68,6 +204,113 @@ int book_find_by_id(const char *id, Book *book);
  */
 int book_find_by_title(const char *title, Book *books, int max_count);
 
+/**
+ * @brief 根据作者查找图书
+ * @param author 作者
+ * @param books 用于存储查找结果的图书结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的图书数量
+ */
+int book_find_by_author(const char *author, Book *books, int max_count);
+
+/**
+ * @brief 根据出版社查找图书
+ * @param publisher 出版社
+ * @param books 用于存储查找结果的图书结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的图书数量
+ */
+int book_find_by_publisher(const char *publisher, Book *books, int max_count);
+
+/**
+ * @brief 查找出版年份在指定范围内的图书（O(log n + k)）
+ * @param min_year 起始年份（含）
+ * @param max_year 结束年份（含）
+ * @param books 用于存储查找结果的图书结构体数组，按出版年份升序，同年按存储顺序
+ * @param max_count 最大返回数量
+ * @return 返回找到的图书数量
+ */
+int book_find_by_year_range(int min_year, int max_year, Book *books, int max_count);
+
+/**
+ * @brief 统计出版年份在指定范围内的图书数量（O(log n)）
+ * @param min_year 起始年份（含）
+ * @param max_year 结束年份（含）
+ * @return 图书数量
+ */
+int book_count_by_year_range(int min_year, int max_year);
+
+/**
+ * @brief 查找当前可借（可借数量大于0）的图书
+ * @param books 用于存储查找结果的图书结构体数组，按存储顺序
+ * @param max_count 最大返回数量
+ * @return 返回找到的图书数量
+ */
+int book_find_available(Book *books, int max_count);
+
+/**
+ * @brief 按标题和作者模糊查找图书，容忍拼写错误
+ *
+ * 查询串按词切分（不区分大小写），每个词都要在标题或作者中找到足够接近的词：
+ * 不超过2个字符的词必须完全相同，3到5个字符允许1处错误，更长的允许2处错误
+ * （插入、删除、替换一个字符各算一处）。
+ *
+ * @param query 查询串，例如"progrmming pearls"
+ * @param matches 用于存储查找结果，按编辑距离之和升序，同距离按存储顺序
+ * @param max_count 最大返回数量
+ * @return 返回找到的图书数量
+ */
+int book_find_fuzzy(const char *query, BookFuzzyMatch *matches, int max_count);
+
+/**
+ * @brief 在标题、作者、出版社中全文检索图书，按相关度排序
+ *
+ * 西文按词匹配（不区分大小写），中文按相邻两字匹配，包含任意一个查询词的图书都参与排名，
+ * 标题中的词权重最高，其次是作者、出版社。只计算前几名需要的评分，不逐条扫描图书。
+ * 翻页时用同一个游标再次调用即可（两次调用之间增删改图书会使名次变化）。
+ *
+ * @param query 查询串，例如"数据结构 严蔚敏"
+ * @param cursor 翻页游标，为NULL时返回第一页
+ * @param hits 用于存储查找结果，按评分降序，同分按存储顺序
+ * @param max_count 本页最大返回数量
+ * @return 返回本页的图书数量
+ */
+int book_search(const char *query, BookSearchCursor *cursor, BookSearchHit *hits, int max_count);
+
+/**
+ * @brief 按条件查询图书
+ *
+ * 从各条件可用的索引（ID哈希、标题三元组等）中选出候选最少的一个驱动扫描，
+ * 其余条件逐条过滤。游标使用期间不能增删改图书。
+ *
+ * @param predicates 条件数组（内容会被复制）
+ * @param count 条件个数，0表示查询全部图书
+ * @return 成功返回游标，条件不合法或失败返回NULL
+ */
+BookCursor *book_query_open(const BookPredicate *predicates, int count);
+
+/**
+ * @brief 取下一条查询结果
+ * @param cursor 游标
+ * @param book 用于存储图书信息
+ * @return 取到返回1，没有更多结果返回0
+ */
+int book_query_next(BookCursor *cursor, Book *book);
+
+/**
+ * @brief 输出查询计划（所选索引、估计候选数、过滤条件以及已扫描的记录数）
+ * @param cursor 游标
+ * @param buffer 用于存储说明文字
+ * @param size 缓冲区大小
+ */
+void book_query_explain(const BookCursor *cursor, char *buffer, size_t size);
+
+/**
+ * @brief 关闭游标
+ * @param cursor 游标
+ */
+void book_query_close(BookCursor *cursor);
+
 /**
  * @brief 获取所有图书
  * @param books 用于存储图书的结构体数组
@@ -76,6 +319,29 @@ int book_find_by_title(const char *title, Book *books, int max_count);
  */
 int book_get_all(Book *books, int max_count);
 
+/**
+ * @brief 按存储顺序遍历图书，逐条还原到同一个临时结构体中，不分配内存
+ *
+ * 回调函数拿到的不是存储中的数据：每条图书都从热数据、冷数据和文本区重新还原为完整的Book
+ * （复制全部文本字段），只是不再为所有图书分配数组。
+ * 删除图书空出的位置会被之后新增的图书复用，存储顺序不一定是录入顺序。
+ * 遍历期间（包括回调函数中）不能增删改图书。
+ *
+ * @param filter 过滤函数，返回非0的图书才交给visit，为NULL时不过滤
+ * @param offset 跳过前offset条符合条件的图书（用于翻页）
+ * @param limit 最多访问的数量（页大小），不大于0时不限
+ * @param visit 访问函数，返回非0时停止遍历
+ * @param user_data 传给filter和visit的用户数据
+ * @return 返回访问的图书数量
+ */
+int book_foreach(BookFilterFunc filter, int offset, int limit, BookVisitFunc visit, void *user_data);
+
+/**
+ * @brief 统计作者、出版社字符串池节省的内存
+ * @param usage 用于存储统计结果
+ */
+void book_memory_usage(BookMemoryUsage *usage);
+
 /**
  * @brief 保存图书数据到文件
  * @return 成功返回0，失败返回非0值
@@ -6,40 +6,1267 @@
 #include "borrow.h"
 #include "book.h"
 #include "reader.h"
+#include "chunk_array.h"
+#include "csv.h"
+#include "id_index.h"
+#include "journal.h"
+#include "snapshot.h"
+#include "string_pool.h"
 #include "utils.h"
+#include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
 
-#define MAX_BORROWS 5000
 #define BORROWS_FILE "data/borrows.csv"
-#define MAX_LINE_SIZE 1024
+#define BORROWS_TMP_FILE "data/borrows.csv.tmp"
+#define BORROWS_SNAPSHOT_FILE "data/borrows.snap"
+#define BORROW_SNAPSHOT_TYPE 0x524F5242u // "BROR"
+#define BORROWS_JOURNAL_FILE "data/borrows.journal"
+#define BORROW_JOURNAL_MIN_COMPACT 256 // 日志至少累积多少条才合并
+#define BORROW_FIELD_COUNT 8
+#define BORROW_MAX_LOAD_THREADS 8 // 并行解析的最大线程数
+#define BORROW_PARALLEL_MIN_BYTES (8 * 1024 * 1024) // 自动选择线程数时每个线程至少分到的字节数
 #define DEFAULT_BORROW_DAYS 30  // 默认借阅期限（天）
 #define MAX_RENEW_COUNT 2      // 最大续借次数
 #define RENEW_DAYS 15          // 续借延长天数
+#define BORROW_ID_PREFIX "BR"  // 借阅记录ID前缀
+#define BORROW_ID_MAX_DIGITS 17 // 能编码为整数的ID最多有几位数字
+#define BORROW_ID_DIGITS_SHIFT 57 // ID编码中数字位数所在的位置
+#define BORROW_ID_POOLED (1ull << 63) // ID编码的最高位：ID不是标准格式，低位是字符串池编号
+#define BORROW_STATUS_BITS 2   // 状态字中借阅状态占的位数
+#define BORROW_STATUS_MASK ((1u << BORROW_STATUS_BITS) - 1)
 
-// 借阅记录数组
-static BorrowRecord *borrows = NULL;
+/**
+ * @brief 借阅记录链表（按记录下标升序，即借阅先后顺序）
+ */
+typedef struct {
+    int head;     /**< 第一条记录下标，-1表示空 */
+    int tail;     /**< 最后一条记录下标，-1表示空 */
+    int count;    /**< 记录数量 */
+} BorrowList;
+
+/**
+ * @brief 读者或图书在借阅模块中的键
+ */
+typedef struct {
+    char id[20];           /**< 读者ID或图书ID */
+    BorrowList active;     /**< 未归还的借阅记录 */
+    BorrowList returned;   /**< 已归还的借阅记录 */
+} BorrowKey;
+
+/**
+ * @brief 键表：把读者ID或图书ID映射为从0开始的整数键
+ */
+typedef struct {
+    BorrowKey *keys;   /**< 键数组 */
+    int count;         /**< 键数量 */
+    int capacity;      /**< 键数组容量 */
+    IdIndex index;     /**< ID到键的索引 */
+} BorrowKeyTable;
+
+/**
+ * @brief 借阅记录的内部存储形式
+ *
+ * 图书和读者用键表中的整数键代替ID字符串，时间存为32位无符号秒数（可表示到2106年），
+ * 状态和续借次数合为一个字；只在对外接口处还原为BorrowRecord。
+ */
+typedef struct {
+    uint64_t id;             /**< 借阅记录ID的编码 */
+    int book;                /**< 图书键 */
+    int reader;              /**< 读者键 */
+    uint32_t borrow_date;    /**< 借阅日期 */
+    uint32_t due_date;       /**< 应还日期 */
+    uint32_t return_date;    /**< 实际归还日期 */
+    uint32_t state;          /**< 低BORROW_STATUS_BITS位为借阅状态，其余位为续借次数 */
+} BorrowEntry;
+
+/**
+ * @brief 借阅记录在某个键的链表中的位置
+ */
+typedef struct {
+    int key;    /**< 所属的键，-1表示不在任何链表中 */
+    int prev;   /**< 前一条记录下标 */
+    int next;   /**< 后一条记录下标 */
+} BorrowLink;
+
+// 借阅记录数组（存储形式，分块存放，扩容时已有记录的地址不变）
+static ChunkArray borrow_store;
 // 借阅记录数量
 static int borrow_count = 0;
-// 借阅记录容量
+// 与借阅记录一一对应的各项索引数组的容量
 static int borrow_capacity = 0;
+// 借阅变更日志
+static Journal borrow_journal;
+// 借阅记录ID索引：按ID编码开放寻址，槽中存放记录下标，-1表示空槽
+static int *borrow_id_slots = NULL;
+// ID索引槽数减1（槽数为2的幂）
+static unsigned int borrow_id_mask = 0;
+// 不是标准格式的借阅记录ID（例如手工编辑的数据文件），按字符串池编号编码
+static StringPool borrow_id_strings;
+// 读者键表
+static BorrowKeyTable borrow_reader_keys;
+// 图书键表
+static BorrowKeyTable borrow_book_keys;
+// 每条借阅记录在所属读者链表中的位置，与借阅记录数组一一对应
+static BorrowLink *borrow_reader_links = NULL;
+// 每条借阅记录在所属图书链表中的位置，与借阅记录数组一一对应
+static BorrowLink *borrow_book_links = NULL;
+// 按应还日期排列的最小堆，只包含未归还且尚未标记为逾期的借阅记录下标
+static int *borrow_due_heap = NULL;
+// 堆中的记录数量
+static int borrow_due_heap_size = 0;
+// 每条借阅记录在堆中的位置，-1表示不在堆中，与借阅记录数组一一对应
+static int *borrow_due_heap_pos = NULL;
+// 已逾期且未归还的借阅记录
+static BorrowList borrow_overdue_list;
+// 每条借阅记录在逾期链表中的位置（key为-1表示不在链表中），与借阅记录数组一一对应
+static BorrowLink *borrow_overdue_links = NULL;
+// 借阅记录变为逾期时的回调函数
+static BorrowOverdueFunc borrow_overdue_callback = NULL;
+// 逾期回调函数的用户数据
+static void *borrow_overdue_user_data = NULL;
+// 解析借阅数据文件使用的线程数，0表示按CPU核心数自动选择
+static int borrow_load_threads = 0;
+
+/**
+ * @brief 写出数据文件时使用的借阅数据副本（与模块内部的存储形式相同，快照直接写出这几部分）
+ */
+typedef struct {
+    ChunkArray entries;   /**< 借阅记录数组副本（BorrowEntry） */
+    BorrowKey *books;     /**< 图书键数组副本 */
+    int book_count;       /**< 图书键数量 */
+    BorrowKey *readers;   /**< 读者键数组副本 */
+    int reader_count;     /**< 读者键数量 */
+    StringPool ids;       /**< 非标准格式记录ID字符串池的副本（编号与原池相同） */
+    int count;            /**< 借阅记录数量 */
+} BorrowSnapshot;
+
+/**
+ * @brief 并行加载时每个线程负责的一段数据
+ *
+ * 本段的记录直接转换为存储形式，其中的图书键、读者键和非标准格式ID编号
+ * 都指向本段自己的键表和字符串池；拼接时先把各段不同的键和ID并入全局表，
+ * 再由各段自己的线程把记录换算为全局编号写入借阅记录数组。
+ */
+typedef struct {
+    char *data;               /**< 本段CSV内容 */
+    size_t len;               /**< 本段长度 */
+    BorrowEntry *entries;     /**< 本段转换出的记录 */
+    int count;                /**< 记录数量 */
+    int capacity;             /**< 记录数组容量 */
+    StringPool ids;           /**< 本段中不是标准格式的借阅记录ID */
+    BorrowKeyTable books;     /**< 本段的图书键表 */
+    BorrowKeyTable readers;   /**< 本段的读者键表 */
+    int *book_map;            /**< 本段各图书键对应的全局键 */
+    int *reader_map;          /**< 本段各读者键对应的全局键 */
+    int *id_map;              /**< 本段各非标准格式ID对应的全局编号 */
+    int base;                 /**< 本段第一条记录在借阅记录数组中的下标 */
+    int result;               /**< 本阶段的处理结果 */
+    pthread_t thread;         /**< 工作线程 */
+    int thread_started;       /**< 是否在工作线程中运行 */
+} BorrowLoadChunk;
+
+/**
+ * @brief 取指定位置的借阅记录
+ * @param index 记录下标
+ * @return 借阅记录指针（存储形式）
+ */
+static BorrowEntry *borrow_at(int index) {
+    return (BorrowEntry *)CHUNK_ARRAY_AT(&borrow_store, index);
+}
+
+/**
+ * @brief 取借阅记录的状态
+ * @param entry 借阅记录
+ * @return 借阅状态
+ */
+static BorrowStatus borrow_status(const BorrowEntry *entry) {
+    return (BorrowStatus)(entry->state & BORROW_STATUS_MASK);
+}
+
+/**
+ * @brief 取借阅记录的续借次数
+ * @param entry 借阅记录
+ * @return 续借次数
+ */
+static int borrow_renew_count(const BorrowEntry *entry) {
+    return (int)(entry->state >> BORROW_STATUS_BITS);
+}
+
+/**
+ * @brief 修改借阅记录的状态（续借次数不变）
+ * @param entry 借阅记录
+ * @param status 借阅状态
+ */
+static void borrow_set_status(BorrowEntry *entry, BorrowStatus status) {
+    entry->state = (entry->state & ~BORROW_STATUS_MASK) | ((uint32_t)status & BORROW_STATUS_MASK);
+}
+
+/**
+ * @brief 把标准格式的借阅记录ID（前缀加1到BORROW_ID_MAX_DIGITS位数字）编码为整数
+ *
+ * 编码中同时记下数字位数，保留前导零，因此编码相等当且仅当ID相同。
+ *
+ * @param id 借阅记录ID
+ * @param code 用于存储编码
+ * @return 是标准格式返回0，否则返回-1
+ */
+static int borrow_id_encode(const char *id, uint64_t *code) {
+    size_t prefix = strlen(BORROW_ID_PREFIX);
+    if (strncmp(id, BORROW_ID_PREFIX, prefix) != 0) {
+        return -1;
+    }
+    
+    uint64_t value = 0;
+    int digits = 0;
+    for (const char *p = id + prefix; *p != '\0'; p++) {
+        if (*p < '0' || *p > '9' || digits == BORROW_ID_MAX_DIGITS) {
+            return -1;
+        }
+        value = value * 10 + (uint64_t)(*p - '0');
+        digits++;
+    }
+    
+    if (digits == 0) {
+        return -1;
+    }
+    
+    *code = ((uint64_t)digits << BORROW_ID_DIGITS_SHIFT) | value;
+    return 0;
+}
+
+/**
+ * @brief 取借阅记录ID的编码（不加入字符串池，用于查找）
+ * @param id 借阅记录ID
+ * @param code 用于存储编码
+ * @return 成功返回0，ID不可能存在时返回-1
+ */
+static int borrow_id_find_code(const char *id, uint64_t *code) {
+    if (borrow_id_encode(id, code) == 0) {
+        return 0;
+    }
+    
+    int pooled = string_pool_find(&borrow_id_strings, id);
+    if (pooled == -1) {
+        return -1;
+    }
+    
+    *code = BORROW_ID_POOLED | (uint64_t)pooled;
+    return 0;
+}
+
+/**
+ * @brief 取借阅记录ID的编码，不是标准格式的ID加入字符串池
+ * @param pool 字符串池
+ * @param id 借阅记录ID
+ * @param code 用于存储编码
+ * @return 成功返回0，内存不足返回-1
+ */
+static int borrow_id_intern(StringPool *pool, const char *id, uint64_t *code) {
+    if (borrow_id_encode(id, code) == 0) {
+        return 0;
+    }
+    
+    int pooled = string_pool_intern(pool, id);
+    if (pooled == -1) {
+        return -1;
+    }
+    
+    *code = BORROW_ID_POOLED | (uint64_t)pooled;
+    return 0;
+}
+
+/**
+ * @brief 把借阅记录ID的编码还原为字符串
+ * @param pool 非标准格式ID所在的字符串池
+ * @param code 编码
+ * @param id 用于存储ID的缓冲区
+ * @param size 缓冲区大小（不小于BorrowRecord中ID的大小）
+ */
+static void borrow_id_decode(const StringPool *pool, uint64_t code, char *id, size_t size) {
+    if (code & BORROW_ID_POOLED) {
+        strncpy(id, string_pool_get(pool, (int)(code & ~BORROW_ID_POOLED)), size - 1);
+        id[size - 1] = '\0';
+        return;
+    }
+    
+    // 标准格式的ID最长为前缀加BORROW_ID_MAX_DIGITS位数字，从低位向高位写出数字
+    size_t prefix = strlen(BORROW_ID_PREFIX);
+    int digits = (int)(code >> BORROW_ID_DIGITS_SHIFT);
+    uint64_t value = code & ((1ull << BORROW_ID_DIGITS_SHIFT) - 1);
+    
+    memcpy(id, BORROW_ID_PREFIX, prefix);
+    for (int i = digits - 1; i >= 0; i--) {
+        id[prefix + i] = (char)('0' + value % 10);
+        value /= 10;
+    }
+    id[prefix + digits] = '\0';
+}
+
+/**
+ * @brief 将借阅记录转换为字段数组
+ * @param record 借阅记录
+ * @param numbers 用于存放数字字段文本的缓冲区
+ * @param fields 用于存储字段的数组
+ */
+static void borrow_to_fields(const BorrowRecord *record, char numbers[5][24], char **fields) {
+    snprintf(numbers[0], sizeof(numbers[0]), "%ld", (long)record->borrow_date);
+    snprintf(numbers[1], sizeof(numbers[1]), "%ld", (long)record->due_date);
+    snprintf(numbers[2], sizeof(numbers[2]), "%ld", (long)record->return_date);
+    snprintf(numbers[3], sizeof(numbers[3]), "%d", record->status);
+    snprintf(numbers[4], sizeof(numbers[4]), "%d", record->renew_count);
+    
+    fields[0] = (char *)record->id;
+    fields[1] = (char *)record->book_id;
+    fields[2] = (char *)record->reader_id;
+    fields[3] = numbers[0];
+    fields[4] = numbers[1];
+    fields[5] = numbers[2];
+    fields[6] = numbers[3];
+    fields[7] = numbers[4];
+}
+
+/**
+ * @brief 用字段数组填充借阅记录结构体
+ * @param record 借阅记录
+ * @param fields 字段数组（id,book_id,reader_id,borrow_date,due_date,return_date,status,renew_count）
+ */
+static void borrow_from_fields(BorrowRecord *record, const CsvField *fields) {
+    csv_field_copy(&fields[0], record->id, sizeof(record->id));
+    csv_field_copy(&fields[1], record->book_id, sizeof(record->book_id));
+    csv_field_copy(&fields[2], record->reader_id, sizeof(record->reader_id));
+    
+    record->borrow_date = (time_t)csv_field_to_long(&fields[3]);
+    record->due_date = (time_t)csv_field_to_long(&fields[4]);
+    record->return_date = (time_t)csv_field_to_long(&fields[5]);
+    record->status = (BorrowStatus)csv_field_to_long(&fields[6]);
+    record->renew_count = (int)csv_field_to_long(&fields[7]);
+}
+
+/**
+ * @brief 计算借阅记录ID编码的哈希值
+ * @param code 编码
+ * @return 哈希值
+ */
+static unsigned int borrow_id_hash(uint64_t code) {
+    return (unsigned int)((code * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+/**
+ * @brief 按ID编码查找借阅记录在数组中的位置
+ * @param code 编码
+ * @return 找到返回下标，否则返回-1
+ */
+static int borrow_index_of_code(uint64_t code) {
+    unsigned int slot = borrow_id_hash(code) & borrow_id_mask;
+    
+    while (borrow_id_slots[slot] != -1) {
+        if (borrow_at(borrow_id_slots[slot])->id == code) {
+            return borrow_id_slots[slot];
+        }
+        slot = (slot + 1) & borrow_id_mask;
+    }
+    
+    return -1;
+}
+
+/**
+ * @brief 查找借阅记录在数组中的位置
+ * @param id 借阅记录ID
+ * @return 找到返回下标，否则返回-1
+ */
+static int borrow_index_of(const char *id) {
+    uint64_t code;
+    if (borrow_id_find_code(id, &code) != 0) {
+        return -1;
+    }
+    
+    return borrow_index_of_code(code);
+}
+
+/**
+ * @brief 把记录放入ID索引的空槽（调用方保证有空槽）
+ * @param index 记录下标
+ */
+static void borrow_id_place(int index) {
+    unsigned int slot = borrow_id_hash(borrow_at(index)->id) & borrow_id_mask;
+    
+    while (borrow_id_slots[slot] != -1) {
+        slot = (slot + 1) & borrow_id_mask;
+    }
+    
+    borrow_id_slots[slot] = index;
+}
+
+/**
+ * @brief 按借阅记录数组重建ID索引（槽数不少于再加一条记录后记录数的2倍）
+ * @param count 记录数量
+ * @return 成功返回0，内存不足返回非0值（原索引保持不变）
+ */
+static int borrow_id_rebuild(int count) {
+    unsigned int slots = 16;
+    while (slots < ((unsigned int)count + 1) * 2) {
+        slots *= 2;
+    }
+    
+    if (slots != borrow_id_mask + 1) {
+        int *grown = (int *)malloc(sizeof(int) * slots);
+        if (grown == NULL) {
+            return -1;
+        }
+        free(borrow_id_slots);
+        borrow_id_slots = grown;
+        borrow_id_mask = slots - 1;
+    }
+    
+    memset(borrow_id_slots, -1, sizeof(int) * slots);
+    for (int i = 0; i < count; i++) {
+        borrow_id_place(i);
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 将新追加的记录加入ID索引（记录下标即当前记录数，装载率超过一半时先扩容）
+ * @param index 记录下标
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int borrow_id_insert(int index) {
+    if ((unsigned int)index + 1 > (borrow_id_mask + 1) / 2 && borrow_id_rebuild(index) != 0) {
+        return -1;
+    }
+    
+    borrow_id_place(index);
+    return 0;
+}
+
+/**
+ * @brief 取键的ID（ID索引的回调函数）
+ * @param index 键
+ * @param user_data 所属的键表
+ * @return 读者ID或图书ID
+ */
+static const char *borrow_key_id(int index, void *user_data) {
+    return ((BorrowKeyTable *)user_data)->keys[index].id;
+}
+
+/**
+ * @brief 初始化键表
+ * @param table 键表
+ * @param capacity 键数组初始容量（键增多时自动扩容）
+ * @return 成功返回0，失败返回非0值
+ */
+static int borrow_key_table_init(BorrowKeyTable *table, int capacity) {
+    table->keys = (BorrowKey *)malloc(sizeof(BorrowKey) * capacity);
+    if (table->keys == NULL) {
+        return -1;
+    }
+    
+    if (id_index_init(&table->index, capacity, borrow_key_id, table) != 0) {
+        free(table->keys);
+        table->keys = NULL;
+        return -1;
+    }
+    
+    table->count = 0;
+    table->capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief 释放键表
+ * @param table 键表
+ */
+static void borrow_key_table_free(BorrowKeyTable *table) {
+    id_index_free(&table->index);
+    free(table->keys);
+    table->keys = NULL;
+    table->count = 0;
+    table->capacity = 0;
+}
+
+/**
+ * @brief 查找ID对应的键，不存在时新建
+ * @param table 键表
+ * @param id 读者ID或图书ID
+ * @return 返回键，内存不足返回-1
+ */
+static int borrow_key_intern(BorrowKeyTable *table, const char *id) {
+    int key = id_index_find(&table->index, id);
+    if (key != -1) {
+        return key;
+    }
+    
+    // 键数组只按键访问，不对外暴露地址，直接倍增
+    if (table->count >= table->capacity) {
+        int capacity = table->capacity * 2;
+        BorrowKey *keys = (BorrowKey *)realloc(table->keys, sizeof(BorrowKey) * capacity);
+        if (keys == NULL) {
+            return -1;
+        }
+        table->keys = keys;
+        table->capacity = capacity;
+    }
+    
+    key = table->count;
+    BorrowKey *entry = &table->keys[key];
+    strncpy(entry->id, id, sizeof(entry->id) - 1);
+    entry->id[sizeof(entry->id) - 1] = '\0';
+    entry->active.head = entry->active.tail = -1;
+    entry->active.count = 0;
+    entry->returned.head = entry->returned.tail = -1;
+    entry->returned.count = 0;
+    
+    if (id_index_insert(&table->index, key) != 0) {
+        return -1;
+    }
+    
+    table->count++;
+    return key;
+}
+
+/**
+ * @brief 清空键表（保留内存）
+ * @param table 键表
+ */
+static void borrow_key_table_clear(BorrowKeyTable *table) {
+    table->count = 0;
+    id_index_rebuild(&table->index, 0);
+}
+
+/**
+ * @brief 用指定的键表和字符串池把借阅记录转换为存储形式
+ * @param entry 存储形式
+ * @param record 借阅记录
+ * @param ids 非标准格式记录ID的字符串池
+ * @param books 图书键表
+ * @param readers 读者键表
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int borrow_entry_convert(BorrowEntry *entry, const BorrowRecord *record, StringPool *ids,
+                                BorrowKeyTable *books, BorrowKeyTable *readers) {
+    if (borrow_id_intern(ids, record->id, &entry->id) != 0) {
+        return -1;
+    }
+    
+    entry->book = borrow_key_intern(books, record->book_id);
+    entry->reader = borrow_key_intern(readers, record->reader_id);
+    if (entry->book == -1 || entry->reader == -1) {
+        return -1;
+    }
+    
+    entry->borrow_date = (uint32_t)record->borrow_date;
+    entry->due_date = (uint32_t)record->due_date;
+    entry->return_date = (uint32_t)record->return_date;
+    entry->state = (uint32_t)(record->renew_count > 0 ? record->renew_count : 0) << BORROW_STATUS_BITS;
+    borrow_set_status(entry, record->status);
+    return 0;
+}
+
+/**
+ * @brief 把借阅记录转换为存储形式（图书和读者ID换成键，非标准格式的记录ID加入字符串池）
+ * @param entry 存储形式
+ * @param record 借阅记录
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int borrow_entry_from(BorrowEntry *entry, const BorrowRecord *record) {
+    return borrow_entry_convert(entry, record, &borrow_id_strings, &borrow_book_keys, &borrow_reader_keys);
+}
+
+/**
+ * @brief 用指定的键数组和字符串池把存储形式还原为BorrowRecord
+ * @param entry 存储形式
+ * @param ids 非标准格式记录ID的字符串池
+ * @param books 图书键数组
+ * @param readers 读者键数组
+ * @param record 用于存储借阅记录的结构体指针
+ */
+static void borrow_entry_restore(const BorrowEntry *entry, const StringPool *ids, const BorrowKey *books,
+                                 const BorrowKey *readers, BorrowRecord *record) {
+    borrow_id_decode(ids, entry->id, record->id, sizeof(record->id));
+    memcpy(record->book_id, books[entry->book].id, sizeof(record->book_id));
+    memcpy(record->reader_id, readers[entry->reader].id, sizeof(record->reader_id));
+    record->borrow_date = (time_t)entry->borrow_date;
+    record->due_date = (time_t)entry->due_date;
+    record->return_date = (time_t)entry->return_date;
+    record->status = borrow_status(entry);
+    record->renew_count = borrow_renew_count(entry);
+}
+
+/**
+ * @brief 把指定位置的借阅记录还原为BorrowRecord
+ * @param index 记录下标
+ * @param record 用于存储借阅记录的结构体指针
+ */
+static void borrow_materialize(int index, BorrowRecord *record) {
+    borrow_entry_restore(borrow_at(index), &borrow_id_strings, borrow_book_keys.keys, borrow_reader_keys.keys, record);
+}
+
+/**
+ * @brief 按记录下标顺序把记录插入链表
+ *
+ * 新借阅的下标总是最大的，从尾部向前找插入位置通常一步就能找到。
+ *
+ * @param list 链表
+ * @param links 记录位置数组
+ * @param index 记录下标
+ */
+static void borrow_list_insert(BorrowList *list, BorrowLink *links, int index) {
+    int after = list->tail;
+    while (after != -1 && after > index) {
+        after = links[after].prev;
+    }
+    
+    int before = after == -1 ? list->head : links[after].next;
+    
+    links[index].prev = after;
+    links[index].next = before;
+    
+    if (after == -1) {
+        list->head = index;
+    } else {
+        links[after].next = index;
+    }
+    
+    if (before == -1) {
+        list->tail = index;
+    } else {
+        links[before].prev = index;
+    }
+    
+    list->count++;
+}
+
+/**
+ * @brief 从链表中移除记录
+ * @param list 链表
+ * @param links 记录位置数组
+ * @param index 记录下标
+ */
+static void borrow_list_remove(BorrowList *list, BorrowLink *links, int index) {
+    int prev = links[index].prev;
+    int next = links[index].next;
+    
+    if (prev == -1) {
+        list->head = next;
+    } else {
+        links[prev].next = next;
+    }
+    
+    if (next == -1) {
+        list->tail = prev;
+    } else {
+        links[next].prev = prev;
+    }
+    
+    links[index].prev = links[index].next = -1;
+    list->count--;
+}
+
+/**
+ * @brief 取记录按当前状态所属的链表
+ * @param table 键表
+ * @param key 键
+ * @param index 记录下标
+ * @return 链表
+ */
+static BorrowList *borrow_list_of(BorrowKeyTable *table, int key, int index) {
+    BorrowKey *entry = &table->keys[key];
+    return borrow_status(borrow_at(index)) == BORROW_STATUS_RETURNED ? &entry->returned : &entry->active;
+}
+
+/**
+ * @brief 比较堆中两条记录的先后（应还日期早的在前，相同时按下标）
+ * @param a 记录下标
+ * @param b 记录下标
+ * @return a应排在b之前返回1，否则返回0
+ */
+static int borrow_due_before(int a, int b) {
+    if (borrow_at(a)->due_date != borrow_at(b)->due_date) {
+        return borrow_at(a)->due_date < borrow_at(b)->due_date;
+    }
+    
+    return a < b;
+}
+
+/**
+ * @brief 把记录放到堆的指定位置
+ * @param pos 堆中位置
+ * @param index 记录下标
+ */
+static void borrow_due_heap_set(int pos, int index) {
+    borrow_due_heap[pos] = index;
+    borrow_due_heap_pos[index] = pos;
+}
+
+/**
+ * @brief 将堆中指定位置的记录上移到合适位置
+ * @param pos 堆中位置
+ */
+static void borrow_due_heap_up(int pos) {
+    int index = borrow_due_heap[pos];
+    
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!borrow_due_before(index, borrow_due_heap[parent])) {
+            break;
+        }
+        borrow_due_heap_set(pos, borrow_due_heap[parent]);
+        pos = parent;
+    }
+    
+    borrow_due_heap_set(pos, index);
+}
+
+/**
+ * @brief 将堆中指定位置的记录下移到合适位置
+ * @param pos 堆中位置
+ */
+static void borrow_due_heap_down(int pos) {
+    int index = borrow_due_heap[pos];
+    
+    for (;;) {
+        int child = pos * 2 + 1;
+        if (child >= borrow_due_heap_size) {
+            break;
+        }
+        if (child + 1 < borrow_due_heap_size &&
+            borrow_due_before(borrow_due_heap[child + 1], borrow_due_heap[child])) {
+            child++;
+        }
+        if (!borrow_due_before(borrow_due_heap[child], index)) {
+            break;
+        }
+        borrow_due_heap_set(pos, borrow_due_heap[child]);
+        pos = child;
+    }
+    
+    borrow_due_heap_set(pos, index);
+}
+
+/**
+ * @brief 将记录加入应还日期堆
+ * @param index 记录下标
+ */
+static void borrow_due_heap_push(int index) {
+    borrow_due_heap_set(borrow_due_heap_size, index);
+    borrow_due_heap_size++;
+    borrow_due_heap_up(borrow_due_heap_size - 1);
+}
+
+/**
+ * @brief 将记录从应还日期堆中移除
+ * @param index 记录下标
+ */
+static void borrow_due_heap_remove(int index) {
+    int pos = borrow_due_heap_pos[index];
+    if (pos == -1) {
+        return;
+    }
+    
+    borrow_due_heap_pos[index] = -1;
+    borrow_due_heap_size--;
+    
+    // 用堆尾的记录填补空位
+    if (pos < borrow_due_heap_size) {
+        int moved = borrow_due_heap[borrow_due_heap_size];
+        borrow_due_heap_set(pos, moved);
+        borrow_due_heap_up(pos);
+        borrow_due_heap_down(borrow_due_heap_pos[moved]);
+    }
+}
+
+/**
+ * @brief 把记录挂到所属读者和图书的链表上（按记录当前的键和状态）
+ * @param index 记录下标
+ */
+static void borrow_link(int index) {
+    const BorrowEntry *entry = borrow_at(index);
+    
+    borrow_reader_links[index].key = entry->reader;
+    borrow_list_insert(borrow_list_of(&borrow_reader_keys, entry->reader, index), borrow_reader_links, index);
+    
+    borrow_book_links[index].key = entry->book;
+    borrow_list_insert(borrow_list_of(&borrow_book_keys, entry->book, index), borrow_book_links, index);
+    
+    // 未归还的记录：已逾期的进逾期链表，其余的进应还日期堆
+    borrow_due_heap_pos[index] = -1;
+    borrow_overdue_links[index].key = -1;
+    
+    if (borrow_status(entry) == BORROW_STATUS_OVERDUE) {
+        borrow_overdue_links[index].key = 0;
+        borrow_list_insert(&borrow_overdue_list, borrow_overdue_links, index);
+    } else if (borrow_status(entry) != BORROW_STATUS_RETURNED) {
+        borrow_due_heap_push(index);
+    }
+}
+
+/**
+ * @brief 把记录从所属读者和图书的链表上摘下（需在修改键或状态之前调用）
+ * @param index 记录下标
+ */
+static void borrow_unlink(int index) {
+    int key = borrow_reader_links[index].key;
+    if (key != -1) {
+        borrow_list_remove(borrow_list_of(&borrow_reader_keys, key, index), borrow_reader_links, index);
+        borrow_reader_links[index].key = -1;
+    }
+    
+    key = borrow_book_links[index].key;
+    if (key != -1) {
+        borrow_list_remove(borrow_list_of(&borrow_book_keys, key, index), borrow_book_links, index);
+        borrow_book_links[index].key = -1;
+    }
+    
+    borrow_due_heap_remove(index);
+    
+    if (borrow_overdue_links[index].key != -1) {
+        borrow_list_remove(&borrow_overdue_list, borrow_overdue_links, index);
+        borrow_overdue_links[index].key = -1;
+    }
+}
+
+/**
+ * @brief 释放借阅记录的各项索引
+ */
+static void borrow_links_free() {
+    free(borrow_id_slots);
+    borrow_id_slots = NULL;
+    borrow_id_mask = 0;
+    string_pool_free(&borrow_id_strings);
+    borrow_key_table_free(&borrow_reader_keys);
+    borrow_key_table_free(&borrow_book_keys);
+    free(borrow_reader_links);
+    free(borrow_book_links);
+    free(borrow_overdue_links);
+    free(borrow_due_heap);
+    free(borrow_due_heap_pos);
+    borrow_reader_links = borrow_book_links = borrow_overdue_links = NULL;
+    borrow_due_heap = borrow_due_heap_pos = NULL;
+    borrow_due_heap_size = 0;
+    borrow_capacity = 0;
+}
+
+/**
+ * @brief 扩充一个与借阅记录一一对应的索引数组
+ * @param array 数组指针的地址
+ * @param size 每个元素的字节数
+ * @param capacity 新容量
+ * @return 成功返回0，失败返回非0值（原数组保持不变）
+ */
+static int borrow_grow_array(void **array, size_t size, int capacity) {
+    void *grown = realloc(*array, size * capacity);
+    if (grown == NULL) {
+        return -1;
+    }
+    
+    *array = grown;
+    return 0;
+}
+
+/**
+ * @brief 确保借阅记录数组和与之一一对应的各项索引数组能容纳指定数量的记录
+ *
+ * 记录数组按块追加；索引数组只按下标访问、不对外暴露地址，按倍增realloc。
+ *
+ * @param count 需要的记录数
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int borrow_reserve(int count) {
+    if (chunk_array_reserve(&borrow_store, count) != 0) {
+        return -1;
+    }
+    
+    if (count <= borrow_capacity) {
+        return 0;
+    }
+    
+    int capacity = borrow_capacity > 0 ? borrow_capacity : CHUNK_ARRAY_RECORDS;
+    while (capacity < count) {
+        capacity = capacity > INT_MAX / 2 ? count : capacity * 2;
+    }
+    
+    if (borrow_grow_array((void **)&borrow_reader_links, sizeof(BorrowLink), capacity) != 0 ||
+        borrow_grow_array((void **)&borrow_book_links, sizeof(BorrowLink), capacity) != 0 ||
+        borrow_grow_array((void **)&borrow_overdue_links, sizeof(BorrowLink), capacity) != 0 ||
+        borrow_grow_array((void **)&borrow_due_heap, sizeof(int), capacity) != 0 ||
+        borrow_grow_array((void **)&borrow_due_heap_pos, sizeof(int), capacity) != 0) {
+        return -1;
+    }
+    
+    borrow_capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief 分配借阅记录的各项索引（记录ID索引、读者和图书的键表及链表、应还日期堆、逾期链表）
+ * @return 成功返回0，失败返回非0值
+ */
+static int borrow_links_alloc() {
+    if (borrow_id_rebuild(0) != 0 ||
+        string_pool_init(&borrow_id_strings) != 0 ||
+        borrow_key_table_init(&borrow_reader_keys, CHUNK_ARRAY_RECORDS) != 0 ||
+        borrow_key_table_init(&borrow_book_keys, CHUNK_ARRAY_RECORDS) != 0 ||
+        borrow_reserve(CHUNK_ARRAY_RECORDS) != 0) {
+        borrow_links_free();
+        return -1;
+    }
+    
+    borrow_due_heap_size = 0;
+    borrow_overdue_list.head = borrow_overdue_list.tail = -1;
+    borrow_overdue_list.count = 0;
+    return 0;
+}
+
+/**
+ * @brief 清空键表中各键的链表（键本身保留，借阅记录仍引用它们）
+ * @param table 键表
+ */
+static void borrow_key_table_reset_lists(BorrowKeyTable *table) {
+    for (int i = 0; i < table->count; i++) {
+        table->keys[i].active.head = table->keys[i].active.tail = -1;
+        table->keys[i].active.count = 0;
+        table->keys[i].returned.head = table->keys[i].returned.tail = -1;
+        table->keys[i].returned.count = 0;
+    }
+}
+
+/**
+ * @brief 根据借阅数组重建记录ID索引、读者和图书的链表
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int borrow_rebuild_links() {
+    if (borrow_reserve(borrow_count) != 0 || borrow_id_rebuild(borrow_count) != 0) {
+        return -1;
+    }
+    
+    borrow_key_table_reset_lists(&borrow_reader_keys);
+    borrow_key_table_reset_lists(&borrow_book_keys);
+    borrow_due_heap_size = 0;
+    borrow_overdue_list.head = borrow_overdue_list.tail = -1;
+    borrow_overdue_list.count = 0;
+    
+    for (int i = 0; i < borrow_count; i++) {
+        borrow_link(i);
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 按借阅先后顺序收集某个键的借阅记录
+ * @param table 键表
+ * @param links 记录位置数组
+ * @param id 读者ID或图书ID
+ * @param active_only 是否只收集未归还的记录
+ * @param records 用于存储借阅记录的结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回收集到的记录数量
+ */
+static int borrow_collect(BorrowKeyTable *table, BorrowLink *links, const char *id,
+                          int active_only, BorrowRecord *records, int max_count) {
+    int key = id_index_find(&table->index, id);
+    if (key == -1) {
+        return 0;
+    }
+    
+    // 两个链表都按下标升序，归并后即为借阅先后顺序
+    int a = table->keys[key].active.head;
+    int r = active_only ? -1 : table->keys[key].returned.head;
+    int count = 0;
+    
+    while ((a != -1 || r != -1) && count < max_count) {
+        int index;
+        if (r == -1 || (a != -1 && a < r)) {
+            index = a;
+            a = links[a].next;
+        } else {
+            index = r;
+            r = links[r].next;
+        }
+        
+        borrow_materialize(index, &records[count]);
+        count++;
+    }
+    
+    return count;
+}
+
+/**
+ * @brief 将借阅数据副本写成二进制快照
+ *
+ * 快照按存储形式保存借阅记录数组、图书和读者的键数组以及非标准格式ID的字符串池，
+ * 加载时整块复制回来即可。
+ *
+ * @param copy 借阅数据副本
+ * @return 成功返回0，失败返回非0值
+ */
+static int borrow_write_binary(const BorrowSnapshot *copy) {
+    char *ids = (char *)malloc(copy->ids.bytes > 0 ? copy->ids.bytes : 1);
+    if (ids == NULL) {
+        return -1;
+    }
+    string_pool_write(&copy->ids, ids);
+    
+    const void *books = copy->books;
+    const void *readers = copy->readers;
+    const void *pool = ids;
+    SnapshotSection sections[4] = {
+        {(const void *const *)copy->entries.chunks, CHUNK_ARRAY_RECORDS, sizeof(BorrowEntry), (size_t)copy->count},
+        {&books, 0, sizeof(BorrowKey), (size_t)copy->book_count},
+        {&readers, 0, sizeof(BorrowKey), (size_t)copy->reader_count},
+        {&pool, 0, 1, copy->ids.bytes}
+    };
+    
+    int result = snapshot_write(BORROWS_SNAPSHOT_FILE, BORROWS_FILE, BORROW_SNAPSHOT_TYPE, sections, 4);
+    free(ids);
+    return result;
+}
+
+/**
+ * @brief 将借阅数据副本写入CSV文件和二进制快照（先写临时文件再替换）
+ * @param copy 借阅数据副本
+ * @return 成功返回0，失败返回非0值
+ */
+static int borrow_write_file(const BorrowSnapshot *copy) {
+    FILE *file = fopen(BORROWS_TMP_FILE, "w");
+    if (file == NULL) {
+        return -1;
+    }
+    
+    // 写入标题行
+    fprintf(file, "id,book_id,reader_id,borrow_date,due_date,return_date,status,renew_count\n");
+    
+    // 写入数据（逐条用副本的键数组和字符串池还原）
+    BorrowRecord record;
+    char numbers[5][24];
+    char *fields[BORROW_FIELD_COUNT];
+    for (int i = 0; i < copy->count; i++) {
+        borrow_entry_restore((const BorrowEntry *)CHUNK_ARRAY_AT(&copy->entries, i), &copy->ids,
+                             copy->books, copy->readers, &record);
+        borrow_to_fields(&record, numbers, fields);
+        csv_write_record(file, fields, BORROW_FIELD_COUNT);
+    }
+    
+    if (fclose(file) != 0) {
+        remove(BORROWS_TMP_FILE);
+        return -1;
+    }
+    
+    if (rename(BORROWS_TMP_FILE, BORROWS_FILE) != 0) {
+        return -1;
+    }
+    
+    // 快照在CSV之后写出，记下刚写好的CSV的大小和修改时间，加载时据此判断快照是否仍然有效
+    return borrow_write_binary(copy);
+}
+
+/**
+ * @brief 释放借阅数据副本中的数组、键数组和字符串池
+ * @param copy 借阅数据副本
+ */
+static void borrow_release_copy(BorrowSnapshot *copy) {
+    chunk_array_free(&copy->entries);
+    free(copy->books);
+    free(copy->readers);
+    string_pool_free(&copy->ids);
+}
+
+/**
+ * @brief 释放借阅数据副本
+ * @param snapshot 借阅数据副本
+ */
+static void borrow_free_snapshot(void *snapshot) {
+    borrow_release_copy((BorrowSnapshot *)snapshot);
+    free(snapshot);
+}
+
+/**
+ * @brief 在后台线程中写出借阅数据副本
+ * @param snapshot 借阅数据副本
+ * @return 成功返回0，失败返回非0值
+ */
+static int borrow_write_snapshot(void *snapshot) {
+    BorrowSnapshot *copy = (BorrowSnapshot *)snapshot;
+    int result = borrow_write_file(copy);
+    borrow_free_snapshot(copy);
+    return result;
+}
+
+/**
+ * @brief 复制一个键表中的键
+ * @param table 键表
+ * @return 键数组副本，内存不足返回NULL
+ */
+static BorrowKey *borrow_copy_keys(const BorrowKeyTable *table) {
+    BorrowKey *keys = (BorrowKey *)malloc(sizeof(BorrowKey) * (table->count > 0 ? table->count : 1));
+    if (keys != NULL) {
+        memcpy(keys, table->keys, sizeof(BorrowKey) * table->count);
+    }
+    return keys;
+}
+
+/**
+ * @brief 按存储形式复制借阅记录数组、键表中的键和非标准格式ID的字符串池
+ *
+ * 记录按整块复制，不还原为BorrowRecord；写出CSV时才在后台线程中
+ * 用副本自己的键数组和字符串池逐条还原，副本不再引用模块中的数据。
+ *
+ * @param copy 数据副本（未初始化）
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int borrow_copy_live(BorrowSnapshot *copy) {
+    memset(copy, 0, sizeof(BorrowSnapshot));
+    if (chunk_array_copy(&copy->entries, &borrow_store, borrow_count) != 0) {
+        return -1;
+    }
+    
+    copy->books = borrow_copy_keys(&borrow_book_keys);
+    copy->readers = borrow_copy_keys(&borrow_reader_keys);
+    if (copy->books == NULL || copy->readers == NULL || string_pool_copy(&copy->ids, &borrow_id_strings) != 0) {
+        chunk_array_free(&copy->entries);
+        free(copy->books);
+        free(copy->readers);
+        return -1;
+    }
+    
+    copy->book_count = borrow_book_keys.count;
+    copy->reader_count = borrow_reader_keys.count;
+    copy->count = borrow_count;
+    return 0;
+}
+
+/**
+ * @brief 日志过长时在后台合并回数据文件
+ */
+static void borrow_maybe_compact() {
+    if (!journal_needs_compaction(&borrow_journal, borrow_count)) {
+        return;
+    }
+    
+    BorrowSnapshot *copy = (BorrowSnapshot *)malloc(sizeof(BorrowSnapshot));
+    if (copy == NULL) {
+        return;
+    }
+    
+    if (borrow_copy_live(copy) != 0) {
+        free(copy);
+        return;
+    }
+    
+    journal_compact(&borrow_journal, borrow_write_snapshot, copy, borrow_free_snapshot);
+}
+
+/**
+ * @brief 记录一条借阅记录写入日志
+ * @param record 写入后的借阅记录
+ * @return 成功返回0，失败返回非0值
+ */
+static int borrow_log_put(const BorrowRecord *record) {
+    char numbers[5][24];
+    char *fields[BORROW_FIELD_COUNT];
+    
+    borrow_to_fields(record, numbers, fields);
+    if (journal_append(&borrow_journal, JOURNAL_OP_PUT, fields, BORROW_FIELD_COUNT) != 0) {
+        return -1;
+    }
+    
+    borrow_maybe_compact();
+    return 0;
+}
+
+/**
+ * @brief 将未归还的借阅记录标记为逾期：移出应还日期堆、加入逾期链表、记录日志并通知
+ * @param index 记录下标
+ */
+static void borrow_mark_overdue(int index) {
+    borrow_due_heap_remove(index);
+    borrow_set_status(borrow_at(index), BORROW_STATUS_OVERDUE);
+    borrow_overdue_links[index].key = 0;
+    borrow_list_insert(&borrow_overdue_list, borrow_overdue_links, index);
+    
+    // 只记录状态真正发生变化的记录
+    BorrowRecord record;
+    borrow_materialize(index, &record);
+    borrow_log_put(&record);
+    
+    if (borrow_overdue_callback != NULL) {
+        borrow_overdue_callback(&record, borrow_overdue_user_data);
+    }
+}
+
+/**
+ * @brief 重放一条借阅日志
+ * @param op 操作类型
+ * @param fields 记录字段
+ * @param num_fields 字段数
+ * @param user_data 未使用
+ * @return 成功返回0，失败返回非0值
+ */
+static int borrow_apply_journal(char op, const CsvField *fields, int num_fields, void *user_data) {
+    (void)user_data;
+    if (op != JOURNAL_OP_PUT || num_fields != BORROW_FIELD_COUNT) {
+        return -1;
+    }
+    
+    BorrowRecord record;
+    BorrowEntry entry;
+    borrow_from_fields(&record, fields);
+    if (borrow_entry_from(&entry, &record) != 0) {
+        return -1;
+    }
+    
+    int index = borrow_index_of_code(entry.id);
+    if (index == -1) {
+        if (borrow_reserve(borrow_count + 1) != 0) {
+            return -1;
+        }
+        
+        index = borrow_count;
+        *borrow_at(index) = entry;
+        if (borrow_id_insert(index) != 0) {
+            return -1;
+        }
+        borrow_count++;
+    } else {
+        borrow_unlink(index);
+        *borrow_at(index) = entry;
+    }
+    
+    borrow_link(index);
+    return 0;
+}
 
 /**
  * @brief 初始化借阅管理模块
  * @return 成功返回0，失败返回非0值
  */
 int borrow_init() {
-    // 分配内存
-    borrows = (BorrowRecord *)malloc(sizeof(BorrowRecord) * MAX_BORROWS);
-    if (borrows == NULL) {
+    // 借阅记录数组按需分块分配
+    if (chunk_array_init(&borrow_store, sizeof(BorrowEntry)) != 0) {
         return -1;
     }
     
-    borrow_capacity = MAX_BORROWS;
     borrow_count = 0;
     
+    // 分配按读者、按图书的借阅索引
+    if (borrow_links_alloc() != 0) {
+        chunk_array_free(&borrow_store);
+        return -1;
+    }
+    
+    // 打开变更日志
+    if (journal_open(&borrow_journal, BORROWS_JOURNAL_FILE, BORROW_JOURNAL_MIN_COMPACT) != 0) {
+        borrow_links_free();
+        chunk_array_free(&borrow_store);
+        return -1;
+    }
+    
     // 加载数据
     return borrow_load_data();
 }
@@ -56,36 +1283,36 @@ int borrow_book(const char *book_id, const char *reader_id, BorrowRecord *record
         return -1;
     }
     
-    // 检查容量
-    if (borrow_count >= borrow_capacity) {
+    // 确保容量（不足时追加一块）
+    if (borrow_reserve(borrow_count + 1) != 0) {
         return -1;
     }
     
-    // 查找图书
-    Book book;
-    if (book_find_by_id(book_id, &book) != 0) {
+    // 查找图书（只取句柄，不复制图书）
+    BookHandle book = book_lookup(book_id);
+    if (book == -1) {
         return -2; // 图书不存在
     }
     
     // 检查图书是否可借
-    if (book.available_count <= 0) {
+    if (book_available_count(book) <= 0) {
         return -3; // 图书已全部借出
     }
     
     // 查找读者
-    Reader reader;
-    if (reader_find_by_id(reader_id, &reader) != 0) {
+    ReaderHandle reader = reader_lookup(reader_id);
+    if (reader == -1) {
         return -4; // 读者不存在
     }
     
     // 检查读者是否可借
-    if (reader.current_borrow_count >= reader.max_borrow_count) {
+    if (reader_borrow_quota(reader) <= 0) {
         return -5; // 读者借阅数量已达上限
     }
     
     // 生成借阅记录
     memset(record, 0, sizeof(BorrowRecord));
-    generate_id("BR", record->id, sizeof(record->id));
+    generate_id(BORROW_ID_PREFIX, record->id, sizeof(record->id));
     strncpy(record->book_id, book_id, sizeof(record->book_id) - 1);
     record->book_id[sizeof(record->book_id) - 1] = '\0';
     strncpy(record->reader_id, reader_id, sizeof(record->reader_id) - 1);
@@ -97,259 +1324,728 @@ int borrow_book(const char *book_id, const char *reader_id, BorrowRecord *record
     record->status = BORROW_STATUS_BORROWED;
     record->renew_count = 0;
     
-    // 添加借阅记录
-    memcpy(&borrows[borrow_count], record, sizeof(BorrowRecord));
+    // 以存储形式添加借阅记录（图书和读者ID在这里换成键，之后都按整数比较）
+    if (borrow_entry_from(borrow_at(borrow_count), record) != 0 || borrow_id_insert(borrow_count) != 0) {
+        return -1;
+    }
+    borrow_link(borrow_count);
     borrow_count++;
     
-    // 更新图书可借数量
-    book.available_count--;
-    book_update(&book);
+    // 原地更新图书可借数量和读者当前借阅数量
+    book_adjust_available(book, -1);
+    reader_adjust_borrow_count(reader, 1);
+    
+    // 记录日志
+    return borrow_log_put(record);
+}
+
+/**
+ * @brief 归还图书
+ * @param record_id 借阅记录ID
+ * @return 成功返回0，失败返回非0值
+ */
+int return_book(const char *record_id) {
+    if (record_id == NULL) {
+        return -1;
+    }
+    
+    // 查找借阅记录
+    int index = borrow_index_of(record_id);
+    if (index == -1) {
+        return -2; // 借阅记录不存在
+    }
+    
+    // 检查是否已归还
+    BorrowEntry *entry = borrow_at(index);
+    if (borrow_status(entry) == BORROW_STATUS_RETURNED) {
+        return -3; // 已归还
+    }
+    
+    // 查找图书
+    BookHandle book = book_lookup(borrow_book_keys.keys[entry->book].id);
+    if (book == -1) {
+        return -4; // 图书不存在
+    }
+    
+    // 查找读者
+    ReaderHandle reader = reader_lookup(borrow_reader_keys.keys[entry->reader].id);
+    if (reader == -1) {
+        return -5; // 读者不存在
+    }
+    
+    // 更新借阅记录，从未归还链表移到已归还链表
+    borrow_unlink(index);
+    entry->return_date = (uint32_t)get_current_time();
+    borrow_set_status(entry, BORROW_STATUS_RETURNED);
+    borrow_link(index);
+    
+    // 原地更新图书可借数量和读者当前借阅数量
+    book_adjust_available(book, 1);
+    reader_adjust_borrow_count(reader, -1); // 借阅数量已为0时不再减少
+    
+    // 记录日志
+    BorrowRecord record;
+    borrow_materialize(index, &record);
+    return borrow_log_put(&record);
+}
+
+/**
+ * @brief 续借图书
+ * @param record_id 借阅记录ID
+ * @param new_due_date 新的应还日期
+ * @return 成功返回0，失败返回非0值
+ */
+int renew_book(const char *record_id, time_t new_due_date) {
+    if (record_id == NULL) {
+        return -1;
+    }
+    
+    // 查找借阅记录
+    int index = borrow_index_of(record_id);
+    if (index == -1) {
+        return -2; // 借阅记录不存在
+    }
+    
+    // 检查是否已归还
+    BorrowEntry *entry = borrow_at(index);
+    if (borrow_status(entry) == BORROW_STATUS_RETURNED) {
+        return -3; // 已归还，不能续借
+    }
+    
+    // 检查续借次数
+    if (borrow_renew_count(entry) >= MAX_RENEW_COUNT) {
+        return -4; // 超过最大续借次数
+    }
+    
+    // 检查是否逾期
+    time_t current_time = get_current_time();
+    if ((time_t)entry->due_date < current_time) {
+        if (borrow_status(entry) != BORROW_STATUS_OVERDUE) {
+            borrow_mark_overdue(index);
+        }
+        return -5; // 已逾期，不能续借
+    }
+    
+    // 更新借阅记录，应还日期变了需要调整在堆中的位置
+    borrow_due_heap_remove(index);
+    
+    if (new_due_date == 0) {
+        // 如果没有指定新的应还日期，则默认延长RENEW_DAYS天
+        entry->due_date += RENEW_DAYS * 24 * 60 * 60;
+    } else {
+        entry->due_date = (uint32_t)new_due_date;
+    }
+    
+    entry->state += 1u << BORROW_STATUS_BITS;
+    borrow_set_status(entry, BORROW_STATUS_RENEWED);
+    borrow_due_heap_push(index);
+    
+    // 记录日志
+    BorrowRecord record;
+    borrow_materialize(index, &record);
+    return borrow_log_put(&record);
+}
+
+/**
+ * @brief 根据ID查找借阅记录
+ * @param id 借阅记录ID
+ * @param record 用于存储查找结果的借阅记录结构体指针
+ * @return 成功返回0，失败返回非0值
+ */
+int borrow_find_by_id(const char *id, BorrowRecord *record) {
+    if (id == NULL || record == NULL) {
+        return -1;
+    }
+    
+    // 通过ID索引查找借阅记录
+    int index = borrow_index_of(id);
+    if (index == -1) {
+        return -1;
+    }
+    
+    borrow_materialize(index, record);
+    return 0;
+}
+
+/**
+ * @brief 查找读者的借阅记录
+ * @param reader_id 读者ID
+ * @param records 用于存储查找结果的借阅记录结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的借阅记录数量
+ */
+int borrow_find_by_reader(const char *reader_id, BorrowRecord *records, int max_count) {
+    if (reader_id == NULL || records == NULL || max_count <= 0) {
+        return 0;
+    }
+    
+    return borrow_collect(&borrow_reader_keys, borrow_reader_links, reader_id, 0, records, max_count);
+}
+
+/**
+ * @brief 查找图书的借阅记录
+ * @param book_id 图书ID
+ * @param records 用于存储查找结果的借阅记录结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的借阅记录数量
+ */
+int borrow_find_by_book(const char *book_id, BorrowRecord *records, int max_count) {
+    if (book_id == NULL || records == NULL || max_count <= 0) {
+        return 0;
+    }
+    
+    return borrow_collect(&borrow_book_keys, borrow_book_links, book_id, 0, records, max_count);
+}
+
+/**
+ * @brief 查找读者当前未归还的借阅记录
+ * @param reader_id 读者ID
+ * @param records 用于存储查找结果的借阅记录结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的借阅记录数量
+ */
+int borrow_find_active_by_reader(const char *reader_id, BorrowRecord *records, int max_count) {
+    if (reader_id == NULL || records == NULL || max_count <= 0) {
+        return 0;
+    }
+    
+    return borrow_collect(&borrow_reader_keys, borrow_reader_links, reader_id, 1, records, max_count);
+}
+
+/**
+ * @brief 查找图书当前未归还的借阅记录
+ * @param book_id 图书ID
+ * @param records 用于存储查找结果的借阅记录结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的借阅记录数量
+ */
+int borrow_find_active_by_book(const char *book_id, BorrowRecord *records, int max_count) {
+    if (book_id == NULL || records == NULL || max_count <= 0) {
+        return 0;
+    }
+    
+    return borrow_collect(&borrow_book_keys, borrow_book_links, book_id, 1, records, max_count);
+}
+
+/**
+ * @brief 获取所有借阅记录
+ * @param records 用于存储借阅记录的结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回借阅记录总数
+ */
+int borrow_get_all(BorrowRecord *records, int max_count) {
+    if (records == NULL || max_count <= 0) {
+        return 0;
+    }
+    
+    int count = (borrow_count < max_count) ? borrow_count : max_count;
     
-    // 更新读者当前借阅数量
-    reader.current_borrow_count++;
-    reader_update(&reader);
+    // 逐条还原借阅记录
+    for (int i = 0; i < count; i++) {
+        borrow_materialize(i, &records[i]);
+    }
     
-    // 保存数据
-    return borrow_save_data();
+    return count;
 }
 
 /**
- * @brief 归还图书
- * @param record_id 借阅记录ID
- * @return 成功返回0，失败返回非0值
+ * @brief 按录入顺序遍历借阅记录，逐条还原到同一个临时结构体中，不分配内存
+ *
+ * 遍历期间（包括回调函数中）不能增删改借阅记录。
+ *
+ * @param filter 过滤函数，返回非0的借阅记录才交给visit，为NULL时不过滤
+ * @param offset 跳过前offset条符合条件的借阅记录（用于翻页）
+ * @param limit 最多访问的数量（页大小），不大于0时不限
+ * @param visit 访问函数，返回非0时停止遍历
+ * @param user_data 传给filter和visit的用户数据
+ * @return 返回访问的借阅记录数量
  */
-int return_book(const char *record_id) {
-    if (record_id == NULL) {
-        return -1;
+int borrow_foreach(BorrowFilterFunc filter, int offset, int limit, BorrowVisitFunc visit, void *user_data) {
+    if (visit == NULL) {
+        return 0;
     }
     
-    // 查找借阅记录
-    int index = -1;
+    BorrowRecord record;
+    int visited = 0;
     for (int i = 0; i < borrow_count; i++) {
-        if (strcmp(borrows[i].id, record_id) == 0) {
-            index = i;
+        borrow_materialize(i, &record);
+        if (filter != NULL && !filter(&record, user_data)) {
+            continue;
+        }
+        
+        // 跳过前面几页
+        if (offset > 0) {
+            offset--;
+            continue;
+        }
+        
+        visited++;
+        if (visit(&record, user_data) != 0 || visited == limit) {
             break;
         }
     }
     
-    if (index == -1) {
-        return -2; // 借阅记录不存在
-    }
+    return visited;
+}
+
+/**
+ * @brief 设置借阅记录变为逾期时的回调函数
+ * @param callback 回调函数，为NULL时取消
+ * @param user_data 用户数据
+ */
+void borrow_set_overdue_callback(BorrowOverdueFunc callback, void *user_data) {
+    borrow_overdue_callback = callback;
+    borrow_overdue_user_data = user_data;
+}
+
+/**
+ * @brief 检查新出现的逾期借阅
+ *
+ * 只从应还日期堆顶取出已过期的记录，开销与新逾期的记录数成正比。
+ *
+ * @return 返回本次新变为逾期的记录数量
+ */
+int borrow_check_overdue() {
+    time_t current_time = get_current_time();
+    int count = 0;
     
-    // 检查是否已归还
-    if (borrows[index].status == BORROW_STATUS_RETURNED) {
-        return -3; // 已归还
+    while (borrow_due_heap_size > 0 && (time_t)borrow_at(borrow_due_heap[0])->due_date < current_time) {
+        borrow_mark_overdue(borrow_due_heap[0]);
+        count++;
     }
     
-    // 查找图书
-    Book book;
-    if (book_find_by_id(borrows[index].book_id, &book) != 0) {
-        return -4; // 图书不存在
+    return count;
+}
+
+/**
+ * @brief 获取逾期的借阅记录
+ * @param records 用于存储借阅记录的结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回逾期借阅记录数量
+ */
+int borrow_get_overdue(BorrowRecord *records, int max_count) {
+    if (records == NULL || max_count <= 0) {
+        return 0;
     }
     
-    // 查找读者
-    Reader reader;
-    if (reader_find_by_id(borrows[index].reader_id, &reader) != 0) {
-        return -5; // 读者不存在
+    // 先把新到期的记录标记为逾期
+    borrow_check_overdue();
+    
+    int count = 0;
+    for (int i = borrow_overdue_list.head; i != -1 && count < max_count; i = borrow_overdue_links[i].next) {
+        borrow_materialize(i, &records[count]);
+        count++;
     }
     
-    // 更新借阅记录
-    borrows[index].return_date = get_current_time();
-    borrows[index].status = BORROW_STATUS_RETURNED;
+    return count;
+}
+
+/**
+ * @brief 检查借阅记录引用的图书和读者是否存在
+ * @return 返回引用了不存在的图书或读者的记录数
+ */
+int borrow_validate() {
+    int dangling = 0;
     
-    // 更新图书可借数量
-    book.available_count++;
-    book_update(&book);
+    for (int i = 0; i < borrow_count; i++) {
+        const BorrowEntry *entry = borrow_at(i);
+        if (book_lookup(borrow_book_keys.keys[entry->book].id) == -1 ||
+            reader_lookup(borrow_reader_keys.keys[entry->reader].id) == -1) {
+            dangling++;
+        }
+    }
     
-    // 更新读者当前借阅数量
-    if (reader.current_borrow_count > 0) {
-        reader.current_borrow_count--;
-        reader_update(&reader);
+    return dangling;
+}
+
+/**
+ * @brief 设置解析借阅数据文件使用的线程数
+ * @param count 线程数，0表示按CPU核心数自动选择
+ */
+void borrow_set_load_threads(int count) {
+    borrow_load_threads = count < 0 ? 0 : count;
+}
+
+/**
+ * @brief 加载时把一条借阅记录转换为存储形式追加到数组末尾（索引在加载完成后统一重建）
+ * @param record 借阅记录
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int borrow_load_append(const BorrowRecord *record) {
+    if (borrow_count == INT_MAX || chunk_array_reserve(&borrow_store, borrow_count + 1) != 0 ||
+        borrow_entry_from(borrow_at(borrow_count), record) != 0) {
+        return -1;
     }
     
-    // 保存数据
-    return borrow_save_data();
+    borrow_count++;
+    return 0;
 }
 
 /**
- * @brief 续借图书
- * @param record_id 借阅记录ID
- * @param new_due_date 新的应还日期
+ * @brief 解析一段借阅数据，转换为存储形式放入该段自己的记录数组
+ * @param chunk 数据段
  * @return 成功返回0，失败返回非0值
  */
-int renew_book(const char *record_id, time_t new_due_date) {
-    if (record_id == NULL) {
+static int borrow_parse_chunk(BorrowLoadChunk *chunk) {
+    if (string_pool_init(&chunk->ids) != 0 ||
+        borrow_key_table_init(&chunk->books, CHUNK_ARRAY_RECORDS) != 0 ||
+        borrow_key_table_init(&chunk->readers, CHUNK_ARRAY_RECORDS) != 0) {
         return -1;
     }
     
-    // 查找借阅记录
-    int index = -1;
-    for (int i = 0; i < borrow_count; i++) {
-        if (strcmp(borrows[i].id, record_id) == 0) {
-            index = i;
-            break;
+    CsvReader csv;
+    CsvField fields[BORROW_FIELD_COUNT];
+    int num_fields;
+    
+    csv_reader_init(&csv, chunk->data, chunk->len);
+    
+    while ((num_fields = csv_read_record(&csv, fields, BORROW_FIELD_COUNT)) >= 0) {
+        if (num_fields != BORROW_FIELD_COUNT) {
+            continue;
+        }
+        
+        // 容量不足时扩容
+        if (chunk->count >= chunk->capacity) {
+            int new_capacity = chunk->capacity > 0 ? chunk->capacity * 2 : (int)(chunk->len / 64) + 16;
+            BorrowEntry *entries = (BorrowEntry *)realloc(chunk->entries, sizeof(BorrowEntry) * new_capacity);
+            if (entries == NULL) {
+                return -1;
+            }
+            chunk->entries = entries;
+            chunk->capacity = new_capacity;
         }
+        
+        BorrowRecord record;
+        borrow_from_fields(&record, fields);
+        if (borrow_entry_convert(&chunk->entries[chunk->count], &record, &chunk->ids,
+                                 &chunk->books, &chunk->readers) != 0) {
+            return -1;
+        }
+        chunk->count++;
     }
     
-    if (index == -1) {
-        return -2; // 借阅记录不存在
+    return 0;
+}
+
+/**
+ * @brief 并行解析的工作线程
+ * @param arg 数据段
+ * @return 总是返回NULL
+ */
+static void *borrow_load_worker(void *arg) {
+    BorrowLoadChunk *chunk = (BorrowLoadChunk *)arg;
+    chunk->result = borrow_parse_chunk(chunk);
+    return NULL;
+}
+
+/**
+ * @brief 并行拼接的工作线程：把本段的记录换算为全局编号写入借阅记录数组
+ * @param arg 数据段（写入位置和编号对应表已由borrow_load_remap填好）
+ * @return 总是返回NULL
+ */
+static void *borrow_store_worker(void *arg) {
+    BorrowLoadChunk *chunk = (BorrowLoadChunk *)arg;
+    
+    for (int i = 0; i < chunk->count; i++) {
+        BorrowEntry *entry = borrow_at(chunk->base + i);
+        *entry = chunk->entries[i];
+        entry->book = chunk->book_map[entry->book];
+        entry->reader = chunk->reader_map[entry->reader];
+        if (entry->id & BORROW_ID_POOLED) {
+            entry->id = BORROW_ID_POOLED | (uint64_t)chunk->id_map[entry->id & ~BORROW_ID_POOLED];
+        }
     }
     
-    // 检查是否已归还
-    if (borrows[index].status == BORROW_STATUS_RETURNED) {
-        return -3; // 已归还，不能续借
+    chunk->result = 0;
+    return NULL;
+}
+
+/**
+ * @brief 各段分别运行同一个处理函数：第一段和线程创建失败的段在当前线程中运行
+ * @param chunks 数据段数组
+ * @param count 段数
+ * @param worker 处理函数，结果写入各段的result
+ * @return 全部成功返回0，否则返回非0值
+ */
+static int borrow_run_chunks(BorrowLoadChunk *chunks, int count, void *(*worker)(void *)) {
+    for (int i = 0; i < count; i++) {
+        chunks[i].thread_started = i > 0 && pthread_create(&chunks[i].thread, NULL, worker, &chunks[i]) == 0;
     }
     
-    // 检查续借次数
-    if (borrows[index].renew_count >= MAX_RENEW_COUNT) {
-        return -4; // 超过最大续借次数
+    for (int i = 0; i < count; i++) {
+        if (!chunks[i].thread_started) {
+            worker(&chunks[i]);
+        }
     }
     
-    // 检查是否逾期
-    time_t current_time = get_current_time();
-    if (borrows[index].due_date < current_time) {
-        borrows[index].status = BORROW_STATUS_OVERDUE;
-        return -5; // 已逾期，不能续借
+    int result = 0;
+    for (int i = 0; i < count; i++) {
+        if (chunks[i].thread_started) {
+            pthread_join(chunks[i].thread, NULL);
+        }
+        if (chunks[i].result != 0) {
+            result = -1;
+        }
     }
     
-    // 更新借阅记录
-    if (new_due_date == 0) {
-        // 如果没有指定新的应还日期，则默认延长RENEW_DAYS天
-        borrows[index].due_date += RENEW_DAYS * 24 * 60 * 60;
-    } else {
-        borrows[index].due_date = new_due_date;
+    return result;
+}
+
+/**
+ * @brief 把一段的键表并入全局键表
+ * @param table 全局键表
+ * @param local 本段的键表
+ * @return 本段各键对应的全局键数组（由调用方释放），内存不足返回NULL
+ */
+static int *borrow_key_table_merge(BorrowKeyTable *table, const BorrowKeyTable *local) {
+    int *map = (int *)malloc(sizeof(int) * (local->count > 0 ? local->count : 1));
+    if (map == NULL) {
+        return NULL;
     }
     
-    borrows[index].renew_count++;
-    borrows[index].status = BORROW_STATUS_RENEWED;
+    // 按本段中首次出现的顺序加入，键的编号与单线程顺序加载时相同
+    for (int i = 0; i < local->count; i++) {
+        map[i] = borrow_key_intern(table, local->keys[i].id);
+        if (map[i] == -1) {
+            free(map);
+            return NULL;
+        }
+    }
     
-    // 保存数据
-    return borrow_save_data();
+    return map;
 }
 
 /**
- * @brief 根据ID查找借阅记录
- * @param id 借阅记录ID
- * @param record 用于存储查找结果的借阅记录结构体指针
- * @return 成功返回0，失败返回非0值
+ * @brief 按文件顺序为一段分配借阅记录数组中的位置，把本段不同的键和非标准格式ID并入全局表
+ * @param chunk 数据段
+ * @return 成功返回0，内存不足返回非0值
  */
-int borrow_find_by_id(const char *id, BorrowRecord *record) {
-    if (id == NULL || record == NULL) {
+static int borrow_load_remap(BorrowLoadChunk *chunk) {
+    if (chunk->count > INT_MAX - borrow_count) {
         return -1;
     }
     
-    // 查找借阅记录
-    for (int i = 0; i < borrow_count; i++) {
-        if (strcmp(borrows[i].id, id) == 0) {
-            memcpy(record, &borrows[i], sizeof(BorrowRecord));
-            return 0;
+    chunk->book_map = borrow_key_table_merge(&borrow_book_keys, &chunk->books);
+    chunk->reader_map = borrow_key_table_merge(&borrow_reader_keys, &chunk->readers);
+    chunk->id_map = (int *)malloc(sizeof(int) * (chunk->ids.count > 0 ? chunk->ids.count : 1));
+    if (chunk->book_map == NULL || chunk->reader_map == NULL || chunk->id_map == NULL) {
+        return -1;
+    }
+    
+    for (int i = 0; i < chunk->ids.count; i++) {
+        chunk->id_map[i] = string_pool_intern(&borrow_id_strings, string_pool_get(&chunk->ids, i));
+        if (chunk->id_map[i] == -1) {
+            return -1;
         }
     }
     
-    return -1;
+    chunk->base = borrow_count;
+    borrow_count += chunk->count;
+    return 0;
 }
 
 /**
- * @brief 查找读者的借阅记录
- * @param reader_id 读者ID
- * @param records 用于存储查找结果的借阅记录结构体数组
- * @param max_count 最大返回数量
- * @return 返回找到的借阅记录数量
+ * @brief 释放一段的全部临时数据
+ * @param chunk 数据段
  */
-int borrow_find_by_reader(const char *reader_id, BorrowRecord *records, int max_count) {
-    if (reader_id == NULL || records == NULL || max_count <= 0) {
-        return 0;
+static void borrow_load_chunk_free(BorrowLoadChunk *chunk) {
+    free(chunk->entries);
+    free(chunk->book_map);
+    free(chunk->reader_map);
+    free(chunk->id_map);
+    string_pool_free(&chunk->ids);
+    borrow_key_table_free(&chunk->books);
+    borrow_key_table_free(&chunk->readers);
+}
+
+/**
+ * @brief 将数据切分为按记录对齐的若干段并行解析和转换，再按文件顺序拼接
+ *
+ * 只有并入各段不同的键和非标准格式ID在当前线程中依次进行，工作量与不同的键数成正比；
+ * 解析、转换和把记录写入借阅记录数组都在各段自己的线程中进行。
+ *
+ * @param data 去掉标题行后的CSV内容
+ * @param len 内容长度
+ * @param threads 线程数
+ * @return 成功返回0，失败返回非0值
+ */
+static int borrow_load_parallel(char *data, size_t len, int threads) {
+    BorrowLoadChunk chunks[BORROW_MAX_LOAD_THREADS];
+    size_t offsets[BORROW_MAX_LOAD_THREADS + 1];
+    int chunk_count = csv_split_chunks(data, len, threads, offsets);
+    
+    memset(chunks, 0, sizeof(chunks));
+    for (int i = 0; i < chunk_count; i++) {
+        chunks[i].data = data + offsets[i];
+        chunks[i].len = offsets[i + 1] - offsets[i];
     }
     
-    int count = 0;
+    int result = borrow_run_chunks(chunks, chunk_count, borrow_load_worker);
     
-    // 查找借阅记录
-    for (int i = 0; i < borrow_count && count < max_count; i++) {
-        if (strcmp(borrows[i].reader_id, reader_id) == 0) {
-            memcpy(&records[count], &borrows[i], sizeof(BorrowRecord));
-            count++;
-        }
+    for (int i = 0; result == 0 && i < chunk_count; i++) {
+        result = borrow_load_remap(&chunks[i]);
     }
     
-    return count;
+    if (result == 0 && chunk_array_reserve(&borrow_store, borrow_count) != 0) {
+        result = -1;
+    }
+    
+    if (result == 0) {
+        result = borrow_run_chunks(chunks, chunk_count, borrow_store_worker);
+    }
+    
+    for (int i = 0; i < chunk_count; i++) {
+        borrow_load_chunk_free(&chunks[i]);
+    }
+    
+    return result;
 }
 
 /**
- * @brief 查找图书的借阅记录
- * @param book_id 图书ID
- * @param records 用于存储查找结果的借阅记录结构体数组
- * @param max_count 最大返回数量
- * @return 返回找到的借阅记录数量
+ * @brief 从CSV文件加载借阅数据
+ *
+ * 文件较大时按记录边界切分，各段在自己的线程中解析并转换为存储形式，
+ * 结果（包括键和非标准格式ID的编号）与单线程顺序加载相同。
+ *
+ * @return 成功返回0，失败返回非0值
  */
-int borrow_find_by_book(const char *book_id, BorrowRecord *records, int max_count) {
-    if (book_id == NULL || records == NULL || max_count <= 0) {
+static int borrow_load_csv() {
+    // 如果文件不存在，直接返回成功
+    if (!file_exists(BORROWS_FILE)) {
         return 0;
     }
     
-    int count = 0;
+    CsvFile file;
+    if (csv_file_open(BORROWS_FILE, &file) != 0) {
+        return -1;
+    }
     
-    // 查找借阅记录
-    for (int i = 0; i < borrow_count && count < max_count; i++) {
-        if (strcmp(borrows[i].book_id, book_id) == 0) {
-            memcpy(&records[count], &borrows[i], sizeof(BorrowRecord));
-            count++;
+    CsvReader csv;
+    CsvField fields[BORROW_FIELD_COUNT];
+    int num_fields;
+    int result = 0;
+    
+    csv_reader_init(&csv, file.data, file.len);
+    
+    // 跳过标题行
+    csv_read_record(&csv, fields, BORROW_FIELD_COUNT);
+    
+    size_t remaining = (size_t)(csv.end - csv.pos);
+    
+    // 自动选择时，单核机器或文件较小时直接单线程解析：多线程解析之后还要依次合并各段，
+    // 没有多个核心同时工作时只会更慢
+    int threads = borrow_load_threads;
+    if (threads == 0) {
+        size_t limit = remaining / BORROW_PARALLEL_MIN_BYTES;
+        threads = cpu_count();
+        if ((size_t)threads > limit) {
+            threads = (int)limit;
         }
     }
+    if (threads > BORROW_MAX_LOAD_THREADS) {
+        threads = BORROW_MAX_LOAD_THREADS;
+    }
     
-    return count;
+    if (threads > 1) {
+        result = borrow_load_parallel(csv.pos, remaining, threads);
+    } else {
+        // 读取数据
+        while ((num_fields = csv_read_record(&csv, fields, BORROW_FIELD_COUNT)) >= 0) {
+            if (num_fields != BORROW_FIELD_COUNT) {
+                continue;
+            }
+            
+            // 内存耗尽时报告失败而不是丢弃后面的记录
+            BorrowRecord record;
+            borrow_from_fields(&record, fields);
+            if (borrow_load_append(&record) != 0) {
+                result = -1;
+                break;
+            }
+        }
+    }
+    
+    csv_file_close(&file);
+    return result;
 }
 
 /**
- * @brief 获取所有借阅记录
- * @param records 用于存储借阅记录的结构体数组
- * @param max_count 最大返回数量
- * @return 返回借阅记录总数
+ * @brief 用快照中的键替换键表中的全部键，并重建ID索引
+ * @param table 键表
+ * @param keys 快照中的键（链表在加载完成后统一重建）
+ * @param count 键数量
+ * @return 成功返回0，有重复的ID或内存不足返回非0值
  */
-int borrow_get_all(BorrowRecord *records, int max_count) {
-    if (records == NULL || max_count <= 0) {
-        return 0;
+static int borrow_key_table_load(BorrowKeyTable *table, const void *keys, size_t count) {
+    if (count > (size_t)INT_MAX) {
+        return -1;
     }
     
-    int count = (borrow_count < max_count) ? borrow_count : max_count;
+    if ((int)count > table->capacity) {
+        BorrowKey *grown = (BorrowKey *)realloc(table->keys, sizeof(BorrowKey) * count);
+        if (grown == NULL) {
+            return -1;
+        }
+        table->keys = grown;
+        table->capacity = (int)count;
+    }
     
-    // 复制借阅记录
-    memcpy(records, borrows, sizeof(BorrowRecord) * count);
+    memcpy(table->keys, keys, sizeof(BorrowKey) * count);
+    for (size_t i = 0; i < count; i++) {
+        table->keys[i].id[sizeof(table->keys[i].id) - 1] = '\0';
+    }
+    table->count = (int)count;
     
-    return count;
+    // 重复的ID只有第一个进入索引，说明内容不是由键表写出的
+    if (id_index_rebuild(&table->index, table->count) != 0 || table->index.count != table->count) {
+        return -1;
+    }
+    return 0;
 }
 
 /**
- * @brief 获取逾期的借阅记录
- * @param records 用于存储借阅记录的结构体数组
- * @param max_count 最大返回数量
- * @return 返回逾期借阅记录数量
+ * @brief 从二进制快照加载借阅数据
+ *
+ * 借阅记录按块整块复制，键数组和字符串池各复制一次，不逐条转换；
+ * 只检查记录引用的键和非标准格式ID没有越界，链表和索引由调用方统一重建。
+ *
+ * @return 成功返回0，快照不存在、已过期或校验失败返回非0值
  */
-int borrow_get_overdue(BorrowRecord *records, int max_count) {
-    if (records == NULL || max_count <= 0) {
-        return 0;
+static int borrow_load_snapshot() {
+    if (!file_exists(BORROWS_SNAPSHOT_FILE)) {
+        return -1;
     }
     
-    int count = 0;
-    time_t current_time = get_current_time();
+    // CSV在快照写出后被修改或替换过（例如手工编辑了CSV文件）时快照失效，以CSV为准
+    static const uint32_t sizes[4] = {sizeof(BorrowEntry), sizeof(BorrowKey), sizeof(BorrowKey), 1};
+    SnapshotView view;
+    if (snapshot_open(BORROWS_SNAPSHOT_FILE, BORROWS_FILE, BORROW_SNAPSHOT_TYPE, sizes, 4, &view) != 0) {
+        return -1;
+    }
     
-    // 查找逾期借阅记录
-    for (int i = 0; i < borrow_count && count < max_count; i++) {
-        if (borrows[i].status != BORROW_STATUS_RETURNED && 
-            borrows[i].due_date < current_time) {
-            // 更新状态为逾期
-            borrows[i].status = BORROW_STATUS_OVERDUE;
-            
-            memcpy(&records[count], &borrows[i], sizeof(BorrowRecord));
-            count++;
-        }
+    size_t count = view.sections[0].count;
+    if (count > (size_t)INT_MAX || chunk_array_reserve(&borrow_store, (int)count) != 0 ||
+        borrow_key_table_load(&borrow_book_keys, view.sections[1].records, view.sections[1].count) != 0 ||
+        borrow_key_table_load(&borrow_reader_keys, view.sections[2].records, view.sections[2].count) != 0 ||
+        string_pool_load(&borrow_id_strings, (const char *)view.sections[3].records, view.sections[3].count) != 0) {
+        snapshot_close(&view);
+        return -1;
     }
     
-    // 如果有状态更新，保存数据
-    if (count > 0) {
-        borrow_save_data();
+    chunk_array_write(&borrow_store, 0, view.sections[0].records, (int)count);
+    snapshot_close(&view);
+    
+    for (int i = 0; i < (int)count; i++) {
+        const BorrowEntry *entry = borrow_at(i);
+        if (entry->book < 0 || entry->book >= borrow_book_keys.count ||
+            entry->reader < 0 || entry->reader >= borrow_reader_keys.count ||
+            ((entry->id & BORROW_ID_POOLED) && (entry->id & ~BORROW_ID_POOLED) >= (uint64_t)borrow_id_strings.count)) {
+            return -1;
+        }
     }
     
-    return count;
+    borrow_count = (int)count;
+    return 0;
 }
 
 /**
@@ -357,29 +2053,32 @@ int borrow_get_overdue(BorrowRecord *records, int max_count) {
  * @return 成功返回0，失败返回非0值
  */
 int borrow_save_data() {
-    FILE *file = fopen(BORROWS_FILE, "w");
-    if (file == NULL) {
+    // 等待后台合并结束，避免同时写同一个文件
+    journal_wait(&borrow_journal);
+    
+    BorrowSnapshot copy;
+    if (borrow_copy_live(&copy) != 0) {
         return -1;
     }
     
-    // 写入标题行
-    fprintf(file, "id,book_id,reader_id,borrow_date,due_date,return_date,status,renew_count\n");
+    int result = borrow_write_file(&copy);
+    borrow_release_copy(&copy);
+    if (result != 0) {
+        return -1;
+    }
     
-    // 写入数据
-    for (int i = 0; i < borrow_count; i++) {
-        fprintf(file, "%s,%s,%s,%ld,%ld,%ld,%d,%d\n",
-                borrows[i].id,
-                borrows[i].book_id,
-                borrows[i].reader_id,
-                (long)borrows[i].borrow_date,
-                (long)borrows[i].due_date,
-                (long)borrows[i].return_date,
-                borrows[i].status,
-                borrows[i].renew_count);
-    }
-    
-    fclose(file);
-    return 0;
+    // 数据文件已包含全部变更，日志可以清空
+    return journal_reset(&borrow_journal);
+}
+
+/**
+ * @brief 清空借阅记录及其引用的键表和非标准格式ID（保留内存）
+ */
+static void borrow_clear() {
+    borrow_count = 0;
+    borrow_key_table_clear(&borrow_reader_keys);
+    borrow_key_table_clear(&borrow_book_keys);
+    string_pool_clear(&borrow_id_strings);
 }
 
 /**
@@ -387,56 +2086,43 @@ int borrow_save_data() {
  * @return 成功返回0，失败返回非0值
  */
 int borrow_load_data() {
-    // 如果文件不存在，直接返回成功
-    if (!file_exists(BORROWS_FILE)) {
-        return 0;
+    borrow_clear();
+    
+    // 先加载最近一次完整写出的数据：优先使用二进制快照，没有可用快照时解析CSV
+    int from_csv = 0;
+    if (borrow_load_snapshot() != 0) {
+        borrow_clear();
+        if (borrow_load_csv() != 0) {
+            return -1;
+        }
+        from_csv = 1;
     }
     
-    FILE *file = fopen(BORROWS_FILE, "r");
-    if (file == NULL) {
+    // 建立按读者、按图书的借阅索引
+    if (borrow_rebuild_links() != 0) {
         return -1;
     }
     
-    char line[MAX_LINE_SIZE];
-    char *fields[8]; // id,book_id,reader_id,borrow_date,due_date,return_date,status,renew_count
+    // 从CSV加载时顺便生成快照，下次启动即可直接映射（快照只对应CSV的内容，在重放日志之前写出）
+    BorrowSnapshot copy;
+    if (from_csv && file_exists(BORROWS_FILE) && borrow_copy_live(&copy) == 0) {
+        borrow_write_binary(&copy);
+        borrow_release_copy(&copy);
+    }
     
-    // 跳过标题行
-    if (fgets(line, sizeof(line), file) == NULL) {
-        fclose(file);
-        return 0;
+    // 再在其上重放变更日志
+    int replayed = journal_replay(&borrow_journal, borrow_apply_journal, NULL);
+    if (replayed < 0) {
+        return -1;
     }
     
-    // 读取数据
-    borrow_count = 0;
-    while (fgets(line, sizeof(line), file) != NULL && borrow_count < borrow_capacity) {
-        // 去除换行符
-        line[strcspn(line, "\n")] = '\0';
-        
-        // 解析CSV行
-        if (parse_csv_line(line, fields, 8) != 8) {
-            continue;
-        }
-        
-        // 填充借阅记录结构体
-        strncpy(borrows[borrow_count].id, fields[0], sizeof(borrows[borrow_count].id) - 1);
-        borrows[borrow_count].id[sizeof(borrows[borrow_count].id) - 1] = '\0';
-        
-        strncpy(borrows[borrow_count].book_id, fields[1], sizeof(borrows[borrow_count].book_id) - 1);
-        borrows[borrow_count].book_id[sizeof(borrows[borrow_count].book_id) - 1] = '\0';
-        
-        strncpy(borrows[borrow_count].reader_id, fields[2], sizeof(borrows[borrow_count].reader_id) - 1);
-        borrows[borrow_count].reader_id[sizeof(borrows[borrow_count].reader_id) - 1] = '\0';
-        
-        borrows[borrow_count].borrow_date = (time_t)atol(fields[3]);
-        borrows[borrow_count].due_date = (time_t)atol(fields[4]);
-        borrows[borrow_count].return_date = (time_t)atol(fields[5]);
-        borrows[borrow_count].status = (BorrowStatus)atoi(fields[6]);
-        borrows[borrow_count].renew_count = atoi(fields[7]);
-        
-        borrow_count++;
+    // 日志保留下来，按与运行时相同的条件在后台合并回数据文件，启动时不重写整个数据文件；
+    // 上次合并中断留下了旧日志时无法启动新的合并，才同步写回
+    if (replayed > 0 && journal_has_old_log(&borrow_journal)) {
+        return borrow_save_data();
     }
+    borrow_maybe_compact();
     
-    fclose(file);
     return 0;
 }
 
@@ -444,11 +2130,10 @@ int borrow_load_data() {
  * @brief 清理借阅管理模块资源
  */
 void borrow_cleanup() {
-    if (borrows != NULL) {
-        free(borrows);
-        borrows = NULL;
-    }
+    journal_close(&borrow_journal);
+    
+    chunk_array_free(&borrow_store);
+    borrow_links_free();
     
     borrow_count = 0;
-    borrow_capacity = 0;
 }
\ No newline at end of file
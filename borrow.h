@@ -37,6 +37,29 @@ typedef struct {
     int renew_count;          /**< 续借次数 */
 } BorrowRecord;
 
+/**
+ * @brief 遍历借阅记录时的过滤函数
+ * @param record 借阅记录（只读，只在回调期间有效）
+ * @param user_data 用户数据
+ * @return 符合条件返回非0值，否则返回0
+ */
+typedef int (*BorrowFilterFunc)(const BorrowRecord *record, void *user_data);
+
+/**
+ * @brief 遍历借阅记录时的访问函数
+ * @param record 借阅记录（只读，只在回调期间有效）
+ * @param user_data 用户数据
+ * @return 返回0继续遍历，返回非0值停止
+ */
+typedef int (*BorrowVisitFunc)(const BorrowRecord *record, void *user_data);
+
+/**
+ * @brief 借阅记录变为逾期时的回调函数
+ * @param record 刚变为逾期的借阅记录
+ * @param user_data 用户数据
+ */
+typedef void (*BorrowOverdueFunc)(const BorrowRecord *record, void *user_data);
+
 /**
  * @brief 初始化借阅管理模块
  * @return 成功返回0，失败返回非0值
@@ -93,6 +116,24 @@ int borrow_find_by_reader(const char *reader_id, BorrowRecord *records, int max_
  */
 int borrow_find_by_book(const char *book_id, BorrowRecord *records, int max_count);
 
+/**
+ * @brief 查找读者当前未归还的借阅记录
+ * @param reader_id 读者ID
+ * @param records 用于存储查找结果的借阅记录结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的借阅记录数量
+ */
+int borrow_find_active_by_reader(const char *reader_id, BorrowRecord *records, int max_count);
+
+/**
+ * @brief 查找图书当前未归还的借阅记录
+ * @param book_id 图书ID
+ * @param records 用于存储查找结果的借阅记录结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的借阅记录数量
+ */
+int borrow_find_active_by_book(const char *book_id, BorrowRecord *records, int max_count);
+
 /**
  * @brief 获取所有借阅记录
  * @param records 用于存储借阅记录的结构体数组
@@ -101,6 +142,37 @@ int borrow_find_by_book(const char *book_id, BorrowRecord *records, int max_coun
  */
 int borrow_get_all(BorrowRecord *records, int max_count);
 
+/**
+ * @brief 按录入顺序遍历借阅记录，逐条还原到同一个临时结构体中，不分配内存
+ *
+ * 遍历期间（包括回调函数中）不能增删改借阅记录。
+ *
+ * @param filter 过滤函数，返回非0的借阅记录才交给visit，为NULL时不过滤
+ * @param offset 跳过前offset条符合条件的借阅记录（用于翻页）
+ * @param limit 最多访问的数量（页大小），不大于0时不限
+ * @param visit 访问函数，返回非0时停止遍历
+ * @param user_data 传给filter和visit的用户数据
+ * @return 返回访问的借阅记录数量
+ */
+int borrow_foreach(BorrowFilterFunc filter, int offset, int limit, BorrowVisitFunc visit, void *user_data);
+
+/**
+ * @brief 检查新出现的逾期借阅
+ *
+ * 把应还日期已过的未归还记录标记为逾期，只记录发生变化的记录，
+ * 并对每条记录调用逾期回调函数。开销与新逾期的记录数成正比，可以定时调用。
+ *
+ * @return 返回本次新变为逾期的记录数量
+ */
+int borrow_check_overdue();
+
+/**
+ * @brief 设置借阅记录变为逾期时的回调函数
+ * @param callback 回调函数，为NULL时取消
+ * @param user_data 用户数据
+ */
+void borrow_set_overdue_callback(BorrowOverdueFunc callback, void *user_data);
+
 /**
  * @brief 获取逾期的借阅记录
  * @param records 用于存储借阅记录的结构体数组
@@ -109,6 +181,25 @@ int borrow_get_all(BorrowRecord *records, int max_count);
  */
 int borrow_get_overdue(BorrowRecord *records, int max_count);
 
+/**
+ * @brief 检查借阅记录引用的图书和读者是否存在
+ *
+ * 需要在图书和读者模块加载完成之后调用。
+ *
+ * @return 返回引用了不存在的图书或读者的记录数
+ */
+int borrow_validate();
+
+/**
+ * @brief 设置解析借阅数据文件使用的线程数
+ *
+ * 只影响之后的加载。自动选择时按CPU核心数，并保证每个线程至少分到8MB数据，
+ * 因此单核机器上或文件较小时单线程解析，不创建线程。
+ *
+ * @param count 线程数，0表示自动选择（最多8个）
+ */
+void borrow_set_load_threads(int count);
+
 /**
  * @brief 保存借阅数据到文件
  * @return 成功返回0，失败返回非0值
@@ -0,0 +1,174 @@
+/**
+ * @file chunk_array.c
+ * @brief 分块记录数组相关函数的实现
+ */
+
+#include "chunk_array.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 初始化分块记录数组（不分配任何块）
+ * @param array 分块记录数组
+ * @param record_size 每条记录的字节数
+ * @return 成功返回0，失败返回非0值
+ */
+int chunk_array_init(ChunkArray *array, size_t record_size) {
+    if (array == NULL || record_size == 0) {
+        return -1;
+    }
+    
+    array->chunks = NULL;
+    array->chunk_count = 0;
+    array->table_capacity = 0;
+    array->record_size = record_size;
+    return 0;
+}
+
+/**
+ * @brief 释放分块记录数组
+ * @param array 分块记录数组
+ */
+void chunk_array_free(ChunkArray *array) {
+    if (array == NULL) {
+        return;
+    }
+    
+    for (int i = 0; i < array->chunk_count; i++) {
+        free(array->chunks[i]);
+    }
+    
+    free(array->chunks);
+    array->chunks = NULL;
+    array->chunk_count = 0;
+    array->table_capacity = 0;
+}
+
+/**
+ * @brief 确保容量足够，不足时按块追加
+ * @param array 分块记录数组
+ * @param count 需要的记录数
+ * @return 成功返回0，内存不足返回非0值（已有的块保持不变）
+ */
+int chunk_array_reserve(ChunkArray *array, int count) {
+    if (count < 0) {
+        return -1;
+    }
+    
+    int needed = (int)(((long)count + CHUNK_ARRAY_RECORDS - 1) >> CHUNK_ARRAY_SHIFT);
+    
+    if (needed > array->table_capacity) {
+        int capacity = array->table_capacity > 0 ? array->table_capacity : 16;
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+        
+        // 只有块指针表会移动，块本身保持原地
+        unsigned char **grown = (unsigned char **)realloc(array->chunks, sizeof(unsigned char *) * capacity);
+        if (grown == NULL) {
+            return -1;
+        }
+        
+        array->chunks = grown;
+        array->table_capacity = capacity;
+    }
+    
+    while (array->chunk_count < needed) {
+        unsigned char *chunk = (unsigned char *)malloc(array->record_size * CHUNK_ARRAY_RECORDS);
+        if (chunk == NULL) {
+            return -1;
+        }
+        array->chunks[array->chunk_count++] = chunk;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 释放不再需要的块（只保留容纳count条记录所需的块）
+ * @param array 分块记录数组
+ * @param count 需要保留的记录数
+ */
+void chunk_array_shrink(ChunkArray *array, int count) {
+    int needed = (int)(((long)count + CHUNK_ARRAY_RECORDS - 1) >> CHUNK_ARRAY_SHIFT);
+    
+    while (array->chunk_count > needed) {
+        free(array->chunks[--array->chunk_count]);
+    }
+}
+
+/**
+ * @brief 取容量（已分配的记录数）
+ * @param array 分块记录数组
+ * @return 容量
+ */
+int chunk_array_capacity(const ChunkArray *array) {
+    return array->chunk_count * CHUNK_ARRAY_RECORDS;
+}
+
+/**
+ * @brief 将连续存放的记录复制到数组中
+ * @param array 分块记录数组（容量需已足够）
+ * @param first 起始下标
+ * @param records 记录
+ * @param count 记录数量
+ */
+void chunk_array_write(ChunkArray *array, int first, const void *records, int count) {
+    const unsigned char *src = (const unsigned char *)records;
+    
+    // 按块分段复制
+    while (count > 0) {
+        int offset = first & CHUNK_ARRAY_MASK;
+        int n = CHUNK_ARRAY_RECORDS - offset < count ? CHUNK_ARRAY_RECORDS - offset : count;
+        memcpy(CHUNK_ARRAY_AT(array, first), src, array->record_size * n);
+        src += array->record_size * n;
+        first += n;
+        count -= n;
+    }
+}
+
+/**
+ * @brief 将数组中的记录复制到连续内存
+ * @param array 分块记录数组
+ * @param first 起始下标
+ * @param records 用于存储记录
+ * @param count 记录数量
+ */
+void chunk_array_read(const ChunkArray *array, int first, void *records, int count) {
+    unsigned char *dest = (unsigned char *)records;
+    
+    while (count > 0) {
+        int offset = first & CHUNK_ARRAY_MASK;
+        int n = CHUNK_ARRAY_RECORDS - offset < count ? CHUNK_ARRAY_RECORDS - offset : count;
+        memcpy(dest, CHUNK_ARRAY_AT(array, first), array->record_size * n);
+        dest += array->record_size * n;
+        first += n;
+        count -= n;
+    }
+}
+
+/**
+ * @brief 复制数组的前count条记录到另一个数组
+ * @param dest 目标数组（应是新初始化的）
+ * @param src 源数组
+ * @param count 记录数量
+ * @return 成功返回0，失败返回非0值
+ */
+int chunk_array_copy(ChunkArray *dest, const ChunkArray *src, int count) {
+    if (chunk_array_init(dest, src->record_size) != 0) {
+        return -1;
+    }
+    
+    if (chunk_array_reserve(dest, count) != 0) {
+        chunk_array_free(dest);
+        return -1;
+    }
+    
+    // 按整块复制，最后一块只复制用到的部分
+    for (int i = 0; i < dest->chunk_count; i++) {
+        int n = count - i * CHUNK_ARRAY_RECORDS < CHUNK_ARRAY_RECORDS ? count - i * CHUNK_ARRAY_RECORDS : CHUNK_ARRAY_RECORDS;
+        memcpy(dest->chunks[i], src->chunks[i], src->record_size * n);
+    }
+    
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+/**
+ * @file chunk_array.h
+ * @brief 分块记录数组相关函数和数据结构的声明
+ *
+ * 记录按固定条数分块存放，容量不足时只追加新块、扩充块指针表，
+ * 已有的块从不移动，所以记录地址在整个生命周期内保持不变，
+ * 不会像realloc整块数组那样让外部持有的指针失效，也没有整块复制的开销。
+ * 下标到地址的换算只需一次移位和一次掩码。
+ */
+
+#ifndef CHUNK_ARRAY_H
+#define CHUNK_ARRAY_H
+
+#include <stddef.h>
+
+#define CHUNK_ARRAY_SHIFT 12                            /**< 每块记录数的以2为底的对数 */
+#define CHUNK_ARRAY_RECORDS (1 << CHUNK_ARRAY_SHIFT)    /**< 每块的记录数 */
+#define CHUNK_ARRAY_MASK (CHUNK_ARRAY_RECORDS - 1)      /**< 块内下标掩码 */
+
+/**
+ * @brief 取记录地址（下标必须小于容量）
+ * @param array 分块记录数组
+ * @param index 记录下标
+ */
+#define CHUNK_ARRAY_AT(array, index) \
+    ((void *)((array)->chunks[(index) >> CHUNK_ARRAY_SHIFT] + \
+              (size_t)((index) & CHUNK_ARRAY_MASK) * (array)->record_size))
+
+/**
+ * @brief 分块记录数组
+ */
+typedef struct {
+    unsigned char **chunks;   /**< 块指针表 */
+    int chunk_count;          /**< 已分配的块数 */
+    int table_capacity;       /**< 块指针表容量 */
+    size_t record_size;       /**< 每条记录的字节数 */
+} ChunkArray;
+
+/**
+ * @brief 初始化分块记录数组（不分配任何块）
+ * @param array 分块记录数组
+ * @param record_size 每条记录的字节数
+ * @return 成功返回0，失败返回非0值
+ */
+int chunk_array_init(ChunkArray *array, size_t record_size);
+
+/**
+ * @brief 释放分块记录数组
+ * @param array 分块记录数组
+ */
+void chunk_array_free(ChunkArray *array);
+
+/**
+ * @brief 确保容量足够，不足时按块追加
+ * @param array 分块记录数组
+ * @param count 需要的记录数
+ * @return 成功返回0，内存不足返回非0值（已有的块保持不变）
+ */
+int chunk_array_reserve(ChunkArray *array, int count);
+
+/**
+ * @brief 释放不再需要的块（只保留容纳count条记录所需的块）
+ * @param array 分块记录数组
+ * @param count 需要保留的记录数
+ */
+void chunk_array_shrink(ChunkArray *array, int count);
+
+/**
+ * @brief 取容量（已分配的记录数）
+ * @param array 分块记录数组
+ * @return 容量
+ */
+int chunk_array_capacity(const ChunkArray *array);
+
+/**
+ * @brief 将连续存放的记录复制到数组中
+ * @param array 分块记录数组（容量需已足够）
+ * @param first 起始下标
+ * @param records 记录
+ * @param count 记录数量
+ */
+void chunk_array_write(ChunkArray *array, int first, const void *records, int count);
+
+/**
+ * @brief 将数组中的记录复制到连续内存
+ * @param array 分块记录数组
+ * @param first 起始下标
+ * @param records 用于存储记录
+ * @param count 记录数量
+ */
+void chunk_array_read(const ChunkArray *array, int first, void *records, int count);
+
+/**
+ * @brief 复制数组的前count条记录到另一个数组
+ * @param dest 目标数组（应是新初始化的）
+ * @param src 源数组
+ * @param count 记录数量
+ * @return 成功返回0，失败返回非0值
+ */
+int chunk_array_copy(ChunkArray *dest, const ChunkArray *src, int count);
+
+#endif /* CHUNK_ARRAY_H */
\ No newline at end of file
@@ -0,0 +1,573 @@
+/**
+ * @file csv.c
+ * @brief CSV读写相关函数的实现
+ */
+
+#include "csv.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define HAVE_CSV_SIMD 1
+#endif
+
+/**
+ * @brief 逐字节查找逗号、引号、\r、\n
+ * @param p 起始位置
+ * @param end 结束位置
+ * @return 第一个匹配的位置，没有则返回end
+ */
+static const char *csv_find_special_scalar(const char *p, const char *end) {
+    while (p < end && *p != ',' && *p != '"' && *p != '\n' && *p != '\r') {
+        p++;
+    }
+    
+    return p;
+}
+
+/**
+ * @brief 逐字节查找引号
+ * @param p 起始位置
+ * @param end 结束位置
+ * @return 第一个匹配的位置，没有则返回end
+ */
+static const char *csv_find_quote_scalar(const char *p, const char *end) {
+    while (p < end && *p != '"') {
+        p++;
+    }
+    
+    return p;
+}
+
+#ifdef HAVE_CSV_SIMD
+/**
+ * @brief 使用SSE2每次比较16字节，查找逗号、引号、\r、\n
+ * @param p 起始位置
+ * @param end 结束位置
+ * @return 第一个匹配的位置，没有则返回end
+ */
+__attribute__((target("sse2")))
+static const char *csv_find_special_sse2(const char *p, const char *end) {
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, quote)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask != 0) {
+            return p + __builtin_ctz((unsigned int)mask);
+        }
+        p += 16;
+    }
+    
+    return csv_find_special_scalar(p, end);
+}
+
+/**
+ * @brief 使用SSE2每次比较16字节，查找引号
+ * @param p 起始位置
+ * @param end 结束位置
+ * @return 第一个匹配的位置，没有则返回end
+ */
+__attribute__((target("sse2")))
+static const char *csv_find_quote_sse2(const char *p, const char *end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, quote));
+        if (mask != 0) {
+            return p + __builtin_ctz((unsigned int)mask);
+        }
+        p += 16;
+    }
+    
+    return csv_find_quote_scalar(p, end);
+}
+
+/**
+ * @brief 使用AVX2每次比较32字节，查找逗号、引号、\r、\n
+ * @param p 起始位置
+ * @param end 结束位置
+ * @return 第一个匹配的位置，没有则返回end
+ */
+__attribute__((target("avx2")))
+static const char *csv_find_special_avx2(const char *p, const char *end) {
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, comma), _mm256_cmpeq_epi8(v, quote)),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr)));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hit);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    
+    return csv_find_special_sse2(p, end);
+}
+
+/**
+ * @brief 使用AVX2每次比较32字节，查找引号
+ * @param p 起始位置
+ * @param end 结束位置
+ * @return 第一个匹配的位置，没有则返回end
+ */
+__attribute__((target("avx2")))
+static const char *csv_find_quote_avx2(const char *p, const char *end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    
+    return csv_find_quote_sse2(p, end);
+}
+#endif
+
+/**
+ * @brief 将整个CSV文件映射到内存
+ * @param path 文件路径
+ * @param file 用于存储映射结果
+ * @return 成功返回0，失败返回非0值
+ */
+int csv_file_open(const char *path, CsvFile *file) {
+    if (path == NULL || file == NULL) {
+        return -1;
+    }
+    
+    file->data = NULL;
+    file->len = 0;
+    file->mapped = 0;
+    
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    
+    // 写时复制映射：原地解析修改的是私有副本，不会写回文件
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    
+    if (map != MAP_FAILED) {
+        madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+        file->data = (char *)map;
+        file->len = (size_t)st.st_size;
+        file->mapped = 1;
+        return 0;
+    }
+#endif
+    
+    // 无法映射时退化为一次性读入内存
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return -1;
+    }
+    
+    if (fseek(fp, 0, SEEK_END) != 0) {
+        fclose(fp);
+        return -1;
+    }
+    
+    long size = ftell(fp);
+    if (size < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        return -1;
+    }
+    
+    file->data = (char *)malloc((size_t)size + 1);
+    if (file->data == NULL) {
+        fclose(fp);
+        return -1;
+    }
+    
+    file->len = fread(file->data, 1, (size_t)size, fp);
+    file->data[file->len] = '\0';
+    
+    fclose(fp);
+    return 0;
+}
+
+/**
+ * @brief 释放映射到内存的CSV文件
+ * @param file CSV文件
+ */
+void csv_file_close(CsvFile *file) {
+    if (file == NULL) {
+        return;
+    }
+    
+#ifndef _WIN32
+    if (file->mapped) {
+        munmap(file->data, file->len);
+    } else {
+        free(file->data);
+    }
+#else
+    free(file->data);
+#endif
+    
+    file->data = NULL;
+    file->len = 0;
+    file->mapped = 0;
+}
+
+/**
+ * @brief 初始化CSV读取器
+ * @param reader CSV读取器
+ * @param data 可写的CSV内容，解析时会被原地修改
+ * @param len 内容长度
+ */
+void csv_reader_init(CsvReader *reader, char *data, size_t len) {
+    reader->pos = data;
+    reader->end = data + len;
+    csv_reader_set_scan_mode(reader, CSV_SCAN_AUTO);
+}
+
+/**
+ * @brief 指定CSV读取器的分隔符扫描方式
+ * @param reader CSV读取器
+ * @param mode 扫描方式
+ * @return 成功返回0，当前CPU不支持该方式返回非0值
+ */
+int csv_reader_set_scan_mode(CsvReader *reader, CsvScanMode mode) {
+    if (reader == NULL) {
+        return -1;
+    }
+    
+#ifdef HAVE_CSV_SIMD
+    if (mode == CSV_SCAN_AUTO) {
+        mode = __builtin_cpu_supports("avx2") ? CSV_SCAN_AVX2 :
+               __builtin_cpu_supports("sse2") ? CSV_SCAN_SSE2 : CSV_SCAN_SCALAR;
+    }
+    
+    if (mode == CSV_SCAN_AVX2 && __builtin_cpu_supports("avx2")) {
+        reader->find_special = csv_find_special_avx2;
+        reader->find_quote = csv_find_quote_avx2;
+        return 0;
+    }
+    
+    if (mode == CSV_SCAN_SSE2 && __builtin_cpu_supports("sse2")) {
+        reader->find_special = csv_find_special_sse2;
+        reader->find_quote = csv_find_quote_sse2;
+        return 0;
+    }
+#else
+    if (mode == CSV_SCAN_AUTO) {
+        mode = CSV_SCAN_SCALAR;
+    }
+#endif
+    
+    reader->find_special = csv_find_special_scalar;
+    reader->find_quote = csv_find_quote_scalar;
+    return mode == CSV_SCAN_SCALAR ? 0 : -1;
+}
+
+/**
+ * @brief 读取一条记录
+ * @param reader CSV读取器
+ * @param fields 用于存储字段的数组
+ * @param max_fields 最大字段数，多出的字段只计数不保存
+ * @return 返回记录的字段数，没有更多记录时返回-1
+ */
+int csv_read_record(CsvReader *reader, CsvField *fields, int max_fields) {
+    if (reader == NULL || reader->pos >= reader->end) {
+        return -1;
+    }
+    
+    char *p = reader->pos;
+    char *end = reader->end;
+    int count = 0;
+    
+    for (;;) {
+        char *start = p;
+        size_t len;
+        
+        if (p < end && *p == '"') {
+            // 带引号的字段：""还原为"，引号内的逗号和换行都属于字段内容
+            char *out = ++p;
+            start = p;
+            
+            for (;;) {
+                char *quote = (char *)reader->find_quote(p, end);
+                memmove(out, p, (size_t)(quote - p));
+                out += quote - p;
+                p = quote;
+                
+                if (p >= end) {
+                    break;
+                }
+                if (p + 1 < end && p[1] == '"') {
+                    *out++ = '"';
+                    p += 2;
+                    continue;
+                }
+                p++;
+                break;
+            }
+            
+            // 结束引号后到分隔符之间的多余内容按原样保留
+            while (p < end && *p != ',' && *p != '\n' && *p != '\r') {
+                *out++ = *p++;
+            }
+            
+            len = (size_t)(out - start);
+        } else {
+            // 未加引号的字段中出现的引号按普通字符处理
+            p = (char *)reader->find_special(p, end);
+            while (p < end && *p == '"') {
+                p = (char *)reader->find_special(p + 1, end);
+            }
+            len = (size_t)(p - start);
+        }
+        
+        if (count < max_fields) {
+            fields[count].data = start;
+            fields[count].len = len;
+        }
+        count++;
+        
+        if (p < end && *p == ',') {
+            p++;
+            continue;
+        }
+        
+        // 记录结束，兼容\r\n、\n和\r
+        if (p < end && *p == '\r') {
+            p++;
+        }
+        if (p < end && *p == '\n') {
+            p++;
+        }
+        break;
+    }
+    
+    reader->pos = p;
+    return count;
+}
+
+/**
+ * @brief 按csv_read_record的规则跟踪一段内容中的引号状态
+ *
+ * 只有字段开头（内容开头或紧跟在逗号、换行、回车之后）的引号才开始带引号的字段；
+ * 带引号的字段中""表示一个引号，单独的引号结束该字段；其余位置的引号按普通字符处理。
+ *
+ * @param scanner 提供引号扫描函数的读取器
+ * @param data CSV内容开头
+ * @param p 起始位置
+ * @param limit 跟踪到的位置
+ * @param end 内容结尾
+ * @param in_quotes 是否在带引号的字段内，跟踪后更新
+ * @return 继续跟踪的起始位置（""跨过limit时大于limit）
+ */
+static const char *csv_track_quotes(const CsvReader *scanner, const char *data, const char *p,
+                                    const char *limit, const char *end, int *in_quotes) {
+    const char *quote;
+    
+    while (p < limit && (quote = scanner->find_quote(p, limit)) < limit) {
+        if (*in_quotes) {
+            if (quote + 1 < end && quote[1] == '"') {
+                p = quote + 2;
+                continue;
+            }
+            *in_quotes = 0;
+        } else if (quote == data || quote[-1] == ',' || quote[-1] == '\n' || quote[-1] == '\r') {
+            *in_quotes = 1;
+        }
+        p = quote + 1;
+    }
+    
+    return p > limit ? p : limit;
+}
+
+/**
+ * @brief 将CSV内容切分为若干段，每段都从记录开头开始
+ * @param data CSV内容
+ * @param len 内容长度
+ * @param max_chunks 最多切分的段数
+ * @param offsets 用于存储各段起始偏移，至少max_chunks + 1个元素，最后一个为len
+ * @return 实际切分的段数
+ */
+int csv_split_chunks(const char *data, size_t len, int max_chunks, size_t *offsets) {
+    CsvReader scanner;
+    csv_reader_init(&scanner, (char *)data, len);
+    
+    const char *p = data;
+    const char *end = data + len;
+    int in_quotes = 0;
+    int count = 1;
+    
+    offsets[0] = 0;
+    
+    for (int i = 1; i < max_chunks && p < end; i++) {
+        const char *target = data + len / (size_t)max_chunks * (size_t)i;
+        if (target < p) {
+            continue;
+        }
+        
+        // 跟踪切分点之前的引号状态
+        p = csv_track_quotes(&scanner, data, p, target, end, &in_quotes);
+        
+        // 找到第一个不在带引号字段内的换行符
+        for (;;) {
+            const char *newline = (const char *)memchr(p, '\n', (size_t)(end - p));
+            if (newline == NULL) {
+                p = end;
+                break;
+            }
+            
+            csv_track_quotes(&scanner, data, p, newline, end, &in_quotes);
+            p = newline + 1;
+            
+            if (!in_quotes) {
+                break;
+            }
+        }
+        
+        if (p < end) {
+            offsets[count++] = (size_t)(p - data);
+        }
+    }
+    
+    offsets[count] = len;
+    return count;
+}
+
+/**
+ * @brief 将字段复制为以'\0'结尾的字符串（超长部分截断）
+ * @param field 字段
+ * @param buffer 目标缓冲区
+ * @param size 缓冲区大小
+ */
+void csv_field_copy(const CsvField *field, char *buffer, size_t size) {
+    if (buffer == NULL || size == 0) {
+        return;
+    }
+    
+    size_t len = field->len < size - 1 ? field->len : size - 1;
+    memcpy(buffer, field->data, len);
+    buffer[len] = '\0';
+}
+
+/**
+ * @brief 将字段解析为整数
+ * @param field 字段
+ * @return 解析结果，非数字返回0
+ */
+long csv_field_to_long(const CsvField *field) {
+    const char *p = field->data;
+    const char *end = field->data + field->len;
+    int negative = 0;
+    long value = 0;
+    
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    
+    return negative ? -value : value;
+}
+
+/**
+ * @brief 写入一个字段，必要时加引号并转义
+ * @param file 文件
+ * @param value 字段内容
+ * @return 成功返回0，失败返回非0值
+ */
+int csv_write_field(FILE *file, const char *value) {
+    if (file == NULL) {
+        return -1;
+    }
+    
+    if (value == NULL) {
+        return 0;
+    }
+    
+    // 只有包含逗号、引号或换行时才需要引号
+    if (strpbrk(value, ",\"\r\n") == NULL) {
+        return fputs(value, file) < 0 ? -1 : 0;
+    }
+    
+    if (fputc('"', file) == EOF) {
+        return -1;
+    }
+    
+    for (const char *p = value; *p; p++) {
+        if (*p == '"' && fputc('"', file) == EOF) {
+            return -1;
+        }
+        if (fputc(*p, file) == EOF) {
+            return -1;
+        }
+    }
+    
+    return fputc('"', file) == EOF ? -1 : 0;
+}
+
+/**
+ * @brief 写入一条记录（含换行符）
+ * @param file 文件
+ * @param fields 字段数组
+ * @param num_fields 字段数
+ * @return 成功返回0，失败返回非0值
+ */
+int csv_write_record(FILE *file, char **fields, int num_fields) {
+    if (file == NULL || fields == NULL) {
+        return -1;
+    }
+    
+    for (int i = 0; i < num_fields; i++) {
+        if (i > 0 && fputc(',', file) == EOF) {
+            return -1;
+        }
+        if (csv_write_field(file, fields[i]) != 0) {
+            return -1;
+        }
+    }
+    
+    return fputc('\n', file) == EOF ? -1 : 0;
+}
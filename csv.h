@@ -0,0 +1,148 @@
+/**
+ * @file csv.h
+ * @brief CSV读写相关函数和数据结构的声明
+ *
+ * 读取时把整个文件以写时复制方式映射到内存并原地解析，字段以切片形式返回，
+ * 引号转义在缓冲区内就地还原，解析过程中不做任何内存分配。
+ * 支持RFC 4180的引号、双引号转义以及引号内的换行。
+ *
+ * 分隔符扫描在运行时按CPU能力选择AVX2（每次32字节）、SSE2（每次16字节）
+ * 或逐字节实现，三者的解析结果完全相同（由tests/test_csv_scan.c做差分检查）。
+ */
+
+#ifndef CSV_H
+#define CSV_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/**
+ * @brief CSV字段（指向缓冲区内部，不以'\0'结尾）
+ */
+typedef struct {
+    char *data;   /**< 字段内容 */
+    size_t len;   /**< 字段长度 */
+} CsvField;
+
+/**
+ * @brief 分隔符扫描方式
+ */
+typedef enum {
+    CSV_SCAN_AUTO = 0,    /**< 按CPU能力自动选择 */
+    CSV_SCAN_SCALAR = 1,  /**< 逐字节扫描 */
+    CSV_SCAN_SSE2 = 2,    /**< SSE2，每次16字节 */
+    CSV_SCAN_AVX2 = 3     /**< AVX2，每次32字节 */
+} CsvScanMode;
+
+/**
+ * @brief 扫描函数：返回[p, end)中第一个目标字符的位置，没有则返回end
+ */
+typedef const char *(*CsvScanFunc)(const char *p, const char *end);
+
+/**
+ * @brief CSV读取器
+ */
+typedef struct {
+    char *pos;                 /**< 当前解析位置 */
+    char *end;                 /**< 缓冲区结尾 */
+    CsvScanFunc find_special;  /**< 查找逗号、引号、\r、\n */
+    CsvScanFunc find_quote;    /**< 查找引号 */
+} CsvReader;
+
+/**
+ * @brief 映射到内存的CSV文件
+ */
+typedef struct {
+    char *data;   /**< 文件内容（可写，修改不会写回文件） */
+    size_t len;   /**< 文件长度 */
+    int mapped;   /**< 是否通过mmap映射 */
+} CsvFile;
+
+/**
+ * @brief 将整个CSV文件映射到内存
+ * @param path 文件路径
+ * @param file 用于存储映射结果
+ * @return 成功返回0，失败返回非0值
+ */
+int csv_file_open(const char *path, CsvFile *file);
+
+/**
+ * @brief 释放映射到内存的CSV文件
+ * @param file CSV文件
+ */
+void csv_file_close(CsvFile *file);
+
+/**
+ * @brief 初始化CSV读取器
+ * @param reader CSV读取器
+ * @param data 可写的CSV内容，解析时会被原地修改
+ * @param len 内容长度
+ */
+void csv_reader_init(CsvReader *reader, char *data, size_t len);
+
+/**
+ * @brief 指定CSV读取器的分隔符扫描方式
+ * @param reader CSV读取器
+ * @param mode 扫描方式
+ * @return 成功返回0，当前CPU不支持该方式返回非0值
+ */
+int csv_reader_set_scan_mode(CsvReader *reader, CsvScanMode mode);
+
+/**
+ * @brief 读取一条记录
+ * @param reader CSV读取器
+ * @param fields 用于存储字段的数组
+ * @param max_fields 最大字段数，多出的字段只计数不保存
+ * @return 返回记录的字段数，没有更多记录时返回-1
+ */
+int csv_read_record(CsvReader *reader, CsvField *fields, int max_fields);
+
+/**
+ * @brief 将CSV内容切分为若干段，每段都从记录开头开始
+ *
+ * 切分点取在大致等分的位置之后第一个不在带引号字段内的换行符之后，
+ * 各段可以分别用独立的读取器并行解析，结果与整体顺序解析相同。
+ * 引号按与csv_read_record相同的规则识别：只有字段开头的引号开始带引号的字段，
+ * 未加引号字段中的引号按普通字符处理（tests/test_csv_scan.c检查两者一致）。
+ *
+ * @param data CSV内容
+ * @param len 内容长度
+ * @param max_chunks 最多切分的段数
+ * @param offsets 用于存储各段起始偏移，至少max_chunks + 1个元素，最后一个为len
+ * @return 实际切分的段数
+ */
+int csv_split_chunks(const char *data, size_t len, int max_chunks, size_t *offsets);
+
+/**
+ * @brief 将字段复制为以'\0'结尾的字符串（超长部分截断）
+ * @param field 字段
+ * @param buffer 目标缓冲区
+ * @param size 缓冲区大小
+ */
+void csv_field_copy(const CsvField *field, char *buffer, size_t size);
+
+/**
+ * @brief 将字段解析为整数
+ * @param field 字段
+ * @return 解析结果，非数字返回0
+ */
+long csv_field_to_long(const CsvField *field);
+
+/**
+ * @brief 写入一个字段，必要时加引号并转义
+ * @param file 文件
+ * @param value 字段内容
+ * @return 成功返回0，失败返回非0值
+ */
+int csv_write_field(FILE *file, const char *value);
+
+/**
+ * @brief 写入一条记录（含换行符）
+ * @param file 文件
+ * @param fields 字段数组
+ * @param num_fields 字段数
+ * @return 成功返回0，失败返回非0值
+ */
+int csv_write_record(FILE *file, char **fields, int num_fields);
+
+#endif /* CSV_H */
@@ -0,0 +1,351 @@
+/**
+ * @file fold_column.c
+ * @brief 折叠列相关函数的实现
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // memmem
+#endif
+
+#include "fold_column.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 初始化折叠列
+ * @param column 折叠列
+ * @param capacity 初始记录容量
+ * @param width 每条记录占用的字节数（取原字段的大小即可）
+ * @return 成功返回0，失败返回非0值
+ */
+int fold_column_init(FoldColumn *column, int capacity, int width) {
+    if (column == NULL || width <= 1) {
+        return -1;
+    }
+    
+    if (capacity < 16) {
+        capacity = 16;
+    }
+    
+    column->data = (char *)malloc((size_t)capacity * width);
+    if (column->data == NULL) {
+        return -1;
+    }
+    
+    column->width = width;
+    column->count = 0;
+    column->capacity = capacity;
+    column->long_rows = NULL;
+    column->long_text = NULL;
+    column->long_count = 0;
+    column->long_capacity = 0;
+    return 0;
+}
+
+/**
+ * @brief 释放折叠列
+ * @param column 折叠列
+ */
+void fold_column_free(FoldColumn *column) {
+    if (column == NULL) {
+        return;
+    }
+    
+    fold_column_clear(column);
+    free(column->long_rows);
+    free(column->long_text);
+    column->long_rows = NULL;
+    column->long_text = NULL;
+    column->long_capacity = 0;
+    
+    free(column->data);
+    column->data = NULL;
+    column->count = 0;
+    column->capacity = 0;
+}
+
+/**
+ * @brief 清空折叠列（保留内存）
+ * @param column 折叠列
+ */
+void fold_column_clear(FoldColumn *column) {
+    for (int i = 0; i < column->long_count; i++) {
+        free(column->long_text[i]);
+    }
+    column->long_count = 0;
+    column->count = 0;
+}
+
+/**
+ * @brief 在超长记录中二分查找第一个下标不小于index的位置
+ * @param column 折叠列
+ * @param index 记录下标
+ * @return 在long_rows中的位置
+ */
+static int fold_long_lower_bound(const FoldColumn *column, int index) {
+    int lo = 0;
+    int hi = column->long_count;
+    
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (column->long_rows[mid] < index) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    
+    return lo;
+}
+
+/**
+ * @brief 设置或清除一条记录的完整文本
+ * @param column 折叠列
+ * @param index 记录下标
+ * @param text 折叠后的完整文本（由折叠列接管），为NULL表示该记录不是超长记录
+ * @return 成功返回0，内存不足返回非0值（此时text已释放）
+ */
+static int fold_long_set(FoldColumn *column, int index, char *text) {
+    int position = fold_long_lower_bound(column, index);
+    int found = position < column->long_count && column->long_rows[position] == index;
+    
+    if (found) {
+        free(column->long_text[position]);
+        if (text != NULL) {
+            column->long_text[position] = text;
+            return 0;
+        }
+        
+        int tail = column->long_count - position - 1;
+        memmove(&column->long_rows[position], &column->long_rows[position + 1], sizeof(int) * tail);
+        memmove(&column->long_text[position], &column->long_text[position + 1], sizeof(char *) * tail);
+        column->long_count--;
+        return 0;
+    }
+    
+    if (text == NULL) {
+        return 0;
+    }
+    
+    if (column->long_count >= column->long_capacity) {
+        int capacity = column->long_capacity > 0 ? column->long_capacity * 2 : 16;
+        int *rows = (int *)realloc(column->long_rows, sizeof(int) * capacity);
+        if (rows == NULL) {
+            free(text);
+            return -1;
+        }
+        column->long_rows = rows;
+        
+        char **texts = (char **)realloc(column->long_text, sizeof(char *) * capacity);
+        if (texts == NULL) {
+            free(text);
+            return -1;
+        }
+        column->long_text = texts;
+        column->long_capacity = capacity;
+    }
+    
+    int tail = column->long_count - position;
+    memmove(&column->long_rows[position + 1], &column->long_rows[position], sizeof(int) * tail);
+    memmove(&column->long_text[position + 1], &column->long_text[position], sizeof(char *) * tail);
+    column->long_rows[position] = index;
+    column->long_text[position] = text;
+    column->long_count++;
+    return 0;
+}
+
+/**
+ * @brief 检查折叠后的文本是否包含查询串
+ * @param text 折叠后的文本
+ * @param pattern 折叠后的查询串
+ * @return 包含返回1，不包含返回0
+ */
+static int fold_text_match(const char *text, const FoldPattern *pattern) {
+    if (!pattern->plain) {
+        return utf8_matcher_match(&pattern->matcher, text);
+    }
+    
+    return memmem(text, strlen(text), pattern->text, pattern->len) != NULL;
+}
+
+/**
+ * @brief 设置一条记录的文本
+ * @param column 折叠列
+ * @param index 记录下标，等于记录数量时追加
+ * @param text 原始文本
+ * @return 成功返回0，失败返回非0值
+ */
+int fold_column_set(FoldColumn *column, int index, const char *text) {
+    if (index < 0 || index > column->count) {
+        return -1;
+    }
+    
+    if (index == column->count) {
+        if (column->count >= column->capacity) {
+            int capacity = column->capacity * 2;
+            char *grown = (char *)realloc(column->data, (size_t)capacity * column->width);
+            if (grown == NULL) {
+                return -1;
+            }
+            column->data = grown;
+            column->capacity = capacity;
+        }
+        column->count++;
+    }
+    
+    // 折叠后不会变长；余下部分补'\0'，保证查找时不会跨越两条记录
+    char *slot = column->data + (size_t)index * column->width;
+    size_t len = utf8_fold_string(text, slot, column->width);
+    memset(slot + len, 0, column->width - len);
+    
+    // 原文不短于固定宽度时可能被截断，截断了才另存完整文本
+    char *full = NULL;
+    size_t size = text != NULL ? strlen(text) + 1 : 0;
+    if (size > (size_t)column->width) {
+        full = (char *)malloc(size);
+        if (full == NULL) {
+            return -1;
+        }
+        if (utf8_fold_string(text, full, size) == len) {
+            free(full);
+            full = NULL;
+        }
+    }
+    
+    return fold_long_set(column, index, full);
+}
+
+/**
+ * @brief 删除一条记录（后面的记录前移）
+ * @param column 折叠列
+ * @param index 记录下标
+ */
+void fold_column_remove(FoldColumn *column, int index) {
+    if (index < 0 || index >= column->count) {
+        return;
+    }
+    
+    char *slot = column->data + (size_t)index * column->width;
+    memmove(slot, slot + column->width, (size_t)(column->count - index - 1) * column->width);
+    column->count--;
+    
+    // 超长记录的下标同样前移
+    fold_long_set(column, index, NULL);
+    for (int i = fold_long_lower_bound(column, index); i < column->long_count; i++) {
+        column->long_rows[i]--;
+    }
+}
+
+/**
+ * @brief 折叠查询串
+ * @param pattern 用于存储折叠结果
+ * @param text 查询串
+ * @return 成功返回0，失败返回非0值
+ */
+int fold_pattern_init(FoldPattern *pattern, const char *text) {
+    if (pattern == NULL || text == NULL) {
+        return -1;
+    }
+    
+    size_t size = strlen(text) + 1;
+    pattern->text = (char *)malloc(size);
+    if (pattern->text == NULL) {
+        return -1;
+    }
+    
+    pattern->len = utf8_fold_string(text, pattern->text, size);
+    
+    // 合法的UTF-8按字节匹配与按字符匹配等价；含非法字节时退回逐字符比较
+    pattern->plain = 1;
+    const char *p = pattern->text;
+    uint32_t c;
+    while ((c = utf8_next_char(&p)) != 0) {
+        if (c > 0x10FFFF) {
+            pattern->plain = 0;
+            break;
+        }
+    }
+    
+    if (!pattern->plain) {
+        utf8_matcher_init(&pattern->matcher, pattern->text);
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 释放折叠后的查询串
+ * @param pattern 折叠后的查询串
+ */
+void fold_pattern_free(FoldPattern *pattern) {
+    if (pattern == NULL) {
+        return;
+    }
+    
+    free(pattern->text);
+    pattern->text = NULL;
+}
+
+/**
+ * @brief 检查一条记录是否包含查询串（不区分大小写）
+ * @param column 折叠列
+ * @param index 记录下标
+ * @param pattern 折叠后的查询串
+ * @return 包含返回1，不包含返回0
+ */
+int fold_column_match(const FoldColumn *column, int index, const FoldPattern *pattern) {
+    if (index < 0 || index >= column->count) {
+        return 0;
+    }
+    
+    if (fold_text_match(column->data + (size_t)index * column->width, pattern)) {
+        return 1;
+    }
+    
+    // 定长部分只是超长记录的前缀，再查完整文本
+    int position = fold_long_lower_bound(column, index);
+    return position < column->long_count && column->long_rows[position] == index &&
+           fold_text_match(column->long_text[position], pattern);
+}
+
+/**
+ * @brief 查找下一条包含查询串的记录（不区分大小写）
+ * @param column 折叠列
+ * @param start 从该下标开始查找
+ * @param pattern 折叠后的查询串
+ * @return 找到返回记录下标，否则返回-1
+ */
+int fold_column_next(const FoldColumn *column, int start, const FoldPattern *pattern) {
+    if (start < 0) {
+        start = 0;
+    }
+    
+    if (start >= column->count) {
+        return -1;
+    }
+    
+    if (!pattern->plain) {
+        for (int i = start; i < column->count; i++) {
+            if (fold_column_match(column, i, pattern)) {
+                return i;
+            }
+        }
+        return -1;
+    }
+    
+    // 查询串不含'\0'，而每条记录至少以一个'\0'结尾，命中位置不会跨越两条记录
+    const char *begin = column->data + (size_t)start * column->width;
+    size_t len = (size_t)(column->count - start) * column->width;
+    const char *hit = (const char *)memmem(begin, len, pattern->text, pattern->len);
+    int row = hit != NULL ? (int)((hit - column->data) / column->width) : -1;
+    
+    // 命中位置之前的超长记录可能在定长部分之外包含查询串
+    int end = row != -1 ? row : column->count;
+    for (int i = fold_long_lower_bound(column, start); i < column->long_count && column->long_rows[i] < end; i++) {
+        if (fold_text_match(column->long_text[i], pattern)) {
+            return column->long_rows[i];
+        }
+    }
+    
+    return row;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file fold_column.h
+ * @brief 折叠列（可搜索字段的大小写折叠副本）相关函数和数据结构的声明
+ *
+ * 记录增删改时把字段折叠一次，按记录下标存放在一块连续内存中，
+ * 每条记录占固定宽度、不足部分补'\0'。查询时只折叠查询串，
+ * 然后对整块内存做memmem，不再逐条规范化字段。
+ *
+ * 折叠后超过固定宽度的记录（字段本身不限长度）在定长部分只存前缀，
+ * 完整文本另外按下标存放，查找时一并检查，长字段末尾的内容也能查到。
+ */
+
+#ifndef FOLD_COLUMN_H
+#define FOLD_COLUMN_H
+
+#include "utf8.h"
+#include <stddef.h>
+
+/**
+ * @brief 折叠列
+ */
+typedef struct {
+    char *data;          /**< 各记录折叠后的文本，每条占width字节 */
+    int width;           /**< 每条记录占用的字节数（含结尾的'\0'） */
+    int count;           /**< 记录数量 */
+    int capacity;        /**< 记录容量 */
+    int *long_rows;      /**< 超长记录的下标，升序 */
+    char **long_text;    /**< 超长记录折叠后的完整文本，与long_rows一一对应 */
+    int long_count;      /**< 超长记录数量 */
+    int long_capacity;   /**< 超长记录容量 */
+} FoldColumn;
+
+/**
+ * @brief 折叠后的查询串
+ */
+typedef struct {
+    char *text;           /**< 折叠后的查询串 */
+    size_t len;           /**< 查询串长度 */
+    int plain;            /**< 查询串是合法的UTF-8，可以直接按字节查找 */
+    Utf8Matcher matcher;  /**< 查询串含非法字节时逐字符比较用的匹配器 */
+} FoldPattern;
+
+/**
+ * @brief 初始化折叠列
+ * @param column 折叠列
+ * @param capacity 初始记录容量
+ * @param width 每条记录占用的字节数（取原字段的大小即可）
+ * @return 成功返回0，失败返回非0值
+ */
+int fold_column_init(FoldColumn *column, int capacity, int width);
+
+/**
+ * @brief 释放折叠列
+ * @param column 折叠列
+ */
+void fold_column_free(FoldColumn *column);
+
+/**
+ * @brief 清空折叠列（保留内存）
+ * @param column 折叠列
+ */
+void fold_column_clear(FoldColumn *column);
+
+/**
+ * @brief 设置一条记录的文本
+ * @param column 折叠列
+ * @param index 记录下标，等于记录数量时追加
+ * @param text 原始文本
+ * @return 成功返回0，失败返回非0值
+ */
+int fold_column_set(FoldColumn *column, int index, const char *text);
+
+/**
+ * @brief 删除一条记录（后面的记录前移）
+ * @param column 折叠列
+ * @param index 记录下标
+ */
+void fold_column_remove(FoldColumn *column, int index);
+
+/**
+ * @brief 折叠查询串
+ * @param pattern 用于存储折叠结果
+ * @param text 查询串
+ * @return 成功返回0，失败返回非0值
+ */
+int fold_pattern_init(FoldPattern *pattern, const char *text);
+
+/**
+ * @brief 释放折叠后的查询串
+ * @param pattern 折叠后的查询串
+ */
+void fold_pattern_free(FoldPattern *pattern);
+
+/**
+ * @brief 检查一条记录是否包含查询串（不区分大小写）
+ * @param column 折叠列
+ * @param index 记录下标
+ * @param pattern 折叠后的查询串
+ * @return 包含返回1，不包含返回0
+ */
+int fold_column_match(const FoldColumn *column, int index, const FoldPattern *pattern);
+
+/**
+ * @brief 查找下一条包含查询串的记录（不区分大小写）
+ * @param column 折叠列
+ * @param start 从该下标开始查找
+ * @param pattern 折叠后的查询串
+ * @return 找到返回记录下标，否则返回-1
+ */
+int fold_column_next(const FoldColumn *column, int start, const FoldPattern *pattern);
+
+#endif /* FOLD_COLUMN_H */
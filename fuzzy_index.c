@@ -0,0 +1,701 @@
+/**
+ * @file fuzzy_index.c
+ * @brief 模糊（容错）查找索引相关函数的实现
+ */
+
+#include "fuzzy_index.h"
+#include "utf8.h"
+#include <stdlib.h>
+#include <string.h>
+
+// 词的最大码点数，更长的部分在切分时丢弃
+#define FUZZY_MAX_TERM 32
+
+// 查询中参与匹配的最大词数
+#define FUZZY_MAX_QUERY_TERMS 8
+
+// 单个查询词允许的最大编辑距离
+#define FUZZY_MAX_DISTANCE 2
+
+// 词表哈希的初始槽数
+#define FUZZY_INITIAL_SLOTS 1024
+
+/**
+ * @brief 查询词在词表中命中的词
+ */
+typedef struct {
+    int term;       /**< 词编号 */
+    int distance;   /**< 编辑距离 */
+} FuzzyHit;
+
+/**
+ * @brief 查询词
+ */
+typedef struct {
+    uint32_t chars[FUZZY_MAX_TERM];   /**< 码点 */
+    int length;                       /**< 码点数 */
+    int max_distance;                 /**< 允许的最大编辑距离 */
+    FuzzyHit *hits;                   /**< 命中的词，按编辑距离升序 */
+    int hit_count;                    /**< 命中数量 */
+    int hit_capacity;                 /**< 命中数组容量 */
+    long volume;                      /**< 命中的词的倒排表总长度 */
+} FuzzyQueryTerm;
+
+/**
+ * @brief 从文本中切出下一个词
+ * @param p 当前位置，返回时指向词之后
+ * @param chars 用于存储词的码点（已折叠），至少FUZZY_MAX_TERM个
+ * @return 返回词的码点数，没有更多词时返回0
+ */
+static int fuzzy_next_term(const char **p, uint32_t *chars) {
+    uint32_t c = 0;
+    
+    // 跳过分隔符
+    while (**p != '\0') {
+        c = utf8_fold(utf8_next_char(p));
+        if (utf8_is_word_char(c)) {
+            break;
+        }
+    }
+    
+    if (!utf8_is_word_char(c)) {
+        return 0;
+    }
+    
+    int length = 0;
+    chars[length++] = c;
+    
+    while (**p != '\0') {
+        const char *start = *p;
+        c = utf8_fold(utf8_next_char(p));
+        if (!utf8_is_word_char(c)) {
+            *p = start;
+            break;
+        }
+        if (length < FUZZY_MAX_TERM) {
+            chars[length++] = c;
+        }
+    }
+    
+    return length;
+}
+
+/**
+ * @brief 计算两个词的编辑距离（插入、删除、替换各计1）
+ * @param a 第一个词
+ * @param a_length 第一个词的码点数
+ * @param b 第二个词
+ * @param b_length 第二个词的码点数
+ * @return 编辑距离
+ */
+static int fuzzy_distance(const uint32_t *a, int a_length, const uint32_t *b, int b_length) {
+    int row[FUZZY_MAX_TERM + 1];
+    
+    for (int j = 0; j <= b_length; j++) {
+        row[j] = j;
+    }
+    
+    for (int i = 1; i <= a_length; i++) {
+        int diagonal = row[0];
+        row[0] = i;
+        for (int j = 1; j <= b_length; j++) {
+            int above = row[j];
+            int best = diagonal + (a[i - 1] != b[j - 1]);
+            if (above + 1 < best) {
+                best = above + 1;
+            }
+            if (row[j - 1] + 1 < best) {
+                best = row[j - 1] + 1;
+            }
+            row[j] = best;
+            diagonal = above;
+        }
+    }
+    
+    return row[b_length];
+}
+
+/**
+ * @brief 计算词的哈希值（FNV-1a）
+ * @param chars 码点
+ * @param length 码点数
+ * @return 哈希值
+ */
+static unsigned int fuzzy_hash(const uint32_t *chars, int length) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ chars[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief 在词表中查找词
+ * @param index 模糊查找索引
+ * @param chars 码点
+ * @param length 码点数
+ * @param slot 用于返回词所在的槽或可插入的空槽，可为NULL
+ * @return 找到返回词编号，否则返回-1
+ */
+static int fuzzy_index_lookup(const FuzzyIndex *index, const uint32_t *chars, int length, unsigned int *slot) {
+    unsigned int i = fuzzy_hash(chars, length) & index->mask;
+    
+    while (index->slots[i] >= 0) {
+        const FuzzyTerm *term = &index->terms[index->slots[i]];
+        if (term->length == length && memcmp(term->chars, chars, sizeof(uint32_t) * length) == 0) {
+            break;
+        }
+        i = (i + 1) & index->mask;
+    }
+    
+    if (slot != NULL) {
+        *slot = i;
+    }
+    return index->slots[i];
+}
+
+/**
+ * @brief 词表哈希扩容
+ * @param index 模糊查找索引
+ * @return 成功返回0，失败返回非0值
+ */
+static int fuzzy_index_grow_slots(FuzzyIndex *index) {
+    unsigned int size = (index->mask + 1) * 2;
+    int *slots = (int *)malloc(sizeof(int) * size);
+    if (slots == NULL) {
+        return -1;
+    }
+    
+    memset(slots, -1, sizeof(int) * size);
+    for (int t = 0; t < index->term_count; t++) {
+        const FuzzyTerm *term = &index->terms[t];
+        unsigned int i = fuzzy_hash(term->chars, term->length) & (size - 1);
+        while (slots[i] >= 0) {
+            i = (i + 1) & (size - 1);
+        }
+        slots[i] = t;
+    }
+    
+    free(index->slots);
+    index->slots = slots;
+    index->mask = size - 1;
+    return 0;
+}
+
+/**
+ * @brief 将新词挂到BK树上
+ * @param index 模糊查找索引
+ * @param id 新词编号（不是根）
+ */
+static void fuzzy_index_link(FuzzyIndex *index, int id) {
+    FuzzyTerm *term = &index->terms[id];
+    int node = 0;
+    
+    for (;;) {
+        FuzzyTerm *parent = &index->terms[node];
+        int distance = fuzzy_distance(term->chars, term->length, parent->chars, parent->length);
+        
+        int child = parent->child;
+        while (child >= 0 && index->terms[child].edge != distance) {
+            child = index->terms[child].sibling;
+        }
+        
+        if (child < 0) {
+            term->edge = distance;
+            term->sibling = parent->child;
+            parent->child = id;
+            return;
+        }
+        node = child;
+    }
+}
+
+/**
+ * @brief 查找词，不存在时加入词表
+ * @param index 模糊查找索引
+ * @param chars 码点
+ * @param length 码点数
+ * @return 返回词编号，失败返回-1
+ */
+static int fuzzy_index_intern(FuzzyIndex *index, const uint32_t *chars, int length) {
+    unsigned int slot;
+    int id = fuzzy_index_lookup(index, chars, length, &slot);
+    if (id >= 0) {
+        return id;
+    }
+    
+    // 装载因子保持在1/2以下
+    if ((unsigned int)(index->term_count + 1) * 2 > index->mask + 1) {
+        if (fuzzy_index_grow_slots(index) != 0) {
+            return -1;
+        }
+        fuzzy_index_lookup(index, chars, length, &slot);
+    }
+    
+    if (index->term_count >= index->term_capacity) {
+        int capacity = index->term_capacity > 0 ? index->term_capacity * 2 : 256;
+        FuzzyTerm *grown = (FuzzyTerm *)realloc(index->terms, sizeof(FuzzyTerm) * capacity);
+        if (grown == NULL) {
+            return -1;
+        }
+        index->terms = grown;
+        index->term_capacity = capacity;
+    }
+    
+    uint32_t *copy = (uint32_t *)malloc(sizeof(uint32_t) * length);
+    if (copy == NULL) {
+        return -1;
+    }
+    memcpy(copy, chars, sizeof(uint32_t) * length);
+    
+    id = index->term_count++;
+    FuzzyTerm *term = &index->terms[id];
+    term->chars = copy;
+    term->length = length;
+    term->docs = NULL;
+    term->count = 0;
+    term->capacity = 0;
+    term->child = -1;
+    term->sibling = -1;
+    term->edge = 0;
+    index->slots[slot] = id;
+    
+    if (id > 0) {
+        fuzzy_index_link(index, id);
+    }
+    return id;
+}
+
+/**
+ * @brief 查找第一个不小于doc的位置
+ * @param docs 升序排列的文档编号
+ * @param count 文档数量
+ * @param doc 文档编号
+ * @return 位置
+ */
+static int fuzzy_lower_bound(const int *docs, int count, int doc) {
+    int low = 0;
+    int high = count;
+    
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (docs[mid] < doc) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    return low;
+}
+
+/**
+ * @brief 判断词的倒排表中是否有文档
+ * @param term 词
+ * @param doc 文档编号
+ * @return 有返回1，否则返回0
+ */
+static int fuzzy_term_has_doc(const FuzzyTerm *term, int doc) {
+    int position = fuzzy_lower_bound(term->docs, term->count, doc);
+    return position < term->count && term->docs[position] == doc;
+}
+
+/**
+ * @brief 将文档加入词的倒排表
+ * @param term 词
+ * @param doc 文档编号
+ * @return 成功返回0，失败返回非0值
+ */
+static int fuzzy_term_add_doc(FuzzyTerm *term, int doc) {
+    // 按编号顺序加入时直接追加
+    int position = term->count;
+    if (term->count > 0 && term->docs[term->count - 1] >= doc) {
+        position = fuzzy_lower_bound(term->docs, term->count, doc);
+        if (term->docs[position] == doc) {
+            return 0;
+        }
+    }
+    
+    if (term->count >= term->capacity) {
+        int capacity = term->capacity > 0 ? term->capacity * 2 : 4;
+        int *grown = (int *)realloc(term->docs, sizeof(int) * capacity);
+        if (grown == NULL) {
+            return -1;
+        }
+        term->docs = grown;
+        term->capacity = capacity;
+    }
+    
+    memmove(&term->docs[position + 1], &term->docs[position], sizeof(int) * (term->count - position));
+    term->docs[position] = doc;
+    term->count++;
+    return 0;
+}
+
+/**
+ * @brief 初始化模糊查找索引
+ * @param index 模糊查找索引
+ * @return 成功返回0，失败返回非0值
+ */
+int fuzzy_index_init(FuzzyIndex *index) {
+    if (index == NULL) {
+        return -1;
+    }
+    
+    index->terms = NULL;
+    index->term_count = 0;
+    index->term_capacity = 0;
+    index->doc_limit = 0;
+    index->slots = (int *)malloc(sizeof(int) * FUZZY_INITIAL_SLOTS);
+    if (index->slots == NULL) {
+        index->mask = 0;
+        return -1;
+    }
+    
+    memset(index->slots, -1, sizeof(int) * FUZZY_INITIAL_SLOTS);
+    index->mask = FUZZY_INITIAL_SLOTS - 1;
+    return 0;
+}
+
+/**
+ * @brief 清空模糊查找索引
+ * @param index 模糊查找索引
+ */
+void fuzzy_index_clear(FuzzyIndex *index) {
+    for (int t = 0; t < index->term_count; t++) {
+        free(index->terms[t].chars);
+        free(index->terms[t].docs);
+    }
+    
+    index->term_count = 0;
+    index->doc_limit = 0;
+    if (index->slots != NULL) {
+        memset(index->slots, -1, sizeof(int) * (index->mask + 1));
+    }
+}
+
+/**
+ * @brief 释放模糊查找索引
+ * @param index 模糊查找索引
+ */
+void fuzzy_index_free(FuzzyIndex *index) {
+    if (index == NULL) {
+        return;
+    }
+    
+    fuzzy_index_clear(index);
+    free(index->terms);
+    free(index->slots);
+    index->terms = NULL;
+    index->term_capacity = 0;
+    index->slots = NULL;
+    index->mask = 0;
+}
+
+/**
+ * @brief 将文档加入索引
+ * @param index 模糊查找索引
+ * @param doc 文档编号
+ * @param text 文档文本
+ * @return 成功返回0，失败返回非0值
+ */
+int fuzzy_index_add(FuzzyIndex *index, int doc, const char *text) {
+    uint32_t chars[FUZZY_MAX_TERM];
+    const char *p = text;
+    int length;
+    
+    if (doc >= index->doc_limit) {
+        index->doc_limit = doc + 1;
+    }
+    
+    while ((length = fuzzy_next_term(&p, chars)) > 0) {
+        int id = fuzzy_index_intern(index, chars, length);
+        if (id < 0 || fuzzy_term_add_doc(&index->terms[id], doc) != 0) {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 将文档从索引中移除（文档文本需与加入时相同）
+ * @param index 模糊查找索引
+ * @param doc 文档编号
+ * @param text 文档文本
+ */
+void fuzzy_index_remove(FuzzyIndex *index, int doc, const char *text) {
+    uint32_t chars[FUZZY_MAX_TERM];
+    const char *p = text;
+    int length;
+    
+    // 词在词表中保留，倒排表为空的词查询时跳过
+    while ((length = fuzzy_next_term(&p, chars)) > 0) {
+        int id = fuzzy_index_lookup(index, chars, length, NULL);
+        if (id < 0) {
+            continue;
+        }
+        
+        FuzzyTerm *term = &index->terms[id];
+        int position = fuzzy_lower_bound(term->docs, term->count, doc);
+        if (position < term->count && term->docs[position] == doc) {
+            memmove(&term->docs[position], &term->docs[position + 1], sizeof(int) * (term->count - position - 1));
+            term->count--;
+        }
+    }
+}
+
+/**
+ * @brief 删除文档，并把编号大于它的文档编号都减1（对应数组中删除元素后后面的元素前移）
+ * @param index 模糊查找索引
+ * @param doc 文档编号
+ * @param text 文档文本
+ */
+void fuzzy_index_delete(FuzzyIndex *index, int doc, const char *text) {
+    fuzzy_index_remove(index, doc, text);
+    
+    for (int t = 0; t < index->term_count; t++) {
+        FuzzyTerm *term = &index->terms[t];
+        for (int i = fuzzy_lower_bound(term->docs, term->count, doc + 1); i < term->count; i++) {
+            term->docs[i]--;
+        }
+    }
+    
+    if (doc < index->doc_limit) {
+        index->doc_limit--;
+    }
+}
+
+/**
+ * @brief 在BK树中查找与查询词编辑距离不超过阈值的词
+ * @param index 模糊查找索引
+ * @param query 查询词，结果存入其命中数组
+ * @return 成功返回0，失败返回非0值
+ */
+static int fuzzy_index_collect(const FuzzyIndex *index, FuzzyQueryTerm *query) {
+    int capacity = 64;
+    int top = 0;
+    int *stack = (int *)malloc(sizeof(int) * capacity);
+    if (stack == NULL) {
+        return -1;
+    }
+    
+    stack[top++] = 0;
+    while (top > 0) {
+        const FuzzyTerm *term = &index->terms[stack[--top]];
+        int distance = fuzzy_distance(query->chars, query->length, term->chars, term->length);
+        
+        if (distance <= query->max_distance && term->count > 0) {
+            if (query->hit_count >= query->hit_capacity) {
+                int grown_capacity = query->hit_capacity > 0 ? query->hit_capacity * 2 : 16;
+                FuzzyHit *grown = (FuzzyHit *)realloc(query->hits, sizeof(FuzzyHit) * grown_capacity);
+                if (grown == NULL) {
+                    free(stack);
+                    return -1;
+                }
+                query->hits = grown;
+                query->hit_capacity = grown_capacity;
+            }
+            
+            // 按编辑距离插入，保持命中数组升序
+            int position = query->hit_count++;
+            while (position > 0 && query->hits[position - 1].distance > distance) {
+                query->hits[position] = query->hits[position - 1];
+                position--;
+            }
+            query->hits[position].term = (int)(term - index->terms);
+            query->hits[position].distance = distance;
+            query->volume += term->count;
+        }
+        
+        // 由三角不等式，只有边长在[distance - k, distance + k]内的子树可能有结果
+        for (int child = term->child; child >= 0; child = index->terms[child].sibling) {
+            int edge = index->terms[child].edge;
+            if (edge < distance - query->max_distance || edge > distance + query->max_distance) {
+                continue;
+            }
+            
+            if (top >= capacity) {
+                int *grown = (int *)realloc(stack, sizeof(int) * capacity * 2);
+                if (grown == NULL) {
+                    free(stack);
+                    return -1;
+                }
+                stack = grown;
+                capacity *= 2;
+            }
+            stack[top++] = child;
+        }
+    }
+    
+    free(stack);
+    return 0;
+}
+
+/**
+ * @brief 模糊查找
+ *
+ * 查询词的容错阈值按长度决定：不超过2个字符必须完全相同，3到5个字符允许1处错误，
+ * 更长的允许2处错误。文档必须与每个查询词都匹配。
+ *
+ * @param index 模糊查找索引
+ * @param query 查询串
+ * @param matches 用于存储结果，按编辑距离之和升序、同距离按文档编号升序
+ * @param max_count 最大返回数量
+ * @return 返回结果数量，失败返回-1
+ */
+int fuzzy_index_search(const FuzzyIndex *index, const char *query, FuzzyMatch *matches, int max_count) {
+    FuzzyQueryTerm terms[FUZZY_MAX_QUERY_TERMS];
+    int term_count = 0;
+    int result = 0;
+    
+    if (query == NULL || matches == NULL || max_count <= 0 || index->term_count == 0) {
+        return 0;
+    }
+    
+    // 切分查询串，重复的词只保留一个
+    const char *p = query;
+    while (term_count < FUZZY_MAX_QUERY_TERMS) {
+        FuzzyQueryTerm *term = &terms[term_count];
+        term->length = fuzzy_next_term(&p, term->chars);
+        if (term->length == 0) {
+            break;
+        }
+        
+        int duplicate = 0;
+        for (int i = 0; i < term_count && !duplicate; i++) {
+            duplicate = terms[i].length == term->length &&
+                        memcmp(terms[i].chars, term->chars, sizeof(uint32_t) * term->length) == 0;
+        }
+        if (duplicate) {
+            continue;
+        }
+        
+        term->max_distance = term->length <= 2 ? 0 : term->length <= 5 ? 1 : FUZZY_MAX_DISTANCE;
+        term->hits = NULL;
+        term->hit_count = 0;
+        term->hit_capacity = 0;
+        term->volume = 0;
+        term_count++;
+    }
+    
+    if (term_count == 0) {
+        return 0;
+    }
+    
+    int *candidates = NULL;
+    unsigned char *best = NULL;
+    unsigned char *mark = NULL;
+    int candidate_count = 0;
+    
+    for (int t = 0; t < term_count; t++) {
+        if (fuzzy_index_collect(index, &terms[t]) != 0) {
+            result = -1;
+            goto cleanup;
+        }
+        if (terms[t].hit_count == 0) {
+            goto cleanup;
+        }
+    }
+    
+    // 按倒排表总长度升序处理，先用最有选择性的词确定候选集
+    for (int t = 1; t < term_count; t++) {
+        FuzzyQueryTerm moving = terms[t];
+        int position = t;
+        while (position > 0 && terms[position - 1].volume > moving.volume) {
+            terms[position] = terms[position - 1];
+            position--;
+        }
+        terms[position] = moving;
+    }
+    
+    // 第一个词：在按文档编号的数组上记录最小编辑距离，按编号顺序取出候选
+    best = (unsigned char *)malloc(index->doc_limit);
+    candidates = (int *)malloc(sizeof(int) * (terms[0].volume < index->doc_limit ? terms[0].volume : index->doc_limit));
+    if (best == NULL || candidates == NULL) {
+        result = -1;
+        goto cleanup;
+    }
+    
+    memset(best, 0xFF, index->doc_limit);
+    for (int h = 0; h < terms[0].hit_count; h++) {
+        const FuzzyTerm *term = &index->terms[terms[0].hits[h].term];
+        unsigned char distance = (unsigned char)terms[0].hits[h].distance;
+        for (int i = 0; i < term->count; i++) {
+            if (distance < best[term->docs[i]]) {
+                best[term->docs[i]] = distance;
+            }
+        }
+    }
+    
+    for (int doc = 0; doc < index->doc_limit; doc++) {
+        if (best[doc] != 0xFF) {
+            candidates[candidate_count++] = doc;
+        }
+    }
+    
+    // 其余的词：候选少时逐个在命中的词的倒排表中二分查找，候选多时把倒排表整体标记一遍再过滤，
+    // 两种方式都取最小编辑距离，找不到的候选淘汰
+    for (int t = 1; t < term_count && candidate_count > 0; t++) {
+        long probe_cost = (long)candidate_count * terms[t].hit_count * 16;
+        int kept = 0;
+        
+        if (probe_cost <= terms[t].volume + candidate_count) {
+            for (int c = 0; c < candidate_count; c++) {
+                int doc = candidates[c];
+                for (int h = 0; h < terms[t].hit_count; h++) {
+                    if (fuzzy_term_has_doc(&index->terms[terms[t].hits[h].term], doc)) {
+                        best[doc] = (unsigned char)(best[doc] + terms[t].hits[h].distance);
+                        candidates[kept++] = doc;
+                        break;
+                    }
+                }
+            }
+        } else {
+            if (mark == NULL && (mark = (unsigned char *)malloc(index->doc_limit)) == NULL) {
+                result = -1;
+                goto cleanup;
+            }
+            
+            memset(mark, 0xFF, index->doc_limit);
+            for (int h = 0; h < terms[t].hit_count; h++) {
+                const FuzzyTerm *term = &index->terms[terms[t].hits[h].term];
+                unsigned char distance = (unsigned char)terms[t].hits[h].distance;
+                for (int i = 0; i < term->count; i++) {
+                    if (distance < mark[term->docs[i]]) {
+                        mark[term->docs[i]] = distance;
+                    }
+                }
+            }
+            
+            for (int c = 0; c < candidate_count; c++) {
+                int doc = candidates[c];
+                if (mark[doc] != 0xFF) {
+                    best[doc] = (unsigned char)(best[doc] + mark[doc]);
+                    candidates[kept++] = doc;
+                }
+            }
+        }
+        candidate_count = kept;
+    }
+    
+    // 按编辑距离之和分桶输出，同一桶内保持文档编号顺序
+    for (int distance = 0; distance <= FUZZY_MAX_QUERY_TERMS * FUZZY_MAX_DISTANCE && result < max_count; distance++) {
+        for (int c = 0; c < candidate_count && result < max_count; c++) {
+            if (best[candidates[c]] == distance) {
+                matches[result].doc = candidates[c];
+                matches[result].distance = distance;
+                result++;
+            }
+        }
+    }
+    
+cleanup:
+    for (int t = 0; t < term_count; t++) {
+        free(terms[t].hits);
+    }
+    free(candidates);
+    free(best);
+    free(mark);
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+/**
+ * @file fuzzy_index.h
+ * @brief 模糊（容错）查找索引相关函数和数据结构的声明
+ *
+ * 文本按utf8_fold折叠后切分为词（连续的字母、数字或汉字），
+ * 每个词维护一个按文档编号升序排列的倒排表。所有不同的词组织成一棵BK树，
+ * 查询时对查询中的每个词在BK树中找出编辑距离（按字符计）不超过阈值的词，
+ * 各查询词命中的文档求交集，按编辑距离之和排序。
+ */
+
+#ifndef FUZZY_INDEX_H
+#define FUZZY_INDEX_H
+
+#include <stdint.h>
+
+/**
+ * @brief 词及其倒排表，同时是BK树的节点
+ */
+typedef struct {
+    uint32_t *chars;   /**< 词的码点（已折叠） */
+    int length;        /**< 码点数 */
+    int *docs;         /**< 按升序排列的文档编号 */
+    int count;         /**< 文档数量 */
+    int capacity;      /**< 文档数组容量 */
+    int child;         /**< BK树中第一个子节点，-1表示没有 */
+    int sibling;       /**< BK树中下一个兄弟节点，-1表示没有 */
+    int edge;          /**< 与父节点的编辑距离 */
+} FuzzyTerm;
+
+/**
+ * @brief 模糊查找索引
+ */
+typedef struct {
+    FuzzyTerm *terms;    /**< 词数组，0号词是BK树的根 */
+    int term_count;      /**< 词数量 */
+    int term_capacity;   /**< 词数组容量 */
+    int *slots;          /**< 词表哈希（开放寻址），存放词编号，-1表示空槽 */
+    unsigned int mask;   /**< 槽数减1（槽数为2的幂） */
+    int doc_limit;       /**< 文档编号上界（最大编号加1） */
+} FuzzyIndex;
+
+/**
+ * @brief 查询结果
+ */
+typedef struct {
+    int doc;        /**< 文档编号 */
+    int distance;   /**< 各查询词的编辑距离之和 */
+} FuzzyMatch;
+
+/**
+ * @brief 初始化模糊查找索引
+ * @param index 模糊查找索引
+ * @return 成功返回0，失败返回非0值
+ */
+int fuzzy_index_init(FuzzyIndex *index);
+
+/**
+ * @brief 清空模糊查找索引
+ * @param index 模糊查找索引
+ */
+void fuzzy_index_clear(FuzzyIndex *index);
+
+/**
+ * @brief 释放模糊查找索引
+ * @param index 模糊查找索引
+ */
+void fuzzy_index_free(FuzzyIndex *index);
+
+/**
+ * @brief 将文档加入索引
+ * @param index 模糊查找索引
+ * @param doc 文档编号
+ * @param text 文档文本
+ * @return 成功返回0，失败返回非0值
+ */
+int fuzzy_index_add(FuzzyIndex *index, int doc, const char *text);
+
+/**
+ * @brief 将文档从索引中移除（文档文本需与加入时相同）
+ * @param index 模糊查找索引
+ * @param doc 文档编号
+ * @param text 文档文本
+ */
+void fuzzy_index_remove(FuzzyIndex *index, int doc, const char *text);
+
+/**
+ * @brief 删除文档，并把编号大于它的文档编号都减1（对应数组中删除元素后后面的元素前移）
+ * @param index 模糊查找索引
+ * @param doc 文档编号
+ * @param text 文档文本
+ */
+void fuzzy_index_delete(FuzzyIndex *index, int doc, const char *text);
+
+/**
+ * @brief 模糊查找
+ *
+ * 查询词的容错阈值按长度决定：不超过2个字符必须完全相同，3到5个字符允许1处错误，
+ * 更长的允许2处错误。文档必须与每个查询词都匹配。
+ *
+ * @param index 模糊查找索引
+ * @param query 查询串
+ * @param matches 用于存储结果，按编辑距离之和升序、同距离按文档编号升序
+ * @param max_count 最大返回数量
+ * @return 返回结果数量，失败返回-1
+ */
+int fuzzy_index_search(const FuzzyIndex *index, const char *query, FuzzyMatch *matches, int max_count);
+
+#endif /* FUZZY_INDEX_H */
\ No newline at end of file
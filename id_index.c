@@ -0,0 +1,235 @@
+/**
+ * @file id_index.c
+ * @brief ID哈希索引相关函数的实现
+ */
+
+#include "id_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 计算ID的哈希值（FNV-1a）
+ * @param id 记录ID
+ * @return 哈希值
+ */
+static unsigned int id_index_hash(const char *id) {
+    unsigned int hash = 2166136261u;
+    
+    while (*id != '\0') {
+        hash ^= (unsigned char)*id++;
+        hash *= 16777619u;
+    }
+    
+    return hash;
+}
+
+/**
+ * @brief 把记录放入空槽（调用方保证ID不在索引中且有空槽）
+ * @param index ID索引
+ * @param record 记录下标
+ */
+static void id_index_place(IdIndex *index, int record) {
+    unsigned int slot = id_index_hash(index->key_of(record, index->user_data)) & index->mask;
+    
+    while (index->slots[slot] != -1) {
+        slot = (slot + 1) & index->mask;
+    }
+    
+    index->slots[slot] = record;
+}
+
+/**
+ * @brief 扩充槽数组，使槽数不少于记录数的2倍
+ * @param index ID索引
+ * @param needed 需要容纳的记录数
+ * @return 成功返回0，失败返回非0值
+ */
+static int id_index_grow(IdIndex *index, int needed) {
+    unsigned int slots = index->mask + 1;
+    if (slots >= (unsigned int)needed * 2) {
+        return 0;
+    }
+    
+    while (slots < (unsigned int)needed * 2) {
+        slots *= 2;
+    }
+    
+    int *grown = (int *)malloc(sizeof(int) * slots);
+    if (grown == NULL) {
+        return -1;
+    }
+    
+    // 原有记录逐个重新放入新的槽数组
+    int *old_slots = index->slots;
+    unsigned int old_count = index->mask + 1;
+    
+    memset(grown, -1, sizeof(int) * slots);
+    index->slots = grown;
+    index->mask = slots - 1;
+    
+    for (unsigned int i = 0; i < old_count; i++) {
+        if (old_slots[i] != -1) {
+            id_index_place(index, old_slots[i]);
+        }
+    }
+    
+    free(old_slots);
+    return 0;
+}
+
+/**
+ * @brief 初始化ID索引（槽数不少于容量的2倍，记录增多时自动扩容）
+ * @param index ID索引
+ * @param capacity 初始记录容量
+ * @param key_of 取记录ID的回调函数
+ * @param user_data 回调函数的用户数据
+ * @return 成功返回0，失败返回非0值
+ */
+int id_index_init(IdIndex *index, int capacity, IdIndexKeyFunc key_of, void *user_data) {
+    if (index == NULL || key_of == NULL) {
+        return -1;
+    }
+    
+    unsigned int slots = 16;
+    while (slots < (unsigned int)capacity * 2) {
+        slots *= 2;
+    }
+    
+    index->slots = (int *)malloc(sizeof(int) * slots);
+    if (index->slots == NULL) {
+        return -1;
+    }
+    
+    index->mask = slots - 1;
+    index->count = 0;
+    index->key_of = key_of;
+    index->user_data = user_data;
+    memset(index->slots, -1, sizeof(int) * slots);
+    return 0;
+}
+
+/**
+ * @brief 查找ID对应的记录下标
+ * @param index ID索引
+ * @param id 记录ID
+ * @return 找到返回下标，否则返回-1
+ */
+int id_index_find(const IdIndex *index, const char *id) {
+    if (index == NULL || index->slots == NULL || id == NULL) {
+        return -1;
+    }
+    
+    unsigned int slot = id_index_hash(id) & index->mask;
+    
+    while (index->slots[slot] != -1) {
+        if (strcmp(index->key_of(index->slots[slot], index->user_data), id) == 0) {
+            return index->slots[slot];
+        }
+        slot = (slot + 1) & index->mask;
+    }
+    
+    return -1;
+}
+
+/**
+ * @brief 将记录加入索引（ID已存在时保留先加入的记录）
+ * @param index ID索引
+ * @param record 记录下标
+ * @return 成功返回0，扩容失败返回非0值
+ */
+int id_index_insert(IdIndex *index, int record) {
+    const char *id = index->key_of(record, index->user_data);
+    unsigned int slot = id_index_hash(id) & index->mask;
+    
+    while (index->slots[slot] != -1) {
+        if (strcmp(index->key_of(index->slots[slot], index->user_data), id) == 0) {
+            return 0;
+        }
+        slot = (slot + 1) & index->mask;
+    }
+    
+    // 装载率超过一半时先扩容，扩容后重新找空槽
+    if (index->count + 1 > (int)((index->mask + 1) / 2)) {
+        if (id_index_grow(index, index->count + 1) != 0) {
+            return -1;
+        }
+        id_index_place(index, record);
+    } else {
+        index->slots[slot] = record;
+    }
+    
+    index->count++;
+    return 0;
+}
+
+/**
+ * @brief 将记录从索引中移除（移除后记录的ID仍需可读，调用方在清除记录前调用）
+ *
+ * 线性探测不能直接把槽置空，否则会截断后面记录的探测序列；
+ * 这里把后面连续的记录中可以前移的逐个移到空位上，不留墓碑。
+ *
+ * @param index ID索引
+ * @param record 记录下标
+ */
+void id_index_remove(IdIndex *index, int record) {
+    unsigned int slot = id_index_hash(index->key_of(record, index->user_data)) & index->mask;
+    
+    while (index->slots[slot] != record) {
+        if (index->slots[slot] == -1) {
+            return;
+        }
+        slot = (slot + 1) & index->mask;
+    }
+    
+    unsigned int hole = slot;
+    for (unsigned int next = (hole + 1) & index->mask; index->slots[next] != -1; next = (next + 1) & index->mask) {
+        unsigned int home = id_index_hash(index->key_of(index->slots[next], index->user_data)) & index->mask;
+        
+        // 起始槽不在(hole, next]之间的记录探测时会经过空位，需要前移
+        if (((next - home) & index->mask) >= ((next - hole) & index->mask)) {
+            index->slots[hole] = index->slots[next];
+            hole = next;
+        }
+    }
+    
+    index->slots[hole] = -1;
+    index->count--;
+}
+
+/**
+ * @brief 按记录数组重建索引
+ * @param index ID索引
+ * @param count 记录数量
+ * @return 成功返回0，扩容失败返回非0值
+ */
+int id_index_rebuild(IdIndex *index, int count) {
+    memset(index->slots, -1, sizeof(int) * (index->mask + 1));
+    index->count = 0;
+    
+    if (id_index_grow(index, count) != 0) {
+        return -1;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        if (id_index_insert(index, i) != 0) {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 释放ID索引
+ * @param index ID索引
+ */
+void id_index_free(IdIndex *index) {
+    if (index == NULL) {
+        return;
+    }
+    
+    free(index->slots);
+    index->slots = NULL;
+    index->mask = 0;
+    index->count = 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file id_index.h
+ * @brief ID哈希索引相关函数和数据结构的声明
+ *
+ * 开放寻址、线性探测的哈希表，把字符串ID映射到记录数组下标。
+ * 表中只存下标，ID通过回调函数从记录数组中取得，
+ * 因此记录移动后只需重建索引，不需要复制ID。
+ */
+
+#ifndef ID_INDEX_H
+#define ID_INDEX_H
+
+/**
+ * @brief 取记录ID的回调函数
+ * @param index 记录下标
+ * @param user_data 用户数据
+ * @return 记录ID
+ */
+typedef const char *(*IdIndexKeyFunc)(int index, void *user_data);
+
+/**
+ * @brief ID哈希索引结构体
+ */
+typedef struct {
+    int *slots;               /**< 槽数组，存放记录下标，-1表示空槽 */
+    unsigned int mask;        /**< 槽数减1（槽数为2的幂） */
+    int count;                /**< 已加入的记录数 */
+    IdIndexKeyFunc key_of;    /**< 取记录ID的回调函数 */
+    void *user_data;          /**< 回调函数的用户数据 */
+} IdIndex;
+
+/**
+ * @brief 初始化ID索引（槽数不少于容量的2倍，记录增多时自动扩容）
+ * @param index ID索引
+ * @param capacity 初始记录容量
+ * @param key_of 取记录ID的回调函数
+ * @param user_data 回调函数的用户数据
+ * @return 成功返回0，失败返回非0值
+ */
+int id_index_init(IdIndex *index, int capacity, IdIndexKeyFunc key_of, void *user_data);
+
+/**
+ * @brief 查找ID对应的记录下标
+ * @param index ID索引
+ * @param id 记录ID
+ * @return 找到返回下标，否则返回-1
+ */
+int id_index_find(const IdIndex *index, const char *id);
+
+/**
+ * @brief 将记录加入索引（ID已存在时保留先加入的记录）
+ * @param index ID索引
+ * @param record 记录下标
+ * @return 成功返回0，扩容失败返回非0值
+ */
+int id_index_insert(IdIndex *index, int record);
+
+/**
+ * @brief 将记录从索引中移除（移除后记录的ID仍需可读，调用方在清除记录前调用）
+ * @param index ID索引
+ * @param record 记录下标
+ */
+void id_index_remove(IdIndex *index, int record);
+
+/**
+ * @brief 按记录数组重建索引
+ * @param index ID索引
+ * @param count 记录数量
+ * @return 成功返回0，扩容失败返回非0值
+ */
+int id_index_rebuild(IdIndex *index, int count);
+
+/**
+ * @brief 释放ID索引
+ * @param index ID索引
+ */
+void id_index_free(IdIndex *index);
+
+#endif /* ID_INDEX_H */
@@ -0,0 +1,392 @@
+/**
+ * @file journal.c
+ * @brief 追加式变更日志相关函数的实现
+ */
+
+#include "journal.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define FSYNC(fd) _commit(fd)
+#define TRUNCATE(fd, len) _chsize(fd, (long)(len))
+#else
+#include <unistd.h>
+#define FSYNC(fd) fsync(fd)
+#define TRUNCATE(fd, len) ftruncate(fd, (off_t)(len))
+#endif
+
+/**
+ * @brief 计算一条日志的校验和
+ * @param op 操作类型
+ * @param fields 记录字段
+ * @param num_fields 字段数
+ * @return 校验和
+ */
+static uint32_t journal_checksum(char op, char **fields, int num_fields) {
+    uint32_t crc = crc32_compute(0, &op, 1);
+    
+    // 每个字段后附加'\0'，避免字段边界不同但拼接结果相同的情况
+    for (int i = 0; i < num_fields; i++) {
+        crc = crc32_compute(crc, fields[i], strlen(fields[i]) + 1);
+    }
+    
+    return crc;
+}
+
+/**
+ * @brief 计算重放时读到的一条日志的校验和
+ * @param op 操作类型
+ * @param fields 记录字段
+ * @param num_fields 字段数
+ * @return 校验和，与journal_checksum对同一条日志的结果相同
+ */
+static uint32_t journal_field_checksum(char op, const CsvField *fields, int num_fields) {
+    static const char separator = '\0';
+    uint32_t crc = crc32_compute(0, &op, 1);
+    
+    for (int i = 0; i < num_fields; i++) {
+        crc = crc32_compute(crc, fields[i].data, fields[i].len);
+        crc = crc32_compute(crc, &separator, 1);
+    }
+    
+    return crc;
+}
+
+/**
+ * @brief 重放单个日志文件
+ * @param path 日志文件路径
+ * @param last_seq 上一条日志的序号，重放后更新
+ * @param replay 重放回调函数
+ * @param user_data 用户数据
+ * @param trim_file 需要截掉损坏尾部时传入以追加方式打开的同一文件，否则为NULL
+ * @return 返回重放的条目数，失败返回-1
+ */
+static int journal_replay_file(const char *path, unsigned long *last_seq,
+                               JournalReplayFunc replay, void *user_data, FILE *trim_file) {
+    if (!file_exists(path)) {
+        return 0;
+    }
+    
+    CsvFile file;
+    if (csv_file_open(path, &file) != 0) {
+        return -1;
+    }
+    
+    CsvReader reader;
+    CsvField fields[JOURNAL_MAX_FIELDS]; // seq,crc,op,记录字段...
+    int num_fields;
+    int count = 0;
+    size_t valid_end = 0; // 最后一条有效日志之后的偏移
+    
+    csv_reader_init(&reader, file.data, file.len);
+    
+    while ((num_fields = csv_read_record(&reader, fields, JOURNAL_MAX_FIELDS)) >= 0) {
+        // 序号或校验和不对说明是写到一半的尾部，之后的内容一律丢弃
+        if (num_fields <= 3 || num_fields > JOURNAL_MAX_FIELDS || fields[2].len != 1) {
+            break;
+        }
+        
+        // 完整的日志以换行结尾，缺少换行的最后一条同样是没写完的
+        if (reader.pos[-1] != '\n' && reader.pos[-1] != '\r') {
+            break;
+        }
+        
+        unsigned long seq = (unsigned long)csv_field_to_long(&fields[0]);
+        char crc_str[16];
+        csv_field_copy(&fields[1], crc_str, sizeof(crc_str));
+        uint32_t crc = (uint32_t)strtoul(crc_str, NULL, 16);
+        char op = fields[2].data[0];
+        
+        if (seq <= *last_seq || crc != journal_field_checksum(op, fields + 3, num_fields - 3)) {
+            break;
+        }
+        
+        *last_seq = seq;
+        replay(op, fields + 3, num_fields - 3, user_data);
+        count++;
+        valid_end = (size_t)(reader.pos - file.data);
+    }
+    
+    size_t file_len = file.len;
+    csv_file_close(&file);
+    
+    // 截掉损坏的尾部，之后追加的日志从新的一行开始，不会粘在残缺的内容后面
+    if (trim_file != NULL && valid_end < file_len && TRUNCATE(fileno(trim_file), valid_end) != 0) {
+        return -1;
+    }
+    
+    return count;
+}
+
+/**
+ * @brief 后台合并线程入口
+ * @param arg 日志结构体
+ * @return 无
+ */
+static void *journal_compact_thread(void *arg) {
+    Journal *journal = (Journal *)arg;
+    
+    // 数据副本已完整写出，旧日志中的变更都已包含在内
+    if (journal->write_snapshot(journal->snapshot) == 0) {
+        remove(journal->old_path);
+    }
+    
+    pthread_mutex_lock(&journal->lock);
+    journal->snapshot = NULL;
+    journal->compacting = 0;
+    pthread_mutex_unlock(&journal->lock);
+    
+    return NULL;
+}
+
+/**
+ * @brief 打开变更日志
+ * @param journal 日志结构体
+ * @param path 日志文件路径
+ * @param min_compact_entries 触发后台合并的最小条目数
+ * @return 成功返回0，失败返回非0值
+ */
+int journal_open(Journal *journal, const char *path, int min_compact_entries) {
+    if (journal == NULL || path == NULL) {
+        return -1;
+    }
+    
+    memset(journal, 0, sizeof(Journal));
+    snprintf(journal->path, sizeof(journal->path), "%s", path);
+    snprintf(journal->old_path, sizeof(journal->old_path), "%s.old", path);
+    journal->next_seq = 1;
+    journal->min_compact_entries = min_compact_entries;
+    pthread_mutex_init(&journal->lock, NULL);
+    
+    journal->file = fopen(journal->path, "a");
+    if (journal->file == NULL) {
+        pthread_mutex_destroy(&journal->lock);
+        journal->path[0] = '\0';
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 按顺序重放旧日志和当前日志
+ * @param journal 日志结构体
+ * @param replay 重放回调函数
+ * @param user_data 用户数据
+ * @return 返回重放的条目数，失败返回-1
+ */
+int journal_replay(Journal *journal, JournalReplayFunc replay, void *user_data) {
+    if (journal == NULL || replay == NULL) {
+        return -1;
+    }
+    
+    unsigned long last_seq = 0;
+    
+    // 上次合并未完成时旧日志仍然存在，需要先于当前日志重放
+    int old_count = journal_replay_file(journal->old_path, &last_seq, replay, user_data, NULL);
+    if (old_count < 0) {
+        return -1;
+    }
+    
+    // 当前日志以追加方式打开，重放后截掉损坏的尾部
+    int count = journal_replay_file(journal->path, &last_seq, replay, user_data, journal->file);
+    if (count < 0) {
+        return -1;
+    }
+    
+    journal->next_seq = last_seq + 1;
+    journal->entry_count = count;
+    
+    return old_count + count;
+}
+
+/**
+ * @brief 追加一条日志
+ * @param journal 日志结构体
+ * @param op 操作类型
+ * @param fields 记录字段
+ * @param num_fields 字段数
+ * @return 成功返回0，失败返回非0值
+ */
+int journal_append(Journal *journal, char op, char **fields, int num_fields) {
+    if (journal == NULL || journal->file == NULL || fields == NULL ||
+        num_fields <= 0 || num_fields > JOURNAL_MAX_FIELDS - 3) {
+        return -1;
+    }
+    
+    char seq_str[24];
+    char crc_str[16];
+    char op_str[2] = {op, '\0'};
+    char *all_fields[JOURNAL_MAX_FIELDS];
+    
+    snprintf(seq_str, sizeof(seq_str), "%lu", journal->next_seq);
+    snprintf(crc_str, sizeof(crc_str), "%08x", (unsigned int)journal_checksum(op, fields, num_fields));
+    
+    all_fields[0] = seq_str;
+    all_fields[1] = crc_str;
+    all_fields[2] = op_str;
+    for (int i = 0; i < num_fields; i++) {
+        all_fields[i + 3] = fields[i];
+    }
+    
+    // 同步到磁盘后才算写入成功，返回之后即使断电变更也不会丢失
+    if (csv_write_record(journal->file, all_fields, num_fields + 3) != 0 ||
+        fflush(journal->file) != 0 || FSYNC(fileno(journal->file)) != 0) {
+        return -1;
+    }
+    
+    journal->next_seq++;
+    journal->entry_count++;
+    
+    return 0;
+}
+
+/**
+ * @brief 判断是否应当进行合并
+ * @param journal 日志结构体
+ * @param record_count 当前记录总数
+ * @return 需要合并返回1，否则返回0
+ */
+int journal_needs_compaction(Journal *journal, int record_count) {
+    if (journal == NULL) {
+        return 0;
+    }
+    
+    return journal->entry_count >= journal->min_compact_entries &&
+           journal->entry_count >= record_count / 8;
+}
+
+/**
+ * @brief 判断是否留有上次未完成合并的旧日志
+ * @param journal 日志结构体
+ * @return 存在返回1，否则返回0
+ */
+int journal_has_old_log(const Journal *journal) {
+    return journal != NULL && file_exists(journal->old_path);
+}
+
+/**
+ * @brief 在后台线程中合并日志
+ * @param journal 日志结构体
+ * @param write_snapshot 数据副本写出函数
+ * @param snapshot 数据副本
+ * @param free_snapshot 释放数据副本的函数
+ * @return 启动合并返回0，未启动返回非0值
+ */
+int journal_compact(Journal *journal, JournalSnapshotFunc write_snapshot,
+                    void *snapshot, void (*free_snapshot)(void *)) {
+    if (journal == NULL || journal->file == NULL || write_snapshot == NULL || snapshot == NULL) {
+        if (free_snapshot != NULL && snapshot != NULL) {
+            free_snapshot(snapshot);
+        }
+        return -1;
+    }
+    
+    pthread_mutex_lock(&journal->lock);
+    int busy = journal->compacting;
+    pthread_mutex_unlock(&journal->lock);
+    
+    // 已有合并在进行，或上次合并失败留下了旧日志，本次不再合并
+    if (busy || file_exists(journal->old_path)) {
+        free_snapshot(snapshot);
+        return 1;
+    }
+    
+    // 回收上一个已结束的合并线程
+    journal_wait(journal);
+    
+    // 切换到新的日志文件
+    fclose(journal->file);
+    journal->file = NULL;
+    
+    if (rename(journal->path, journal->old_path) != 0) {
+        journal->file = fopen(journal->path, "a");
+        free_snapshot(snapshot);
+        return -1;
+    }
+    
+    journal->file = fopen(journal->path, "a");
+    if (journal->file == NULL) {
+        free_snapshot(snapshot);
+        return -1;
+    }
+    journal->entry_count = 0;
+    
+    journal->write_snapshot = write_snapshot;
+    journal->snapshot = snapshot;
+    journal->compacting = 1;
+    
+    if (pthread_create(&journal->compact_thread, NULL, journal_compact_thread, journal) != 0) {
+        // 无法启动线程时直接同步写出
+        journal_compact_thread(journal);
+        return 0;
+    }
+    
+    journal->thread_started = 1;
+    return 0;
+}
+
+/**
+ * @brief 等待正在进行的后台合并结束
+ * @param journal 日志结构体
+ */
+void journal_wait(Journal *journal) {
+    if (journal == NULL || !journal->thread_started) {
+        return;
+    }
+    
+    pthread_join(journal->compact_thread, NULL);
+    journal->thread_started = 0;
+}
+
+/**
+ * @brief 清空日志（数据文件已完整写出之后调用）
+ * @param journal 日志结构体
+ * @return 成功返回0，失败返回非0值
+ */
+int journal_reset(Journal *journal) {
+    if (journal == NULL) {
+        return -1;
+    }
+    
+    journal_wait(journal);
+    
+    if (journal->file != NULL) {
+        fclose(journal->file);
+    }
+    
+    remove(journal->old_path);
+    
+    journal->file = fopen(journal->path, "w");
+    if (journal->file == NULL) {
+        return -1;
+    }
+    
+    journal->entry_count = 0;
+    return 0;
+}
+
+/**
+ * @brief 关闭变更日志
+ * @param journal 日志结构体
+ */
+void journal_close(Journal *journal) {
+    if (journal == NULL || journal->path[0] == '\0') {
+        return;
+    }
+    
+    journal_wait(journal);
+    
+    if (journal->file != NULL) {
+        fclose(journal->file);
+        journal->file = NULL;
+    }
+    
+    pthread_mutex_destroy(&journal->lock);
+    journal->path[0] = '\0';
+    journal->entry_count = 0;
+}
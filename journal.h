@@ -0,0 +1,151 @@
+/**
+ * @file journal.h
+ * @brief 追加式变更日志相关函数和数据结构的声明
+ *
+ * 每次增删改只向日志文件追加一条记录（序号 + 校验和 + 操作 + 字段），
+ * 启动时在最近一次完整数据文件之上重放日志；日志条目累积到一定数量后，
+ * 在后台线程中把内存数据的副本写回数据文件，并丢弃已合并的日志。
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include "csv.h"
+
+#define JOURNAL_OP_PUT    'P'  /**< 写入记录（新增或整体覆盖） */
+#define JOURNAL_OP_DELETE 'D'  /**< 按ID删除记录 */
+#define JOURNAL_OP_COUNT  'C'  /**< 按ID只改写记录中的数量字段 */
+
+#define JOURNAL_MAX_FIELDS 16  /**< 每条日志最多携带的字段数 */
+
+/**
+ * @brief 日志重放回调函数
+ * @param op 操作类型（JOURNAL_OP_PUT / JOURNAL_OP_DELETE / JOURNAL_OP_COUNT）
+ * @param fields 记录字段
+ * @param num_fields 字段数
+ * @param user_data 用户数据
+ * @return 成功返回0，失败返回非0值
+ */
+typedef int (*JournalReplayFunc)(char op, const CsvField *fields, int num_fields, void *user_data);
+
+/**
+ * @brief 数据快照写出函数，在后台线程中调用，负责写出并释放snapshot
+ * @param snapshot 数据副本
+ * @return 成功返回0，失败返回非0值
+ */
+typedef int (*JournalSnapshotFunc)(void *snapshot);
+
+/**
+ * @brief 变更日志结构体
+ */
+typedef struct {
+    char path[256];               /**< 当前日志文件路径 */
+    char old_path[264];           /**< 合并中的旧日志文件路径 */
+    FILE *file;                   /**< 以追加方式打开的日志文件 */
+    unsigned long next_seq;       /**< 下一条日志的序号 */
+    int entry_count;              /**< 当前日志中的条目数 */
+    int min_compact_entries;      /**< 触发合并的最小条目数 */
+    int compacting;               /**< 后台合并是否正在进行 */
+    int thread_started;           /**< 是否存在尚未回收的合并线程 */
+    pthread_t compact_thread;     /**< 合并线程 */
+    pthread_mutex_t lock;         /**< 保护compacting标志 */
+    JournalSnapshotFunc write_snapshot; /**< 合并时使用的写出函数 */
+    void *snapshot;               /**< 合并时使用的数据副本 */
+} Journal;
+
+/**
+ * @brief 打开变更日志
+ * @param journal 日志结构体
+ * @param path 日志文件路径
+ * @param min_compact_entries 触发后台合并的最小条目数
+ * @return 成功返回0，失败返回非0值
+ */
+int journal_open(Journal *journal, const char *path, int min_compact_entries);
+
+/**
+ * @brief 按顺序重放旧日志和当前日志
+ *
+ * 遇到序号不递增、校验和不匹配或缺少结尾换行的条目（通常是写到一半的尾部）即停止，
+ * 并把当前日志截断到最后一条有效条目之后，保证之后追加的条目从新的一行开始。
+ *
+ * @param journal 日志结构体
+ * @param replay 重放回调函数
+ * @param user_data 用户数据
+ * @return 返回重放的条目数，失败返回-1
+ */
+int journal_replay(Journal *journal, JournalReplayFunc replay, void *user_data);
+
+/**
+ * @brief 追加一条日志
+ *
+ * 写入后调用fsync，返回0时该条日志已落盘。
+ *
+ * @param journal 日志结构体
+ * @param op 操作类型
+ * @param fields 记录字段
+ * @param num_fields 字段数
+ * @return 成功返回0，失败返回非0值
+ */
+int journal_append(Journal *journal, char op, char **fields, int num_fields);
+
+/**
+ * @brief 判断是否应当进行合并
+ *
+ * 日志条目数达到最小值且不少于记录总数的1/8时返回1，
+ * 这样每次变更分摊到的合并开销是常数级的。
+ *
+ * @param journal 日志结构体
+ * @param record_count 当前记录总数
+ * @return 需要合并返回1，否则返回0
+ */
+int journal_needs_compaction(Journal *journal, int record_count);
+
+/**
+ * @brief 判断是否留有上次未完成合并的旧日志
+ *
+ * 旧日志存在时journal_compact不会启动新的合并，只能由调用方同步写出数据文件后
+ * 调用journal_reset清除。
+ *
+ * @param journal 日志结构体
+ * @return 存在返回1，否则返回0
+ */
+int journal_has_old_log(const Journal *journal);
+
+/**
+ * @brief 在后台线程中合并日志
+ *
+ * 当前日志被改名为旧日志后立即返回，新的变更写入新日志；
+ * 后台线程调用write_snapshot写出数据副本，成功后删除旧日志。
+ * 未能启动合并时（已有合并在进行等），由本函数负责释放snapshot。
+ *
+ * @param journal 日志结构体
+ * @param write_snapshot 数据副本写出函数
+ * @param snapshot 数据副本
+ * @param free_snapshot 释放数据副本的函数
+ * @return 启动合并返回0，未启动返回非0值
+ */
+int journal_compact(Journal *journal, JournalSnapshotFunc write_snapshot,
+                    void *snapshot, void (*free_snapshot)(void *));
+
+/**
+ * @brief 等待正在进行的后台合并结束
+ * @param journal 日志结构体
+ */
+void journal_wait(Journal *journal);
+
+/**
+ * @brief 清空日志（数据文件已完整写出之后调用）
+ * @param journal 日志结构体
+ * @return 成功返回0，失败返回非0值
+ */
+int journal_reset(Journal *journal);
+
+/**
+ * @brief 关闭变更日志
+ * @param journal 日志结构体
+ */
+void journal_close(Journal *journal);
+
+#endif /* JOURNAL_H */
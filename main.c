@@ -7,14 +7,46 @@
 #include <stdlib.h>
 #include <string.h>
 #include <locale.h>
+#include <pthread.h>
 #include "book.h"
 #include "reader.h"
 #include "borrow.h"
 #include "ui.h"
 #include "utils.h"
 
+/**
+ * @brief 模块初始化任务
+ */
+typedef struct {
+    const char *name;         /**< 模块名称 */
+    int (*init)();            /**< 初始化函数 */
+    void (*cleanup)();        /**< 清理函数 */
+    int result;               /**< 初始化结果 */
+    double elapsed_ms;        /**< 初始化耗时（毫秒） */
+    pthread_t thread;         /**< 工作线程 */
+    int thread_started;       /**< 是否在工作线程中运行 */
+} InitTask;
+
+/**
+ * @brief 在工作线程中初始化一个模块
+ * @param arg 初始化任务
+ * @return 总是返回NULL
+ */
+static void *init_worker(void *arg) {
+    InitTask *task = (InitTask *)arg;
+    double start = monotonic_ms();
+    
+    task->result = task->init();
+    task->elapsed_ms = monotonic_ms() - start;
+    return NULL;
+}
+
 /**
  * @brief 初始化应用程序
+ *
+ * 三个数据文件互不依赖，有多个CPU核心时分别在各自的工作线程中加载，
+ * 单核机器上依次在当前线程中加载；全部加载完成后再检查借阅记录对图书和读者的引用。
+ *
  * @return 成功返回0，失败返回非0值
  */
 static int init_application() {
@@ -24,25 +56,58 @@ static int init_application() {
         return -1;
     }
     
-    // 初始化各模块
-    if (book_init() != 0) {
-        fprintf(stderr, "Error: Failed to initialize book module\n");
-        return -1;
+    InitTask tasks[] = {
+        {"book", book_init, book_cleanup, 0, 0.0, 0, 0},
+        {"reader", reader_init, reader_cleanup, 0, 0.0, 0, 0},
+        {"borrow", borrow_init, borrow_cleanup, 0, 0.0, 0, 0}
+    };
+    int task_count = (int)(sizeof(tasks) / sizeof(tasks[0]));
+    double start = monotonic_ms();
+    
+    // 并行加载各模块，单核或线程创建失败时在当前线程中加载
+    int parallel = cpu_count() > 1;
+    for (int i = 0; i < task_count; i++) {
+        if (parallel && pthread_create(&tasks[i].thread, NULL, init_worker, &tasks[i]) == 0) {
+            tasks[i].thread_started = 1;
+        } else {
+            init_worker(&tasks[i]);
+        }
     }
     
-    if (reader_init() != 0) {
-        fprintf(stderr, "Error: Failed to initialize reader module\n");
-        book_cleanup();
-        return -1;
+    int failed = 0;
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].thread_started) {
+            pthread_join(tasks[i].thread, NULL);
+        }
+        if (tasks[i].result != 0) {
+            fprintf(stderr, "Error: Failed to initialize %s module\n", tasks[i].name);
+            failed = 1;
+        }
     }
     
-    if (borrow_init() != 0) {
-        fprintf(stderr, "Error: Failed to initialize borrow module\n");
-        reader_cleanup();
-        book_cleanup();
+    double load_ms = monotonic_ms() - start;
+    
+    if (failed) {
+        for (int i = task_count - 1; i >= 0; i--) {
+            if (tasks[i].result == 0) {
+                tasks[i].cleanup();
+            }
+        }
         return -1;
     }
     
+    // 校验模块之间的引用关系
+    double validate_start = monotonic_ms();
+    int dangling = borrow_validate();
+    double validate_ms = monotonic_ms() - validate_start;
+    
+    if (dangling > 0) {
+        fprintf(stderr, "Warning: %d borrow records reference missing books or readers\n", dangling);
+    }
+    
+    printf("Startup: book %.1f ms, reader %.1f ms, borrow %.1f ms, load %.1f ms, validate %.1f ms\n",
+           tasks[0].elapsed_ms, tasks[1].elapsed_ms, tasks[2].elapsed_ms, load_ms, validate_ms);
+    
     return 0;
 }
 
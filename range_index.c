@@ -0,0 +1,205 @@
+/**
+ * @file range_index.c
+ * @brief 有序范围索引相关函数的实现
+ */
+
+#include "range_index.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 比较两个索引项（qsort回调）
+ */
+static int range_entry_compare(const void *a, const void *b) {
+    const RangeEntry *x = (const RangeEntry *)a;
+    const RangeEntry *y = (const RangeEntry *)b;
+    
+    if (x->key != y->key) {
+        return x->key < y->key ? -1 : 1;
+    }
+    return x->row < y->row ? -1 : x->row > y->row ? 1 : 0;
+}
+
+/**
+ * @brief 查找第一个不小于(key, row)的索引项位置
+ * @param index 范围索引
+ * @param key 键
+ * @param row 记录下标
+ * @return 位置
+ */
+static int range_index_lower_bound(const RangeIndex *index, int key, int row) {
+    int low = 0;
+    int high = index->count;
+    
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        const RangeEntry *entry = &index->entries[mid];
+        if (entry->key < key || (entry->key == key && entry->row < row)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    return low;
+}
+
+/**
+ * @brief 确保容量足够
+ * @param index 范围索引
+ * @param needed 需要的索引项数量
+ * @return 成功返回0，失败返回非0值
+ */
+static int range_index_reserve(RangeIndex *index, int needed) {
+    if (needed <= index->capacity) {
+        return 0;
+    }
+    
+    int capacity = index->capacity > 0 ? index->capacity : 16;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    
+    RangeEntry *grown = (RangeEntry *)realloc(index->entries, sizeof(RangeEntry) * capacity);
+    if (grown == NULL) {
+        return -1;
+    }
+    
+    index->entries = grown;
+    index->capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief 初始化范围索引
+ * @param index 范围索引
+ * @param capacity 初始容量
+ * @return 成功返回0，失败返回非0值
+ */
+int range_index_init(RangeIndex *index, int capacity) {
+    if (index == NULL) {
+        return -1;
+    }
+    
+    index->entries = NULL;
+    index->count = 0;
+    index->capacity = 0;
+    return range_index_reserve(index, capacity > 0 ? capacity : 16);
+}
+
+/**
+ * @brief 释放范围索引
+ * @param index 范围索引
+ */
+void range_index_free(RangeIndex *index) {
+    if (index == NULL) {
+        return;
+    }
+    
+    free(index->entries);
+    index->entries = NULL;
+    index->count = 0;
+    index->capacity = 0;
+}
+
+/**
+ * @brief 按记录数组重建索引
+ * @param index 范围索引
+ * @param count 记录数量
+ * @param key_of 取记录键的回调函数
+ * @param user_data 回调函数的用户数据
+ * @return 成功返回0，失败返回非0值
+ */
+int range_index_rebuild(RangeIndex *index, int count, RangeIndexKeyFunc key_of, void *user_data) {
+    index->count = 0;
+    if (range_index_reserve(index, count) != 0) {
+        return -1;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        index->entries[i].key = key_of(i, user_data);
+        index->entries[i].row = i;
+    }
+    
+    index->count = count;
+    qsort(index->entries, count, sizeof(RangeEntry), range_entry_compare);
+    return 0;
+}
+
+/**
+ * @brief 插入一条记录
+ * @param index 范围索引
+ * @param key 键
+ * @param row 记录下标
+ * @return 成功返回0，失败返回非0值
+ */
+int range_index_insert(RangeIndex *index, int key, int row) {
+    if (range_index_reserve(index, index->count + 1) != 0) {
+        return -1;
+    }
+    
+    int position = range_index_lower_bound(index, key, row);
+    memmove(&index->entries[position + 1], &index->entries[position],
+            sizeof(RangeEntry) * (index->count - position));
+    
+    index->entries[position].key = key;
+    index->entries[position].row = row;
+    index->count++;
+    return 0;
+}
+
+/**
+ * @brief 移除一条记录（其他记录的下标不变）
+ * @param index 范围索引
+ * @param key 记录当前在索引中的键
+ * @param row 记录下标
+ */
+void range_index_remove(RangeIndex *index, int key, int row) {
+    int position = range_index_lower_bound(index, key, row);
+    if (position >= index->count || index->entries[position].key != key || index->entries[position].row != row) {
+        return;
+    }
+    
+    memmove(&index->entries[position], &index->entries[position + 1],
+            sizeof(RangeEntry) * (index->count - position - 1));
+    index->count--;
+}
+
+/**
+ * @brief 删除一条记录，并把下标大于它的记录下标都减1（对应数组中删除元素后后面的元素前移）
+ * @param index 范围索引
+ * @param key 记录当前在索引中的键
+ * @param row 记录下标
+ */
+void range_index_delete(RangeIndex *index, int key, int row) {
+    range_index_remove(index, key, row);
+    
+    // 同一个键内的相对顺序不变，下标整体减1后仍然有序
+    for (int i = 0; i < index->count; i++) {
+        if (index->entries[i].row > row) {
+            index->entries[i].row--;
+        }
+    }
+}
+
+/**
+ * @brief 查找键在[min, max]之间的索引项范围
+ * @param index 范围索引
+ * @param min 键的下限
+ * @param max 键的上限
+ * @param first 用于返回第一个索引项的位置
+ * @return 返回索引项个数，entries[first]到entries[first + 返回值 - 1]即为结果
+ */
+int range_index_find(const RangeIndex *index, int min, int max, int *first) {
+    int begin = range_index_lower_bound(index, min, -1);
+    *first = begin;
+    
+    if (min > max) {
+        return 0;
+    }
+    
+    // max为INT_MAX时没有更大的键可作为上界，直接取到末尾
+    int end = max == INT_MAX ? index->count : range_index_lower_bound(index, max + 1, -1);
+    return end - begin;
+}
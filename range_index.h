@@ -0,0 +1,97 @@
+/**
+ * @file range_index.h
+ * @brief 有序范围索引相关函数和数据结构的声明
+ *
+ * 按(键, 记录下标)升序保存的数组，用二分查找定位键的范围，
+ * 范围查询的开销为O(log n + k)。记录数组删除元素后，
+ * 后面记录的下标在索引中同步减1。
+ */
+
+#ifndef RANGE_INDEX_H
+#define RANGE_INDEX_H
+
+/**
+ * @brief 取记录键的回调函数
+ * @param row 记录下标
+ * @param user_data 用户数据
+ * @return 记录的键
+ */
+typedef int (*RangeIndexKeyFunc)(int row, void *user_data);
+
+/**
+ * @brief 索引项
+ */
+typedef struct {
+    int key;   /**< 键 */
+    int row;   /**< 记录下标 */
+} RangeEntry;
+
+/**
+ * @brief 有序范围索引
+ */
+typedef struct {
+    RangeEntry *entries;  /**< 按(键, 记录下标)升序排列的索引项 */
+    int count;            /**< 索引项数量 */
+    int capacity;         /**< 索引项容量 */
+} RangeIndex;
+
+/**
+ * @brief 初始化范围索引
+ * @param index 范围索引
+ * @param capacity 初始容量
+ * @return 成功返回0，失败返回非0值
+ */
+int range_index_init(RangeIndex *index, int capacity);
+
+/**
+ * @brief 释放范围索引
+ * @param index 范围索引
+ */
+void range_index_free(RangeIndex *index);
+
+/**
+ * @brief 按记录数组重建索引
+ * @param index 范围索引
+ * @param count 记录数量
+ * @param key_of 取记录键的回调函数
+ * @param user_data 回调函数的用户数据
+ * @return 成功返回0，失败返回非0值
+ */
+int range_index_rebuild(RangeIndex *index, int count, RangeIndexKeyFunc key_of, void *user_data);
+
+/**
+ * @brief 插入一条记录
+ * @param index 范围索引
+ * @param key 键
+ * @param row 记录下标
+ * @return 成功返回0，失败返回非0值
+ */
+int range_index_insert(RangeIndex *index, int key, int row);
+
+/**
+ * @brief 移除一条记录（其他记录的下标不变）
+ * @param index 范围索引
+ * @param key 记录当前在索引中的键
+ * @param row 记录下标
+ */
+void range_index_remove(RangeIndex *index, int key, int row);
+
+/**
+ * @brief 删除一条记录，并把下标大于它的记录下标都减1（对应数组中删除元素后后面的元素前移）
+ * @param index 范围索引
+ * @param key 记录当前在索引中的键
+ * @param row 记录下标
+ */
+void range_index_delete(RangeIndex *index, int key, int row);
+
+/**
+ * @brief 查找键在[min, max]之间的索引项范围
+ * @param index 范围索引
+ * @param min 键的下限
+ * @param max 键的上限
+ * @param first 用于返回第一个索引项的位置
+ * @return 返回索引项个数，entries[first]到entries[first + 返回值 - 1]即为结果
+ */
+int range_index_find(const RangeIndex *index, int min, int max, int *first);
+
+#endif /* RANGE_INDEX_H */
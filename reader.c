@@ -4,35 +4,854 @@
  */
 
 #include "reader.h"
+#include "bitmap.h"
+#include "chunk_array.h"
+#include "csv.h"
+#include "fold_column.h"
+#include "id_index.h"
+#include "journal.h"
+#include "snapshot.h"
+#include "text_arena.h"
 #include "utils.h"
+#include <limits.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define MAX_READERS 1000
 #define READERS_FILE "data/readers.csv"
-#define MAX_LINE_SIZE 1024
+#define READERS_TMP_FILE "data/readers.csv.tmp"
+#define READERS_SNAPSHOT_FILE "data/readers.snap"
+#define READER_SNAPSHOT_TYPE 0x52444552u // "REDR"
+#define READERS_JOURNAL_FILE "data/readers.journal"
+#define READER_JOURNAL_MIN_COMPACT 256 // 日志至少累积多少条才合并
+#define READER_FIELD_COUNT 8
+#define READER_COMPACT_MIN_DELETED 1024 // 已删除的位置至少多少个才整理
+#define READER_COMPACT_STEP 2 // 超过整理条件时每次删除顺带移动的读者数
+#define READER_GENERATION_MAX 0x7FFFFFFFu // 代数的上限，句柄因此总是非负
+#define READER_TEXT_COUNT 5 // 存放在文本区中的字段数
 
-// 读者数组
-static Reader *readers = NULL;
-// 读者数量
+/**
+ * @brief 存放在文本区中的字段（顺序与CSV中第2到第6列相同）
+ */
+enum {
+    READER_TEXT_NAME = 0,
+    READER_TEXT_GENDER,
+    READER_TEXT_PHONE,
+    READER_TEXT_EMAIL,
+    READER_TEXT_ADDRESS
+};
+
+// 各文本字段在Reader中的偏移和大小
+static const size_t reader_text_offsets[READER_TEXT_COUNT] = {
+    offsetof(Reader, name), offsetof(Reader, gender), offsetof(Reader, phone),
+    offsetof(Reader, email), offsetof(Reader, address)
+};
+static const size_t reader_text_sizes[READER_TEXT_COUNT] = {
+    sizeof(((Reader *)0)->name), sizeof(((Reader *)0)->gender), sizeof(((Reader *)0)->phone),
+    sizeof(((Reader *)0)->email), sizeof(((Reader *)0)->address)
+};
+
+/**
+ * @brief 读者的存储形式：姓名、地址等文本存放在文本区中，按实际长度占用空间，不截断
+ */
+typedef struct {
+    char id[sizeof(((Reader *)0)->id)];   /**< 读者ID */
+    TextRef text[READER_TEXT_COUNT];      /**< 各文本字段在文本区中的位置 */
+    int max_borrow_count;                 /**< 最大借阅数量 */
+    int current_borrow_count;             /**< 当前借阅数量 */
+    unsigned int generation;              /**< 写入该位置时分配的代数，句柄据此判断是否过期 */
+} ReaderEntry;
+
+/**
+ * @brief 一位待写入的读者，只在转换和写入时临时使用（文本引用调用方的数据）
+ */
+typedef struct {
+    char id[sizeof(((Reader *)0)->id)];   /**< 读者ID */
+    TextSpan text[READER_TEXT_COUNT];     /**< 各文本字段 */
+    int max_borrow_count;                 /**< 最大借阅数量 */
+    int current_borrow_count;             /**< 当前借阅数量 */
+} ReaderRecord;
+
+// 读者数组（分块存放，扩容时已有读者的地址不变）
+static ChunkArray reader_store;
+// 读者文本字段的文本区（修改和删除留下的废弃文本过多时整理，重新加载数据时清空）
+static TextArena reader_text;
+// 读者数组中已使用的位置数（含已删除的位置）
 static int reader_count = 0;
-// 读者容量
-static int reader_capacity = 0;
+// 已删除的位置数
+static int reader_deleted = 0;
+// 位置占用位图：置位表示存放着有效读者，清零表示已删除
+static Bitmap reader_used;
+// 最近分配的代数（重新加载数据时不清零，旧句柄不会与新数据碰巧相符）
+static unsigned int reader_generation = 0;
+// 空闲位置栈，新增读者时优先复用
+static int *reader_free_slots = NULL;
+static int reader_free_count = 0;
+static int reader_free_capacity = 0;
+// 读者变更日志
+static Journal reader_journal;
+// 读者ID索引
+static IdIndex reader_id_index;
+// 姓名、电子邮箱的折叠列
+static FoldColumn reader_name_folded;
+static FoldColumn reader_email_folded;
+
+/**
+ * @brief 写出数据文件时使用的读者数据副本（文本都在副本自己的文本区中）
+ */
+typedef struct {
+    ChunkArray readers;  /**< 读者数组副本（ReaderEntry） */
+    TextArena text;      /**< 副本中的全部文本 */
+    int count;           /**< 读者数量 */
+} ReaderSnapshot;
+
+/**
+ * @brief 取指定位置的读者
+ * @param index 读者下标
+ * @return 读者存储形式的指针
+ */
+static ReaderEntry *reader_at(int index) {
+    return (ReaderEntry *)CHUNK_ARRAY_AT(&reader_store, index);
+}
+
+/**
+ * @brief 取读者的一个文本字段
+ * @param entry 读者
+ * @param field 字段（READER_TEXT_*）
+ * @return 字段内容（在下一次向文本区追加之前有效）
+ */
+static const char *reader_text_of(const ReaderEntry *entry, int field) {
+    return text_arena_get(&reader_text, entry->text[field]);
+}
+
+/**
+ * @brief 把读者转换为存储形式（文本引用读者中的字段）
+ * @param record 用于存储转换结果
+ * @param reader 读者
+ */
+static void reader_record_from(ReaderRecord *record, const Reader *reader) {
+    memcpy(record->id, reader->id, sizeof(record->id));
+    record->id[sizeof(record->id) - 1] = '\0';
+    
+    // 字段不一定以'\0'结尾（例如来自快照文件），长度不超过字段大小
+    for (int i = 0; i < READER_TEXT_COUNT; i++) {
+        record->text[i].data = (const char *)reader + reader_text_offsets[i];
+        record->text[i].length = strnlen(record->text[i].data, reader_text_sizes[i]);
+    }
+    
+    record->max_borrow_count = reader->max_borrow_count;
+    record->current_borrow_count = reader->current_borrow_count;
+}
+
+/**
+ * @brief 把文本区中的读者还原为Reader（超出定长字段的文本在完整的UTF-8字符处截断）
+ * @param text 文本区
+ * @param entry 读者的存储形式
+ * @param reader 用于存储读者
+ * @param used 各文本字段上一次写入的字节数，返回时更新（见text_copy_over）；为NULL时补齐全部文本字段
+ * @return 没有截断返回0，有文本被截断返回非0值
+ */
+static int reader_entry_to_reader(const TextArena *text, const ReaderEntry *entry, Reader *reader,
+                                  size_t used[READER_TEXT_COUNT]) {
+    int truncated = 0;
+    
+    memcpy(reader->id, entry->id, sizeof(reader->id));
+    for (int i = 0; i < READER_TEXT_COUNT; i++) {
+        truncated |= text_arena_copy_over(text, entry->text[i], (char *)reader + reader_text_offsets[i],
+                                          reader_text_sizes[i], used ? &used[i] : NULL);
+    }
+    reader->max_borrow_count = entry->max_borrow_count;
+    reader->current_borrow_count = entry->current_borrow_count;
+    return truncated;
+}
+
+/**
+ * @brief 把指定位置的读者还原为Reader
+ * @param index 读者下标
+ * @param reader 用于存储读者
+ */
+static void reader_materialize(int index, Reader *reader) {
+    reader_entry_to_reader(&reader_text, reader_at(index), reader, NULL);
+}
+
+/**
+ * @brief 将读者转换为字段数组
+ * @param reader 读者
+ * @param numbers 用于存放数字字段文本的缓冲区
+ * @param fields 用于存储字段的数组
+ */
+static void reader_to_fields(const Reader *reader, char numbers[2][16], char **fields) {
+    snprintf(numbers[0], sizeof(numbers[0]), "%d", reader->max_borrow_count);
+    snprintf(numbers[1], sizeof(numbers[1]), "%d", reader->current_borrow_count);
+    
+    fields[0] = (char *)reader->id;
+    fields[1] = (char *)reader->name;
+    fields[2] = (char *)reader->gender;
+    fields[3] = (char *)reader->phone;
+    fields[4] = (char *)reader->email;
+    fields[5] = (char *)reader->address;
+    fields[6] = numbers[0];
+    fields[7] = numbers[1];
+}
+
+/**
+ * @brief 用字段数组填充读者记录（文本引用字段中的数据，不截断）
+ * @param record 读者记录
+ * @param fields 字段数组（id,name,gender,phone,email,address,max_borrow_count,current_borrow_count）
+ */
+static void reader_from_fields(ReaderRecord *record, const CsvField *fields) {
+    csv_field_copy(&fields[0], record->id, sizeof(record->id));
+    for (int i = 0; i < READER_TEXT_COUNT; i++) {
+        record->text[i].data = fields[1 + i].data;
+        record->text[i].length = fields[1 + i].len;
+    }
+    
+    record->max_borrow_count = (int)csv_field_to_long(&fields[6]);
+    record->current_borrow_count = (int)csv_field_to_long(&fields[7]);
+}
+
+/**
+ * @brief 把读者记录写入指定位置（文本追加到文本区，不更新索引）
+ * @param index 读者下标
+ * @param record 读者记录
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int reader_write_at(int index, const ReaderRecord *record) {
+    ReaderEntry *entry = reader_at(index);
+    TextRef text[READER_TEXT_COUNT];
+    
+    for (int i = 0; i < READER_TEXT_COUNT; i++) {
+        if (text_arena_append(&reader_text, record->text[i], &text[i]) != 0) {
+            while (i-- > 0) {
+                text_arena_release(&reader_text, text[i]);
+            }
+            return -1;
+        }
+    }
+    
+    memcpy(entry->id, record->id, sizeof(entry->id));
+    memcpy(entry->text, text, sizeof(entry->text));
+    entry->max_borrow_count = record->max_borrow_count;
+    entry->current_borrow_count = record->current_borrow_count;
+    
+    // 每次写入新读者都分配新的代数，指向该位置旧读者的句柄随之失效
+    reader_generation = reader_generation % READER_GENERATION_MAX + 1;
+    entry->generation = reader_generation;
+    return 0;
+}
+
+/**
+ * @brief 废弃指定位置读者的全部文本
+ * @param index 读者下标
+ */
+static void reader_release_text(int index) {
+    ReaderEntry *entry = reader_at(index);
+    
+    for (int i = READER_TEXT_COUNT - 1; i >= 0; i--) {
+        text_arena_release(&reader_text, entry->text[i]);
+        entry->text[i].offset = 0;
+        entry->text[i].length = 0;
+    }
+}
+
+/**
+ * @brief 取读者ID（ID索引的回调函数）
+ * @param index 读者下标
+ * @param user_data 未使用
+ * @return 读者ID
+ */
+static const char *reader_key_of(int index, void *user_data) {
+    (void)user_data;
+    return reader_at(index)->id;
+}
+
+/**
+ * @brief 查找读者在数组中的位置
+ * @param id 读者ID
+ * @return 找到返回下标，否则返回-1
+ */
+static int reader_index_of(const char *id) {
+    return id_index_find(&reader_id_index, id);
+}
+
+/**
+ * @brief 更新指定位置读者的折叠列
+ * @param index 读者下标，等于折叠列中的记录数时追加
+ * @param entry 读者
+ */
+static void reader_fold_at(int index, const ReaderEntry *entry) {
+    fold_column_set(&reader_name_folded, index, reader_text_of(entry, READER_TEXT_NAME));
+    fold_column_set(&reader_email_folded, index, reader_text_of(entry, READER_TEXT_EMAIL));
+}
+
+/**
+ * @brief 整理文本区：废弃的文本过多时，把有效读者的文本按顺序搬到新的文本区
+ */
+static void reader_maybe_compact_text() {
+    if (!text_arena_needs_compaction(&reader_text)) {
+        return;
+    }
+    
+    // 容量按有效文本的字节数预留，搬移时不会再扩容，也就不会中途失败
+    TextArena text;
+    if (text_arena_init(&text, reader_text.used - reader_text.garbage) != 0) {
+        return;
+    }
+    
+    for (int i = bitmap_next(&reader_used, 0); i != -1; i = bitmap_next(&reader_used, i + 1)) {
+        ReaderEntry *entry = reader_at(i);
+        for (int j = 0; j < READER_TEXT_COUNT; j++) {
+            text_arena_move(&text, &reader_text, &entry->text[j]);
+        }
+    }
+    
+    text_arena_free(&reader_text);
+    reader_text = text;
+}
+
+/**
+ * @brief 用新内容覆盖指定位置的读者，并更新折叠列
+ *
+ * 只有变化的文本才追加到文本区，旧文本随后废弃。
+ *
+ * @param index 读者下标
+ * @param record 新的读者记录
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int reader_store_at(int index, const ReaderRecord *record) {
+    ReaderEntry *entry = reader_at(index);
+    TextRef text[READER_TEXT_COUNT];
+    int changed[READER_TEXT_COUNT];
+    
+    for (int i = 0; i < READER_TEXT_COUNT; i++) {
+        text[i] = entry->text[i];
+        changed[i] = !text_arena_equals(&reader_text, entry->text[i], record->text[i]);
+        if (changed[i] && text_arena_append(&reader_text, record->text[i], &text[i]) != 0) {
+            while (i-- > 0) {
+                if (changed[i]) {
+                    text_arena_release(&reader_text, text[i]);
+                }
+            }
+            return -1;
+        }
+    }
+    
+    for (int i = 0; i < READER_TEXT_COUNT; i++) {
+        if (changed[i]) {
+            text_arena_release(&reader_text, entry->text[i]);
+            entry->text[i] = text[i];
+        }
+    }
+    entry->max_borrow_count = record->max_borrow_count;
+    entry->current_borrow_count = record->current_borrow_count;
+    reader_fold_at(index, entry);
+    
+    reader_maybe_compact_text();
+    return 0;
+}
+
+/**
+ * @brief 取空闲栈顶的位置
+ *
+ * 整理时数组末尾的空位直接截掉，它们留在栈中的记录已经过期，这里顺带丢弃。
+ *
+ * @return 空位下标，没有空位时返回-1
+ */
+static int reader_free_slot_top() {
+    while (reader_free_count > 0 && reader_free_slots[reader_free_count - 1] >= reader_count) {
+        reader_free_count--;
+    }
+    
+    return reader_free_count > 0 ? reader_free_slots[reader_free_count - 1] : -1;
+}
+
+/**
+ * @brief 加入读者，并加入ID索引和折叠列
+ *
+ * 优先复用已删除的位置，没有空位时追加到数组末尾（容量不足时追加一块）。
+ *
+ * @param record 读者记录
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int reader_insert(const ReaderRecord *record) {
+    int index = reader_free_slot_top();
+    if (index == -1) {
+        index = reader_count;
+        if (chunk_array_reserve(&reader_store, reader_count + 1) != 0) {
+            return -1;
+        }
+    }
+    
+    if (reader_write_at(index, record) != 0) {
+        return -1;
+    }
+    if (id_index_insert(&reader_id_index, index) != 0) {
+        reader_release_text(index);
+        return -1;
+    }
+    
+    if (index == reader_count) {
+        reader_count++;
+    } else {
+        reader_free_count--;
+        reader_deleted--;
+    }
+    
+    bitmap_set(&reader_used, index, 1);
+    reader_fold_at(index, reader_at(index));
+    return 0;
+}
+
+/**
+ * @brief 根据读者数组重建ID索引、折叠列和占用位图（数组中不能有已删除的位置）
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int reader_rebuild_indexes() {
+    if (id_index_rebuild(&reader_id_index, reader_count) != 0) {
+        return -1;
+    }
+    
+    fold_column_clear(&reader_name_folded);
+    fold_column_clear(&reader_email_folded);
+    bitmap_clear(&reader_used);
+    
+    for (int i = 0; i < reader_count; i++) {
+        bitmap_set(&reader_used, i, 1);
+        reader_fold_at(i, reader_at(i));
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 取有效读者数量（不含已删除的位置）
+ * @return 读者数量
+ */
+static int reader_live_count() {
+    return reader_count - reader_deleted;
+}
+
+/**
+ * @brief 整理读者数组：有效读者按原顺序前移填满已删除的位置，释放多余的块并重建索引
+ *
+ * 需要线性时间，只在保存数据时调用；删除时由reader_compact_step逐步整理。
+ */
+static void reader_compact_slots() {
+    int count = 0;
+    
+    for (int i = bitmap_next(&reader_used, 0); i != -1; i = bitmap_next(&reader_used, i + 1)) {
+        if (i != count) {
+            memcpy(reader_at(count), reader_at(i), sizeof(ReaderEntry));
+        }
+        count++;
+    }
+    
+    reader_count = count;
+    reader_deleted = 0;
+    reader_free_count = 0;
+    chunk_array_shrink(&reader_store, reader_count);
+    reader_rebuild_indexes();
+}
+
+/**
+ * @brief 把指定位置的读者从ID索引和折叠列中移除，并标记为空位（不修改读者本身）
+ * @param index 读者下标
+ */
+static void reader_unindex_at(int index) {
+    id_index_remove(&reader_id_index, index);
+    fold_column_set(&reader_name_folded, index, "");
+    fold_column_set(&reader_email_folded, index, "");
+    bitmap_set(&reader_used, index, 0);
+}
+
+/**
+ * @brief 逐步整理读者数组：把末尾的读者移到空位上，截掉末尾的空位并释放多余的块
+ *
+ * 每移动一名读者只需更新它在ID索引和折叠列中的位置，不必重建全部索引。
+ *
+ * @param moves 最多移动的读者数
+ */
+static void reader_compact_step(int moves) {
+    while (moves > 0) {
+        // 末尾的空位直接截掉
+        while (reader_count > 0 && !bitmap_get(&reader_used, reader_count - 1)) {
+            reader_count--;
+            reader_deleted--;
+        }
+        
+        int hole = reader_free_slot_top();
+        if (hole == -1) {
+            break;
+        }
+        reader_free_count--;
+        
+        // 移除后再加入，ID索引的记录数不变，不会扩容，也就不会失败
+        int last = reader_count - 1;
+        reader_unindex_at(last);
+        memcpy(reader_at(hole), reader_at(last), sizeof(ReaderEntry));
+        id_index_insert(&reader_id_index, hole);
+        bitmap_set(&reader_used, hole, 1);
+        reader_fold_at(hole, reader_at(hole));
+        
+        reader_count--;
+        reader_deleted--;
+        moves--;
+    }
+    
+    chunk_array_shrink(&reader_store, reader_count);
+}
+
+/**
+ * @brief 删除指定位置的读者
+ *
+ * 只把读者从ID索引中移除、位置标记为已删除并放入空闲栈，其他读者的下标不变。
+ * 已删除的位置超过总数的1/4后，每次删除再把末尾的几名读者移到空位上，
+ * 空位的比例因此保持在1/4左右，每次删除的开销都有上限。
+ *
+ * @param index 读者下标
+ */
+static void reader_remove_at(int index) {
+    reader_unindex_at(index);
+    reader_release_text(index);
+    reader_deleted++;
+    
+    // 空闲栈扩容失败时该位置只是暂不复用，整理时仍会回收
+    if (reader_free_count >= reader_free_capacity) {
+        int capacity = reader_free_capacity > 0 ? reader_free_capacity * 2 : 64;
+        int *grown = (int *)realloc(reader_free_slots, sizeof(int) * capacity);
+        if (grown != NULL) {
+            reader_free_slots = grown;
+            reader_free_capacity = capacity;
+        }
+    }
+    if (reader_free_count < reader_free_capacity) {
+        reader_free_slots[reader_free_count++] = index;
+    }
+    
+    if (reader_deleted >= READER_COMPACT_MIN_DELETED && reader_deleted > reader_count / 4) {
+        reader_compact_step(READER_COMPACT_STEP);
+    }
+    reader_maybe_compact_text();
+}
+
+/**
+ * @brief 分配姓名、电子邮箱的折叠列和占用位图
+ * @return 成功返回0，失败返回非0值
+ */
+static int reader_secondary_init() {
+    if (fold_column_init(&reader_name_folded, CHUNK_ARRAY_RECORDS, sizeof(((Reader *)0)->name)) != 0) {
+        return -1;
+    }
+    
+    if (fold_column_init(&reader_email_folded, CHUNK_ARRAY_RECORDS, sizeof(((Reader *)0)->email)) != 0) {
+        fold_column_free(&reader_name_folded);
+        return -1;
+    }
+    
+    if (bitmap_init(&reader_used, CHUNK_ARRAY_RECORDS) != 0) {
+        fold_column_free(&reader_email_folded);
+        fold_column_free(&reader_name_folded);
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 释放折叠列和占用位图
+ */
+static void reader_secondary_free() {
+    fold_column_free(&reader_name_folded);
+    fold_column_free(&reader_email_folded);
+    bitmap_free(&reader_used);
+}
+
+/**
+ * @brief 将读者数组写成二进制快照
+ *
+ * 快照按存储形式保存读者数组和文本区，文本不截断，加载时整块复制回来即可。
+ * 文本区中可能有修改和删除留下的废弃文本，加载时重新统计。
+ *
+ * @param data 读者数组（ReaderEntry，不含已删除的位置）
+ * @param text 读者数组引用的文本区
+ * @param count 读者数量
+ * @return 成功返回0，失败返回非0值
+ */
+static int reader_write_binary(const ChunkArray *data, const TextArena *text, int count) {
+    const void *bytes = text->data;
+    SnapshotSection sections[2] = {
+        {(const void *const *)data->chunks, CHUNK_ARRAY_RECORDS, sizeof(ReaderEntry), (size_t)count},
+        {&bytes, 0, 1, text->used}
+    };
+    return snapshot_write(READERS_SNAPSHOT_FILE, READERS_FILE, READER_SNAPSHOT_TYPE, sections, 2);
+}
+
+/**
+ * @brief 将读者数组写入CSV文件和二进制快照（先写临时文件再替换）
+ * @param data 读者数组（ReaderEntry，不含已删除的位置）
+ * @param text 读者数组引用的文本区
+ * @param count 读者数量
+ * @return 成功返回0，失败返回非0值
+ */
+static int reader_write_file(const ChunkArray *data, const TextArena *text, int count) {
+    FILE *file = fopen(READERS_TMP_FILE, "w");
+    if (file == NULL) {
+        return -1;
+    }
+    
+    // 写入标题行
+    fprintf(file, "id,name,gender,phone,email,address,max_borrow_count,current_borrow_count\n");
+    
+    // 写入数据（文本不截断）
+    char numbers[2][16];
+    char *fields[READER_FIELD_COUNT];
+    for (int i = 0; i < count; i++) {
+        const ReaderEntry *entry = (const ReaderEntry *)CHUNK_ARRAY_AT(data, i);
+        snprintf(numbers[0], sizeof(numbers[0]), "%d", entry->max_borrow_count);
+        snprintf(numbers[1], sizeof(numbers[1]), "%d", entry->current_borrow_count);
+        fields[0] = (char *)entry->id;
+        for (int j = 0; j < READER_TEXT_COUNT; j++) {
+            fields[1 + j] = (char *)text_arena_get(text, entry->text[j]);
+        }
+        fields[6] = numbers[0];
+        fields[7] = numbers[1];
+        csv_write_record(file, fields, READER_FIELD_COUNT);
+    }
+    
+    if (fclose(file) != 0) {
+        remove(READERS_TMP_FILE);
+        return -1;
+    }
+    
+    if (rename(READERS_TMP_FILE, READERS_FILE) != 0) {
+        return -1;
+    }
+    
+    // 快照在CSV之后写出，记下刚写好的CSV的大小和修改时间，加载时据此判断快照是否仍然有效
+    return reader_write_binary(data, text, count);
+}
+
+/**
+ * @brief 释放读者数据副本
+ * @param snapshot 读者数据副本
+ */
+static void reader_free_snapshot(void *snapshot) {
+    ReaderSnapshot *copy = (ReaderSnapshot *)snapshot;
+    chunk_array_free(&copy->readers);
+    text_arena_free(&copy->text);
+    free(copy);
+}
+
+/**
+ * @brief 在后台线程中写出读者数据副本
+ * @param snapshot 读者数据副本
+ * @return 成功返回0，失败返回非0值
+ */
+static int reader_write_snapshot(void *snapshot) {
+    ReaderSnapshot *copy = (ReaderSnapshot *)snapshot;
+    int result = reader_write_file(&copy->readers, &copy->text, copy->count);
+    reader_free_snapshot(copy);
+    return result;
+}
+
+/**
+ * @brief 把有效读者按顺序复制到数据副本（跳过已删除的位置，文本搬到副本自己的文本区）
+ * @param copy 数据副本（未初始化）
+ * @return 成功返回0，内存不足返回非0值
+ */
+static int reader_copy_live(ReaderSnapshot *copy) {
+    if (chunk_array_init(&copy->readers, sizeof(ReaderEntry)) != 0) {
+        return -1;
+    }
+    
+    // 文本区的容量按有效文本的字节数预留，复制时不会再扩容
+    if (chunk_array_reserve(&copy->readers, reader_live_count()) != 0 ||
+        text_arena_init(&copy->text, reader_text.used - reader_text.garbage) != 0) {
+        chunk_array_free(&copy->readers);
+        return -1;
+    }
+    
+    int count = 0;
+    for (int i = bitmap_next(&reader_used, 0); i != -1; i = bitmap_next(&reader_used, i + 1)) {
+        ReaderEntry *dest = (ReaderEntry *)CHUNK_ARRAY_AT(&copy->readers, count);
+        memcpy(dest, reader_at(i), sizeof(ReaderEntry));
+        for (int j = 0; j < READER_TEXT_COUNT; j++) {
+            text_arena_move(&copy->text, &reader_text, &dest->text[j]);
+        }
+        count++;
+    }
+    
+    copy->count = count;
+    return 0;
+}
+
+/**
+ * @brief 日志过长时在后台合并回数据文件
+ */
+static void reader_maybe_compact() {
+    if (!journal_needs_compaction(&reader_journal, reader_live_count())) {
+        return;
+    }
+    
+    ReaderSnapshot *copy = (ReaderSnapshot *)malloc(sizeof(ReaderSnapshot));
+    if (copy == NULL) {
+        return;
+    }
+    
+    if (reader_copy_live(copy) != 0) {
+        free(copy);
+        return;
+    }
+    
+    journal_compact(&reader_journal, reader_write_snapshot, copy, reader_free_snapshot);
+}
+
+/**
+ * @brief 记录一条读者写入日志
+ * @param reader 写入后的读者
+ * @return 成功返回0，失败返回非0值
+ */
+static int reader_log_put(const Reader *reader) {
+    char numbers[2][16];
+    char *fields[READER_FIELD_COUNT];
+    
+    reader_to_fields(reader, numbers, fields);
+    if (journal_append(&reader_journal, JOURNAL_OP_PUT, fields, READER_FIELD_COUNT) != 0) {
+        return -1;
+    }
+    
+    reader_maybe_compact();
+    return 0;
+}
+
+/**
+ * @brief 记录一条读者借阅数量日志（只含ID和当前借阅数量，借还时不必还原整个读者）
+ * @param entry 写入后的读者
+ * @return 成功返回0，失败返回非0值
+ */
+static int reader_log_count(const ReaderEntry *entry) {
+    char number[16];
+    char *fields[2];
+    
+    snprintf(number, sizeof(number), "%d", entry->current_borrow_count);
+    fields[0] = (char *)entry->id;
+    fields[1] = number;
+    
+    if (journal_append(&reader_journal, JOURNAL_OP_COUNT, fields, 2) != 0) {
+        return -1;
+    }
+    
+    reader_maybe_compact();
+    return 0;
+}
+
+/**
+ * @brief 记录一条读者删除日志
+ * @param id 读者ID
+ * @return 成功返回0，失败返回非0值
+ */
+static int reader_log_delete(const char *id) {
+    char *fields[1] = {(char *)id};
+    
+    if (journal_append(&reader_journal, JOURNAL_OP_DELETE, fields, 1) != 0) {
+        return -1;
+    }
+    
+    reader_maybe_compact();
+    return 0;
+}
+
+/**
+ * @brief 重放一条读者日志
+ * @param op 操作类型
+ * @param fields 记录字段
+ * @param num_fields 字段数
+ * @param user_data 未使用
+ * @return 成功返回0，失败返回非0值
+ */
+static int reader_apply_journal(char op, const CsvField *fields, int num_fields, void *user_data) {
+    (void)user_data;
+    if (op == JOURNAL_OP_DELETE) {
+        char id[sizeof(((Reader *)0)->id)];
+        csv_field_copy(&fields[0], id, sizeof(id));
+        
+        int index = reader_index_of(id);
+        if (index != -1) {
+            reader_remove_at(index);
+        }
+        return 0;
+    }
+    
+    if (op == JOURNAL_OP_COUNT && num_fields == 2) {
+        char id[sizeof(((Reader *)0)->id)];
+        csv_field_copy(&fields[0], id, sizeof(id));
+        
+        int index = reader_index_of(id);
+        if (index != -1) {
+            reader_at(index)->current_borrow_count = (int)csv_field_to_long(&fields[1]);
+        }
+        return 0;
+    }
+    
+    if (op != JOURNAL_OP_PUT || num_fields != READER_FIELD_COUNT) {
+        return -1;
+    }
+    
+    ReaderRecord record;
+    reader_from_fields(&record, fields);
+    
+    int index = reader_index_of(record.id);
+    if (index == -1) {
+        return reader_insert(&record);
+    }
+    
+    return reader_store_at(index, &record);
+}
 
 /**
  * @brief 初始化读者管理模块
  * @return 成功返回0，失败返回非0值
  */
 int reader_init() {
-    // 分配内存
-    readers = (Reader *)malloc(sizeof(Reader) * MAX_READERS);
-    if (readers == NULL) {
+    // 读者数组按需分块分配
+    if (chunk_array_init(&reader_store, sizeof(ReaderEntry)) != 0) {
         return -1;
     }
     
-    reader_capacity = MAX_READERS;
     reader_count = 0;
+    reader_deleted = 0;
+    reader_free_count = 0;
+    
+    // 分配文本区
+    if (text_arena_init(&reader_text, 0) != 0) {
+        chunk_array_free(&reader_store);
+        return -1;
+    }
+    
+    // 分配ID索引
+    if (id_index_init(&reader_id_index, CHUNK_ARRAY_RECORDS, reader_key_of, NULL) != 0) {
+        text_arena_free(&reader_text);
+        chunk_array_free(&reader_store);
+        return -1;
+    }
+    
+    // 分配折叠列和占用位图
+    if (reader_secondary_init() != 0) {
+        id_index_free(&reader_id_index);
+        text_arena_free(&reader_text);
+        chunk_array_free(&reader_store);
+        return -1;
+    }
+    
+    // 打开变更日志
+    if (journal_open(&reader_journal, READERS_JOURNAL_FILE, READER_JOURNAL_MIN_COMPACT) != 0) {
+        reader_secondary_free();
+        id_index_free(&reader_id_index);
+        text_arena_free(&reader_text);
+        chunk_array_free(&reader_store);
+        return -1;
+    }
     
     // 加载数据
     return reader_load_data();
@@ -48,22 +867,20 @@ int reader_add(Reader *reader) {
         return -1;
     }
     
-    // 检查容量
-    if (reader_count >= reader_capacity) {
-        return -1;
-    }
-    
     // 生成ID（如果没有）
     if (strlen(reader->id) == 0) {
         generate_id("R", reader->id, sizeof(reader->id));
     }
     
-    // 添加读者
-    memcpy(&readers[reader_count], reader, sizeof(Reader));
-    reader_count++;
+    // 添加读者（优先复用已删除的位置）
+    ReaderRecord record;
+    reader_record_from(&record, reader);
+    if (reader_insert(&record) != 0) {
+        return -1;
+    }
     
-    // 保存数据
-    return reader_save_data();
+    // 记录日志
+    return reader_log_put(reader);
 }
 
 /**
@@ -77,32 +894,21 @@ int reader_delete(const char *id) {
     }
     
     // 查找读者
-    int index = -1;
-    for (int i = 0; i < reader_count; i++) {
-        if (strcmp(readers[i].id, id) == 0) {
-            index = i;
-            break;
-        }
-    }
-    
+    int index = reader_index_of(id);
     if (index == -1) {
         return -1;
     }
     
     // 检查是否有未归还的图书
-    if (readers[index].current_borrow_count > 0) {
+    if (reader_at(index)->current_borrow_count > 0) {
         return -2; // 有未归还的图书，不能删除
     }
     
-    // 删除读者（移动后面的元素）
-    for (int i = index; i < reader_count - 1; i++) {
-        memcpy(&readers[i], &readers[i + 1], sizeof(Reader));
-    }
-    
-    reader_count--;
+    // 删除读者（只标记位置，不移动其他读者）
+    reader_remove_at(index);
     
-    // 保存数据
-    return reader_save_data();
+    // 记录日志
+    return reader_log_delete(id);
 }
 
 /**
@@ -116,29 +922,23 @@ int reader_update(Reader *reader) {
     }
     
     // 查找读者
-    int index = -1;
-    for (int i = 0; i < reader_count; i++) {
-        if (strcmp(readers[i].id, reader->id) == 0) {
-            index = i;
-            break;
-        }
-    }
-    
+    int index = reader_index_of(reader->id);
     if (index == -1) {
         return -1;
     }
     
-    // 保存当前借阅数量
-    int current_borrow_count = readers[index].current_borrow_count;
-    
-    // 更新读者
-    memcpy(&readers[index], reader, sizeof(Reader));
-    
-    // 恢复当前借阅数量（防止被覆盖）
-    readers[index].current_borrow_count = current_borrow_count;
+    // 更新读者，保留当前借阅数量（防止被覆盖）
+    ReaderRecord record;
+    reader_record_from(&record, reader);
+    record.current_borrow_count = reader_at(index)->current_borrow_count;
+    if (reader_store_at(index, &record) != 0) {
+        return -1;
+    }
     
-    // 保存数据
-    return reader_save_data();
+    // 记录日志
+    Reader stored;
+    reader_materialize(index, &stored);
+    return reader_log_put(&stored);
 }
 
 /**
@@ -152,42 +952,169 @@ int reader_find_by_id(const char *id, Reader *reader) {
         return -1;
     }
     
-    // 查找读者
-    for (int i = 0; i < reader_count; i++) {
-        if (strcmp(readers[i].id, id) == 0) {
-            memcpy(reader, &readers[i], sizeof(Reader));
-            return 0;
-        }
+    // 通过ID索引查找读者
+    int index = reader_index_of(id);
+    if (index == -1) {
+        return -1;
     }
     
-    return -1;
+    reader_materialize(index, reader);
+    return 0;
 }
 
 /**
- * @brief 根据姓名查找读者
- * @param name 读者姓名
+ * @brief 根据ID取读者句柄
+ * @param id 读者ID
+ * @return 找到返回句柄，否则返回-1
+ */
+ReaderHandle reader_lookup(const char *id) {
+    if (id == NULL) {
+        return -1;
+    }
+    
+    int index = reader_index_of(id);
+    if (index == -1) {
+        return -1;
+    }
+    
+    // 高32位是代数，低32位是下标
+    return (ReaderHandle)reader_at(index)->generation << 32 | index;
+}
+
+/**
+ * @brief 取句柄指向的读者下标
+ *
+ * 读者被删除、位置被复用、整理时被移走或数据重新加载后，
+ * 该位置的代数与句柄中的不再相同，句柄随之失效。
+ *
+ * @param handle 读者句柄
+ * @return 有效返回下标，句柄无效或已过期返回-1
+ */
+static int reader_handle_index(ReaderHandle handle) {
+    if (handle < 0 || (handle & 0xFFFFFFFF) >= reader_count) {
+        return -1;
+    }
+    
+    int index = (int)(handle & 0xFFFFFFFF);
+    if (!bitmap_get(&reader_used, index) || reader_at(index)->generation != (unsigned int)(handle >> 32)) {
+        return -1;
+    }
+    return index;
+}
+
+/**
+ * @brief 取句柄对应的读者
+ * @param handle 读者句柄
+ * @param reader 用于存储读者信息
+ * @return 成功返回0，句柄无效时返回非0值
+ */
+int reader_get(ReaderHandle handle, Reader *reader) {
+    int index = reader_handle_index(handle);
+    if (reader == NULL || index == -1) {
+        return -1;
+    }
+    
+    reader_materialize(index, reader);
+    return 0;
+}
+
+/**
+ * @brief 取句柄对应读者还能再借的数量，不复制读者
+ * @param handle 读者句柄
+ * @return 最大借阅数量减去当前借阅数量（不小于0），句柄无效时返回-1
+ */
+int reader_borrow_quota(ReaderHandle handle) {
+    int index = reader_handle_index(handle);
+    if (index == -1) {
+        return -1;
+    }
+    
+    const ReaderEntry *entry = reader_at(index);
+    int quota = entry->max_borrow_count - entry->current_borrow_count;
+    return quota > 0 ? quota : 0;
+}
+
+/**
+ * @brief 原地调整读者的当前借阅数量并记录日志
+ *
+ * reader_update不修改当前借阅数量，借还书时由借阅模块通过这里维护。
+ *
+ * @param handle 读者句柄
+ * @param delta 当前借阅数量的增量（借出为1，归还为-1）
+ * @return 成功返回0，句柄无效或借阅数量将小于0时返回非0值
+ */
+int reader_adjust_borrow_count(ReaderHandle handle, int delta) {
+    int index = reader_handle_index(handle);
+    if (index == -1) {
+        return -1;
+    }
+    
+    ReaderEntry *current = reader_at(index);
+    if (current->current_borrow_count + delta < 0) {
+        return -1;
+    }
+    
+    current->current_borrow_count += delta;
+    
+    // 记录日志（只记ID和数量，不访问文本）
+    return reader_log_count(current);
+}
+
+/**
+ * @brief 在折叠列中逐条查找包含查询串的读者
+ * @param column 折叠列
+ * @param text 查询串
  * @param result_readers 用于存储查找结果的读者结构体数组
  * @param max_count 最大返回数量
  * @return 返回找到的读者数量
  */
-int reader_find_by_name(const char *name, Reader *result_readers, int max_count) {
-    if (name == NULL || result_readers == NULL || max_count <= 0) {
+static int reader_find_in_column(const FoldColumn *column, const char *text, Reader *result_readers, int max_count) {
+    if (text == NULL || result_readers == NULL || max_count <= 0) {
         return 0;
     }
     
-    int count = 0;
+    FoldPattern pattern;
+    if (fold_pattern_init(&pattern, text) != 0) {
+        return 0;
+    }
     
-    // 查找读者
-    for (int i = 0; i < reader_count && count < max_count; i++) {
-        if (contains_ignore_case(readers[i].name, name)) {
-            memcpy(&result_readers[count], &readers[i], sizeof(Reader));
-            count++;
+    int count = 0;
+    for (int i = fold_column_next(column, 0, &pattern); i != -1 && count < max_count;
+         i = fold_column_next(column, i + 1, &pattern)) {
+        // 已删除位置的折叠文本为空串，空查询串也会命中
+        if (!bitmap_get(&reader_used, i)) {
+            continue;
         }
+        reader_materialize(i, &result_readers[count]);
+        count++;
     }
     
+    fold_pattern_free(&pattern);
     return count;
 }
 
+/**
+ * @brief 根据姓名查找读者
+ * @param name 读者姓名
+ * @param result_readers 用于存储查找结果的读者结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的读者数量
+ */
+int reader_find_by_name(const char *name, Reader *result_readers, int max_count) {
+    return reader_find_in_column(&reader_name_folded, name, result_readers, max_count);
+}
+
+/**
+ * @brief 根据电子邮箱查找读者
+ * @param email 电子邮箱
+ * @param result_readers 用于存储查找结果的读者结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的读者数量
+ */
+int reader_find_by_email(const char *email, Reader *result_readers, int max_count) {
+    return reader_find_in_column(&reader_email_folded, email, result_readers, max_count);
+}
+
 /**
  * @brief 获取所有读者
  * @param result_readers 用于存储读者的结构体数组
@@ -199,105 +1126,244 @@ int reader_get_all(Reader *result_readers, int max_count) {
         return 0;
     }
     
-    int count = (reader_count < max_count) ? reader_count : max_count;
-    
-    // 复制读者
-    memcpy(result_readers, readers, sizeof(Reader) * count);
+    int count = 0;
+    for (int i = bitmap_next(&reader_used, 0); i != -1 && count < max_count; i = bitmap_next(&reader_used, i + 1)) {
+        reader_materialize(i, &result_readers[count]);
+        count++;
+    }
     
     return count;
 }
 
 /**
- * @brief 保存读者数据到文件
- * @return 成功返回0，失败返回非0值
+ * @brief 按存储顺序遍历读者，逐条还原到同一个临时结构体中，不分配内存
+ *
+ * 回调函数拿到的不是存储中的数据：每位读者都从文本区重新还原为完整的Reader
+ * （复制全部文本字段），只是不再为所有读者分配数组。
+ * 删除读者空出的位置会被之后新增的读者复用，存储顺序不一定是录入顺序。
+ * 遍历期间（包括回调函数中）不能增删改读者。
+ *
+ * @param filter 过滤函数，返回非0的读者才交给visit，为NULL时不过滤
+ * @param offset 跳过前offset条符合条件的读者（用于翻页）
+ * @param limit 最多访问的数量（页大小），不大于0时不限
+ * @param visit 访问函数，返回非0时停止遍历
+ * @param user_data 传给filter和visit的用户数据
+ * @return 返回访问的读者数量
  */
-int reader_save_data() {
-    FILE *file = fopen(READERS_FILE, "w");
-    if (file == NULL) {
-        return -1;
+int reader_foreach(ReaderFilterFunc filter, int offset, int limit, ReaderVisitFunc visit, void *user_data) {
+    if (visit == NULL) {
+        return 0;
     }
     
-    // 写入标题行
-    fprintf(file, "id,name,gender,phone,email,address,max_borrow_count,current_borrow_count\n");
+    // 结构体只清零一次，之后每条只补齐上一条多写的部分（见text_copy_over）
+    Reader reader;
+    size_t used[READER_TEXT_COUNT] = {0};
+    memset(&reader, 0, sizeof(reader));
     
-    // 写入数据
-    for (int i = 0; i < reader_count; i++) {
-        fprintf(file, "%s,%s,%s,%s,%s,%s,%d,%d\n",
-                readers[i].id,
-                readers[i].name,
-                readers[i].gender,
-                readers[i].phone,
-                readers[i].email,
-                readers[i].address,
-                readers[i].max_borrow_count,
-                readers[i].current_borrow_count);
-    }
-    
-    fclose(file);
-    return 0;
+    int visited = 0;
+    for (int i = bitmap_next(&reader_used, 0); i != -1; i = bitmap_next(&reader_used, i + 1)) {
+        // 不过滤时，前面几页不必还原
+        if (filter == NULL && offset > 0) {
+            offset--;
+            continue;
+        }
+        
+        reader_entry_to_reader(&reader_text, reader_at(i), &reader, used);
+        if (filter != NULL && !filter(&reader, user_data)) {
+            continue;
+        }
+        
+        // 跳过前面几页
+        if (offset > 0) {
+            offset--;
+            continue;
+        }
+        
+        visited++;
+        if (visit(&reader, user_data) != 0 || visited == limit) {
+            break;
+        }
+    }
+    
+    return visited;
 }
 
 /**
- * @brief 从文件加载读者数据
+ * @brief 从CSV文件加载读者数据
  * @return 成功返回0，失败返回非0值
  */
-int reader_load_data() {
+static int reader_load_csv() {
     // 如果文件不存在，直接返回成功
     if (!file_exists(READERS_FILE)) {
         return 0;
     }
     
-    FILE *file = fopen(READERS_FILE, "r");
-    if (file == NULL) {
+    CsvFile file;
+    if (csv_file_open(READERS_FILE, &file) != 0) {
         return -1;
     }
     
-    char line[MAX_LINE_SIZE];
-    char *fields[8]; // id,name,gender,phone,email,address,max_borrow_count,current_borrow_count
+    CsvReader csv;
+    CsvField fields[READER_FIELD_COUNT];
+    int num_fields;
+    
+    csv_reader_init(&csv, file.data, file.len);
     
     // 跳过标题行
-    if (fgets(line, sizeof(line), file) == NULL) {
-        fclose(file);
-        return 0;
-    }
+    csv_read_record(&csv, fields, READER_FIELD_COUNT);
     
     // 读取数据
-    reader_count = 0;
-    while (fgets(line, sizeof(line), file) != NULL && reader_count < reader_capacity) {
-        // 去除换行符
-        line[strcspn(line, "\n")] = '\0';
-        
-        // 解析CSV行
-        if (parse_csv_line(line, fields, 8) != 8) {
+    while ((num_fields = csv_read_record(&csv, fields, READER_FIELD_COUNT)) >= 0) {
+        if (num_fields != READER_FIELD_COUNT) {
             continue;
         }
         
-        // 填充读者结构体
-        strncpy(readers[reader_count].id, fields[0], sizeof(readers[reader_count].id) - 1);
-        readers[reader_count].id[sizeof(readers[reader_count].id) - 1] = '\0';
-        
-        strncpy(readers[reader_count].name, fields[1], sizeof(readers[reader_count].name) - 1);
-        readers[reader_count].name[sizeof(readers[reader_count].name) - 1] = '\0';
-        
-        strncpy(readers[reader_count].gender, fields[2], sizeof(readers[reader_count].gender) - 1);
-        readers[reader_count].gender[sizeof(readers[reader_count].gender) - 1] = '\0';
-        
-        strncpy(readers[reader_count].phone, fields[3], sizeof(readers[reader_count].phone) - 1);
-        readers[reader_count].phone[sizeof(readers[reader_count].phone) - 1] = '\0';
-        
-        strncpy(readers[reader_count].email, fields[4], sizeof(readers[reader_count].email) - 1);
-        readers[reader_count].email[sizeof(readers[reader_count].email) - 1] = '\0';
-        
-        strncpy(readers[reader_count].address, fields[5], sizeof(readers[reader_count].address) - 1);
-        readers[reader_count].address[sizeof(readers[reader_count].address) - 1] = '\0';
-        
-        readers[reader_count].max_borrow_count = atoi(fields[6]);
-        readers[reader_count].current_borrow_count = atoi(fields[7]);
+        // 容量不足时追加一块，内存耗尽时报告失败而不是丢弃后面的记录
+        if (chunk_array_reserve(&reader_store, reader_count + 1) != 0) {
+            csv_file_close(&file);
+            return -1;
+        }
         
+        // 填充读者记录
+        ReaderRecord record;
+        reader_from_fields(&record, fields);
+        if (reader_write_at(reader_count, &record) != 0) {
+            csv_file_close(&file);
+            return -1;
+        }
         reader_count++;
     }
     
-    fclose(file);
+    csv_file_close(&file);
+    return 0;
+}
+
+/**
+ * @brief 从二进制快照加载读者数据
+ *
+ * 读者数组按块整块复制，文本区复制一次，不逐条转换；只为每位读者分配新的代数，
+ * 检查文本引用没有越界，并统计文本区中的废弃文本。
+ *
+ * @return 成功返回0，快照不存在、已过期或校验失败返回非0值
+ */
+static int reader_load_snapshot() {
+    if (!file_exists(READERS_SNAPSHOT_FILE)) {
+        return -1;
+    }
+    
+    // CSV在快照写出后被修改或替换过（例如手工编辑了CSV文件）时快照失效，以CSV为准
+    static const uint32_t sizes[2] = {sizeof(ReaderEntry), 1};
+    SnapshotView view;
+    if (snapshot_open(READERS_SNAPSHOT_FILE, READERS_FILE, READER_SNAPSHOT_TYPE, sizes, 2, &view) != 0) {
+        return -1;
+    }
+    
+    size_t count = view.sections[0].count;
+    if (count > (size_t)INT_MAX || chunk_array_reserve(&reader_store, (int)count) != 0 ||
+        text_arena_load(&reader_text, (const char *)view.sections[1].records, view.sections[1].count) != 0) {
+        snapshot_close(&view);
+        text_arena_clear(&reader_text);
+        return -1;
+    }
+    
+    chunk_array_write(&reader_store, 0, view.sections[0].records, (int)count);
+    snapshot_close(&view);
+    
+    // 第0个字节是共用的空文本，其余字节不属于任何读者的即为废弃文本
+    size_t live = 1;
+    for (int i = 0; i < (int)count; i++) {
+        ReaderEntry *entry = reader_at(i);
+        for (int j = 0; j < READER_TEXT_COUNT; j++) {
+            TextRef ref = entry->text[j];
+            if ((size_t)ref.offset + ref.length >= reader_text.used) {
+                text_arena_clear(&reader_text);
+                return -1;
+            }
+            live += ref.length > 0 ? (size_t)ref.length + 1 : 0;
+        }
+        
+        // 每位读者都分配新的代数，加载前发出的句柄随之失效
+        entry->id[sizeof(entry->id) - 1] = '\0';
+        reader_generation = reader_generation % READER_GENERATION_MAX + 1;
+        entry->generation = reader_generation;
+    }
+    
+    if (live > reader_text.used) {
+        text_arena_clear(&reader_text);
+        return -1;
+    }
+    reader_text.garbage = reader_text.used - live;
+    reader_count = (int)count;
+    return 0;
+}
+
+/**
+ * @brief 保存读者数据到文件
+ * @return 成功返回0，失败返回非0值
+ */
+int reader_save_data() {
+    // 等待后台合并结束，避免同时写同一个文件
+    journal_wait(&reader_journal);
+    
+    // 数据文件中不保留已删除的位置，先整理
+    if (reader_deleted > 0) {
+        reader_compact_slots();
+    }
+    
+    // 整理后数组中只有有效读者，直接写出（文本不截断）
+    if (reader_write_file(&reader_store, &reader_text, reader_count) != 0) {
+        return -1;
+    }
+    
+    // 数据文件已包含全部变更，日志可以清空
+    return journal_reset(&reader_journal);
+}
+
+/**
+ * @brief 从文件加载读者数据
+ * @return 成功返回0，失败返回非0值
+ */
+int reader_load_data() {
+    reader_count = 0;
+    reader_deleted = 0;
+    reader_free_count = 0;
+    
+    // 文本区随数据一起重建
+    text_arena_clear(&reader_text);
+    
+    // 先加载最近一次完整写出的数据：优先使用二进制快照，没有可用快照时解析CSV
+    int from_csv = 0;
+    if (reader_load_snapshot() != 0) {
+        reader_count = 0;
+        if (reader_load_csv() != 0) {
+            return -1;
+        }
+        from_csv = 1;
+    }
+    
+    // 建立ID索引和折叠列，重放日志时按ID定位读者
+    if (reader_rebuild_indexes() != 0) {
+        return -1;
+    }
+    
+    // 从CSV加载时顺便生成快照，下次启动即可直接映射（快照只对应CSV的内容，在重放日志之前写出）
+    if (from_csv && file_exists(READERS_FILE)) {
+        reader_write_binary(&reader_store, &reader_text, reader_count);
+    }
+    
+    // 再在其上重放变更日志
+    int replayed = journal_replay(&reader_journal, reader_apply_journal, NULL);
+    if (replayed < 0) {
+        return -1;
+    }
+    
+    // 日志保留下来，按与运行时相同的条件在后台合并回数据文件，启动时不重写整个数据文件；
+    // 上次合并中断留下了旧日志时无法启动新的合并，才同步写回
+    if (replayed > 0 && journal_has_old_log(&reader_journal)) {
+        return reader_save_data();
+    }
+    reader_maybe_compact();
+    
     return 0;
 }
 
@@ -305,11 +1371,17 @@ int reader_load_data() {
  * @brief 清理读者管理模块资源
  */
 void reader_cleanup() {
-    if (readers != NULL) {
-        free(readers);
-        readers = NULL;
-    }
+    journal_close(&reader_journal);
+    
+    chunk_array_free(&reader_store);
+    text_arena_free(&reader_text);
+    id_index_free(&reader_id_index);
+    reader_secondary_free();
     
+    free(reader_free_slots);
+    reader_free_slots = NULL;
+    reader_free_capacity = 0;
+    reader_free_count = 0;
+    reader_deleted = 0;
     reader_count = 0;
-    reader_capacity = 0;
 }
\ No newline at end of file
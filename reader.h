@@ -9,9 +9,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 /**
  * @brief 读者结构体
+ *
+ * 模块内部按实际长度存放文本，不截断；取出到结构体时超出字段长度的文本
+ * 在完整的UTF-8字符处截断。
  */
 typedef struct {
     char id[20];          /**< 读者ID */
@@ -24,6 +28,31 @@ typedef struct {
     int current_borrow_count; /**< 当前借阅数量 */
 } Reader;
 
+/**
+ * @brief 遍历读者时的过滤函数
+ * @param reader 遍历时还原出的读者副本（只读，只在回调期间有效）
+ * @param user_data 用户数据
+ * @return 符合条件返回非0值，否则返回0
+ */
+typedef int (*ReaderFilterFunc)(const Reader *reader, void *user_data);
+
+/**
+ * @brief 遍历读者时的访问函数
+ * @param reader 遍历时还原出的读者副本（只读，只在回调期间有效）
+ * @param user_data 用户数据
+ * @return 返回0继续遍历，返回非0值停止
+ */
+typedef int (*ReaderVisitFunc)(const Reader *reader, void *user_data);
+
+/**
+ * @brief 读者句柄（读者在内部数组中的位置及该位置的代数），-1表示不存在
+ *
+ * 新增、修改读者不会使已有句柄失效。读者被删除、所在位置被其他读者复用、
+ * 整理时被移动或数据重新加载后，句柄过期，以句柄为参数的函数返回失败，
+ * 此时应重新调用reader_lookup。
+ */
+typedef int64_t ReaderHandle;
+
 /**
  * @brief 初始化读者管理模块
  * @return 成功返回0，失败返回非0值
@@ -59,6 +88,36 @@ int reader_update(Reader *reader);
  */
 int reader_find_by_id(const char *id, Reader *reader);
 
+/**
+ * @brief 根据ID取读者句柄
+ * @param id 读者ID
+ * @return 找到返回句柄，否则返回-1
+ */
+ReaderHandle reader_lookup(const char *id);
+
+/**
+ * @brief 取句柄对应的读者
+ * @param handle 读者句柄
+ * @param reader 用于存储读者信息
+ * @return 成功返回0，句柄无效时返回非0值
+ */
+int reader_get(ReaderHandle handle, Reader *reader);
+
+/**
+ * @brief 取句柄对应读者还能再借的数量，不复制读者
+ * @param handle 读者句柄
+ * @return 最大借阅数量减去当前借阅数量（不小于0），句柄无效时返回-1
+ */
+int reader_borrow_quota(ReaderHandle handle);
+
+/**
+ * @brief 原地调整读者的当前借阅数量并记录日志
+ * @param handle 读者句柄
+ * @param delta 当前借阅数量的增量（借出为1，归还为-1）
+ * @return 成功返回0，句柄无效或借阅数量将小于0时返回非0值
+ */
+int reader_adjust_borrow_count(ReaderHandle handle, int delta);
+
 /**
  * @brief 根据姓名查找读者
  * @param name 读者姓名
@@ -68,6 +127,15 @@ int reader_find_by_id(const char *id, Reader *reader);
  */
 int reader_find_by_name(const char *name, Reader *readers, int max_count);
 
+/**
+ * @brief 根据电子邮箱查找读者
+ * @param email 电子邮箱
+ * @param readers 用于存储查找结果的读者结构体数组
+ * @param max_count 最大返回数量
+ * @return 返回找到的读者数量
+ */
+int reader_find_by_email(const char *email, Reader *readers, int max_count);
+
 /**
  * @brief 获取所有读者
  * @param readers 用于存储读者的结构体数组
@@ -76,6 +144,23 @@ int reader_find_by_name(const char *name, Reader *readers, int max_count);
  */
 int reader_get_all(Reader *readers, int max_count);
 
+/**
+ * @brief 按存储顺序遍历读者，逐条还原到同一个临时结构体中，不分配内存
+ *
+ * 回调函数拿到的不是存储中的数据：每位读者都从文本区重新还原为完整的Reader
+ * （复制全部文本字段），只是不再为所有读者分配数组。
+ * 删除读者空出的位置会被之后新增的读者复用，存储顺序不一定是录入顺序。
+ * 遍历期间（包括回调函数中）不能增删改读者。
+ *
+ * @param filter 过滤函数，返回非0的读者才交给visit，为NULL时不过滤
+ * @param offset 跳过前offset条符合条件的读者（用于翻页）
+ * @param limit 最多访问的数量（页大小），不大于0时不限
+ * @param visit 访问函数，返回非0时停止遍历
+ * @param user_data 传给filter和visit的用户数据
+ * @return 返回访问的读者数量
+ */
+int reader_foreach(ReaderFilterFunc filter, int offset, int limit, ReaderVisitFunc visit, void *user_data);
+
 /**
  * @brief 保存读者数据到文件
  * @return 成功返回0，失败返回非0值
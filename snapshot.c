@@ -0,0 +1,505 @@
+/**
+ * @file snapshot.c
+ * @brief 二进制数据快照相关函数的实现
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // struct stat中的st_mtim
+#endif
+
+#include "snapshot.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define SNAPSHOT_MAGIC "BMSSNAP"
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+#define SNAPSHOT_ALIGN 64
+
+/**
+ * @brief 快照文件头（56字节），后面紧跟数据段表
+ */
+typedef struct {
+    char magic[8];            /**< 魔数 */
+    uint32_t version;         /**< 格式版本 */
+    uint32_t byte_order;      /**< 字节序标记 */
+    uint32_t record_type;     /**< 快照类型标识 */
+    uint32_t section_count;   /**< 数据段数 */
+    uint64_t source_size;     /**< 写快照时源CSV文件的字节数 */
+    int64_t source_mtime;     /**< 写快照时源CSV文件的修改时间（纳秒） */
+    uint64_t source_inode;    /**< 写快照时源CSV文件的索引节点号（不支持时为0） */
+    uint32_t reserved;        /**< 保留 */
+    uint32_t header_crc;      /**< 文件头和数据段表的校验和（计算时此字段为0） */
+} SnapshotHeader;
+
+/**
+ * @brief 数据段表中的一项（32字节）
+ */
+typedef struct {
+    uint32_t record_size;     /**< 每条记录的字节数 */
+    uint32_t block_records;   /**< 每个校验块包含的记录数 */
+    uint64_t record_count;    /**< 记录数量 */
+    uint64_t crc_offset;      /**< 校验表在文件中的偏移 */
+    uint64_t data_offset;     /**< 第一条记录在文件中的偏移 */
+} SnapshotSectionHeader;
+
+/**
+ * @brief 源CSV文件的大小、修改时间和索引节点号
+ */
+typedef struct {
+    uint64_t size;     /**< 字节数 */
+    int64_t mtime;     /**< 修改时间（纳秒，文件系统不支持时精确到秒） */
+    uint64_t inode;    /**< 索引节点号 */
+} SnapshotSourceStamp;
+
+/**
+ * @brief 取源CSV文件的标记
+ *
+ * 只比较修改时间的秒数时，同一秒内的两次修改无法区分；
+ * 同时比较大小、纳秒级修改时间和索引节点号（改名替换会换新节点）。
+ *
+ * @param path 源文件路径
+ * @param stamp 用于存储标记，文件不存在时全部为0
+ * @return 成功返回0，文件不存在返回-1
+ */
+static int snapshot_source_stamp(const char *path, SnapshotSourceStamp *stamp) {
+    memset(stamp, 0, sizeof(SnapshotSourceStamp));
+    
+#ifdef _WIN32
+    struct _stat64 st;
+    if (path == NULL || _stat64(path, &st) != 0) {
+        return -1;
+    }
+    stamp->mtime = (int64_t)st.st_mtime * 1000000000;
+#else
+    struct stat st;
+    if (path == NULL || stat(path, &st) != 0) {
+        return -1;
+    }
+#if defined(__APPLE__)
+    stamp->mtime = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    stamp->mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    stamp->inode = (uint64_t)st.st_ino;
+#endif
+    
+    stamp->size = (uint64_t)st.st_size;
+    return 0;
+}
+
+/**
+ * @brief 计算每个校验块包含的记录数
+ * @param record_size 每条记录的字节数
+ * @return 记录数
+ */
+static uint32_t snapshot_block_records(uint32_t record_size) {
+    uint32_t records = SNAPSHOT_BLOCK_BYTES / record_size;
+    return records > 0 ? records : 1;
+}
+
+/**
+ * @brief 计算校验块数量
+ * @param section 数据段表项（记录数和每块记录数已填好）
+ * @return 块数
+ */
+static uint64_t snapshot_block_count(const SnapshotSectionHeader *section) {
+    return (section->record_count + section->block_records - 1) / section->block_records;
+}
+
+/**
+ * @brief 按各段的记录大小和数量排列文件：文件头、数据段表，然后依次是各段的校验表和按64字节对齐的记录
+ * @param sections 数据段表（记录大小、每块记录数和记录数已填好，本函数填写偏移）
+ * @param count 数据段数
+ * @return 文件总长度
+ */
+static uint64_t snapshot_layout(SnapshotSectionHeader *sections, int count) {
+    uint64_t offset = sizeof(SnapshotHeader) + (uint64_t)count * sizeof(SnapshotSectionHeader);
+    
+    for (int i = 0; i < count; i++) {
+        sections[i].crc_offset = offset;
+        offset += snapshot_block_count(&sections[i]) * sizeof(uint32_t);
+        offset = (offset + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+        sections[i].data_offset = offset;
+        offset += sections[i].record_count * sections[i].record_size;
+    }
+    
+    return offset;
+}
+
+/**
+ * @brief 计算文件头和数据段表的校验和
+ * @param header 文件头
+ * @param sections 数据段表
+ * @return 校验和
+ */
+static uint32_t snapshot_header_crc(const SnapshotHeader *header, const SnapshotSectionHeader *sections) {
+    SnapshotHeader copy = *header;
+    copy.header_crc = 0;
+    uint32_t crc = crc32c_compute(0, &copy, sizeof(copy));
+    return crc32c_compute(crc, sections, sizeof(SnapshotSectionHeader) * header->section_count);
+}
+
+/**
+ * @brief 取一段不跨块的连续记录
+ * @param section 数据段
+ * @param first 起始记录
+ * @param end 结束记录（不含）
+ * @param count 用于存储这一段的记录数
+ * @return 起始记录的地址
+ */
+static const unsigned char *snapshot_span(const SnapshotSection *section, size_t first, size_t end,
+                                          size_t *count) {
+    if (section->chunk_records == 0) {
+        *count = end - first;
+        return (const unsigned char *)section->chunks[0] + first * section->record_size;
+    }
+    
+    size_t offset = first % section->chunk_records;
+    size_t n = section->chunk_records - offset;
+    
+    *count = end - first < n ? end - first : n;
+    return (const unsigned char *)section->chunks[first / section->chunk_records] + offset * section->record_size;
+}
+
+/**
+ * @brief 计算一个数据段的块校验表，校验块跨记录块时分段累计
+ * @param section 数据段
+ * @param header 数据段表项
+ * @return 校验表（由调用方释放），内存不足返回NULL
+ */
+static uint32_t *snapshot_block_crcs(const SnapshotSection *section, const SnapshotSectionHeader *header) {
+    size_t block_count = (size_t)snapshot_block_count(header);
+    uint32_t *crcs = (uint32_t *)calloc(block_count > 0 ? block_count : 1, sizeof(uint32_t));
+    if (crcs == NULL) {
+        return NULL;
+    }
+    
+    for (size_t i = 0; i < block_count; i++) {
+        size_t first = i * header->block_records;
+        size_t end = section->count - first < header->block_records ? section->count : first + header->block_records;
+        uint32_t crc = 0;
+        
+        while (first < end) {
+            size_t n;
+            const unsigned char *data = snapshot_span(section, first, end, &n);
+            crc = crc32c_compute(crc, data, n * section->record_size);
+            first += n;
+        }
+        crcs[i] = crc;
+    }
+    
+    return crcs;
+}
+
+/**
+ * @brief 写出填充字节，使文件写到指定偏移
+ * @param file 文件
+ * @param position 当前偏移
+ * @param offset 目标偏移
+ * @return 成功返回1，失败返回0
+ */
+static int snapshot_pad_to(FILE *file, uint64_t position, uint64_t offset) {
+    static const char padding[SNAPSHOT_ALIGN] = {0};
+    size_t pad_size = (size_t)(offset - position);
+    return fwrite(padding, 1, pad_size, file) == pad_size;
+}
+
+/**
+ * @brief 写出一个数据段的校验表和记录
+ * @param file 文件
+ * @param position 当前偏移，返回时更新为写完后的偏移
+ * @param section 数据段
+ * @param header 数据段表项
+ * @return 成功返回1，失败返回0
+ */
+static int snapshot_write_section(FILE *file, uint64_t *position, const SnapshotSection *section,
+                                  const SnapshotSectionHeader *header) {
+    uint32_t *crcs = snapshot_block_crcs(section, header);
+    if (crcs == NULL) {
+        return 0;
+    }
+    
+    size_t table_size = (size_t)snapshot_block_count(header) * sizeof(uint32_t);
+    int ok = snapshot_pad_to(file, *position, header->crc_offset) &&
+             fwrite(crcs, 1, table_size, file) == table_size &&
+             snapshot_pad_to(file, header->crc_offset + table_size, header->data_offset);
+    free(crcs);
+    
+    for (size_t first = 0; ok && first < section->count; ) {
+        size_t n;
+        const unsigned char *data = snapshot_span(section, first, section->count, &n);
+        ok = fwrite(data, section->record_size, n, file) == n;
+        first += n;
+    }
+    
+    *position = header->data_offset + header->record_count * header->record_size;
+    return ok;
+}
+
+/**
+ * @brief 写出快照（先写临时文件再替换）
+ * @param path 快照文件路径
+ * @param source_path 快照内容对应的CSV文件路径（记下它当前的大小和修改时间）
+ * @param record_type 快照类型标识
+ * @param sections 数据段数组
+ * @param section_count 数据段数（不超过SNAPSHOT_MAX_SECTIONS）
+ * @return 成功返回0，失败返回非0值
+ */
+int snapshot_write(const char *path, const char *source_path, uint32_t record_type,
+                   const SnapshotSection *sections, int section_count) {
+    if (path == NULL || sections == NULL || section_count <= 0 || section_count > SNAPSHOT_MAX_SECTIONS) {
+        return -1;
+    }
+    
+    SnapshotSectionHeader table[SNAPSHOT_MAX_SECTIONS];
+    memset(table, 0, sizeof(table));
+    for (int i = 0; i < section_count; i++) {
+        if (sections[i].record_size == 0 || (sections[i].count > 0 && sections[i].chunks == NULL)) {
+            return -1;
+        }
+        table[i].record_size = sections[i].record_size;
+        table[i].block_records = snapshot_block_records(sections[i].record_size);
+        table[i].record_count = sections[i].count;
+    }
+    snapshot_layout(table, section_count);
+    
+    char tmp_path[280];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.record_type = record_type;
+    header.section_count = (uint32_t)section_count;
+    
+    SnapshotSourceStamp stamp;
+    snapshot_source_stamp(source_path, &stamp);
+    header.source_size = stamp.size;
+    header.source_mtime = stamp.mtime;
+    header.source_inode = stamp.inode;
+    header.header_crc = snapshot_header_crc(&header, table);
+    
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        return -1;
+    }
+    
+    size_t table_size = sizeof(SnapshotSectionHeader) * (size_t)section_count;
+    uint64_t position = sizeof(header) + table_size;
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(table, 1, table_size, file) == table_size;
+    
+    for (int i = 0; ok && i < section_count; i++) {
+        ok = snapshot_write_section(file, &position, &sections[i], &table[i]);
+    }
+    
+    if (fclose(file) != 0 || !ok) {
+        remove(tmp_path);
+        return -1;
+    }
+    
+    return rename(tmp_path, path);
+}
+
+/**
+ * @brief 映射整个文件
+ * @param path 文件路径
+ * @param view 用于存储映射结果
+ * @return 成功返回0，失败返回非0值
+ */
+static int snapshot_map_file(const char *path, SnapshotView *view) {
+#ifdef _WIN32
+    // Windows下退化为一次性读入内存
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+    
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    
+    if (size <= 0) {
+        fclose(file);
+        return -1;
+    }
+    
+    view->map = malloc((size_t)size);
+    if (view->map == NULL || fread(view->map, 1, (size_t)size, file) != (size_t)size) {
+        free(view->map);
+        view->map = NULL;
+        fclose(file);
+        return -1;
+    }
+    
+    fclose(file);
+    view->map_size = (size_t)size;
+    return 0;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return -1;
+    }
+    
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    
+    view->map = map;
+    view->map_size = (size_t)st.st_size;
+    return 0;
+#endif
+}
+
+/**
+ * @brief 校验一个数据段的各块
+ * @param base 映射的文件内容
+ * @param section 数据段表项（偏移已确认在文件范围内）
+ * @return 全部匹配返回0，否则返回-1
+ */
+static int snapshot_check_section(const unsigned char *base, const SnapshotSectionHeader *section) {
+    const unsigned char *data = base + section->data_offset;
+    uint64_t block_count = snapshot_block_count(section);
+    
+    for (uint64_t i = 0; i < block_count; i++) {
+        uint32_t expected;
+        memcpy(&expected, base + section->crc_offset + i * sizeof(uint32_t), sizeof(expected));
+        
+        uint64_t first = i * section->block_records;
+        uint64_t n = section->record_count - first < section->block_records ?
+                     section->record_count - first : section->block_records;
+        
+        if (crc32c_compute(0, data + first * section->record_size, (size_t)(n * section->record_size)) != expected) {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 映射并校验快照
+ * @param path 快照文件路径
+ * @param source_path 快照内容对应的CSV文件路径
+ * @param record_type 期望的快照类型标识
+ * @param record_sizes 期望的各数据段每条记录字节数
+ * @param section_count 期望的数据段数
+ * @param view 用于存储打开结果
+ * @return 成功返回0，失败返回非0值
+ */
+int snapshot_open(const char *path, const char *source_path, uint32_t record_type,
+                  const uint32_t *record_sizes, int section_count, SnapshotView *view) {
+    if (path == NULL || record_sizes == NULL || view == NULL ||
+        section_count <= 0 || section_count > SNAPSHOT_MAX_SECTIONS) {
+        return -1;
+    }
+    
+    memset(view, 0, sizeof(SnapshotView));
+    
+    if (snapshot_map_file(path, view) != 0) {
+        return -1;
+    }
+    
+    size_t table_size = sizeof(SnapshotSectionHeader) * (size_t)section_count;
+    if (view->map_size < sizeof(SnapshotHeader) + table_size) {
+        snapshot_close(view);
+        return -1;
+    }
+    
+    // 校验文件头和数据段表
+    SnapshotHeader header;
+    SnapshotSectionHeader table[SNAPSHOT_MAX_SECTIONS];
+    memcpy(&header, view->map, sizeof(header));
+    memcpy(table, (const unsigned char *)view->map + sizeof(header), table_size);
+    
+    // 源CSV文件在快照写出后被修改或替换过时以CSV为准；CSV不存在时快照是唯一的数据，仍然使用
+    SnapshotSourceStamp stamp;
+    int source_changed = snapshot_source_stamp(source_path, &stamp) == 0 &&
+                         (header.source_size != stamp.size || header.source_mtime != stamp.mtime ||
+                          header.source_inode != stamp.inode);
+    
+    if (source_changed ||
+        memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        header.version != SNAPSHOT_VERSION ||
+        header.byte_order != SNAPSHOT_BYTE_ORDER ||
+        header.record_type != record_type ||
+        header.section_count != (uint32_t)section_count ||
+        header.header_crc != snapshot_header_crc(&header, table)) {
+        snapshot_close(view);
+        return -1;
+    }
+    
+    // 各段的记录大小必须符合预期，偏移必须与按记录数重新排列的结果一致，并且都在文件范围内
+    SnapshotSectionHeader expected[SNAPSHOT_MAX_SECTIONS];
+    memset(expected, 0, sizeof(expected));
+    for (int i = 0; i < section_count; i++) {
+        if (table[i].record_size != record_sizes[i] ||
+            table[i].block_records != snapshot_block_records(record_sizes[i]) ||
+            table[i].record_count > view->map_size / record_sizes[i]) {
+            snapshot_close(view);
+            return -1;
+        }
+        expected[i] = table[i];
+    }
+    
+    if (snapshot_layout(expected, section_count) > view->map_size ||
+        memcmp(expected, table, table_size) != 0) {
+        snapshot_close(view);
+        return -1;
+    }
+    
+    // 逐块校验记录
+    const unsigned char *base = (const unsigned char *)view->map;
+    for (int i = 0; i < section_count; i++) {
+        if (snapshot_check_section(base, &table[i]) != 0) {
+            snapshot_close(view);
+            return -1;
+        }
+        view->sections[i].records = base + table[i].data_offset;
+        view->sections[i].count = (size_t)table[i].record_count;
+    }
+    
+    view->section_count = section_count;
+    return 0;
+}
+
+/**
+ * @brief 关闭快照
+ * @param view 已打开的快照
+ */
+void snapshot_close(SnapshotView *view) {
+    if (view == NULL || view->map == NULL) {
+        return;
+    }
+    
+#ifdef _WIN32
+    free(view->map);
+#else
+    munmap(view->map, view->map_size);
+#endif
+    
+    memset(view, 0, sizeof(SnapshotView));
+}
@@ -0,0 +1,90 @@
+/**
+ * @file snapshot.h
+ * @brief 二进制数据快照相关函数和数据结构的声明
+ *
+ * 快照文件由固定长度的文件头、数据段表和若干数据段组成。每个数据段是一组定长记录，
+ * 内存布局与模块内部的存储形式（例如图书的热数据、冷数据数组）完全一致；
+ * 变长文本以字节为记录整段存放，记录中只存偏移。每段按块计算CRC32C校验和。
+ * 加载时直接映射文件，校验后按段整块复制回模块的数组，不需要逐行解析或转换。
+ * 文件头记下快照内容对应的CSV文件的大小、修改时间（纳秒）和索引节点号，
+ * CSV之后被修改或替换时快照即失效。
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SNAPSHOT_VERSION 3                  /**< 快照格式版本 */
+#define SNAPSHOT_MAX_SECTIONS 8             /**< 一个快照最多包含的数据段数 */
+#define SNAPSHOT_BLOCK_BYTES (256 * 1024)   /**< 每个校验块的大致字节数（取整到整条记录） */
+
+/**
+ * @brief 写快照时的一个数据段
+ *
+ * 记录可以分块存放：第i块存放第i*chunk_records条起的记录，
+ * 连续存放的记录传入只有一块的块表、chunk_records为0即可。
+ */
+typedef struct {
+    const void *const *chunks;   /**< 记录块表 */
+    size_t chunk_records;        /**< 每块的记录数，0表示全部记录在同一块中 */
+    uint32_t record_size;        /**< 每条记录的字节数 */
+    size_t count;                /**< 记录数量 */
+} SnapshotSection;
+
+/**
+ * @brief 已打开的快照中的一个数据段
+ */
+typedef struct {
+    const void *records;   /**< 第一条记录（在映射的文件中，按64字节对齐） */
+    size_t count;          /**< 记录数量 */
+} SnapshotData;
+
+/**
+ * @brief 已打开的快照
+ */
+typedef struct {
+    void *map;                                    /**< 映射的文件内容 */
+    size_t map_size;                              /**< 映射的长度 */
+    SnapshotData sections[SNAPSHOT_MAX_SECTIONS]; /**< 各数据段 */
+    int section_count;                            /**< 数据段数 */
+} SnapshotView;
+
+/**
+ * @brief 写出快照（先写临时文件再替换）
+ * @param path 快照文件路径
+ * @param source_path 快照内容对应的CSV文件路径（记下它当前的大小和修改时间）
+ * @param record_type 快照类型标识
+ * @param sections 数据段数组
+ * @param section_count 数据段数（不超过SNAPSHOT_MAX_SECTIONS）
+ * @return 成功返回0，失败返回非0值
+ */
+int snapshot_write(const char *path, const char *source_path, uint32_t record_type,
+                   const SnapshotSection *sections, int section_count);
+
+/**
+ * @brief 映射并校验快照
+ *
+ * 文件头、快照类型、数据段数、任一段的记录大小或校验和不匹配，或者源CSV文件的
+ * 大小、修改时间、索引节点号与写快照时不同时返回失败，调用方应退回到CSV文件。
+ * 源CSV文件不存在时不比较，快照仍然可用。
+ *
+ * @param path 快照文件路径
+ * @param source_path 快照内容对应的CSV文件路径
+ * @param record_type 期望的快照类型标识
+ * @param record_sizes 期望的各数据段每条记录字节数
+ * @param section_count 期望的数据段数
+ * @param view 用于存储打开结果
+ * @return 成功返回0，失败返回非0值
+ */
+int snapshot_open(const char *path, const char *source_path, uint32_t record_type,
+                  const uint32_t *record_sizes, int section_count, SnapshotView *view);
+
+/**
+ * @brief 关闭快照
+ * @param view 已打开的快照
+ */
+void snapshot_close(SnapshotView *view);
+
+#endif /* SNAPSHOT_H */
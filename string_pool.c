@@ -0,0 +1,301 @@
+/**
+ * @file string_pool.c
+ * @brief 字符串池相关函数的实现
+ */
+
+#include "string_pool.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRING_POOL_BLOCK_SIZE 65536 // 每块的字节数（更长的字符串单独占一块）
+#define STRING_POOL_INITIAL_CAPACITY 1024 // 字符串表的初始容量
+
+/**
+ * @brief 取编号对应的字符串（哈希索引的回调函数）
+ * @param index 编号
+ * @param user_data 所属的字符串池
+ * @return 字符串
+ */
+static const char *string_pool_key(int index, void *user_data) {
+    return ((StringPool *)user_data)->strings[index];
+}
+
+/**
+ * @brief 初始化字符串池
+ * @param pool 字符串池
+ * @return 成功返回0，失败返回非0值
+ */
+int string_pool_init(StringPool *pool) {
+    if (pool == NULL) {
+        return -1;
+    }
+    
+    pool->blocks = NULL;
+    pool->block_count = 0;
+    pool->block_capacity = 0;
+    pool->block_used = 0;
+    pool->block_size = 0;
+    pool->count = 0;
+    pool->bytes = 0;
+    
+    pool->strings = (const char **)malloc(sizeof(const char *) * STRING_POOL_INITIAL_CAPACITY);
+    if (pool->strings == NULL) {
+        return -1;
+    }
+    pool->capacity = STRING_POOL_INITIAL_CAPACITY;
+    
+    if (id_index_init(&pool->index, STRING_POOL_INITIAL_CAPACITY, string_pool_key, pool) != 0) {
+        free(pool->strings);
+        pool->strings = NULL;
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 清空字符串池（释放所有字符串，保留哈希索引的内存）
+ * @param pool 字符串池
+ */
+void string_pool_clear(StringPool *pool) {
+    for (int i = 0; i < pool->block_count; i++) {
+        free(pool->blocks[i]);
+    }
+    
+    pool->block_count = 0;
+    pool->block_used = 0;
+    pool->block_size = 0;
+    pool->count = 0;
+    pool->bytes = 0;
+    id_index_rebuild(&pool->index, 0);
+}
+
+/**
+ * @brief 释放字符串池
+ * @param pool 字符串池
+ */
+void string_pool_free(StringPool *pool) {
+    // 未初始化成功或已经释放过的池不需要再释放
+    if (pool == NULL || pool->strings == NULL) {
+        return;
+    }
+    
+    string_pool_clear(pool);
+    id_index_free(&pool->index);
+    free(pool->blocks);
+    free((void *)pool->strings);
+    pool->blocks = NULL;
+    pool->block_capacity = 0;
+    pool->strings = NULL;
+    pool->capacity = 0;
+}
+
+/**
+ * @brief 在块中分配空间，最后一块不够时追加一块
+ * @param pool 字符串池
+ * @param size 需要的字节数
+ * @return 成功返回地址，内存不足返回NULL
+ */
+static char *string_pool_alloc(StringPool *pool, size_t size) {
+    if (pool->block_count > 0 && pool->block_size - pool->block_used >= size) {
+        char *p = pool->blocks[pool->block_count - 1] + pool->block_used;
+        pool->block_used += size;
+        return p;
+    }
+    
+    if (pool->block_count >= pool->block_capacity) {
+        int capacity = pool->block_capacity > 0 ? pool->block_capacity * 2 : 16;
+        char **grown = (char **)realloc(pool->blocks, sizeof(char *) * capacity);
+        if (grown == NULL) {
+            return NULL;
+        }
+        pool->blocks = grown;
+        pool->block_capacity = capacity;
+    }
+    
+    // 块只追加不移动，已有字符串的地址保持不变
+    size_t block_size = size > STRING_POOL_BLOCK_SIZE ? size : STRING_POOL_BLOCK_SIZE;
+    char *block = (char *)malloc(block_size);
+    if (block == NULL) {
+        return NULL;
+    }
+    
+    pool->blocks[pool->block_count++] = block;
+    pool->block_size = block_size;
+    pool->block_used = size;
+    return block;
+}
+
+/**
+ * @brief 驻留字符串：已存在时返回原编号，否则复制一份并分配新编号
+ * @param pool 字符串池
+ * @param text 字符串
+ * @return 返回编号，内存不足返回-1
+ */
+int string_pool_intern(StringPool *pool, const char *text) {
+    int id = id_index_find(&pool->index, text);
+    if (id != -1) {
+        return id;
+    }
+    
+    if (pool->count >= pool->capacity) {
+        int capacity = pool->capacity * 2;
+        const char **grown = (const char **)realloc((void *)pool->strings, sizeof(const char *) * capacity);
+        if (grown == NULL) {
+            return -1;
+        }
+        pool->strings = grown;
+        pool->capacity = capacity;
+    }
+    
+    size_t size = strlen(text) + 1;
+    char *copy = string_pool_alloc(pool, size);
+    if (copy == NULL) {
+        return -1;
+    }
+    memcpy(copy, text, size);
+    
+    id = pool->count;
+    pool->strings[id] = copy;
+    if (id_index_insert(&pool->index, id) != 0) {
+        return -1;
+    }
+    
+    pool->count++;
+    pool->bytes += size;
+    return id;
+}
+
+/**
+ * @brief 查找字符串的编号（不加入）
+ * @param pool 字符串池
+ * @param text 字符串
+ * @return 找到返回编号，否则返回-1
+ */
+int string_pool_find(const StringPool *pool, const char *text) {
+    return id_index_find(&pool->index, text);
+}
+
+/**
+ * @brief 取编号对应的字符串
+ * @param pool 字符串池
+ * @param id 编号
+ * @return 字符串（在清空或释放字符串池之前有效）
+ */
+const char *string_pool_get(const StringPool *pool, int id) {
+    return pool->strings[id];
+}
+
+/**
+ * @brief 把全部字符串按编号顺序首尾相接地写到缓冲区（每个字符串都带结尾'\0'）
+ * @param pool 字符串池
+ * @param buffer 缓冲区（不小于pool->bytes字节）
+ */
+void string_pool_write(const StringPool *pool, char *buffer) {
+    for (int i = 0; i < pool->count; i++) {
+        size_t size = strlen(pool->strings[i]) + 1;
+        memcpy(buffer, pool->strings[i], size);
+        buffer += size;
+    }
+}
+
+/**
+ * @brief 用string_pool_write写出的内容替换字符串池中的全部字符串，编号与写出时相同
+ * @param pool 字符串池
+ * @param data 字符串池的内容
+ * @param size 字节数
+ * @return 成功返回0，内容格式不对（不以'\0'结尾或有重复的字符串）或内存不足返回非0值
+ */
+int string_pool_load(StringPool *pool, const char *data, size_t size) {
+    string_pool_clear(pool);
+    if (size == 0) {
+        return 0;
+    }
+    if (data[size - 1] != '\0') {
+        return -1;
+    }
+    
+    int count = 0;
+    for (const char *p = data; p < data + size; p = (const char *)memchr(p, '\0', (size_t)(data + size - p)) + 1) {
+        if (count == INT_MAX) {
+            return -1;
+        }
+        count++;
+    }
+    
+    if (count > pool->capacity) {
+        const char **grown = (const char **)realloc((void *)pool->strings, sizeof(const char *) * count);
+        if (grown == NULL) {
+            return -1;
+        }
+        pool->strings = grown;
+        pool->capacity = count;
+    }
+    
+    char *block = string_pool_alloc(pool, size);
+    if (block == NULL) {
+        return -1;
+    }
+    memcpy(block, data, size);
+    
+    for (int i = 0; i < count; i++) {
+        pool->strings[i] = block;
+        block += strlen(block) + 1;
+    }
+    pool->count = count;
+    pool->bytes = size;
+    
+    // 重复的字符串只有第一个进入索引，说明内容不是由字符串池写出的
+    if (id_index_rebuild(&pool->index, count) != 0 || pool->index.count != count) {
+        string_pool_clear(pool);
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 复制字符串池，副本中的编号与原池相同
+ * @param dest 副本（未初始化，由调用方用string_pool_free释放）
+ * @param src 原字符串池
+ * @return 成功返回0，内存不足返回非0值
+ */
+int string_pool_copy(StringPool *dest, const StringPool *src) {
+    if (string_pool_init(dest) != 0) {
+        return -1;
+    }
+    
+    char *data = (char *)malloc(src->bytes > 0 ? src->bytes : 1);
+    if (data == NULL) {
+        string_pool_free(dest);
+        return -1;
+    }
+    
+    string_pool_write(src, data);
+    int result = string_pool_load(dest, data, src->bytes);
+    free(data);
+    if (result != 0) {
+        string_pool_free(dest);
+    }
+    return result;
+}
+
+/**
+ * @brief 统计字符串池占用的内存（字符串块、字符串表和哈希索引）
+ * @param pool 字符串池
+ * @return 字节数
+ */
+size_t string_pool_memory(const StringPool *pool) {
+    size_t bytes = sizeof(const char *) * pool->capacity + sizeof(int) * ((size_t)pool->index.mask + 1);
+    
+    // 除最后一块外都是整块分配，按分配大小计算
+    for (int i = 0; i + 1 < pool->block_count; i++) {
+        bytes += STRING_POOL_BLOCK_SIZE;
+    }
+    if (pool->block_count > 0) {
+        bytes += pool->block_size;
+    }
+    
+    return bytes;
+}
\ No newline at end of file
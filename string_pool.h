@@ -0,0 +1,109 @@
+/**
+ * @file string_pool.h
+ * @brief 字符串池相关函数和数据结构的声明
+ *
+ * 字符串池对字符串做驻留：相同的字符串只存一份，用从0开始的编号引用，
+ * 两个编号相等当且仅当字符串相同。字符串按块连续存放，加入新字符串时
+ * 已有字符串的地址不变；池只增不减，清空或释放时整体回收。
+ */
+
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <stddef.h>
+#include "id_index.h"
+
+/**
+ * @brief 字符串池结构体
+ */
+typedef struct {
+    char **blocks;          /**< 存放字符串的块 */
+    int block_count;        /**< 块数量 */
+    int block_capacity;     /**< 块指针表容量 */
+    size_t block_used;      /**< 最后一块已使用的字节数 */
+    size_t block_size;      /**< 最后一块的字节数 */
+    const char **strings;   /**< 各编号对应的字符串 */
+    int count;              /**< 字符串数量 */
+    int capacity;           /**< 字符串表容量 */
+    size_t bytes;           /**< 字符串占用的字节数（含结尾'\0'） */
+    IdIndex index;          /**< 字符串到编号的哈希索引 */
+} StringPool;
+
+/**
+ * @brief 初始化字符串池
+ * @param pool 字符串池
+ * @return 成功返回0，失败返回非0值
+ */
+int string_pool_init(StringPool *pool);
+
+/**
+ * @brief 清空字符串池（释放所有字符串，保留哈希索引的内存）
+ * @param pool 字符串池
+ */
+void string_pool_clear(StringPool *pool);
+
+/**
+ * @brief 释放字符串池
+ * @param pool 字符串池
+ */
+void string_pool_free(StringPool *pool);
+
+/**
+ * @brief 驻留字符串：已存在时返回原编号，否则复制一份并分配新编号
+ * @param pool 字符串池
+ * @param text 字符串
+ * @return 返回编号，内存不足返回-1
+ */
+int string_pool_intern(StringPool *pool, const char *text);
+
+/**
+ * @brief 查找字符串的编号（不加入）
+ * @param pool 字符串池
+ * @param text 字符串
+ * @return 找到返回编号，否则返回-1
+ */
+int string_pool_find(const StringPool *pool, const char *text);
+
+/**
+ * @brief 取编号对应的字符串
+ * @param pool 字符串池
+ * @param id 编号
+ * @return 字符串（在清空或释放字符串池之前有效）
+ */
+const char *string_pool_get(const StringPool *pool, int id);
+
+/**
+ * @brief 把全部字符串按编号顺序首尾相接地写到缓冲区（每个字符串都带结尾'\0'）
+ * @param pool 字符串池
+ * @param buffer 缓冲区（不小于pool->bytes字节）
+ */
+void string_pool_write(const StringPool *pool, char *buffer);
+
+/**
+ * @brief 用string_pool_write写出的内容替换字符串池中的全部字符串，编号与写出时相同
+ *
+ * 内容整块复制到一个块中，只重建哈希索引，不逐个驻留。
+ *
+ * @param pool 字符串池
+ * @param data 字符串池的内容
+ * @param size 字节数
+ * @return 成功返回0，内容格式不对（不以'\0'结尾或有重复的字符串）或内存不足返回非0值
+ */
+int string_pool_load(StringPool *pool, const char *data, size_t size);
+
+/**
+ * @brief 复制字符串池，副本中的编号与原池相同
+ * @param dest 副本（未初始化，由调用方用string_pool_free释放）
+ * @param src 原字符串池
+ * @return 成功返回0，内存不足返回非0值
+ */
+int string_pool_copy(StringPool *dest, const StringPool *src);
+
+/**
+ * @brief 统计字符串池占用的内存（字符串块、字符串表和哈希索引）
+ * @param pool 字符串池
+ * @return 字节数
+ */
+size_t string_pool_memory(const StringPool *pool);
+
+#endif /* STRING_POOL_H */
\ No newline at end of file
@@ -0,0 +1,36 @@
+/**
+ * @file test.h
+ * @brief 测试程序共用的检查宏和辅助函数
+ *
+ * 测试程序只链接数据模块，不依赖GTK。每个程序在一个带有data/子目录的空目录中运行
+ * （由Makefile的test目标准备），全部检查通过时返回0。
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * @brief 检查条件，不成立时输出位置并以失败退出
+ */
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+/**
+ * @brief 取单调时钟的当前时间
+ * @return 秒数
+ */
+static inline double test_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+#endif /* TEST_H */
@@ -0,0 +1,173 @@
+/**
+ * @file test_borrow_load.c
+ * @brief 大量借阅记录的加载测试
+ *
+ * 生成指定条数（默认1000万条）的borrows.csv，分别用单线程、多线程解析CSV
+ * 以及从二进制快照加载，逐条核对记录内容和按读者、按ID的查找结果，
+ * 确认加载过程中没有任何记录被截断或丢弃。每TEST_LEGACY_EVERY条中有一条使用
+ * 不是标准格式的记录ID，覆盖多线程加载时各段字符串池的合并。
+ *
+ * 用法：test_borrow_load [记录条数]
+ */
+
+#include "test.h"
+#include "../borrow.h"
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#define TEST_DEFAULT_ROWS 10000000L
+#define TEST_BOOKS 200000    // 记录引用的不同图书数
+#define TEST_READERS 50000   // 记录引用的不同读者数
+#define TEST_BASE_DATE 1700000000L
+#define TEST_LEGACY_EVERY 1000 // 每多少条记录中有一条使用非标准格式的ID
+
+/**
+ * @brief 取进程的内存峰值
+ * @return MB
+ */
+static long test_peak_rss_mb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;
+}
+
+/**
+ * @brief 第i条记录的借阅状态：每3条中有1条已归还
+ * @param i 记录序号
+ * @return 借阅状态
+ */
+static BorrowStatus test_status(long i) {
+    return i % 3 == 0 ? BORROW_STATUS_RETURNED : BORROW_STATUS_BORROWED;
+}
+
+/**
+ * @brief 第i条记录的ID
+ * @param i 记录序号
+ * @param id 用于存储ID
+ * @param size 缓冲区大小
+ */
+static void test_record_id(long i, char *id, size_t size) {
+    if (i % TEST_LEGACY_EVERY == 7) {
+        snprintf(id, size, "OLD-%ld", i);
+    } else {
+        snprintf(id, size, "BR%08ld", i);
+    }
+}
+
+/**
+ * @brief 生成借阅数据文件
+ * @param rows 记录条数
+ */
+static void test_write_csv(long rows) {
+    FILE *file = fopen("data/borrows.csv", "w");
+    CHECK(file != NULL);
+    
+    fprintf(file, "id,book_id,reader_id,borrow_date,due_date,return_date,status,renew_count\n");
+    for (long i = 0; i < rows; i++) {
+        BorrowStatus status = test_status(i);
+        char id[32];
+        test_record_id(i, id, sizeof(id));
+        fprintf(file, "%s,B%06ld,R%06ld,%ld,%ld,%ld,%d,%ld\n",
+                id, i % TEST_BOOKS, i % TEST_READERS, TEST_BASE_DATE + i, TEST_BASE_DATE + 2592000L + i,
+                status == BORROW_STATUS_RETURNED ? TEST_BASE_DATE + 86400L + i : 0L, (int)status, i % 3);
+    }
+    
+    CHECK(fclose(file) == 0);
+}
+
+/**
+ * @brief 核对一条借阅记录（borrow_foreach的回调函数）
+ * @param record 借阅记录
+ * @param user_data 已核对的记录数
+ * @return 总是返回0
+ */
+static int test_check_record(const BorrowRecord *record, void *user_data) {
+    long i = (*(long *)user_data)++;
+    char id[32];
+    char book_id[32];
+    char reader_id[32];
+    
+    test_record_id(i, id, sizeof(id));
+    snprintf(book_id, sizeof(book_id), "B%06ld", i % TEST_BOOKS);
+    snprintf(reader_id, sizeof(reader_id), "R%06ld", i % TEST_READERS);
+    
+    BorrowStatus status = test_status(i);
+    CHECK(strcmp(record->id, id) == 0);
+    CHECK(strcmp(record->book_id, book_id) == 0);
+    CHECK(strcmp(record->reader_id, reader_id) == 0);
+    CHECK(record->borrow_date == (time_t)(TEST_BASE_DATE + i));
+    CHECK(record->due_date == (time_t)(TEST_BASE_DATE + 2592000L + i));
+    CHECK(record->return_date == (time_t)(status == BORROW_STATUS_RETURNED ? TEST_BASE_DATE + 86400L + i : 0));
+    CHECK(record->status == status);
+    CHECK(record->renew_count == (int)(i % 3));
+    return 0;
+}
+
+/**
+ * @brief 核对已加载的全部借阅记录
+ * @param rows 记录条数
+ */
+static void test_check_loaded(long rows) {
+    long seen = 0;
+    CHECK(borrow_foreach(NULL, 0, 0, test_check_record, &seen) == (int)rows);
+    CHECK(seen == rows);
+    
+    // 按读者查找：R000123的记录每TEST_READERS条出现一次
+    long expected = rows / TEST_READERS + (rows % TEST_READERS > 123 ? 1 : 0);
+    BorrowRecord *records = (BorrowRecord *)malloc(sizeof(BorrowRecord) * (size_t)(expected + 1));
+    CHECK(records != NULL);
+    CHECK(borrow_find_by_reader("R000123", records, (int)expected + 1) == (int)expected);
+    free(records);
+    
+    // 按ID查找最后一条记录和最后一条非标准格式ID的记录
+    char id[32];
+    BorrowRecord record;
+    test_record_id(rows - 1, id, sizeof(id));
+    CHECK(borrow_find_by_id(id, &record) == 0);
+    CHECK(record.borrow_date == (time_t)(TEST_BASE_DATE + rows - 1));
+    
+    long legacy = (rows - 8) / TEST_LEGACY_EVERY * TEST_LEGACY_EVERY + 7;
+    if (rows > 7) {
+        test_record_id(legacy, id, sizeof(id));
+        CHECK(borrow_find_by_id(id, &record) == 0);
+        CHECK(record.borrow_date == (time_t)(TEST_BASE_DATE + legacy));
+    }
+}
+
+/**
+ * @brief 加载并核对一次
+ * @param rows 记录条数
+ * @param threads 解析CSV使用的线程数
+ * @param what 加载方式的说明
+ */
+static void test_load(long rows, int threads, const char *what) {
+    borrow_set_load_threads(threads);
+    
+    double start = test_now();
+    CHECK(borrow_init() == 0);
+    double loaded = test_now();
+    test_check_loaded(rows);
+    
+    printf("%-24s load %.2fs, verify %.2fs, peak RSS %ld MB\n",
+           what, loaded - start, test_now() - loaded, test_peak_rss_mb());
+    borrow_cleanup();
+}
+
+int main(int argc, char *argv[]) {
+    long rows = argc > 1 ? atol(argv[1]) : TEST_DEFAULT_ROWS;
+    CHECK(rows > 0);
+    
+    double start = test_now();
+    test_write_csv(rows);
+    printf("generated %ld borrow records in %.2fs\n", rows, test_now() - start);
+    
+    // 没有快照时解析CSV，并顺便写出快照
+    test_load(rows, 1, "csv, 1 thread");
+    CHECK(unlink("data/borrows.snap") == 0);
+    test_load(rows, 4, "csv, 4 threads");
+    test_load(rows, 1, "snapshot");
+    
+    printf("test_borrow_load: ok\n");
+    return 0;
+}
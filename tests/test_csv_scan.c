@@ -0,0 +1,228 @@
+/**
+ * @file test_csv_scan.c
+ * @brief CSV分隔符扫描的差分测试
+ *
+ * 同一段内容分别用逐字节、SSE2和AVX2扫描解析，字段序列必须逐字节相同；
+ * 另有几条已知结果的用例检查引号转义、字段内换行和各种行尾。
+ * 随机内容的长度覆盖0到300字节，包括不是16或32整数倍的长度，
+ * 每段内容都放在恰好大小的堆内存中，结尾附近的处理一并覆盖。
+ * 每段内容还会用csv_split_chunks切成2到7段分别解析，拼接结果必须与整体解析相同。
+ */
+
+#include "test.h"
+#include "../csv.h"
+#include <string.h>
+
+#define TEST_MAX_FIELDS 64
+#define TEST_MAX_OUTPUT 4096
+#define TEST_RANDOM_CASES 200000
+#define TEST_MAX_LENGTH 300
+
+/**
+ * @brief 解析结果：每个字段写成"长度:内容"，每条记录以字段数结尾
+ */
+typedef struct {
+    char data[TEST_MAX_OUTPUT * 4];
+    size_t len;
+} TestOutput;
+
+/**
+ * @brief 已知结果的用例（内容为字符串字面量）
+ */
+#define TEST_KNOWN(input, expected) test_compare(input, sizeof(input) - 1, expected)
+
+static const char *const test_mode_names[] = {"auto", "scalar", "sse2", "avx2"};
+
+/**
+ * @brief 向解析结果追加内容
+ * @param out 解析结果
+ * @param data 内容
+ * @param len 长度
+ */
+static void test_output_append(TestOutput *out, const char *data, size_t len) {
+    CHECK(out->len + len <= sizeof(out->data));
+    memcpy(out->data + out->len, data, len);
+    out->len += len;
+}
+
+/**
+ * @brief 用指定扫描方式解析一段内容
+ * @param input 内容
+ * @param len 长度
+ * @param mode 扫描方式
+ * @param out 用于存储解析结果
+ * @return 成功返回0，当前CPU不支持该扫描方式返回非0值
+ */
+static int test_parse(const char *input, size_t len, CsvScanMode mode, TestOutput *out) {
+    // 解析会原地修改内容，复制到恰好大小的缓冲区中
+    char *buffer = (char *)malloc(len > 0 ? len : 1);
+    CHECK(buffer != NULL);
+    memcpy(buffer, input, len);
+    
+    CsvReader reader;
+    csv_reader_init(&reader, buffer, len);
+    if (csv_reader_set_scan_mode(&reader, mode) != 0) {
+        free(buffer);
+        return -1;
+    }
+    
+    CsvField fields[TEST_MAX_FIELDS];
+    int num_fields;
+    char header[32];
+    out->len = 0;
+    
+    while ((num_fields = csv_read_record(&reader, fields, TEST_MAX_FIELDS)) >= 0) {
+        int stored = num_fields < TEST_MAX_FIELDS ? num_fields : TEST_MAX_FIELDS;
+        for (int i = 0; i < stored; i++) {
+            int n = snprintf(header, sizeof(header), "%zu:", fields[i].len);
+            test_output_append(out, header, (size_t)n);
+            test_output_append(out, fields[i].data, fields[i].len);
+        }
+        int n = snprintf(header, sizeof(header), "|%d\n", num_fields);
+        test_output_append(out, header, (size_t)n);
+    }
+    
+    free(buffer);
+    return 0;
+}
+
+/**
+ * @brief 切分后逐段解析，拼接结果必须与整体解析相同
+ * @param input 内容
+ * @param len 长度
+ * @param reference 整体解析的结果
+ */
+static void test_split(const char *input, size_t len, const TestOutput *reference) {
+    static TestOutput joined;
+    static TestOutput part;
+    size_t offsets[8];
+    
+    for (int chunks = 2; chunks <= 7; chunks++) {
+        int count = csv_split_chunks(input, len, chunks, offsets);
+        CHECK(count >= 1 && count <= chunks && offsets[0] == 0 && offsets[count] == len);
+        
+        joined.len = 0;
+        for (int i = 0; i < count; i++) {
+            CHECK(offsets[i] < offsets[i + 1] || len == 0);
+            CHECK(test_parse(input + offsets[i], offsets[i + 1] - offsets[i], CSV_SCAN_SCALAR, &part) == 0);
+            test_output_append(&joined, part.data, part.len);
+        }
+        
+        if (joined.len != reference->len || memcmp(joined.data, reference->data, joined.len) != 0) {
+            fprintf(stderr, "split into %d chunks differs from whole parse on \"%.*s\"\n",
+                    chunks, (int)len, input);
+            CHECK(0);
+        }
+    }
+}
+
+/**
+ * @brief 用所有可用的扫描方式解析同一段内容并比较结果
+ * @param input 内容
+ * @param len 长度
+ * @param expected 期望的解析结果，为NULL时只比较各方式之间是否一致
+ */
+static void test_compare(const char *input, size_t len, const char *expected) {
+    static TestOutput reference;
+    static TestOutput output;
+    
+    CHECK(test_parse(input, len, CSV_SCAN_SCALAR, &reference) == 0);
+    if (expected != NULL && (reference.len != strlen(expected) ||
+                             memcmp(reference.data, expected, reference.len) != 0)) {
+        fprintf(stderr, "unexpected parse of \"%.*s\":\n%.*s", (int)len, input,
+                (int)reference.len, reference.data);
+        CHECK(0);
+    }
+    
+    test_split(input, len, &reference);
+    
+    for (int mode = CSV_SCAN_AUTO; mode <= CSV_SCAN_AVX2; mode++) {
+        if (mode == CSV_SCAN_SCALAR || test_parse(input, len, (CsvScanMode)mode, &output) != 0) {
+            continue;
+        }
+        if (output.len != reference.len || memcmp(output.data, reference.data, output.len) != 0) {
+            fprintf(stderr, "%s scanner differs from scalar on \"%.*s\"\n",
+                    test_mode_names[mode], (int)len, input);
+            CHECK(0);
+        }
+    }
+}
+
+/**
+ * @brief 已知结果的用例
+ */
+static void test_known_cases(void) {
+    TEST_KNOWN("", "");
+    TEST_KNOWN("a,b,c\n", "1:a1:b1:c|3\n");
+    TEST_KNOWN("a,b,c", "1:a1:b1:c|3\n");
+    TEST_KNOWN("a,,\r\n,x\r", "1:a0:0:|3\n0:1:x|2\n");
+    TEST_KNOWN("\"q,1\",\"say \"\"hi\"\"\"\n", "3:q,18:say \"hi\"|2\n");
+    TEST_KNOWN("\"line1\nline2\",z\nnext\n", "11:line1\nline21:z|2\n4:next|1\n");
+    TEST_KNOWN("ab\"c,d\n", "4:ab\"c1:d|2\n");
+    TEST_KNOWN("\"unterminated,x\n", "15:unterminated,x\n|1\n");
+    TEST_KNOWN("\"a\"b,c\n", "2:ab1:c|2\n");
+    
+    // 未加引号字段中的引号不开始带引号的字段，切分时也必须这样处理
+    TEST_KNOWN("a\"b\nc,\"d\ne\nf\"\ng\nh\n", "3:a\"b|1\n1:c5:d\ne\nf|2\n1:g|1\n1:h|1\n");
+    TEST_KNOWN("\"x\"y\"z\nw\n\"p\n\"\n", "4:xy\"z|1\n1:w|1\n2:p\n|1\n");
+    
+    // 超过一个向量宽度的字段，分隔符落在16、32字节边界的前后
+    char line[128];
+    for (int width = 1; width <= 70; width++) {
+        memset(line, 'x', (size_t)width);
+        line[width] = ',';
+        line[width + 1] = 'y';
+        line[width + 2] = '\n';
+        test_compare(line, (size_t)width + 3, NULL);
+        test_compare(line, (size_t)width + 1, NULL);
+    }
+}
+
+/**
+ * @brief 随机内容：逗号、引号、换行、回车、ASCII字母和多字节UTF-8字符混合
+ */
+static void test_random_cases(void) {
+    static const char *const pieces[] = {
+        ",", "\"", "\"\"", "\n", "\r", "\r\n", "a", "b", "xyzxyzxyzxyzxyzxyz", "数据", "é", " "
+    };
+    const int piece_count = (int)(sizeof(pieces) / sizeof(pieces[0]));
+    char input[TEST_MAX_LENGTH + 32];
+    unsigned int seed = 12345;
+    
+    for (int c = 0; c < TEST_RANDOM_CASES; c++) {
+        seed = seed * 1103515245u + 12345u;
+        size_t target = (seed >> 8) % (TEST_MAX_LENGTH + 1);
+        size_t len = 0;
+        
+        while (len < target) {
+            seed = seed * 1103515245u + 12345u;
+            // 字母和长片段占多数，分隔符和引号穿插其间
+            int pick = (int)((seed >> 8) % (unsigned int)(piece_count + 6));
+            const char *piece = pieces[pick < piece_count ? pick : 6 + pick % 3];
+            size_t n = strlen(piece);
+            if (len + n > target) {
+                break;
+            }
+            memcpy(input + len, piece, n);
+            len += n;
+        }
+        
+        test_compare(input, len, NULL);
+    }
+}
+
+int main(void) {
+    for (int mode = CSV_SCAN_SSE2; mode <= CSV_SCAN_AVX2; mode++) {
+        CsvReader reader;
+        csv_reader_init(&reader, NULL, 0);
+        if (csv_reader_set_scan_mode(&reader, (CsvScanMode)mode) != 0) {
+            printf("%s scanner not supported on this CPU, skipped\n", test_mode_names[mode]);
+        }
+    }
+    
+    test_known_cases();
+    test_random_cases();
+    
+    printf("test_csv_scan: ok\n");
+    return 0;
+}
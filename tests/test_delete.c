@@ -0,0 +1,153 @@
+/**
+ * @file test_delete.c
+ * @brief 大量删除时逐步整理的测试
+ *
+ * 删除的图书、读者超过总数的1/4后，每次删除都会把末尾的记录移到空位上。
+ * 移动后各个索引必须仍然指向正确的位置：按ID、标题、年份查找的结果与
+ * 剩下的记录一致，新增的记录能复用空位，重新加载后内容不变。
+ */
+
+#include "test.h"
+#include "../book.h"
+#include "../reader.h"
+#include <string.h>
+
+#define TEST_BOOKS 4000
+#define TEST_DELETED 3000
+
+static Book test_books[TEST_BOOKS + 500];
+static char test_live[TEST_BOOKS + 500];
+
+/**
+ * @brief 填充一本测试图书（标题中带有按编号区分的词，便于按标题查找）
+ * @param book 图书
+ * @param i 编号
+ */
+static void test_make_book(Book *book, int i) {
+    memset(book, 0, sizeof(Book));
+    snprintf(book->id, sizeof(book->id), "B%05d", i);
+    snprintf(book->title, sizeof(book->title), "标题 word%05dx", i);
+    snprintf(book->author, sizeof(book->author), "作者%d", i % 37);
+    snprintf(book->publisher, sizeof(book->publisher), "出版社%d", i % 11);
+    snprintf(book->isbn, sizeof(book->isbn), "978%05d", i);
+    book->publish_year = 1950 + i % 70;
+    book->total_count = 3;
+    book->available_count = i % 3;
+}
+
+/**
+ * @brief 逐本核对剩下的图书
+ * @param count 已使用的编号数
+ */
+static void test_check_books(int count) {
+    static Book found[TEST_BOOKS + 500];
+    int live = 0;
+    int in_range = 0;
+    
+    for (int i = 0; i < count; i++) {
+        Book book;
+        char word[16];
+        snprintf(word, sizeof(word), "word%05dx", i);
+        int hits = book_find_by_title(word, found, 2);
+        
+        if (!test_live[i]) {
+            CHECK(book_find_by_id(test_books[i].id, &book) != 0);
+            CHECK(hits == 0);
+            continue;
+        }
+        
+        live++;
+        in_range += test_books[i].publish_year >= 1980 && test_books[i].publish_year <= 1990;
+        CHECK(book_find_by_id(test_books[i].id, &book) == 0);
+        CHECK(strcmp(book.title, test_books[i].title) == 0 && book.available_count == test_books[i].available_count);
+        CHECK(hits == 1 && strcmp(found[0].id, test_books[i].id) == 0);
+    }
+    
+    CHECK(book_get_all(found, TEST_BOOKS + 500) == live);
+    CHECK(book_count_by_year_range(1980, 1990) == in_range);
+}
+
+/**
+ * @brief 图书：删除大部分后核对，再新增、重新加载后核对
+ */
+static void test_books_delete(void) {
+    CHECK(book_init() == 0);
+    for (int i = 0; i < TEST_BOOKS; i++) {
+        test_make_book(&test_books[i], i);
+        CHECK(book_add(&test_books[i]) == 0);
+        test_live[i] = 1;
+    }
+    
+    // 按分散的顺序删除，空位既有在中间的，也有在末尾的
+    for (int k = 0; k < TEST_DELETED; k++) {
+        int i = (int)((k * 2654435761u) % TEST_BOOKS);
+        while (!test_live[i]) {
+            i = (i + 1) % TEST_BOOKS;
+        }
+        CHECK(book_delete(test_books[i].id) == 0);
+        test_live[i] = 0;
+    }
+    test_check_books(TEST_BOOKS);
+    
+    for (int i = TEST_BOOKS; i < TEST_BOOKS + 500; i++) {
+        test_make_book(&test_books[i], i);
+        CHECK(book_add(&test_books[i]) == 0);
+        test_live[i] = 1;
+    }
+    test_check_books(TEST_BOOKS + 500);
+    
+    // 日志重放后内容相同
+    book_cleanup();
+    CHECK(book_init() == 0);
+    test_check_books(TEST_BOOKS + 500);
+    book_cleanup();
+}
+
+/**
+ * @brief 读者：删除大部分后按ID、姓名查找
+ */
+static void test_readers_delete(void) {
+    static Reader found[TEST_BOOKS];
+    Reader reader;
+    
+    CHECK(reader_init() == 0);
+    for (int i = 0; i < TEST_BOOKS; i++) {
+        memset(&reader, 0, sizeof(reader));
+        snprintf(reader.id, sizeof(reader.id), "R%05d", i);
+        snprintf(reader.name, sizeof(reader.name), "name%05dx", i);
+        reader.max_borrow_count = 5;
+        CHECK(reader_add(&reader) == 0);
+    }
+    
+    // 删除编号不是4的倍数的读者
+    for (int i = 0; i < TEST_BOOKS; i++) {
+        if (i % 4 != 0) {
+            snprintf(reader.id, sizeof(reader.id), "R%05d", i);
+            CHECK(reader_delete(reader.id) == 0);
+        }
+    }
+    
+    for (int i = 0; i < TEST_BOOKS; i++) {
+        char id[16];
+        char name[16];
+        snprintf(id, sizeof(id), "R%05d", i);
+        snprintf(name, sizeof(name), "name%05dx", i);
+        int hits = reader_find_by_name(name, found, 2);
+        if (i % 4 == 0) {
+            CHECK(reader_find_by_id(id, &reader) == 0 && strcmp(reader.name, name) == 0);
+            CHECK(hits == 1 && strcmp(found[0].id, id) == 0);
+        } else {
+            CHECK(reader_find_by_id(id, &reader) != 0 && hits == 0);
+        }
+    }
+    CHECK(reader_get_all(found, TEST_BOOKS) == TEST_BOOKS / 4);
+    reader_cleanup();
+}
+
+int main(void) {
+    test_books_delete();
+    test_readers_delete();
+    
+    printf("test_delete: ok\n");
+    return 0;
+}
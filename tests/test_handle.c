@@ -0,0 +1,131 @@
+/**
+ * @file test_handle.c
+ * @brief 图书、读者句柄过期检测的测试
+ *
+ * 句柄指向的图书或读者被删除、位置被复用、整理时被移动或数据重新加载后，
+ * 以句柄为参数的函数必须返回失败，而不是访问或修改占据该位置的其他记录。
+ */
+
+#include "test.h"
+#include "../book.h"
+#include "../reader.h"
+#include <string.h>
+
+/**
+ * @brief 填充一本测试图书
+ * @param book 图书
+ * @param id 图书ID
+ */
+static void test_make_book(Book *book, const char *id) {
+    memset(book, 0, sizeof(Book));
+    snprintf(book->id, sizeof(book->id), "%s", id);
+    snprintf(book->title, sizeof(book->title), "标题%s", id);
+    snprintf(book->author, sizeof(book->author), "作者");
+    snprintf(book->publisher, sizeof(book->publisher), "出版社");
+    snprintf(book->isbn, sizeof(book->isbn), "978%s", id);
+    book->publish_year = 2000;
+    book->total_count = 3;
+    book->available_count = 3;
+}
+
+/**
+ * @brief 添加一本测试图书
+ * @param id 图书ID
+ */
+static void test_add_book(const char *id) {
+    Book book;
+    test_make_book(&book, id);
+    CHECK(book_add(&book) == 0);
+}
+
+/**
+ * @brief 添加一名测试读者
+ * @param id 读者ID
+ */
+static void test_add_reader(const char *id) {
+    Reader reader;
+    memset(&reader, 0, sizeof(reader));
+    snprintf(reader.id, sizeof(reader.id), "%s", id);
+    snprintf(reader.name, sizeof(reader.name), "读者%s", id);
+    reader.max_borrow_count = 5;
+    CHECK(reader_add(&reader) == 0);
+}
+
+/**
+ * @brief 图书句柄：修改后仍有效，删除、复用位置、整理和重新加载后失效
+ */
+static void test_book_handles(void) {
+    Book book;
+    
+    CHECK(book_init() == 0);
+    test_add_book("B1");
+    test_add_book("B2");
+    test_add_book("B3");
+    BookHandle b1 = book_lookup("B1");
+    CHECK(b1 != -1 && book_get(b1, &book) == 0 && strcmp(book.id, "B1") == 0);
+    
+    // 修改不移动图书，句柄仍然有效
+    test_make_book(&book, "B1");
+    book.total_count = 7;
+    CHECK(book_update(&book) == 0);
+    CHECK(book_get(b1, &book) == 0 && book.total_count == 7);
+    
+    // 删除后失效；新图书复用这个位置后也不能通过旧句柄访问到它
+    CHECK(book_delete("B1") == 0);
+    CHECK(book_get(b1, &book) != 0);
+    test_add_book("B4");
+    BookHandle b4 = book_lookup("B4");
+    CHECK((b4 & 0xFFFFFFFF) == (b1 & 0xFFFFFFFF));
+    CHECK(book_get(b1, &book) != 0);
+    CHECK(book_available_count(b1) == -1);
+    CHECK(book_adjust_available(b1, -1) != 0);
+    CHECK(book_available_count(b4) == 3);
+    
+    // 保存前整理：B3、B5前移，旧句柄的位置上是别的图书或已超出范围
+    test_add_book("B5");
+    BookHandle b3 = book_lookup("B3");
+    BookHandle b5 = book_lookup("B5");
+    CHECK(book_delete("B2") == 0);
+    CHECK(book_save_data() == 0);
+    CHECK(book_get(b3, &book) != 0);
+    CHECK(book_get(b5, &book) != 0);
+    CHECK(book_get(book_lookup("B5"), &book) == 0 && strcmp(book.id, "B5") == 0);
+    
+    // 没有移动的图书句柄不受整理影响
+    CHECK(book_get(b4, &book) == 0 && strcmp(book.id, "B4") == 0);
+    
+    // 重新加载后全部失效
+    CHECK(book_load_data() == 0);
+    CHECK(book_get(b4, &book) != 0);
+    CHECK(book_get(book_lookup("B4"), &book) == 0);
+    book_cleanup();
+}
+
+/**
+ * @brief 读者句柄：删除并复用位置后失效，不会改动新读者的借阅数量
+ */
+static void test_reader_handles(void) {
+    Reader reader;
+    
+    CHECK(reader_init() == 0);
+    test_add_reader("R1");
+    ReaderHandle r1 = reader_lookup("R1");
+    CHECK(reader_borrow_quota(r1) == 5);
+    
+    CHECK(reader_delete("R1") == 0);
+    test_add_reader("R2");
+    CHECK(reader_get(r1, &reader) != 0);
+    CHECK(reader_borrow_quota(r1) == -1);
+    CHECK(reader_adjust_borrow_count(r1, 1) != 0);
+    CHECK(reader_find_by_id("R2", &reader) == 0 && reader.current_borrow_count == 0);
+    CHECK(reader_adjust_borrow_count(reader_lookup("R2"), 1) == 0);
+    reader_cleanup();
+}
+
+int main(void) {
+    test_book_handles();
+    test_reader_handles();
+    
+    printf("test_handle: ok\n");
+    return 0;
+}
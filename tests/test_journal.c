@@ -0,0 +1,115 @@
+/**
+ * @file test_journal.c
+ * @brief 变更日志的重放和损坏尾部处理测试
+ *
+ * 日志尾部写到一半（缺少换行或校验和不对）时，重放后应截掉这部分内容，
+ * 之后追加的日志从新的一行开始，重启后不会丢失。
+ */
+
+#include "test.h"
+#include "../book.h"
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_JOURNAL "data/books.journal"
+
+/**
+ * @brief 填充一本测试图书
+ * @param book 图书
+ * @param id 图书ID
+ * @param title 标题
+ */
+static void test_make_book(Book *book, const char *id, const char *title) {
+    memset(book, 0, sizeof(Book));
+    snprintf(book->id, sizeof(book->id), "%s", id);
+    snprintf(book->title, sizeof(book->title), "%s", title);
+    snprintf(book->author, sizeof(book->author), "作者");
+    snprintf(book->publisher, sizeof(book->publisher), "出版社");
+    snprintf(book->isbn, sizeof(book->isbn), "978%s", id);
+    book->publish_year = 2000;
+    book->total_count = 3;
+    book->available_count = 3;
+}
+
+/**
+ * @brief 取图书总数
+ * @return 图书数量
+ */
+static int test_book_count(void) {
+    Book books[16];
+    return book_get_all(books, 16);
+}
+
+/**
+ * @brief 重新加载图书数据（模拟重启）
+ */
+static void test_restart(void) {
+    book_cleanup();
+    CHECK(book_init() == 0);
+}
+
+/**
+ * @brief 向日志文件末尾直接写入内容（模拟写到一半时断电）
+ * @param text 内容
+ */
+static void test_append_raw(const char *text) {
+    FILE *file = fopen(TEST_JOURNAL, "a");
+    CHECK(file != NULL);
+    fputs(text, file);
+    CHECK(fclose(file) == 0);
+}
+
+/**
+ * @brief 去掉日志文件的最后一个字节（最后一条日志的换行）
+ */
+static void test_cut_last_byte(void) {
+    FILE *file = fopen(TEST_JOURNAL, "rb");
+    CHECK(file != NULL);
+    CHECK(fseek(file, 0, SEEK_END) == 0);
+    long size = ftell(file);
+    fclose(file);
+    CHECK(size > 0 && truncate(TEST_JOURNAL, size - 1) == 0);
+}
+
+int main(void) {
+    Book book;
+    
+    // 第一行就是残缺的日志：重放时丢弃，之后的新增从新的一行开始
+    test_append_raw("1,deadbeef,P,B0,x");
+    CHECK(book_init() == 0);
+    CHECK(test_book_count() == 0);
+    test_make_book(&book, "B1", "第一本");
+    CHECK(book_add(&book) == 0);
+    test_restart();
+    CHECK(test_book_count() == 1);
+    CHECK(book_find_by_id("B1", &book) == 0 && strcmp(book.title, "第一本") == 0);
+    
+    // 校验和正确但缺少换行的日志同样视为没写完
+    test_make_book(&book, "B2", "第二本");
+    CHECK(book_add(&book) == 0);
+    book_cleanup();
+    test_cut_last_byte();
+    CHECK(book_init() == 0);
+    CHECK(test_book_count() == 1 && book_find_by_id("B2", &book) != 0);
+    test_make_book(&book, "B3", "第三本");
+    CHECK(book_add(&book) == 0);
+    test_restart();
+    CHECK(test_book_count() == 2 && book_find_by_id("B3", &book) == 0);
+    
+    // 完整日志之后的垃圾内容被截掉，之前的变更保留
+    test_make_book(&book, "B3", "改过的第三本");
+    CHECK(book_update(&book) == 0);
+    book_cleanup();
+    test_append_raw("99,00000000,P,B9,garbage\n");
+    CHECK(book_init() == 0);
+    CHECK(book_find_by_id("B3", &book) == 0 && strcmp(book.title, "改过的第三本") == 0);
+    CHECK(book_find_by_id("B9", &book) != 0);
+    test_make_book(&book, "B4", "第四本");
+    CHECK(book_add(&book) == 0);
+    test_restart();
+    CHECK(test_book_count() == 3 && book_find_by_id("B4", &book) == 0);
+    
+    book_cleanup();
+    printf("test_journal: ok\n");
+    return 0;
+}
@@ -0,0 +1,204 @@
+/**
+ * @file test_long_text.c
+ * @brief 超出结构体字段长度的文本的查找测试
+ *
+ * CSV中的标题、作者、读者姓名等可以长于Book、Reader中的字段，模块内部按实际长度存放。
+ * 按标题、作者、姓名查找，按条件查询和容错查找都必须能查到只出现在长文本末尾的词，
+ * 命中的顺序仍按存储顺序。遍历时长记录之后的短记录取出的结构体与逐条获取的逐字节相同。
+ * 有长文本时照常写出快照，重新加载时直接使用快照，长文本完整保留。
+ */
+
+#include "test.h"
+#include "../book.h"
+#include "../reader.h"
+#include <string.h>
+#include <sys/stat.h>
+
+#define TEST_BOOKS_FILE "data/books.csv"
+#define TEST_READERS_FILE "data/readers.csv"
+#define TEST_BOOKS_SNAPSHOT "data/books.snap"
+#define TEST_READERS_SNAPSHOT "data/readers.snap"
+
+// 129字节的标题，只在末尾出现ZEBRAFISH
+#define TEST_LONG_TITLE "The Complete Illustrated Handbook of Freshwater Aquarium Species: " \
+                        "Their Care and Breeding and Feeding; Volume Two (98): ZEBRAFISH"
+// 超过50字节的作者，只在末尾出现Quetzal
+#define TEST_LONG_AUTHOR "Maximilian Alexander Theodore Wolfgang Friedrich von Quetzal"
+
+/**
+ * @brief 写出测试数据：第一本是长标题、长作者，第二本是短标题
+ */
+static void test_write_csv(void) {
+    FILE *file = fopen(TEST_BOOKS_FILE, "w");
+    CHECK(file != NULL);
+    fprintf(file, "id,title,author,publisher,isbn,publish_year,total_count,available_count\n");
+    fprintf(file, "B001,%s,%s,出版社,9780000000001,2001,3,3\n", TEST_LONG_TITLE, TEST_LONG_AUTHOR);
+    fprintf(file, "B002,Zebrafish Genetics,Quetzal,出版社,9780000000002,2002,3,3\n");
+    fprintf(file, "B003,Ordinary Title,Someone,出版社,9780000000003,2003,3,3\n");
+    CHECK(fclose(file) == 0);
+    
+    file = fopen(TEST_READERS_FILE, "w");
+    CHECK(file != NULL);
+    fprintf(file, "id,name,gender,phone,email,address,max_borrow_count,current_borrow_count\n");
+    fprintf(file, "R001,Chukwuemeka Oluwaseun Adebayo-Nwachukwu Okonkwo Jr,男,13800000000,"
+                  "chukwuemeka.oluwaseun.adebayo@long-domain-name.example.org,某市,5,0\n");
+    fprintf(file, "R002,Okonkwo,女,13800000001,okonkwo@example.org,某市,5,0\n");
+    CHECK(fclose(file) == 0);
+}
+
+typedef struct {
+    Book books[4];
+    int count;
+} TestCollected;
+
+/**
+ * @brief 遍历访问函数：把图书追加到数组中
+ * @param book 图书
+ * @param user_data 收集结果（TestCollected *）
+ * @return 返回0继续遍历
+ */
+static int test_collect_book(const Book *book, void *user_data) {
+    TestCollected *collected = (TestCollected *)user_data;
+    collected->books[collected->count++] = *book;
+    return 0;
+}
+
+/**
+ * @brief 检查快照文件存在，并且与上次记下的是同一个文件（没有被重新写出）
+ * @param path 快照文件路径
+ * @param saved 上次记下的文件状态，st_ino为0时只记下当前状态
+ */
+static void test_check_snapshot(const char *path, struct stat *saved) {
+    struct stat st;
+    CHECK(stat(path, &st) == 0);
+    if (saved->st_ino == 0) {
+        *saved = st;
+        return;
+    }
+    CHECK(st.st_ino == saved->st_ino && st.st_mtim.tv_sec == saved->st_mtim.tv_sec &&
+          st.st_mtim.tv_nsec == saved->st_mtim.tv_nsec);
+}
+
+/**
+ * @brief 检查两组图书的各个字段相同（字段中'\0'之后的字节不比较）
+ * @param books 图书
+ * @param expected 期望的图书
+ * @param count 数量
+ */
+static void test_check_books(const Book *books, const Book *expected, int count) {
+    for (int i = 0; i < count; i++) {
+        CHECK(strcmp(books[i].id, expected[i].id) == 0 && strcmp(books[i].title, expected[i].title) == 0);
+        CHECK(strcmp(books[i].author, expected[i].author) == 0 &&
+              strcmp(books[i].publisher, expected[i].publisher) == 0 && strcmp(books[i].isbn, expected[i].isbn) == 0);
+        CHECK(books[i].publish_year == expected[i].publish_year && books[i].total_count == expected[i].total_count &&
+              books[i].available_count == expected[i].available_count);
+    }
+}
+
+/**
+ * @brief 按“包含”条件查询，返回命中的图书ID
+ * @param field 字段
+ * @param text 查询串
+ * @param ids 用于存储命中的图书ID（以逗号分隔）
+ * @param size 缓冲区大小
+ */
+static void test_query_contains(BookField field, const char *text, char *ids, size_t size) {
+    BookPredicate predicate = {field, BOOK_OP_CONTAINS, text, 0, 0};
+    BookCursor *cursor = book_query_open(&predicate, 1);
+    CHECK(cursor != NULL);
+    
+    Book book;
+    ids[0] = '\0';
+    while (book_query_next(cursor, &book)) {
+        size_t len = strlen(ids);
+        snprintf(ids + len, size - len, "%s%s", len > 0 ? "," : "", book.id);
+    }
+    book_query_close(cursor);
+}
+
+int main(void) {
+    Book books[4];
+    Reader readers[4];
+    char ids[64];
+    
+    CHECK(strlen(TEST_LONG_TITLE) == 129 && strlen(TEST_LONG_AUTHOR) > 50);
+    test_write_csv();
+    CHECK(book_init() == 0);
+    CHECK(reader_init() == 0);
+    
+    // 标题：三元组索引给出候选，再在折叠文本上验证
+    CHECK(book_find_by_title("zebrafish", books, 4) == 2);
+    CHECK(strcmp(books[0].id, "B001") == 0 && strcmp(books[1].id, "B002") == 0);
+    
+    // 作者：扫描折叠列，长记录排在短记录之前也要按存储顺序返回
+    CHECK(book_find_by_author("quetzal", books, 4) == 2);
+    CHECK(strcmp(books[0].id, "B001") == 0 && strcmp(books[1].id, "B002") == 0);
+    
+    test_query_contains(BOOK_FIELD_TITLE, "ZebraFish", ids, sizeof(ids));
+    CHECK(strcmp(ids, "B001,B002") == 0);
+    test_query_contains(BOOK_FIELD_AUTHOR, "von quetzal", ids, sizeof(ids));
+    CHECK(strcmp(ids, "B001") == 0);
+    
+    // 容错查找：长标题末尾的词也在索引中
+    BookFuzzyMatch matches[4];
+    int found = book_find_fuzzy("zebrafsh", matches, 4);
+    CHECK(found == 2 && strcmp(matches[0].book.id, "B001") == 0);
+    
+    // 遍历时逐条补齐的结构体与逐条获取的相同（长记录在前，后面的短记录不能留有残余文本）
+    TestCollected collected = {0};
+    CHECK(book_foreach(NULL, 0, 0, test_collect_book, &collected) == 3);
+    CHECK(book_get_all(books, 4) == 3 && memcmp(collected.books, books, 3 * sizeof(Book)) == 0);
+    CHECK(book_foreach(NULL, 1, 1, test_collect_book, &collected) == 1);
+    CHECK(memcmp(&collected.books[3], &books[1], sizeof(Book)) == 0);
+    
+    // 改成短标题后不再命中
+    CHECK(book_find_by_id("B001", &books[0]) == 0);
+    strcpy(books[0].title, "Short");
+    CHECK(book_update(&books[0]) == 0);
+    CHECK(book_find_by_title("zebrafish", books, 4) == 1 && strcmp(books[0].id, "B002") == 0);
+    test_query_contains(BOOK_FIELD_TITLE, "zebrafish", ids, sizeof(ids));
+    CHECK(strcmp(ids, "B002") == 0);
+    
+    // 读者姓名、电子邮箱
+    CHECK(reader_find_by_name("okonkwo jr", readers, 4) == 1 && strcmp(readers[0].id, "R001") == 0);
+    CHECK(reader_find_by_name("OKONKWO", readers, 4) == 2);
+    CHECK(strcmp(readers[0].id, "R001") == 0 && strcmp(readers[1].id, "R002") == 0);
+    CHECK(reader_find_by_email("example.org", readers, 4) == 2);
+    
+    // 从CSV加载时写出了快照（长文本不再导致快照被删除），重新加载时直接使用，不再重写
+    Book saved[4];
+    struct stat book_snapshot = {0};
+    struct stat reader_snapshot = {0};
+    test_check_snapshot(TEST_BOOKS_SNAPSHOT, &book_snapshot);
+    test_check_snapshot(TEST_READERS_SNAPSHOT, &reader_snapshot);
+    CHECK(book_get_all(saved, 4) == 3);
+    reader_cleanup();
+    book_cleanup();
+    
+    CHECK(book_init() == 0);
+    CHECK(reader_init() == 0);
+    test_check_snapshot(TEST_BOOKS_SNAPSHOT, &book_snapshot);
+    test_check_snapshot(TEST_READERS_SNAPSHOT, &reader_snapshot);
+    CHECK(book_get_all(books, 4) == 3);
+    test_check_books(books, saved, 3);
+    CHECK(book_find_by_title("zebrafish", books, 4) == 1 && strcmp(books[0].id, "B002") == 0);
+    CHECK(reader_find_by_name("okonkwo jr", readers, 4) == 1 && strcmp(readers[0].id, "R001") == 0);
+    
+    // 保存后快照中是完整的长文本，再次加载仍能查到
+    CHECK(book_save_data() == 0);
+    CHECK(reader_save_data() == 0);
+    reader_cleanup();
+    book_cleanup();
+    
+    CHECK(book_init() == 0);
+    CHECK(reader_init() == 0);
+    CHECK(book_get_all(books, 4) == 3);
+    test_check_books(books, saved, 3);
+    CHECK(reader_find_by_name("okonkwo jr", readers, 4) == 1 && strcmp(readers[0].id, "R001") == 0);
+    
+    reader_cleanup();
+    book_cleanup();
+    
+    printf("test_long_text: ok\n");
+    return 0;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file test_snapshot.c
+ * @brief 二进制快照有效性和启动时日志处理的测试
+ *
+ * 快照写出后，在同一秒内把CSV改成长度相同的新内容，再次加载必须读到新内容；
+ * 启动时重放了日志但未达到合并条件时，CSV文件保持不变，日志保留到下次启动仍能重放。
+ */
+
+#include "test.h"
+#include "../reader.h"
+#include <string.h>
+#include <sys/stat.h>
+
+#define TEST_READERS_FILE "data/readers.csv"
+
+/**
+ * @brief 写出只有一名读者的数据文件
+ * @param name 读者姓名
+ */
+static void test_write_csv(const char *name) {
+    FILE *file = fopen(TEST_READERS_FILE, "w");
+    CHECK(file != NULL);
+    fprintf(file, "id,name,gender,phone,email,address,max_borrow_count,current_borrow_count\n");
+    fprintf(file, "R001,%s,女,13800000000,a@example.com,某市某区,5,0\n", name);
+    CHECK(fclose(file) == 0);
+}
+
+/**
+ * @brief 取文件的大小和修改时间
+ * @param path 文件路径
+ * @param st 用于存储结果
+ */
+static void test_stat(const char *path, struct stat *st) {
+    CHECK(stat(path, st) == 0);
+}
+
+int main(void) {
+    Reader reader;
+    
+    // 第一次加载解析CSV并写出快照
+    test_write_csv("Alice");
+    CHECK(reader_init() == 0);
+    CHECK(reader_find_by_id("R001", &reader) == 0 && strcmp(reader.name, "Alice") == 0);
+    reader_cleanup();
+    
+    // 紧接着（通常在同一秒内）改为长度相同的内容，快照必须失效
+    test_write_csv("Alicf");
+    CHECK(reader_init() == 0);
+    CHECK(reader_find_by_id("R001", &reader) == 0 && strcmp(reader.name, "Alicf") == 0);
+    
+    // 加一名读者：只写日志
+    memset(&reader, 0, sizeof(reader));
+    strcpy(reader.id, "R002");
+    strcpy(reader.name, "Bob");
+    strcpy(reader.gender, "男");
+    reader.max_borrow_count = 5;
+    CHECK(reader_add(&reader) == 0);
+    reader_cleanup();
+    
+    // 重新启动：日志只有一条，不触发合并，CSV不被重写
+    struct stat before;
+    struct stat after;
+    test_stat(TEST_READERS_FILE, &before);
+    CHECK(reader_init() == 0);
+    test_stat(TEST_READERS_FILE, &after);
+    CHECK(before.st_size == after.st_size && before.st_ino == after.st_ino &&
+          before.st_mtim.tv_sec == after.st_mtim.tv_sec && before.st_mtim.tv_nsec == after.st_mtim.tv_nsec);
+    CHECK(reader_find_by_id("R002", &reader) == 0 && strcmp(reader.name, "Bob") == 0);
+    reader_cleanup();
+    
+    // 再次启动：快照仍然有效，日志再次重放
+    CHECK(reader_init() == 0);
+    CHECK(reader_find_by_id("R001", &reader) == 0 && strcmp(reader.name, "Alicf") == 0);
+    CHECK(reader_find_by_id("R002", &reader) == 0 && strcmp(reader.name, "Bob") == 0);
+    
+    // 保存后日志清空，数据都在CSV中
+    CHECK(reader_save_data() == 0);
+    reader_cleanup();
+    CHECK(reader_init() == 0);
+    CHECK(reader_find_by_id("R002", &reader) == 0);
+    reader_cleanup();
+    
+    printf("test_snapshot: ok\n");
+    return 0;
+}
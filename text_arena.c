@@ -0,0 +1,290 @@
+/**
+ * @file text_arena.c
+ * @brief 文本区相关函数的实现
+ */
+
+#include "text_arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TEXT_ARENA_MIN_CAPACITY 4096 // 最小容量
+#define TEXT_ARENA_COMPACT_MIN_GARBAGE (1 << 20) // 触发整理的最少废弃字节数
+
+/**
+ * @brief 取以'\0'结尾的字符串对应的文本
+ * @param text 字符串
+ * @return 文本
+ */
+TextSpan text_span(const char *text) {
+    TextSpan span;
+    span.data = text;
+    span.length = text != NULL ? strlen(text) : 0;
+    return span;
+}
+
+/**
+ * @brief 把文本复制到定长缓冲区，超长时在完整的UTF-8字符处截断，余下部分补'\0'
+ * @param buffer 缓冲区
+ * @param size 缓冲区大小
+ * @param text 文本
+ * @param length 文本的字节数
+ * @return 未截断返回0，截断返回1
+ */
+int text_copy(char *buffer, size_t size, const char *text, size_t length) {
+    return text_copy_over(buffer, size, text, length, NULL);
+}
+
+/**
+ * @brief 把文本复制到反复使用的定长缓冲区，结果与text_copy相同，但只清零上一次多写的部分
+ * @param buffer 缓冲区（第一次使用前需全部清零）
+ * @param size 缓冲区大小
+ * @param text 文本
+ * @param length 文本的字节数
+ * @param used 上一次写入的字节数，返回时更新为本次写入的字节数，为NULL时补齐整个缓冲区
+ * @return 未截断返回0，截断返回1
+ */
+int text_copy_over(char *buffer, size_t size, const char *text, size_t length, size_t *used) {
+    if (buffer == NULL || size == 0) {
+        return length > 0;
+    }
+    
+    int truncated = 0;
+    if (length > size - 1) {
+        length = size - 1;
+        // 退回到下一个字符的首字节之前，不把多字节字符切成两半
+        while (length > 0 && ((unsigned char)text[length] & 0xC0) == 0x80) {
+            length--;
+        }
+        truncated = 1;
+    }
+    
+    // 与strncpy一样补齐，同一条记录每次取出的结构体逐字节相同；
+    // 上一次写入的部分之后本来就是'\0'，只需清零到那里为止
+    size_t dirty = used != NULL && *used < size ? *used + 1 : size;
+    memcpy(buffer, text, length);
+    memset(buffer + length, 0, dirty > length ? dirty - length : 1);
+    if (used != NULL) {
+        *used = length;
+    }
+    return truncated;
+}
+
+/**
+ * @brief 初始化文本区
+ * @param arena 文本区
+ * @param capacity 初始容量（字节数，不够时自动扩容）
+ * @return 成功返回0，失败返回非0值
+ */
+int text_arena_init(TextArena *arena, size_t capacity) {
+    if (arena == NULL) {
+        return -1;
+    }
+    
+    if (capacity < TEXT_ARENA_MIN_CAPACITY) {
+        capacity = TEXT_ARENA_MIN_CAPACITY;
+    }
+    
+    arena->data = (char *)malloc(capacity);
+    if (arena->data == NULL) {
+        arena->used = 0;
+        arena->capacity = 0;
+        arena->garbage = 0;
+        return -1;
+    }
+    
+    // 第0个字节是所有空文本共用的'\0'
+    arena->data[0] = '\0';
+    arena->used = 1;
+    arena->capacity = capacity;
+    arena->garbage = 0;
+    return 0;
+}
+
+/**
+ * @brief 释放文本区
+ * @param arena 文本区
+ */
+void text_arena_free(TextArena *arena) {
+    if (arena == NULL) {
+        return;
+    }
+    
+    free(arena->data);
+    arena->data = NULL;
+    arena->used = 0;
+    arena->capacity = 0;
+    arena->garbage = 0;
+}
+
+/**
+ * @brief 清空文本区（保留内存）
+ * @param arena 文本区
+ */
+void text_arena_clear(TextArena *arena) {
+    if (arena == NULL || arena->data == NULL) {
+        return;
+    }
+    
+    arena->used = 1;
+    arena->garbage = 0;
+}
+
+/**
+ * @brief 用一份完整的文本区内容（例如快照中保存的）替换文本区的内容，废弃字节数清零
+ * @param arena 文本区（已初始化）
+ * @param data 文本区的内容（从第0个字节起，即原文本区data的前used个字节）
+ * @param size 字节数
+ * @return 成功返回0，内容格式不对或内存不足返回非0值
+ */
+int text_arena_load(TextArena *arena, const char *data, size_t size) {
+    // 第0个字节是共用的空文本，每段文本都以'\0'结尾，偏移不超过32位
+    if (arena == NULL || arena->data == NULL || size == 0 || size > UINT32_MAX ||
+        data[0] != '\0' || data[size - 1] != '\0') {
+        return -1;
+    }
+    
+    if (size > arena->capacity) {
+        char *grown = (char *)realloc(arena->data, size);
+        if (grown == NULL) {
+            return -1;
+        }
+        arena->data = grown;
+        arena->capacity = size;
+    }
+    
+    memcpy(arena->data, data, size);
+    arena->used = size;
+    arena->garbage = 0;
+    return 0;
+}
+
+/**
+ * @brief 把文本追加到文本区（空文本不占空间）
+ * @param arena 文本区
+ * @param text 文本
+ * @param ref 用于存储文本的位置
+ * @return 成功返回0，内存不足或超出32位偏移时返回非0值
+ */
+int text_arena_append(TextArena *arena, TextSpan text, TextRef *ref) {
+    if (arena == NULL || arena->data == NULL || ref == NULL) {
+        return -1;
+    }
+    
+    if (text.length == 0) {
+        ref->offset = 0;
+        ref->length = 0;
+        return 0;
+    }
+    
+    // 偏移和长度都用32位存储
+    if (text.length > UINT32_MAX - 1 || arena->used > (size_t)UINT32_MAX - 1 - text.length) {
+        return -1;
+    }
+    
+    size_t need = arena->used + text.length + 1;
+    if (need > arena->capacity) {
+        size_t capacity = arena->capacity * 2;
+        if (capacity < need) {
+            capacity = need;
+        }
+        char *grown = (char *)realloc(arena->data, capacity);
+        if (grown == NULL) {
+            return -1;
+        }
+        arena->data = grown;
+        arena->capacity = capacity;
+    }
+    
+    memcpy(arena->data + arena->used, text.data, text.length);
+    arena->data[arena->used + text.length] = '\0';
+    ref->offset = (uint32_t)arena->used;
+    ref->length = (uint32_t)text.length;
+    arena->used = need;
+    return 0;
+}
+
+/**
+ * @brief 废弃一段文本（位于末尾时直接收回，否则计入废弃字节数）
+ * @param arena 文本区
+ * @param ref 文本的位置
+ */
+void text_arena_release(TextArena *arena, TextRef ref) {
+    if (arena == NULL || ref.length == 0) {
+        return;
+    }
+    
+    if ((size_t)ref.offset + ref.length + 1 == arena->used) {
+        arena->used = ref.offset;
+    } else {
+        arena->garbage += (size_t)ref.length + 1;
+    }
+}
+
+/**
+ * @brief 取文本
+ * @param arena 文本区
+ * @param ref 文本的位置
+ * @return 以'\0'结尾的字符串（在下一次追加之前有效）
+ */
+const char *text_arena_get(const TextArena *arena, TextRef ref) {
+    return arena->data + ref.offset;
+}
+
+/**
+ * @brief 判断文本区中的文本是否与给定文本相同
+ * @param arena 文本区
+ * @param ref 文本的位置
+ * @param text 文本
+ * @return 相同返回1，否则返回0
+ */
+int text_arena_equals(const TextArena *arena, TextRef ref, TextSpan text) {
+    return ref.length == text.length && memcmp(arena->data + ref.offset, text.data, text.length) == 0;
+}
+
+/**
+ * @brief 把文本区中的文本复制到定长缓冲区，超长时在完整的UTF-8字符处截断，余下部分补'\0'
+ * @param arena 文本区
+ * @param ref 文本的位置
+ * @param buffer 缓冲区
+ * @param size 缓冲区大小
+ * @return 未截断返回0，截断返回1
+ */
+int text_arena_copy(const TextArena *arena, TextRef ref, char *buffer, size_t size) {
+    return text_copy(buffer, size, arena->data + ref.offset, ref.length);
+}
+
+/**
+ * @brief 把文本区中的文本复制到反复使用的定长缓冲区（见text_copy_over）
+ * @param arena 文本区
+ * @param ref 文本的位置
+ * @param buffer 缓冲区
+ * @param size 缓冲区大小
+ * @param used 上一次写入的字节数，返回时更新为本次写入的字节数，为NULL时补齐整个缓冲区
+ * @return 未截断返回0，截断返回1
+ */
+int text_arena_copy_over(const TextArena *arena, TextRef ref, char *buffer, size_t size, size_t *used) {
+    return text_copy_over(buffer, size, arena->data + ref.offset, ref.length, used);
+}
+
+/**
+ * @brief 判断废弃的文本是否多到值得整理（至少1MB且超过已使用字节数的一半）
+ * @param arena 文本区
+ * @return 需要整理返回1，否则返回0
+ */
+int text_arena_needs_compaction(const TextArena *arena) {
+    return arena->garbage >= TEXT_ARENA_COMPACT_MIN_GARBAGE && arena->garbage > arena->used / 2;
+}
+
+/**
+ * @brief 把文本从一个文本区搬到另一个文本区（整理时逐段调用），并更新文本的位置
+ * @param dest 目标文本区
+ * @param src 原文本区
+ * @param ref 文本的位置
+ * @return 成功返回0，内存不足返回非0值
+ */
+int text_arena_move(TextArena *dest, const TextArena *src, TextRef *ref) {
+    TextSpan text;
+    text.data = src->data + ref->offset;
+    text.length = ref->length;
+    return text_arena_append(dest, text, ref);
+}
\ No newline at end of file
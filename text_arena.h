@@ -0,0 +1,179 @@
+/**
+ * @file text_arena.h
+ * @brief 文本区相关函数和数据结构的声明
+ *
+ * 文本区把一个模块的所有变长文本首尾相接地存放在一块连续内存中，
+ * 记录里只存偏移和长度，不再为每个字段预留定长数组，也不截断超长文本。
+ * 每段文本后面跟一个'\0'，取出的指针可以直接当作C字符串使用。
+ * 修改或删除记录时旧文本只计入废弃字节数，废弃过多时由调用方把仍在使用的文本
+ * 搬到新的文本区；模块清理时整块释放。
+ */
+
+#ifndef TEXT_ARENA_H
+#define TEXT_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 文本在文本区中的位置
+ */
+typedef struct {
+    uint32_t offset;   /**< 起始偏移 */
+    uint32_t length;   /**< 字节数（不含结尾'\0'） */
+} TextRef;
+
+/**
+ * @brief 一段待存入文本区的文本（不要求以'\0'结尾）
+ */
+typedef struct {
+    const char *data;   /**< 文本 */
+    size_t length;      /**< 字节数 */
+} TextSpan;
+
+/**
+ * @brief 文本区
+ */
+typedef struct {
+    char *data;         /**< 连续存放的文本 */
+    size_t used;        /**< 已使用的字节数 */
+    size_t capacity;    /**< 容量 */
+    size_t garbage;     /**< 已废弃文本占用的字节数 */
+} TextArena;
+
+/**
+ * @brief 取以'\0'结尾的字符串对应的文本
+ * @param text 字符串
+ * @return 文本
+ */
+TextSpan text_span(const char *text);
+
+/**
+ * @brief 把文本复制到定长缓冲区，超长时在完整的UTF-8字符处截断，余下部分补'\0'
+ * @param buffer 缓冲区
+ * @param size 缓冲区大小
+ * @param text 文本
+ * @param length 文本的字节数
+ * @return 未截断返回0，截断返回1
+ */
+int text_copy(char *buffer, size_t size, const char *text, size_t length);
+
+/**
+ * @brief 把文本复制到反复使用的定长缓冲区，结果与text_copy相同，但只清零上一次多写的部分
+ *
+ * 遍历时每条记录都取出到同一个结构体，缓冲区中上一条文本之后的部分已经是'\0'，
+ * 不必每次把剩余部分全部清零。
+ *
+ * @param buffer 缓冲区（第一次使用前需全部清零）
+ * @param size 缓冲区大小
+ * @param text 文本
+ * @param length 文本的字节数
+ * @param used 上一次写入的字节数，返回时更新为本次写入的字节数（第一次使用前为0）；
+ *             为NULL时与text_copy相同，补齐整个缓冲区
+ * @return 未截断返回0，截断返回1
+ */
+int text_copy_over(char *buffer, size_t size, const char *text, size_t length, size_t *used);
+
+/**
+ * @brief 初始化文本区
+ * @param arena 文本区
+ * @param capacity 初始容量（字节数，不够时自动扩容）
+ * @return 成功返回0，失败返回非0值
+ */
+int text_arena_init(TextArena *arena, size_t capacity);
+
+/**
+ * @brief 释放文本区
+ * @param arena 文本区
+ */
+void text_arena_free(TextArena *arena);
+
+/**
+ * @brief 清空文本区（保留内存）
+ * @param arena 文本区
+ */
+void text_arena_clear(TextArena *arena);
+
+/**
+ * @brief 用一份完整的文本区内容（例如快照中保存的）替换文本区的内容，废弃字节数清零
+ * @param arena 文本区（已初始化）
+ * @param data 文本区的内容（从第0个字节起，即原文本区data的前used个字节）
+ * @param size 字节数
+ * @return 成功返回0，内容格式不对或内存不足返回非0值
+ */
+int text_arena_load(TextArena *arena, const char *data, size_t size);
+
+/**
+ * @brief 把文本追加到文本区（空文本不占空间）
+ *
+ * 扩容时整块内存可能移动，之前用text_arena_get取得的指针随之失效。
+ *
+ * @param arena 文本区
+ * @param text 文本
+ * @param ref 用于存储文本的位置
+ * @return 成功返回0，内存不足或超出32位偏移时返回非0值
+ */
+int text_arena_append(TextArena *arena, TextSpan text, TextRef *ref);
+
+/**
+ * @brief 废弃一段文本（位于末尾时直接收回，否则计入废弃字节数）
+ * @param arena 文本区
+ * @param ref 文本的位置
+ */
+void text_arena_release(TextArena *arena, TextRef ref);
+
+/**
+ * @brief 取文本
+ * @param arena 文本区
+ * @param ref 文本的位置
+ * @return 以'\0'结尾的字符串（在下一次追加之前有效）
+ */
+const char *text_arena_get(const TextArena *arena, TextRef ref);
+
+/**
+ * @brief 判断文本区中的文本是否与给定文本相同
+ * @param arena 文本区
+ * @param ref 文本的位置
+ * @param text 文本
+ * @return 相同返回1，否则返回0
+ */
+int text_arena_equals(const TextArena *arena, TextRef ref, TextSpan text);
+
+/**
+ * @brief 把文本区中的文本复制到定长缓冲区，超长时在完整的UTF-8字符处截断，余下部分补'\0'
+ * @param arena 文本区
+ * @param ref 文本的位置
+ * @param buffer 缓冲区
+ * @param size 缓冲区大小
+ * @return 未截断返回0，截断返回1
+ */
+int text_arena_copy(const TextArena *arena, TextRef ref, char *buffer, size_t size);
+
+/**
+ * @brief 把文本区中的文本复制到反复使用的定长缓冲区（见text_copy_over）
+ * @param arena 文本区
+ * @param ref 文本的位置
+ * @param buffer 缓冲区
+ * @param size 缓冲区大小
+ * @param used 上一次写入的字节数，返回时更新为本次写入的字节数，为NULL时补齐整个缓冲区
+ * @return 未截断返回0，截断返回1
+ */
+int text_arena_copy_over(const TextArena *arena, TextRef ref, char *buffer, size_t size, size_t *used);
+
+/**
+ * @brief 判断废弃的文本是否多到值得整理（至少1MB且超过已使用字节数的一半）
+ * @param arena 文本区
+ * @return 需要整理返回1，否则返回0
+ */
+int text_arena_needs_compaction(const TextArena *arena);
+
+/**
+ * @brief 把文本从一个文本区搬到另一个文本区（整理时逐段调用），并更新文本的位置
+ * @param dest 目标文本区
+ * @param src 原文本区
+ * @param ref 文本的位置
+ * @return 成功返回0，内存不足返回非0值
+ */
+int text_arena_move(TextArena *dest, const TextArena *src, TextRef *ref);
+
+#endif /* TEXT_ARENA_H */
\ No newline at end of file
@@ -0,0 +1,761 @@
+/**
+ * @file text_index.c
+ * @brief 全文检索索引相关函数的实现
+ */
+
+#include "text_index.h"
+#include "utf8.h"
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 词的最大码点数，更长的部分在切分时丢弃
+#define TEXT_MAX_TERM 32
+
+// 查询中参与评分的最大词数
+#define TEXT_MAX_QUERY_TERMS 32
+
+// 词表哈希的初始槽数
+#define TEXT_INITIAL_SLOTS 1024
+
+// BM25参数：词频饱和度和文档长度归一化程度
+#define TEXT_BM25_K1 1.2
+#define TEXT_BM25_B 0.75
+
+/**
+ * @brief 切分出一个词时调用的回调函数
+ * @param chars 词的码点
+ * @param length 码点数
+ * @param context 用户数据
+ * @return 成功返回0，失败返回非0值（停止切分）
+ */
+typedef int (*TextTokenFunc)(const uint32_t *chars, int length, void *context);
+
+/**
+ * @brief 文档中的一个词
+ */
+typedef struct {
+    int term;   /**< 词编号 */
+    int freq;   /**< 加权词频 */
+} TextDocTerm;
+
+/**
+ * @brief 切分文档时的状态
+ */
+typedef struct {
+    TextIndex *index;      /**< 全文检索索引 */
+    int create;            /**< 词不存在时是否加入词表 */
+    int weight;            /**< 当前字段的权重 */
+    TextDocTerm *items;    /**< 文档中出现的词 */
+    int count;             /**< 词数量 */
+    int capacity;          /**< 词数组容量 */
+    int length;            /**< 加权长度 */
+} TextDocument;
+
+/**
+ * @brief 查询时每个词的倒排表游标
+ */
+typedef struct {
+    const TextTerm *term;   /**< 词 */
+    int position;           /**< 当前倒排项位置 */
+    int doc;                /**< 当前文档编号，倒排表结束时为INT_MAX */
+    int order;              /**< 查询词在查询串中的次序 */
+    double idf;             /**< 逆文档频率 */
+    double bound;           /**< 该词对任意文档评分的上界 */
+} TextCursor;
+
+/**
+ * @brief 切分文本，西文按词，中日韩文字按相邻两字
+ * @param text 文本
+ * @param func 每切出一个词调用一次
+ * @param context 回调函数的用户数据
+ * @return 成功返回0，回调函数失败时返回非0值
+ */
+static int text_tokenize(const char *text, TextTokenFunc func, void *context) {
+    uint32_t word[TEXT_MAX_TERM];
+    int word_length = 0;
+    uint32_t pair[2];
+    int cjk_run = 0;
+    const char *p = text;
+    
+    for (;;) {
+        uint32_t c = *p != '\0' ? utf8_fold(utf8_next_char(&p)) : 0;
+        int cjk = c != 0 && utf8_is_cjk(c);
+        int word_char = c != 0 && !cjk && utf8_is_word_char(c);
+        
+        // 西文词结束
+        if (!word_char && word_length > 0) {
+            if (func(word, word_length, context) != 0) {
+                return -1;
+            }
+            word_length = 0;
+        }
+        
+        // 中日韩文字段结束，只有一个字时单独成词
+        if (!cjk) {
+            if (cjk_run == 1 && func(pair, 1, context) != 0) {
+                return -1;
+            }
+            cjk_run = 0;
+        }
+        
+        if (c == 0) {
+            return 0;
+        }
+        
+        if (cjk) {
+            if (cjk_run > 0) {
+                pair[1] = c;
+                if (func(pair, 2, context) != 0) {
+                    return -1;
+                }
+            }
+            pair[0] = c;
+            cjk_run++;
+        } else if (word_char && word_length < TEXT_MAX_TERM) {
+            word[word_length++] = c;
+        }
+    }
+}
+
+/**
+ * @brief 计算词的哈希值（FNV-1a）
+ * @param chars 码点
+ * @param length 码点数
+ * @return 哈希值
+ */
+static unsigned int text_hash(const uint32_t *chars, int length) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ chars[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief 在词表中查找词
+ * @param index 全文检索索引
+ * @param chars 码点
+ * @param length 码点数
+ * @param slot 用于返回词所在的槽或可插入的空槽，可为NULL
+ * @return 找到返回词编号，否则返回-1
+ */
+static int text_index_lookup(const TextIndex *index, const uint32_t *chars, int length, unsigned int *slot) {
+    unsigned int i = text_hash(chars, length) & index->mask;
+    
+    while (index->slots[i] >= 0) {
+        const TextTerm *term = &index->terms[index->slots[i]];
+        if (term->length == length && memcmp(term->chars, chars, sizeof(uint32_t) * length) == 0) {
+            break;
+        }
+        i = (i + 1) & index->mask;
+    }
+    
+    if (slot != NULL) {
+        *slot = i;
+    }
+    return index->slots[i];
+}
+
+/**
+ * @brief 词表哈希扩容
+ * @param index 全文检索索引
+ * @return 成功返回0，失败返回非0值
+ */
+static int text_index_grow_slots(TextIndex *index) {
+    unsigned int size = (index->mask + 1) * 2;
+    int *slots = (int *)malloc(sizeof(int) * size);
+    if (slots == NULL) {
+        return -1;
+    }
+    
+    memset(slots, -1, sizeof(int) * size);
+    for (int t = 0; t < index->term_count; t++) {
+        const TextTerm *term = &index->terms[t];
+        unsigned int i = text_hash(term->chars, term->length) & (size - 1);
+        while (slots[i] >= 0) {
+            i = (i + 1) & (size - 1);
+        }
+        slots[i] = t;
+    }
+    
+    free(index->slots);
+    index->slots = slots;
+    index->mask = size - 1;
+    return 0;
+}
+
+/**
+ * @brief 查找词，不存在时加入词表
+ * @param index 全文检索索引
+ * @param chars 码点
+ * @param length 码点数
+ * @return 返回词编号，失败返回-1
+ */
+static int text_index_intern(TextIndex *index, const uint32_t *chars, int length) {
+    unsigned int slot;
+    int id = text_index_lookup(index, chars, length, &slot);
+    if (id >= 0) {
+        return id;
+    }
+    
+    // 装载因子保持在1/2以下
+    if ((unsigned int)(index->term_count + 1) * 2 > index->mask + 1) {
+        if (text_index_grow_slots(index) != 0) {
+            return -1;
+        }
+        text_index_lookup(index, chars, length, &slot);
+    }
+    
+    if (index->term_count >= index->term_capacity) {
+        int capacity = index->term_capacity > 0 ? index->term_capacity * 2 : 256;
+        TextTerm *grown = (TextTerm *)realloc(index->terms, sizeof(TextTerm) * capacity);
+        if (grown == NULL) {
+            return -1;
+        }
+        index->terms = grown;
+        index->term_capacity = capacity;
+    }
+    
+    uint32_t *copy = (uint32_t *)malloc(sizeof(uint32_t) * length);
+    if (copy == NULL) {
+        return -1;
+    }
+    memcpy(copy, chars, sizeof(uint32_t) * length);
+    
+    id = index->term_count++;
+    TextTerm *term = &index->terms[id];
+    term->chars = copy;
+    term->length = length;
+    term->docs = NULL;
+    term->freqs = NULL;
+    term->count = 0;
+    term->capacity = 0;
+    term->max_freq = 0;
+    index->slots[slot] = id;
+    return id;
+}
+
+/**
+ * @brief 查找第一个不小于doc的位置
+ * @param docs 升序排列的文档编号
+ * @param low 查找范围起点
+ * @param high 查找范围终点（不含）
+ * @param doc 文档编号
+ * @return 位置
+ */
+static int text_lower_bound(const int *docs, int low, int high, int doc) {
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (docs[mid] < doc) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    return low;
+}
+
+/**
+ * @brief 将文档加入词的倒排表
+ * @param term 词
+ * @param doc 文档编号
+ * @param freq 加权词频
+ * @return 成功返回0，失败返回非0值
+ */
+static int text_term_add_doc(TextTerm *term, int doc, int freq) {
+    if (term->count >= term->capacity) {
+        int capacity = term->capacity > 0 ? term->capacity * 2 : 4;
+        int *docs = (int *)realloc(term->docs, sizeof(int) * capacity);
+        if (docs == NULL) {
+            return -1;
+        }
+        term->docs = docs;
+        
+        unsigned short *freqs = (unsigned short *)realloc(term->freqs, sizeof(unsigned short) * capacity);
+        if (freqs == NULL) {
+            return -1;
+        }
+        term->freqs = freqs;
+        term->capacity = capacity;
+    }
+    
+    // 按编号顺序加入时直接追加
+    int position = term->count;
+    if (term->count > 0 && term->docs[term->count - 1] > doc) {
+        position = text_lower_bound(term->docs, 0, term->count, doc);
+    }
+    
+    memmove(&term->docs[position + 1], &term->docs[position], sizeof(int) * (term->count - position));
+    memmove(&term->freqs[position + 1], &term->freqs[position], sizeof(unsigned short) * (term->count - position));
+    
+    if (freq > USHRT_MAX) {
+        freq = USHRT_MAX;
+    }
+    term->docs[position] = doc;
+    term->freqs[position] = (unsigned short)freq;
+    term->count++;
+    
+    if (freq > term->max_freq) {
+        term->max_freq = freq;
+    }
+    return 0;
+}
+
+/**
+ * @brief 切分文档时的回调：累计词频和文档长度
+ * @param chars 词的码点
+ * @param length 码点数
+ * @param context 切分状态（TextDocument）
+ * @return 成功返回0，失败返回非0值
+ */
+static int text_document_token(const uint32_t *chars, int length, void *context) {
+    TextDocument *document = (TextDocument *)context;
+    document->length += document->weight;
+    
+    int id = document->create ? text_index_intern(document->index, chars, length)
+                              : text_index_lookup(document->index, chars, length, NULL);
+    if (id < 0) {
+        return document->create ? -1 : 0;
+    }
+    
+    for (int i = 0; i < document->count; i++) {
+        if (document->items[i].term == id) {
+            document->items[i].freq += document->weight;
+            return 0;
+        }
+    }
+    
+    if (document->count >= document->capacity) {
+        int capacity = document->capacity > 0 ? document->capacity * 2 : 32;
+        TextDocTerm *grown = (TextDocTerm *)realloc(document->items, sizeof(TextDocTerm) * capacity);
+        if (grown == NULL) {
+            return -1;
+        }
+        document->items = grown;
+        document->capacity = capacity;
+    }
+    
+    document->items[document->count].term = id;
+    document->items[document->count].freq = document->weight;
+    document->count++;
+    return 0;
+}
+
+/**
+ * @brief 切分文档的各个字段，统计其中的词
+ * @param index 全文检索索引
+ * @param fields 各字段的文本
+ * @param create 词不存在时是否加入词表
+ * @param document 用于返回统计结果，调用方负责释放items
+ * @return 成功返回0，失败返回非0值
+ */
+static int text_index_collect(TextIndex *index, const char *const *fields, int create, TextDocument *document) {
+    document->index = index;
+    document->create = create;
+    document->items = NULL;
+    document->count = 0;
+    document->capacity = 0;
+    document->length = 0;
+    
+    for (int f = 0; f < index->field_count; f++) {
+        document->weight = index->weights[f];
+        if (fields[f] != NULL && text_tokenize(fields[f], text_document_token, document) != 0) {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 初始化全文检索索引
+ * @param index 全文检索索引
+ * @param weights 各字段的权重（正整数）
+ * @param field_count 字段数量，不超过TEXT_MAX_FIELDS
+ * @return 成功返回0，失败返回非0值
+ */
+int text_index_init(TextIndex *index, const int *weights, int field_count) {
+    if (index == NULL || weights == NULL || field_count <= 0 || field_count > TEXT_MAX_FIELDS) {
+        return -1;
+    }
+    
+    index->terms = NULL;
+    index->term_count = 0;
+    index->term_capacity = 0;
+    index->lengths = NULL;
+    index->doc_count = 0;
+    index->live_count = 0;
+    index->doc_capacity = 0;
+    index->total_length = 0;
+    index->field_count = field_count;
+    memcpy(index->weights, weights, sizeof(int) * field_count);
+    
+    index->slots = (int *)malloc(sizeof(int) * TEXT_INITIAL_SLOTS);
+    if (index->slots == NULL) {
+        index->mask = 0;
+        return -1;
+    }
+    
+    memset(index->slots, -1, sizeof(int) * TEXT_INITIAL_SLOTS);
+    index->mask = TEXT_INITIAL_SLOTS - 1;
+    return 0;
+}
+
+/**
+ * @brief 清空全文检索索引
+ * @param index 全文检索索引
+ */
+void text_index_clear(TextIndex *index) {
+    for (int t = 0; t < index->term_count; t++) {
+        free(index->terms[t].chars);
+        free(index->terms[t].docs);
+        free(index->terms[t].freqs);
+    }
+    
+    index->term_count = 0;
+    index->doc_count = 0;
+    index->live_count = 0;
+    index->total_length = 0;
+    if (index->slots != NULL) {
+        memset(index->slots, -1, sizeof(int) * (index->mask + 1));
+    }
+}
+
+/**
+ * @brief 释放全文检索索引
+ * @param index 全文检索索引
+ */
+void text_index_free(TextIndex *index) {
+    if (index == NULL) {
+        return;
+    }
+    
+    text_index_clear(index);
+    free(index->terms);
+    free(index->slots);
+    free(index->lengths);
+    index->terms = NULL;
+    index->term_capacity = 0;
+    index->slots = NULL;
+    index->mask = 0;
+    index->lengths = NULL;
+    index->doc_capacity = 0;
+}
+
+/**
+ * @brief 将文档加入索引
+ * @param index 全文检索索引
+ * @param doc 文档编号，等于文档数量时追加，否则应是先前移除过的文档
+ * @param fields 各字段的文本
+ * @return 成功返回0，失败返回非0值
+ */
+int text_index_add(TextIndex *index, int doc, const char *const *fields) {
+    if (doc < 0 || doc > index->doc_count) {
+        return -1;
+    }
+    
+    if (doc == index->doc_count) {
+        if (index->doc_count >= index->doc_capacity) {
+            int capacity = index->doc_capacity > 0 ? index->doc_capacity * 2 : 256;
+            int *grown = (int *)realloc(index->lengths, sizeof(int) * capacity);
+            if (grown == NULL) {
+                return -1;
+            }
+            index->lengths = grown;
+            index->doc_capacity = capacity;
+        }
+        index->lengths[index->doc_count++] = 0;
+    }
+    
+    TextDocument document;
+    int result = text_index_collect(index, fields, 1, &document);
+    
+    for (int i = 0; i < document.count && result == 0; i++) {
+        result = text_term_add_doc(&index->terms[document.items[i].term], doc, document.items[i].freq);
+    }
+    
+    index->live_count++;
+    index->total_length += document.length - index->lengths[doc];
+    index->lengths[doc] = document.length;
+    free(document.items);
+    return result;
+}
+
+/**
+ * @brief 将文档从索引中移除，文档编号保留（字段文本需与加入时相同）
+ * @param index 全文检索索引
+ * @param doc 文档编号
+ * @param fields 各字段的文本
+ */
+void text_index_remove(TextIndex *index, int doc, const char *const *fields) {
+    if (doc < 0 || doc >= index->doc_count) {
+        return;
+    }
+    
+    TextDocument document;
+    text_index_collect(index, fields, 0, &document);
+    
+    // 词在词表中保留，倒排表为空的词查询时跳过
+    for (int i = 0; i < document.count; i++) {
+        TextTerm *term = &index->terms[document.items[i].term];
+        int position = text_lower_bound(term->docs, 0, term->count, doc);
+        if (position < term->count && term->docs[position] == doc) {
+            memmove(&term->docs[position], &term->docs[position + 1], sizeof(int) * (term->count - position - 1));
+            memmove(&term->freqs[position], &term->freqs[position + 1],
+                    sizeof(unsigned short) * (term->count - position - 1));
+            term->count--;
+        }
+    }
+    
+    index->live_count--;
+    index->total_length -= index->lengths[doc];
+    index->lengths[doc] = 0;
+    free(document.items);
+}
+
+/**
+ * @brief 删除文档，并把编号大于它的文档编号都减1（对应数组中删除元素后后面的元素前移）
+ * @param index 全文检索索引
+ * @param doc 文档编号
+ * @param fields 各字段的文本
+ */
+void text_index_delete(TextIndex *index, int doc, const char *const *fields) {
+    if (doc < 0 || doc >= index->doc_count) {
+        return;
+    }
+    
+    text_index_remove(index, doc, fields);
+    
+    for (int t = 0; t < index->term_count; t++) {
+        TextTerm *term = &index->terms[t];
+        for (int i = text_lower_bound(term->docs, 0, term->count, doc + 1); i < term->count; i++) {
+            term->docs[i]--;
+        }
+    }
+    
+    memmove(&index->lengths[doc], &index->lengths[doc + 1], sizeof(int) * (index->doc_count - doc - 1));
+    index->doc_count--;
+}
+
+/**
+ * @brief 切分查询串时的回调：收集在索引中出现过的查询词
+ * @param chars 词的码点
+ * @param length 码点数
+ * @param context 切分状态（TextDocument，items存放查询词编号，容量固定）
+ * @return 始终返回0
+ */
+static int text_query_token(const uint32_t *chars, int length, void *context) {
+    TextDocument *query = (TextDocument *)context;
+    int id = text_index_lookup(query->index, chars, length, NULL);
+    
+    if (id < 0 || query->index->terms[id].count == 0 || query->count >= query->capacity) {
+        return 0;
+    }
+    
+    // 重复的查询词只计一次
+    for (int i = 0; i < query->count; i++) {
+        if (query->items[i].term == id) {
+            return 0;
+        }
+    }
+    
+    query->items[query->count].term = id;
+    query->items[query->count].freq = 1;
+    query->count++;
+    return 0;
+}
+
+/**
+ * @brief 将游标移到第一个编号不小于doc的倒排项
+ * @param cursor 游标
+ * @param doc 文档编号
+ */
+static void text_cursor_seek(TextCursor *cursor, int doc) {
+    const TextTerm *term = cursor->term;
+    
+    // 先倍增步长找到范围，再在范围内二分，跳过的倒排项不需要逐个检查
+    int low = cursor->position;
+    int step = 1;
+    while (low + step < term->count && term->docs[low + step] < doc) {
+        low += step;
+        step *= 2;
+    }
+    int high = low + step < term->count ? low + step + 1 : term->count;
+    
+    cursor->position = text_lower_bound(term->docs, low, high, doc);
+    cursor->doc = cursor->position < term->count ? term->docs[cursor->position] : INT_MAX;
+}
+
+/**
+ * @brief 游标前进一项
+ * @param cursor 游标
+ */
+static void text_cursor_next(TextCursor *cursor) {
+    cursor->position++;
+    cursor->doc = cursor->position < cursor->term->count ? cursor->term->docs[cursor->position] : INT_MAX;
+}
+
+/**
+ * @brief 比较两个结果，评分高的在前，同分时编号小的在前
+ * @return a排在b之前返回1，否则返回0
+ */
+static int text_hit_before(const TextHit *a, const TextHit *b) {
+    return a->score > b->score || (a->score == b->score && a->doc < b->doc);
+}
+
+/**
+ * @brief 小顶堆下沉（堆顶是当前排名最后的结果）
+ * @param heap 堆
+ * @param count 堆大小
+ * @param i 下沉的位置
+ */
+static void text_heap_down(TextHit *heap, int count, int i) {
+    for (;;) {
+        int worst = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < count && text_hit_before(&heap[worst], &heap[left])) {
+            worst = left;
+        }
+        if (right < count && text_hit_before(&heap[worst], &heap[right])) {
+            worst = right;
+        }
+        if (worst == i) {
+            return;
+        }
+        
+        TextHit moving = heap[i];
+        heap[i] = heap[worst];
+        heap[worst] = moving;
+        i = worst;
+    }
+}
+
+/**
+ * @brief 查询评分最高的前k个文档
+ *
+ * 包含任意一个查询词的文档都参与排名。
+ *
+ * @param index 全文检索索引
+ * @param query 查询串
+ * @param hits 用于存储结果，按评分降序、同分按文档编号升序
+ * @param k 最大返回数量
+ * @return 返回结果数量，失败返回-1
+ */
+int text_index_search(const TextIndex *index, const char *query, TextHit *hits, int k) {
+    TextDocTerm items[TEXT_MAX_QUERY_TERMS];
+    TextCursor cursors[TEXT_MAX_QUERY_TERMS];
+    TextDocument parsed;
+    
+    if (query == NULL || hits == NULL || k <= 0 || index->live_count == 0 || index->total_length == 0) {
+        return 0;
+    }
+    
+    parsed.index = (TextIndex *)index;
+    parsed.items = items;
+    parsed.count = 0;
+    parsed.capacity = TEXT_MAX_QUERY_TERMS;
+    text_tokenize(query, text_query_token, &parsed);
+    
+    // 已移除的文档不计入文档总数和平均长度，评分与整理后的索引相同
+    double average = (double)index->total_length / index->live_count;
+    int cursor_count = parsed.count;
+    
+    for (int i = 0; i < cursor_count; i++) {
+        TextCursor *cursor = &cursors[i];
+        const TextTerm *term = &index->terms[items[i].term];
+        double df = term->count;
+        
+        cursor->term = term;
+        cursor->order = i;
+        cursor->position = 0;
+        cursor->doc = term->docs[0];
+        cursor->idf = log(1.0 + (index->live_count - df + 0.5) / (df + 0.5));
+        
+        // 文档长度取0时评分最大，以此作为上界
+        double tf = term->max_freq;
+        cursor->bound = cursor->idf * tf * (TEXT_BM25_K1 + 1) / (tf + TEXT_BM25_K1 * (1 - TEXT_BM25_B));
+    }
+    
+    int count = 0;
+    for (;;) {
+        // 游标按当前文档编号排序（查询词很少，插入排序即可）
+        for (int i = 1; i < cursor_count; i++) {
+            TextCursor moving = cursors[i];
+            int j = i;
+            while (j > 0 && cursors[j - 1].doc > moving.doc) {
+                cursors[j] = cursors[j - 1];
+                j--;
+            }
+            cursors[j] = moving;
+        }
+        
+        // 找枢轴：上界累加后首次超过第k名分数的游标，编号更小的文档不可能进入前k名
+        double threshold = count < k ? 0.0 : hits[0].score;
+        double bound = 0.0;
+        int pivot = -1;
+        for (int i = 0; i < cursor_count && cursors[i].doc != INT_MAX; i++) {
+            bound += cursors[i].bound;
+            if (bound > threshold) {
+                pivot = i;
+                break;
+            }
+        }
+        
+        if (pivot < 0) {
+            break;
+        }
+        
+        int pivot_doc = cursors[pivot].doc;
+        if (cursors[0].doc != pivot_doc) {
+            // 前面的游标直接跳到枢轴文档
+            for (int i = 0; i < pivot; i++) {
+                text_cursor_seek(&cursors[i], pivot_doc);
+            }
+            continue;
+        }
+        
+        // 所有停在枢轴文档上的词一起计算评分，按查询词次序累加，保证同样的文档得到完全相同的分数
+        double norm = TEXT_BM25_K1 * (1 - TEXT_BM25_B + TEXT_BM25_B * index->lengths[pivot_doc] / average);
+        double parts[TEXT_MAX_QUERY_TERMS] = {0};
+        double score = 0.0;
+        for (int i = 0; i < cursor_count && cursors[i].doc == pivot_doc; i++) {
+            double tf = cursors[i].term->freqs[cursors[i].position];
+            parts[cursors[i].order] = cursors[i].idf * tf * (TEXT_BM25_K1 + 1) / (tf + norm);
+            text_cursor_next(&cursors[i]);
+        }
+        for (int i = 0; i < cursor_count; i++) {
+            score += parts[i];
+        }
+        
+        // 文档按编号递增出现，同分时先出现的排在前面，所以只有分数更高才替换堆顶
+        if (count < k) {
+            int i = count++;
+            hits[i].doc = pivot_doc;
+            hits[i].score = score;
+            while (i > 0 && text_hit_before(&hits[(i - 1) / 2], &hits[i])) {
+                TextHit moving = hits[i];
+                hits[i] = hits[(i - 1) / 2];
+                hits[(i - 1) / 2] = moving;
+                i = (i - 1) / 2;
+            }
+        } else if (score > hits[0].score) {
+            hits[0].doc = pivot_doc;
+            hits[0].score = score;
+            text_heap_down(hits, count, 0);
+        }
+    }
+    
+    // 堆排序：依次把排名最后的结果换到末尾
+    for (int n = count - 1; n > 0; n--) {
+        TextHit moving = hits[0];
+        hits[0] = hits[n];
+        hits[n] = moving;
+        text_heap_down(hits, n, 0);
+    }
+    
+    return count;
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+/**
+ * @file text_index.h
+ * @brief 全文检索索引相关函数和数据结构的声明
+ *
+ * 文本按utf8_fold折叠后切分为词：西文按连续的字母、数字切分，中日韩文字没有空格，
+ * 连续的一段取相邻两字组成的二元组（只有一个字时取单字）。一篇文档由若干字段组成，
+ * 每个字段有权重，词频和文档长度都按字段权重累加，评分使用BM25。
+ * 查询取前k个结果时使用WAND剪枝：每个词记录评分上界，当前候选的上界之和
+ * 不超过第k名的分数时直接跳过，不必对每个倒排项都计算评分。
+ */
+
+#ifndef TEXT_INDEX_H
+#define TEXT_INDEX_H
+
+#include <stdint.h>
+
+// 文档的最大字段数
+#define TEXT_MAX_FIELDS 4
+
+/**
+ * @brief 词及其倒排表
+ */
+typedef struct {
+    uint32_t *chars;         /**< 词的码点（已折叠） */
+    int length;              /**< 码点数 */
+    int *docs;               /**< 按升序排列的文档编号 */
+    unsigned short *freqs;   /**< 与docs对应的加权词频 */
+    int count;               /**< 文档数量 */
+    int capacity;            /**< 倒排表容量 */
+    int max_freq;            /**< 倒排表中出现过的最大加权词频（只增不减，用于评分上界） */
+} TextTerm;
+
+/**
+ * @brief 全文检索索引
+ */
+typedef struct {
+    TextTerm *terms;                  /**< 词数组 */
+    int term_count;                   /**< 词数量 */
+    int term_capacity;                /**< 词数组容量 */
+    int *slots;                       /**< 词表哈希（开放寻址），存放词编号，-1表示空槽 */
+    unsigned int mask;                /**< 槽数减1（槽数为2的幂） */
+    int weights[TEXT_MAX_FIELDS];     /**< 各字段的权重 */
+    int field_count;                  /**< 字段数量 */
+    int *lengths;                     /**< 各文档的加权长度 */
+    int doc_count;                    /**< 文档编号上界（含已移除的文档） */
+    int live_count;                   /**< 未移除的文档数量（评分时的文档总数） */
+    int doc_capacity;                 /**< 文档长度数组容量 */
+    long total_length;                /**< 所有文档加权长度之和 */
+} TextIndex;
+
+/**
+ * @brief 查询结果
+ */
+typedef struct {
+    int doc;        /**< 文档编号 */
+    double score;   /**< BM25评分 */
+} TextHit;
+
+/**
+ * @brief 初始化全文检索索引
+ * @param index 全文检索索引
+ * @param weights 各字段的权重（正整数）
+ * @param field_count 字段数量，不超过TEXT_MAX_FIELDS
+ * @return 成功返回0，失败返回非0值
+ */
+int text_index_init(TextIndex *index, const int *weights, int field_count);
+
+/**
+ * @brief 清空全文检索索引
+ * @param index 全文检索索引
+ */
+void text_index_clear(TextIndex *index);
+
+/**
+ * @brief 释放全文检索索引
+ * @param index 全文检索索引
+ */
+void text_index_free(TextIndex *index);
+
+/**
+ * @brief 将文档加入索引
+ * @param index 全文检索索引
+ * @param doc 文档编号，等于文档数量时追加，否则应是先前移除过的文档
+ * @param fields 各字段的文本
+ * @return 成功返回0，失败返回非0值
+ */
+int text_index_add(TextIndex *index, int doc, const char *const *fields);
+
+/**
+ * @brief 将文档从索引中移除，文档编号保留（字段文本需与加入时相同）
+ * @param index 全文检索索引
+ * @param doc 文档编号
+ * @param fields 各字段的文本
+ */
+void text_index_remove(TextIndex *index, int doc, const char *const *fields);
+
+/**
+ * @brief 删除文档，并把编号大于它的文档编号都减1（对应数组中删除元素后后面的元素前移）
+ * @param index 全文检索索引
+ * @param doc 文档编号
+ * @param fields 各字段的文本
+ */
+void text_index_delete(TextIndex *index, int doc, const char *const *fields);
+
+/**
+ * @brief 查询评分最高的前k个文档
+ *
+ * 包含任意一个查询词的文档都参与排名。
+ *
+ * @param index 全文检索索引
+ * @param query 查询串
+ * @param hits 用于存储结果，按评分降序、同分按文档编号升序
+ * @param k 最大返回数量
+ * @return 返回结果数量，失败返回-1
+ */
+int text_index_search(const TextIndex *index, const char *query, TextHit *hits, int k);
+
+#endif /* TEXT_INDEX_H */
\ No newline at end of file
@@ -0,0 +1,462 @@
+/**
+ * @file trigram.c
+ * @brief 三元组倒排索引相关函数的实现
+ */
+
+#include "trigram.h"
+#include "utf8.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TRIGRAM_INITIAL_SLOTS 1024 // 哈希表初始槽数
+#define TRIGRAM_LOCAL_KEYS 256     // 栈上缓冲区能容纳的三元组数，超过时改用堆内存
+
+/**
+ * @brief 比较两个三元组键（qsort回调）
+ */
+static int trigram_compare_keys(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/**
+ * @brief 提取文本中所有不重复的三元组
+ * @param text 文本
+ * @param local 栈上缓冲区（TRIGRAM_LOCAL_KEYS个元素）
+ * @param keys 用于返回三元组数组（可能是local，也可能是新分配的内存）
+ * @param chars 用于返回文本的字符数，可以为NULL
+ * @return 返回三元组数量，失败返回-1
+ */
+static int trigram_extract(const char *text, uint64_t *local, uint64_t **keys, int *chars) {
+    const char *p = text;
+    uint64_t *buffer = local;
+    int capacity = TRIGRAM_LOCAL_KEYS;
+    int count = 0;
+    int n = 0;
+    uint32_t a = 0, b = 0, c;
+    
+    while ((c = utf8_fold(utf8_next_char(&p))) != 0) {
+        n++;
+        if (n >= 3) {
+            if (count >= capacity) {
+                uint64_t *grown = (uint64_t *)malloc(sizeof(uint64_t) * capacity * 2);
+                if (grown == NULL) {
+                    if (buffer != local) {
+                        free(buffer);
+                    }
+                    return -1;
+                }
+                memcpy(grown, buffer, sizeof(uint64_t) * count);
+                if (buffer != local) {
+                    free(buffer);
+                }
+                buffer = grown;
+                capacity *= 2;
+            }
+            buffer[count++] = ((uint64_t)a << 42) | ((uint64_t)b << 21) | c;
+        }
+        a = b;
+        b = c;
+    }
+    
+    // 排序去重
+    qsort(buffer, count, sizeof(uint64_t), trigram_compare_keys);
+    
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (unique == 0 || buffer[unique - 1] != buffer[i]) {
+            buffer[unique++] = buffer[i];
+        }
+    }
+    
+    if (chars != NULL) {
+        *chars = n;
+    }
+    
+    *keys = buffer;
+    return unique;
+}
+
+/**
+ * @brief 计算三元组键的哈希槽
+ * @param index 三元组索引
+ * @param key 三元组键
+ * @return 起始槽位
+ */
+static unsigned int trigram_slot_of(const TrigramIndex *index, uint64_t key) {
+    return (unsigned int)((key * 0x9E3779B97F4A7C15ull) >> 32) & index->mask;
+}
+
+/**
+ * @brief 查找三元组的倒排表
+ * @param index 三元组索引
+ * @param key 三元组键
+ * @return 找到返回倒排表，否则返回NULL
+ */
+static TrigramPosting *trigram_lookup(const TrigramIndex *index, uint64_t key) {
+    unsigned int slot = trigram_slot_of(index, key);
+    
+    while (index->slots[slot].key != 0) {
+        if (index->slots[slot].key == key) {
+            return &index->slots[slot];
+        }
+        slot = (slot + 1) & index->mask;
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief 分配指定槽数的哈希表
+ * @param index 三元组索引
+ * @param slots 槽数（2的幂）
+ * @return 成功返回0，失败返回非0值
+ */
+static int trigram_alloc_slots(TrigramIndex *index, unsigned int slots) {
+    index->slots = (TrigramPosting *)calloc(slots, sizeof(TrigramPosting));
+    if (index->slots == NULL) {
+        return -1;
+    }
+    
+    index->mask = slots - 1;
+    index->used = 0;
+    return 0;
+}
+
+/**
+ * @brief 哈希表扩容为原来的2倍
+ * @param index 三元组索引
+ * @return 成功返回0，失败返回非0值
+ */
+static int trigram_grow(TrigramIndex *index) {
+    TrigramPosting *old_slots = index->slots;
+    unsigned int old_count = index->mask + 1;
+    
+    if (trigram_alloc_slots(index, old_count * 2) != 0) {
+        index->slots = old_slots;
+        index->mask = old_count - 1;
+        return -1;
+    }
+    
+    for (unsigned int i = 0; i < old_count; i++) {
+        if (old_slots[i].key != 0) {
+            unsigned int slot = trigram_slot_of(index, old_slots[i].key);
+            while (index->slots[slot].key != 0) {
+                slot = (slot + 1) & index->mask;
+            }
+            index->slots[slot] = old_slots[i];
+            index->used++;
+        }
+    }
+    
+    free(old_slots);
+    return 0;
+}
+
+/**
+ * @brief 查找三元组的倒排表，不存在时新建
+ * @param index 三元组索引
+ * @param key 三元组键
+ * @return 成功返回倒排表，失败返回NULL
+ */
+static TrigramPosting *trigram_insert(TrigramIndex *index, uint64_t key) {
+    TrigramPosting *posting = trigram_lookup(index, key);
+    if (posting != NULL) {
+        return posting;
+    }
+    
+    // 装载因子保持在1/2以下
+    if ((unsigned int)(index->used + 1) * 2 > index->mask + 1 && trigram_grow(index) != 0) {
+        return NULL;
+    }
+    
+    unsigned int slot = trigram_slot_of(index, key);
+    while (index->slots[slot].key != 0) {
+        slot = (slot + 1) & index->mask;
+    }
+    
+    index->slots[slot].key = key;
+    index->used++;
+    return &index->slots[slot];
+}
+
+/**
+ * @brief 在升序数组中查找第一个不小于value的位置
+ * @param docs 升序数组
+ * @param count 元素数量
+ * @param value 要查找的值
+ * @return 位置
+ */
+static int trigram_lower_bound(const int *docs, int count, int value) {
+    int lo = 0, hi = count;
+    
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (docs[mid] < value) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    
+    return lo;
+}
+
+/**
+ * @brief 初始化三元组索引
+ * @param index 三元组索引
+ * @return 成功返回0，失败返回非0值
+ */
+int trigram_index_init(TrigramIndex *index) {
+    if (index == NULL) {
+        return -1;
+    }
+    
+    return trigram_alloc_slots(index, TRIGRAM_INITIAL_SLOTS);
+}
+
+/**
+ * @brief 清空三元组索引（保留哈希表）
+ * @param index 三元组索引
+ */
+void trigram_index_clear(TrigramIndex *index) {
+    if (index == NULL || index->slots == NULL) {
+        return;
+    }
+    
+    for (unsigned int i = 0; i <= index->mask; i++) {
+        free(index->slots[i].docs);
+    }
+    
+    memset(index->slots, 0, sizeof(TrigramPosting) * (index->mask + 1));
+    index->used = 0;
+}
+
+/**
+ * @brief 释放三元组索引
+ * @param index 三元组索引
+ */
+void trigram_index_free(TrigramIndex *index) {
+    if (index == NULL) {
+        return;
+    }
+    
+    trigram_index_clear(index);
+    free(index->slots);
+    index->slots = NULL;
+    index->mask = 0;
+}
+
+/**
+ * @brief 将文档加入索引
+ * @param index 三元组索引
+ * @param doc 文档编号
+ * @param text 文档文本
+ * @return 成功返回0，失败返回非0值
+ */
+int trigram_index_add(TrigramIndex *index, int doc, const char *text) {
+    if (index == NULL || index->slots == NULL || text == NULL) {
+        return -1;
+    }
+    
+    uint64_t local[TRIGRAM_LOCAL_KEYS];
+    uint64_t *keys;
+    int count = trigram_extract(text, local, &keys, NULL);
+    if (count < 0) {
+        return -1;
+    }
+    
+    int result = 0;
+    
+    for (int i = 0; i < count; i++) {
+        TrigramPosting *posting = trigram_insert(index, keys[i]);
+        if (posting == NULL) {
+            result = -1;
+            break;
+        }
+        
+        // 按顺序加载时文档编号递增，直接追加在末尾
+        int pos = (posting->count == 0 || posting->docs[posting->count - 1] < doc) ?
+                  posting->count : trigram_lower_bound(posting->docs, posting->count, doc);
+        if (pos < posting->count && posting->docs[pos] == doc) {
+            continue;
+        }
+        
+        if (posting->count >= posting->capacity) {
+            int new_capacity = posting->capacity > 0 ? posting->capacity * 2 : 4;
+            int *docs = (int *)realloc(posting->docs, sizeof(int) * new_capacity);
+            if (docs == NULL) {
+                result = -1;
+                break;
+            }
+            posting->docs = docs;
+            posting->capacity = new_capacity;
+        }
+        
+        memmove(&posting->docs[pos + 1], &posting->docs[pos], sizeof(int) * (posting->count - pos));
+        posting->docs[pos] = doc;
+        posting->count++;
+    }
+    
+    if (keys != local) {
+        free(keys);
+    }
+    
+    return result;
+}
+
+/**
+ * @brief 将文档从索引中移除（文档文本需与加入时相同）
+ * @param index 三元组索引
+ * @param doc 文档编号
+ * @param text 文档文本
+ */
+void trigram_index_remove(TrigramIndex *index, int doc, const char *text) {
+    if (index == NULL || index->slots == NULL || text == NULL) {
+        return;
+    }
+    
+    uint64_t local[TRIGRAM_LOCAL_KEYS];
+    uint64_t *keys;
+    int count = trigram_extract(text, local, &keys, NULL);
+    if (count < 0) {
+        return;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        TrigramPosting *posting = trigram_lookup(index, keys[i]);
+        if (posting == NULL) {
+            continue;
+        }
+        
+        int pos = trigram_lower_bound(posting->docs, posting->count, doc);
+        if (pos < posting->count && posting->docs[pos] == doc) {
+            memmove(&posting->docs[pos], &posting->docs[pos + 1], sizeof(int) * (posting->count - pos - 1));
+            posting->count--;
+        }
+    }
+    
+    if (keys != local) {
+        free(keys);
+    }
+}
+
+/**
+ * @brief 删除文档，并把编号大于它的文档编号都减1
+ * @param index 三元组索引
+ * @param doc 文档编号
+ * @param text 文档文本
+ */
+void trigram_index_delete(TrigramIndex *index, int doc, const char *text) {
+    if (index == NULL || index->slots == NULL) {
+        return;
+    }
+    
+    trigram_index_remove(index, doc, text);
+    
+    // 倒排表有序，只需处理第一个大于doc的位置之后的部分
+    for (unsigned int i = 0; i <= index->mask; i++) {
+        TrigramPosting *posting = &index->slots[i];
+        for (int j = trigram_lower_bound(posting->docs, posting->count, doc + 1); j < posting->count; j++) {
+            posting->docs[j]--;
+        }
+    }
+}
+
+/**
+ * @brief 比较两个倒排表的长度（qsort回调）
+ */
+static int trigram_compare_postings(const void *a, const void *b) {
+    const TrigramPosting *x = *(const TrigramPosting * const *)a;
+    const TrigramPosting *y = *(const TrigramPosting * const *)b;
+    return x->count - y->count;
+}
+
+/**
+ * @brief 查找可能包含查询串的候选文档
+ * @param index 三元组索引
+ * @param pattern 查询串
+ * @param docs 用于返回按升序排列的候选文档编号数组（调用方负责free）
+ * @return 返回候选文档数量，无法使用索引或失败返回-1
+ */
+int trigram_index_query(const TrigramIndex *index, const char *pattern, int **docs) {
+    if (index == NULL || index->slots == NULL || pattern == NULL || docs == NULL) {
+        return -1;
+    }
+    
+    *docs = NULL;
+    
+    uint64_t local[TRIGRAM_LOCAL_KEYS];
+    uint64_t *keys;
+    int chars;
+    int count = trigram_extract(pattern, local, &keys, &chars);
+    if (count < 0) {
+        return -1;
+    }
+    
+    if (chars < 3) {
+        return -1;
+    }
+    
+    TrigramPosting **postings = (TrigramPosting **)malloc(sizeof(TrigramPosting *) * count);
+    if (postings == NULL) {
+        if (keys != local) {
+            free(keys);
+        }
+        return -1;
+    }
+    
+    // 任一三元组没有出现过，结果必为空
+    int missing = 0;
+    for (int i = 0; i < count; i++) {
+        postings[i] = trigram_lookup(index, keys[i]);
+        if (postings[i] == NULL || postings[i]->count == 0) {
+            missing = 1;
+            break;
+        }
+    }
+    
+    if (keys != local) {
+        free(keys);
+    }
+    
+    if (missing) {
+        free(postings);
+        return 0;
+    }
+    
+    // 从最短的倒排表开始求交集
+    qsort(postings, count, sizeof(TrigramPosting *), trigram_compare_postings);
+    
+    int *result = (int *)malloc(sizeof(int) * postings[0]->count);
+    if (result == NULL) {
+        free(postings);
+        return -1;
+    }
+    
+    int result_count = postings[0]->count;
+    memcpy(result, postings[0]->docs, sizeof(int) * result_count);
+    
+    for (int i = 1; i < count && result_count > 0; i++) {
+        const int *other = postings[i]->docs;
+        int other_count = postings[i]->count;
+        int pos = 0;
+        int kept = 0;
+        
+        for (int j = 0; j < result_count && pos < other_count; j++) {
+            // 候选远少于倒排表时用二分跳过
+            pos += trigram_lower_bound(other + pos, other_count - pos, result[j]);
+            if (pos < other_count && other[pos] == result[j]) {
+                result[kept++] = result[j];
+                pos++;
+            }
+        }
+        
+        result_count = kept;
+    }
+    
+    free(postings);
+    *docs = result;
+    return result_count;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file trigram.h
+ * @brief 三元组倒排索引相关函数和数据结构的声明
+ *
+ * 以UTF-8码点为单位，把文本中每相邻三个字符（按utf8_fold折叠大小写）作为一个三元组，
+ * 为每个三元组维护一个按文档编号升序排列的倒排表。
+ * 子串查询时取出查询串所有三元组的倒排表求交集得到候选文档，再由调用方逐个验证。
+ * 文档编号即记录在数组中的下标。
+ */
+
+#ifndef TRIGRAM_H
+#define TRIGRAM_H
+
+#include <stdint.h>
+
+/**
+ * @brief 一个三元组及其倒排表
+ */
+typedef struct {
+    uint64_t key;     /**< 三个码点拼成的键，0表示空槽 */
+    int *docs;        /**< 按升序排列的文档编号 */
+    int count;        /**< 文档数量 */
+    int capacity;     /**< 文档数组容量 */
+} TrigramPosting;
+
+/**
+ * @brief 三元组倒排索引
+ */
+typedef struct {
+    TrigramPosting *slots;   /**< 开放寻址的哈希表 */
+    unsigned int mask;       /**< 槽数减1（槽数为2的幂） */
+    int used;                /**< 已使用的槽数 */
+} TrigramIndex;
+
+/**
+ * @brief 初始化三元组索引
+ * @param index 三元组索引
+ * @return 成功返回0，失败返回非0值
+ */
+int trigram_index_init(TrigramIndex *index);
+
+/**
+ * @brief 清空三元组索引（保留哈希表）
+ * @param index 三元组索引
+ */
+void trigram_index_clear(TrigramIndex *index);
+
+/**
+ * @brief 释放三元组索引
+ * @param index 三元组索引
+ */
+void trigram_index_free(TrigramIndex *index);
+
+/**
+ * @brief 将文档加入索引
+ * @param index 三元组索引
+ * @param doc 文档编号
+ * @param text 文档文本
+ * @return 成功返回0，失败返回非0值
+ */
+int trigram_index_add(TrigramIndex *index, int doc, const char *text);
+
+/**
+ * @brief 将文档从索引中移除（文档文本需与加入时相同）
+ * @param index 三元组索引
+ * @param doc 文档编号
+ * @param text 文档文本
+ */
+void trigram_index_remove(TrigramIndex *index, int doc, const char *text);
+
+/**
+ * @brief 删除文档，并把编号大于它的文档编号都减1（对应数组中删除元素后后面的元素前移）
+ * @param index 三元组索引
+ * @param doc 文档编号
+ * @param text 文档文本
+ */
+void trigram_index_delete(TrigramIndex *index, int doc, const char *text);
+
+/**
+ * @brief 查找可能包含查询串的候选文档
+ *
+ * 查询串不足三个字符时无法使用索引，返回-1，调用方应退回到逐条比较。
+ *
+ * @param index 三元组索引
+ * @param pattern 查询串
+ * @param docs 用于返回按升序排列的候选文档编号数组（调用方负责free）
+ * @return 返回候选文档数量，无法使用索引或失败返回-1
+ */
+int trigram_index_query(const TrigramIndex *index, const char *pattern, int **docs);
+
+#endif /* TRIGRAM_H */
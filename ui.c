@@ -13,6 +13,8 @@
 #include <string.h>
 #include <time.h>
 
+#define OVERDUE_CHECK_INTERVAL 60 // 逾期检查间隔（秒）
+
 // 主窗口
 static GtkWidget *main_window = NULL;
 
@@ -45,6 +47,7 @@ static void on_delete_reader_clicked(GtkWidget *widget, gpointer data);
 static void on_borrow_book_clicked(GtkWidget *widget, gpointer data);
 static void on_return_book_clicked(GtkWidget *widget, gpointer data);
 static void on_renew_book_clicked(GtkWidget *widget, gpointer data);
+static gboolean on_overdue_timer(gpointer data);
 
 /**
  * @brief 初始化用户界面
@@ -69,6 +72,9 @@ void ui_run() {
     // 显示主窗口
     ui_show_main_window();
     
+    // 定时检查逾期借阅
+    g_timeout_add_seconds(OVERDUE_CHECK_INTERVAL, on_overdue_timer, NULL);
+    
     // 运行GTK+主循环
     gtk_main();
 }
@@ -972,17 +978,17 @@ void ui_show_borrow_book_dialog() {
                 ui_show_error_dialog(GTK_WINDOW(dialog), "输入错误", "借阅天数必须大于0");
             } else {
                 // 查找读者
-                Reader reader;
-                if (reader_find_by_id(reader_id, &reader) != 0) {
+                int quota = reader_borrow_quota(reader_lookup(reader_id));
+                if (quota < 0) {
                     ui_show_error_dialog(GTK_WINDOW(dialog), "借阅失败", "找不到指定的读者");
-                } else if (reader.current_borrow_count >= reader.max_borrow_count) {
+                } else if (quota == 0) {
                     ui_show_error_dialog(GTK_WINDOW(dialog), "借阅失败", "该读者已达到最大借阅数量");
                 } else {
                     // 查找图书
-                    Book book;
-                    if (book_find_by_id(book_id, &book) != 0) {
+                    BookHandle book = book_lookup(book_id);
+                    if (book == -1) {
                         ui_show_error_dialog(GTK_WINDOW(dialog), "借阅失败", "找不到指定的图书");
-                    } else if (book.available_count <= 0) {
+                    } else if (book_available_count(book) <= 0) {
                         ui_show_error_dialog(GTK_WINDOW(dialog), "借阅失败", "该图书已无可借数量");
                     } else {
                         // 创建借阅记录
@@ -1231,6 +1237,19 @@ void ui_show_error_dialog(GtkWindow *parent, const char *title, const char *mess
     gtk_widget_destroy(dialog);
 }
 
+/**
+ * @brief 逾期检查定时器回调函数
+ * @return 返回TRUE以继续定时
+ */
+static gboolean on_overdue_timer(gpointer data) {
+    // 有借阅记录变为逾期时刷新借阅列表
+    if (borrow_check_overdue() > 0) {
+        ui_refresh_borrow_list();
+    }
+    
+    return TRUE;
+}
+
 /**
  * @brief 主窗口销毁回调函数
  */
@@ -1445,6 +1464,28 @@ static void on_renew_book_clicked(GtkWidget *widget, gpointer data) {
     ui_show_renew_book_dialog();
 }
 
+/**
+ * @brief 把一本图书加入图书列表（book_foreach的访问函数）
+ * @param book 图书
+ * @param user_data 图书列表
+ * @return 始终返回0，继续遍历
+ */
+static int ui_append_book_row(const Book *book, void *user_data) {
+    GtkListStore *store = GTK_LIST_STORE(user_data);
+    GtkTreeIter iter;
+    
+    gtk_list_store_append(store, &iter);
+    gtk_list_store_set(store, &iter,
+                      0, book->id,
+                      1, book->title,
+                      2, book->author,
+                      3, book->publisher,
+                      4, book->isbn,
+                      5, book->available_count > 0 ? "可借" : "已借出",
+                      -1);
+    return 0;
+}
+
 /**
  * @brief 刷新图书列表
  */
@@ -1456,26 +1497,27 @@ void ui_refresh_book_list() {
     // 清空列表
     gtk_list_store_clear(book_list_store);
     
-    // 获取所有图书
-    Book books[100]; // 假设最多100本图书
-    int count = 0;
-    count = book_get_all(books, 100);
-    
-    // 添加到列表
-    for (int i = 0; i < count; i++) {
-        GtkTreeIter iter;
-        gtk_list_store_append(book_list_store, &iter);
-        gtk_list_store_set(book_list_store, &iter,
-                          0, books[i].id,
-                          1, books[i].title,
-                          2, books[i].author,
-                          3, books[i].publisher,
-                          4, books[i].isbn,
-                          5, books[i].available_count > 0 ? "可借" : "已借出",
-                          -1);
-    }
+    // 逐本加入列表（每本图书还原到同一个临时结构体中，不分配数组，也不限制数量）
+    book_foreach(NULL, 0, 0, ui_append_book_row, book_list_store);
+}
+
+/**
+ * @brief 把一位读者加入读者列表（reader_foreach的访问函数）
+ * @param reader 读者
+ * @param user_data 读者列表
+ * @return 始终返回0，继续遍历
+ */
+static int ui_append_reader_row(const Reader *reader, void *user_data) {
+    GtkListStore *store = GTK_LIST_STORE(user_data);
+    GtkTreeIter iter;
     
-    // 不需要释放内存，因为books是栈上分配的数组
+    gtk_list_store_append(store, &iter);
+    gtk_list_store_set(store, &iter,
+                      0, reader->id,
+                      1, reader->name,
+                      2, reader->phone,
+                      -1);
+    return 0;
 }
 
 /**
@@ -1489,23 +1531,72 @@ void ui_refresh_reader_list() {
     // 清空列表
     gtk_list_store_clear(reader_list_store);
     
-    // 获取所有读者
-    Reader readers[100]; // 假设最多100位读者
-    int count = 0;
-    count = reader_get_all(readers, 100);
-    
-    // 添加到列表
-    for (int i = 0; i < count; i++) {
-        GtkTreeIter iter;
-        gtk_list_store_append(reader_list_store, &iter);
-        gtk_list_store_set(reader_list_store, &iter,
-                          0, readers[i].id,
-                          1, readers[i].name,
-                          2, readers[i].phone,
-                          -1);
+    // 逐位加入列表
+    reader_foreach(NULL, 0, 0, ui_append_reader_row, reader_list_store);
+}
+
+/**
+ * @brief 把一条借阅记录加入借阅列表（borrow_foreach的访问函数）
+ * @param record 借阅记录
+ * @param user_data 借阅列表
+ * @return 始终返回0，继续遍历
+ */
+static int ui_append_borrow_row(const BorrowRecord *record, void *user_data) {
+    GtkListStore *store = GTK_LIST_STORE(user_data);
+    GtkTreeIter iter;
+    
+    gtk_list_store_append(store, &iter);
+    
+    // 获取图书和读者信息（都还原到栈上）
+    Book book;
+    int has_book = book_get(book_lookup(record->book_id), &book) == 0;
+    Reader reader;
+    int has_reader = reader_get(reader_lookup(record->reader_id), &reader) == 0;
+    
+    // 转换时间戳为字符串
+    char borrow_date[64] = {0};
+    char due_date[64] = {0};
+    char return_date[64] = {0};
+    
+    time_to_string(record->borrow_date, borrow_date, sizeof(borrow_date), "%Y-%m-%d");
+    time_to_string(record->due_date, due_date, sizeof(due_date), "%Y-%m-%d");
+    
+    if (record->status == BORROW_STATUS_RETURNED) {
+        time_to_string(record->return_date, return_date, sizeof(return_date), "%Y-%m-%d");
+    } else {
+        strcpy(return_date, "未归还");
     }
     
-    // 不需要释放内存，因为readers是栈上分配的数组
+    // 状态文本
+    const char *status_text = "";
+    switch (record->status) {
+        case BORROW_STATUS_BORROWED:
+            status_text = "借出";
+            break;
+        case BORROW_STATUS_RETURNED:
+            status_text = "已归还";
+            break;
+        case BORROW_STATUS_OVERDUE:
+            status_text = "逾期";
+            break;
+        case BORROW_STATUS_RENEWED:
+            status_text = "已续借";
+            break;
+        default:
+            status_text = "未知";
+            break;
+    }
+    
+    gtk_list_store_set(store, &iter,
+                      0, record->id,
+                      1, has_book ? book.title : "",
+                      2, has_reader ? reader.name : "",
+                      3, borrow_date,
+                      4, due_date,
+                      5, return_date,
+                      6, status_text,
+                      -1);
+    return 0;
 }
 
 /**
@@ -1519,68 +1610,6 @@ void ui_refresh_borrow_list() {
     // 清空列表
     gtk_list_store_clear(borrow_list_store);
     
-    // 获取所有借阅记录
-    BorrowRecord records[100]; // 假设最多100条记录
-    int count = 0;
-    count = borrow_get_all(records, 100);
-    
-    // 添加到列表
-    for (int i = 0; i < count; i++) {
-        GtkTreeIter iter;
-        gtk_list_store_append(borrow_list_store, &iter);
-        
-        // 获取图书信息
-        Book book;
-        book_find_by_id(records[i].book_id, &book);
-        
-        // 获取读者信息
-        Reader reader;
-        reader_find_by_id(records[i].reader_id, &reader);
-        
-        // 转换时间戳为字符串
-        char borrow_date[64] = {0};
-        char due_date[64] = {0};
-        char return_date[64] = {0};
-        
-        time_to_string(records[i].borrow_date, borrow_date, sizeof(borrow_date), "%Y-%m-%d");
-        time_to_string(records[i].due_date, due_date, sizeof(due_date), "%Y-%m-%d");
-        
-        if (records[i].status == BORROW_STATUS_RETURNED) {
-            time_to_string(records[i].return_date, return_date, sizeof(return_date), "%Y-%m-%d");
-        } else {
-            strcpy(return_date, "未归还");
-        }
-        
-        // 状态文本
-        const char *status_text = "";
-        switch (records[i].status) {
-            case BORROW_STATUS_BORROWED:
-                status_text = "借出";
-                break;
-            case BORROW_STATUS_RETURNED:
-                status_text = "已归还";
-                break;
-            case BORROW_STATUS_OVERDUE:
-                status_text = "逾期";
-                break;
-            case BORROW_STATUS_RENEWED:
-                status_text = "已续借";
-                break;
-            default:
-                status_text = "未知";
-                break;
-        }
-        
-        gtk_list_store_set(borrow_list_store, &iter,
-                          0, records[i].id,
-                          1, book.title,
-                          2, reader.name,
-                          3, borrow_date,
-                          4, due_date,
-                          5, return_date,
-                          6, status_text,
-                          -1);
-    }
-    
-    // 不需要释放内存，因为records是栈上分配的数组
+    // 逐条加入列表（借阅记录可能很多，不再复制到临时数组）
+    borrow_foreach(NULL, 0, 0, ui_append_borrow_row, borrow_list_store);
 }
\ No newline at end of file
@@ -0,0 +1,530 @@
+/**
+ * @file utf8.c
+ * @brief UTF-8解码与大小写折叠相关函数的实现
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // memmem
+#endif
+
+#include "utf8.h"
+#include <string.h>
+
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define HAVE_UTF8_SSE2 1
+#endif
+
+#define UTF8_INVALID_BASE 0x110000 // 非法字节映射到的码点起点
+
+/**
+ * @brief 大小写折叠区间：[first, last]中与first相差stride整数倍的码点加上delta
+ */
+typedef struct {
+    uint32_t first;   /**< 区间起点 */
+    uint32_t last;    /**< 区间终点（含） */
+    int32_t delta;    /**< 折叠时加上的偏移 */
+    uint32_t stride;  /**< 步长（1或2），1表示整个区间，2表示大小写交替排列 */
+} Utf8FoldRange;
+
+static const Utf8FoldRange fold_ranges[] = {
+    {0x0041, 0x005A, 32, 1},      // A-Z
+    {0x00B5, 0x00B5, 775, 1},     // µ -> μ
+    {0x00C0, 0x00D6, 32, 1},      // À-Ö
+    {0x00D8, 0x00DE, 32, 1},      // Ø-Þ
+    {0x0100, 0x012E, 1, 2},       // Ā-Į
+    {0x0132, 0x0136, 1, 2},       // Ĳ-Ķ
+    {0x0139, 0x0147, 1, 2},       // Ĺ-Ň
+    {0x014A, 0x0176, 1, 2},       // Ŋ-Ŷ
+    {0x0178, 0x0178, -121, 1},    // Ÿ -> ÿ
+    {0x0179, 0x017D, 1, 2},       // Ź-Ž
+    {0x017F, 0x017F, -268, 1},    // ſ -> s
+    {0x0386, 0x0386, 38, 1},      // Ά
+    {0x0388, 0x038A, 37, 1},      // Έ-Ί
+    {0x038C, 0x038C, 64, 1},      // Ό
+    {0x038E, 0x038F, 63, 1},      // Ύ-Ώ
+    {0x0391, 0x03A1, 32, 1},      // Α-Ρ
+    {0x03A3, 0x03AB, 32, 1},      // Σ-Ϋ
+    {0x03C2, 0x03C2, 1, 1},       // ς -> σ
+    {0x0400, 0x040F, 80, 1},      // Ѐ-Џ
+    {0x0410, 0x042F, 32, 1},      // А-Я
+    {0x0460, 0x0480, 1, 2},       // Ѡ-Ҁ
+    {0x048A, 0x04BE, 1, 2},       // Ҋ-Ҿ
+    {0x212A, 0x212A, -8383, 1},   // 开尔文符号 -> k
+    {0x212B, 0x212B, -8262, 1},   // 埃符号 -> å
+    {0xFF21, 0xFF3A, 32, 1}       // 全角Ａ-Ｚ
+};
+
+#define FOLD_RANGE_COUNT (int)(sizeof(fold_ranges) / sizeof(fold_ranges[0]))
+
+/**
+ * @brief 读取一个UTF-8字符
+ * @param p 读取位置，读取后前移
+ * @return 字符的码点，非法字节返回0x110000加字节值，到达字符串结尾返回0
+ */
+uint32_t utf8_next_char(const char **p) {
+    const unsigned char *s = (const unsigned char *)*p;
+    uint32_t c = s[0];
+    
+    if (c < 0x80) {
+        if (c != 0) {
+            *p += 1;
+        }
+        return c;
+    }
+    
+    int len = (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 0;
+    uint32_t cp = len == 2 ? (c & 0x1F) : len == 3 ? (c & 0x0F) : (c & 0x07);
+    
+    for (int i = 1; i < len; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            len = 0;
+            break;
+        }
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    
+    if (len == 0) {
+        *p += 1;
+        return UTF8_INVALID_BASE + c;
+    }
+    
+    *p += len;
+    return cp;
+}
+
+/**
+ * @brief 对码点做大小写折叠
+ * @param c 码点
+ * @return 折叠后的码点
+ */
+uint32_t utf8_fold(uint32_t c) {
+    if (c < 0x80) {
+        return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+    
+    // 汉字、假名等常见字符都落在这两个区间之外，直接返回
+    if (c < 0xB5 || (c > 0x212B && c < 0xFF21) || c > 0xFF3A) {
+        return c;
+    }
+    
+    for (int i = 0; i < FOLD_RANGE_COUNT; i++) {
+        const Utf8FoldRange *range = &fold_ranges[i];
+        if (c < range->first) {
+            break;
+        }
+        if (c <= range->last && ((c - range->first) & (range->stride - 1)) == 0) {
+            return (uint32_t)((int32_t)c + range->delta);
+        }
+    }
+    
+    return c;
+}
+
+/**
+ * @brief 将字符串整体做大小写折叠（超长时在字符边界截断）
+ * @param src 源字符串
+ * @param dst 目标缓冲区
+ * @param size 缓冲区大小
+ * @return 写入的字节数（不含'\0'）
+ */
+size_t utf8_fold_string(const char *src, char *dst, size_t size) {
+    if (dst == NULL || size == 0) {
+        return 0;
+    }
+    
+    size_t len = 0;
+    
+    if (src != NULL) {
+        uint32_t c;
+        while ((c = utf8_next_char(&src)) != 0) {
+            unsigned char bytes[4];
+            int n = 0;
+            
+            // 非法字节原样保留，折叠不会改变它们
+            c = utf8_fold(c);
+            if (c >= UTF8_INVALID_BASE) {
+                bytes[n++] = (unsigned char)(c - UTF8_INVALID_BASE);
+            } else if (c < 0x80) {
+                bytes[n++] = (unsigned char)c;
+            } else if (c < 0x800) {
+                bytes[n++] = (unsigned char)(0xC0 | (c >> 6));
+                bytes[n++] = (unsigned char)(0x80 | (c & 0x3F));
+            } else if (c < 0x10000) {
+                bytes[n++] = (unsigned char)(0xE0 | (c >> 12));
+                bytes[n++] = (unsigned char)(0x80 | ((c >> 6) & 0x3F));
+                bytes[n++] = (unsigned char)(0x80 | (c & 0x3F));
+            } else {
+                bytes[n++] = (unsigned char)(0xF0 | (c >> 18));
+                bytes[n++] = (unsigned char)(0x80 | ((c >> 12) & 0x3F));
+                bytes[n++] = (unsigned char)(0x80 | ((c >> 6) & 0x3F));
+                bytes[n++] = (unsigned char)(0x80 | (c & 0x3F));
+            }
+            
+            if (len + n >= size) {
+                break;
+            }
+            memcpy(dst + len, bytes, n);
+            len += n;
+        }
+    }
+    
+    dst[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief 判断码点是否属于词（字母、数字、汉字等），空白、标点、符号和非法字节都不属于
+ * @param c 码点
+ * @return 属于返回1，否则返回0
+ */
+int utf8_is_word_char(uint32_t c) {
+    if (c < 0x80) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+    
+    // 非法字节、Latin-1符号、通用标点和各类符号、CJK标点、全角标点
+    if (c >= UTF8_INVALID_BASE || c < 0xC0 || c == 0xD7 || c == 0xF7) {
+        return 0;
+    }
+    if ((c >= 0x2000 && c <= 0x2BFF) || (c >= 0x3000 && c <= 0x303F) || (c >= 0xFE30 && c <= 0xFE4F)) {
+        return 0;
+    }
+    if ((c >= 0xFF00 && c <= 0xFF0F) || (c >= 0xFF1A && c <= 0xFF20) ||
+        (c >= 0xFF3B && c <= 0xFF40) || (c >= 0xFF5B && c <= 0xFF65)) {
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief 判断码点是否是中日韩文字（汉字、假名、谚文），这类文字的词之间没有空格
+ * @param c 码点
+ * @return 是返回1，否则返回0
+ */
+int utf8_is_cjk(uint32_t c) {
+    return (c >= 0x3040 && c <= 0x30FF) ||     // 平假名、片假名
+           (c >= 0x3400 && c <= 0x4DBF) ||     // 汉字扩展A
+           (c >= 0x4E00 && c <= 0x9FFF) ||     // 基本汉字
+           (c >= 0xAC00 && c <= 0xD7AF) ||     // 谚文音节
+           (c >= 0xF900 && c <= 0xFAFF) ||     // 兼容汉字
+           (c >= 0x20000 && c <= 0x3134F);     // 汉字扩展B及以后
+}
+
+/**
+ * @brief 判断码点是否落在有大小写字符的区间内（快速排除汉字等字符）
+ * @param c 码点
+ * @return 可能有大小写返回1，否则返回0
+ */
+static int utf8_in_case_band(uint32_t c) {
+    if (c < 0x80) {
+        return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+    }
+    
+    return (c >= 0xB5 && c <= 0x212B) || (c >= 0xFF21 && c <= 0xFF5A);
+}
+
+/**
+ * @brief 求码点UTF-8编码的首字节
+ * @param c 码点（可以是非法字节映射出的码点）
+ * @return 首字节
+ */
+static unsigned char utf8_lead_byte(uint32_t c) {
+    if (c < 0x80) {
+        return (unsigned char)c;
+    }
+    if (c < 0x800) {
+        return (unsigned char)(0xC0 | (c >> 6));
+    }
+    if (c < 0x10000) {
+        return (unsigned char)(0xE0 | (c >> 12));
+    }
+    if (c < UTF8_INVALID_BASE) {
+        return (unsigned char)(0xF0 | (c >> 18));
+    }
+    return (unsigned char)(c - UTF8_INVALID_BASE);
+}
+
+/**
+ * @brief 求所有折叠后等于folded的字符的UTF-8首字节
+ * @param folded 折叠后的码点
+ * @param leads 用于存储首字节（不重复），至少UTF8_MAX_VARIANTS个元素
+ * @param single_byte 用于返回这些字符是否都是单字节的ASCII字符，可以为NULL
+ * @return 首字节个数
+ */
+static int utf8_variant_leads(uint32_t folded, unsigned char *leads, int *single_byte) {
+    int count = 0;
+    leads[count++] = utf8_lead_byte(folded);
+    
+    if (single_byte != NULL) {
+        *single_byte = folded < 0x80;
+    }
+    
+    if (!utf8_in_case_band(folded)) {
+        return count;
+    }
+    
+    for (int i = 0; i < FOLD_RANGE_COUNT && count < UTF8_MAX_VARIANTS; i++) {
+        const Utf8FoldRange *range = &fold_ranges[i];
+        uint32_t c = (uint32_t)((int32_t)folded - range->delta);
+        if (c < range->first || c > range->last || ((c - range->first) & (range->stride - 1)) != 0) {
+            continue;
+        }
+        
+        if (single_byte != NULL && c >= 0x80) {
+            *single_byte = 0;
+        }
+        
+        unsigned char lead = utf8_lead_byte(c);
+        if (memchr(leads, lead, count) == NULL) {
+            leads[count++] = lead;
+        }
+    }
+    
+    return count;
+}
+
+/**
+ * @brief 判断字符是否有大小写之分（折叠后不是自身，或有其他字符折叠到它）
+ * @param c 码点
+ * @return 有返回1，没有返回0
+ */
+static int utf8_has_case(uint32_t c) {
+    if (!utf8_in_case_band(c)) {
+        return 0;
+    }
+    
+    if (utf8_fold(c) != c) {
+        return 1;
+    }
+    
+    for (int i = 0; i < FOLD_RANGE_COUNT; i++) {
+        const Utf8FoldRange *range = &fold_ranges[i];
+        uint32_t x = (uint32_t)((int32_t)c - range->delta);
+        if (x >= range->first && x <= range->last && ((x - range->first) & (range->stride - 1)) == 0) {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 在[p, end)中查找候选位置：该字节属于leads，且（next_count大于0时）下一个字节属于next_leads
+ * @param p 起始位置
+ * @param end 结束位置
+ * @param leads 第一个字节的取值
+ * @param count leads的个数（1到4）
+ * @param next_leads 第二个字节的取值
+ * @param next_count next_leads的个数（0到4，0表示不检查第二个字节）
+ * @return 找到返回位置，否则返回end
+ */
+static const char *utf8_find_candidate(const char *p, const char *end,
+                                       const unsigned char *leads, int count,
+                                       const unsigned char *next_leads, int next_count) {
+    if (count == 1 && next_count == 0) {
+        const char *found = (const char *)memchr(p, leads[0], end - p);
+        return found != NULL ? found : end;
+    }
+    
+#ifdef HAVE_UTF8_SSE2
+    // 不足4个取值时用第一个补齐，每次比较16个位置
+    __m128i l0 = _mm_set1_epi8((char)leads[0]);
+    __m128i l1 = _mm_set1_epi8((char)leads[count > 1 ? 1 : 0]);
+    __m128i l2 = _mm_set1_epi8((char)leads[count > 2 ? 2 : 0]);
+    __m128i l3 = _mm_set1_epi8((char)leads[count > 3 ? 3 : 0]);
+    
+    if (next_count > 0) {
+        __m128i n0 = _mm_set1_epi8((char)next_leads[0]);
+        __m128i n1 = _mm_set1_epi8((char)next_leads[next_count > 1 ? 1 : 0]);
+        __m128i n2 = _mm_set1_epi8((char)next_leads[next_count > 2 ? 2 : 0]);
+        __m128i n3 = _mm_set1_epi8((char)next_leads[next_count > 3 ? 3 : 0]);
+        
+        while (end - p >= 17) {
+            __m128i v = _mm_loadu_si128((const __m128i *)p);
+            __m128i w = _mm_loadu_si128((const __m128i *)(p + 1));
+            __m128i first = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, l0), _mm_cmpeq_epi8(v, l1)),
+                                         _mm_or_si128(_mm_cmpeq_epi8(v, l2), _mm_cmpeq_epi8(v, l3)));
+            __m128i second = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(w, n0), _mm_cmpeq_epi8(w, n1)),
+                                          _mm_or_si128(_mm_cmpeq_epi8(w, n2), _mm_cmpeq_epi8(w, n3)));
+            int mask = _mm_movemask_epi8(_mm_and_si128(first, second));
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 16;
+        }
+    } else {
+        while (end - p >= 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)p);
+            __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, l0), _mm_cmpeq_epi8(v, l1)),
+                                       _mm_or_si128(_mm_cmpeq_epi8(v, l2), _mm_cmpeq_epi8(v, l3)));
+            int mask = _mm_movemask_epi8(hit);
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 16;
+        }
+    }
+#endif
+    
+    for (; p < end; p++) {
+        if (memchr(leads, (unsigned char)p[0], count) == NULL) {
+            continue;
+        }
+        if (next_count == 0 || (p + 1 < end && memchr(next_leads, (unsigned char)p[1], next_count) != NULL)) {
+            return p;
+        }
+    }
+    
+    return end;
+}
+
+/**
+ * @brief 判断位置是否是一个字符的开头（而不是合法多字节字符的后续字节）
+ * @param str 字符串开头
+ * @param p 位置
+ * @return 是返回1，否则返回0
+ */
+static int utf8_is_char_start(const char *str, const char *p) {
+    if (((unsigned char)*p & 0xC0) != 0x80) {
+        return 1;
+    }
+    
+    // 向前找最近的首字节，看它开始的合法序列是否覆盖当前位置
+    for (int back = 1; back <= 3 && p - back >= str; back++) {
+        const char *q = p - back;
+        if (((unsigned char)*q & 0xC0) == 0x80) {
+            continue;
+        }
+        
+        const char *next = q;
+        utf8_next_char(&next);
+        return next <= p;
+    }
+    
+    return 1;
+}
+
+/**
+ * @brief 检查字符串在给定位置是否以子串开头（折叠后比较）
+ * @param s 字符串中的位置
+ * @param pattern 子串
+ * @return 是返回1，否则返回0
+ */
+static int utf8_match_at(const char *s, const char *pattern) {
+    for (;;) {
+        unsigned char pc = (unsigned char)*pattern;
+        unsigned char sc = (unsigned char)*s;
+        
+        if (pc == 0) {
+            return 1;
+        }
+        
+        // 两边都是ASCII字符时直接按字节比较，省去解码
+        if (pc < 0x80 && sc < 0x80) {
+            if (utf8_fold(pc) != utf8_fold(sc)) {
+                return 0;
+            }
+            pattern++;
+            s++;
+            continue;
+        }
+        
+        uint32_t expected = utf8_fold(utf8_next_char(&pattern));
+        if (utf8_fold(utf8_next_char(&s)) != expected) {
+            return 0;
+        }
+    }
+}
+
+/**
+ * @brief 预处理子串，供多次匹配使用
+ * @param matcher 匹配器
+ * @param pattern 子串（匹配器使用期间必须保持有效）
+ */
+void utf8_matcher_init(Utf8Matcher *matcher, const char *pattern) {
+    memset(matcher, 0, sizeof(Utf8Matcher));
+    matcher->pattern = pattern != NULL ? pattern : "";
+    
+    // 子串开头没有大小写之分的部分（如汉字）只能按原样出现，可以直接按字节查找
+    const char *prefix_end = matcher->pattern;
+    for (;;) {
+        const char *next = prefix_end;
+        uint32_t c = utf8_next_char(&next);
+        if (c == 0 || utf8_has_case(c)) {
+            break;
+        }
+        prefix_end = next;
+    }
+    
+    matcher->prefix_len = (size_t)(prefix_end - matcher->pattern);
+    if (matcher->prefix_len > 0 || *matcher->pattern == '\0') {
+        return;
+    }
+    
+    // 否则按第一个字符（任一大小写形式）的首字节筛选候选位置；
+    // 第一个字符的各种形式都是ASCII时，第二个字符的首字节紧随其后，可以一起筛选
+    const char *rest = matcher->pattern;
+    int single_byte = 0;
+    matcher->lead_count = utf8_variant_leads(utf8_fold(utf8_next_char(&rest)), matcher->leads, &single_byte);
+    
+    if (single_byte && *rest != '\0') {
+        matcher->next_count = utf8_variant_leads(utf8_fold(utf8_next_char(&rest)), matcher->next_leads, NULL);
+    }
+}
+
+/**
+ * @brief 检查字符串是否包含匹配器的子串（按UTF-8字符做大小写折叠后比较，不分配内存）
+ * @param matcher 匹配器
+ * @param str 要检查的字符串
+ * @return 包含返回1，不包含返回0
+ */
+int utf8_matcher_match(const Utf8Matcher *matcher, const char *str) {
+    if (str == NULL) {
+        return 0;
+    }
+    
+    if (*matcher->pattern == '\0') {
+        return 1;
+    }
+    
+    const char *p = str;
+    const char *end = str + strlen(str);
+    
+    if (matcher->prefix_len > 0) {
+        while ((p = (const char *)memmem(p, end - p, matcher->pattern, matcher->prefix_len)) != NULL) {
+            if (utf8_is_char_start(str, p) && utf8_match_at(p, matcher->pattern)) {
+                return 1;
+            }
+            p++;
+        }
+        return 0;
+    }
+    
+    // 第一个字符有大小写之分，必然是合法字符，候选位置一定是字符开头
+    while ((p = utf8_find_candidate(p, end, matcher->leads, matcher->lead_count,
+                                    matcher->next_leads, matcher->next_count)) < end) {
+        if (utf8_match_at(p, matcher->pattern)) {
+            return 1;
+        }
+        p++;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 检查字符串是否包含子串（按UTF-8字符做大小写折叠后比较，不分配内存）
+ * @param str 要检查的字符串
+ * @param pattern 子串
+ * @return 包含返回1，不包含返回0
+ */
+int utf8_contains_fold(const char *str, const char *pattern) {
+    if (str == NULL || pattern == NULL) {
+        return 0;
+    }
+    
+    Utf8Matcher matcher;
+    utf8_matcher_init(&matcher, pattern);
+    return utf8_matcher_match(&matcher, str);
+}
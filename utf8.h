@@ -0,0 +1,94 @@
+/**
+ * @file utf8.h
+ * @brief UTF-8解码与大小写折叠相关函数的声明
+ *
+ * 大小写折叠采用Unicode简单折叠规则中常用的部分：ASCII、Latin-1、拉丁文扩展A、
+ * 希腊字母、西里尔字母和全角拉丁字母。汉字等没有大小写的字符保持不变。
+ * 非法的UTF-8字节按单个字符处理，映射到码点范围之外（0x110000加字节值），
+ * 不会与合法字符混淆。
+ */
+
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define UTF8_MAX_VARIANTS 4 // 折叠到同一码点的字符最多个数
+
+/**
+ * @brief 预处理过的子串匹配器，同一子串匹配多个字符串时只需初始化一次
+ */
+typedef struct {
+    const char *pattern;                          /**< 子串 */
+    size_t prefix_len;                            /**< 开头没有大小写之分的部分的字节数 */
+    unsigned char leads[UTF8_MAX_VARIANTS];       /**< 第一个字符各种形式的首字节 */
+    int lead_count;                               /**< leads的个数 */
+    unsigned char next_leads[UTF8_MAX_VARIANTS];  /**< 第二个字符各种形式的首字节 */
+    int next_count;                               /**< next_leads的个数，0表示不使用 */
+} Utf8Matcher;
+
+/**
+ * @brief 读取一个UTF-8字符
+ * @param p 读取位置，读取后前移
+ * @return 字符的码点，非法字节返回0x110000加字节值，到达字符串结尾返回0
+ */
+uint32_t utf8_next_char(const char **p);
+
+/**
+ * @brief 对码点做大小写折叠
+ * @param c 码点
+ * @return 折叠后的码点
+ */
+uint32_t utf8_fold(uint32_t c);
+
+/**
+ * @brief 将字符串整体做大小写折叠（超长时在字符边界截断）
+ *
+ * 本规则下折叠后的字节数不会超过原字符串。
+ *
+ * @param src 源字符串
+ * @param dst 目标缓冲区
+ * @param size 缓冲区大小
+ * @return 写入的字节数（不含'\0'）
+ */
+size_t utf8_fold_string(const char *src, char *dst, size_t size);
+
+/**
+ * @brief 判断码点是否属于词（字母、数字、汉字等），空白、标点、符号和非法字节都不属于
+ * @param c 码点
+ * @return 属于返回1，否则返回0
+ */
+int utf8_is_word_char(uint32_t c);
+
+/**
+ * @brief 判断码点是否是中日韩文字（汉字、假名、谚文），这类文字的词之间没有空格
+ * @param c 码点
+ * @return 是返回1，否则返回0
+ */
+int utf8_is_cjk(uint32_t c);
+
+/**
+ * @brief 预处理子串，供多次匹配使用
+ * @param matcher 匹配器
+ * @param pattern 子串（匹配器使用期间必须保持有效）
+ */
+void utf8_matcher_init(Utf8Matcher *matcher, const char *pattern);
+
+/**
+ * @brief 检查字符串是否包含匹配器的子串（按UTF-8字符做大小写折叠后比较，不分配内存）
+ * @param matcher 匹配器
+ * @param str 要检查的字符串
+ * @return 包含返回1，不包含返回0
+ */
+int utf8_matcher_match(const Utf8Matcher *matcher, const char *str);
+
+/**
+ * @brief 检查字符串是否包含子串（按UTF-8字符做大小写折叠后比较，不分配内存）
+ * @param str 要检查的字符串
+ * @param pattern 子串
+ * @return 包含返回1，不包含返回0
+ */
+int utf8_contains_fold(const char *str, const char *pattern);
+
+#endif /* UTF8_H */
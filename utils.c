@@ -4,6 +4,7 @@
  */
 
 #include "utils.h"
+#include "utf8.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,7 +13,13 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define HAVE_HW_CRC32C 1
+#endif
+
 #ifdef _WIN32
+#include <windows.h>
 #include <direct.h>
 #define MKDIR(dir) _mkdir(dir)
 #else
@@ -197,158 +204,128 @@ void trim(char *str) {
  * @return 包含返回1，不包含返回0
  */
 int contains_ignore_case(const char *str, const char *substr) {
-    if (str == NULL || substr == NULL) {
-        return 0;
-    }
+    return utf8_contains_fold(str, substr);
+}
+
+/**
+ * @brief 计算CRC32校验和
+ * @param crc 之前数据的校验和，首次计算传0
+ * @param data 数据
+ * @param len 数据长度
+ * @return 累计的校验和
+ */
+uint32_t crc32_compute(uint32_t crc, const void *data, size_t len) {
+    // 按半字节查表（多项式0xEDB88320），表很小，不需要运行时初始化
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
     
-    // 转换为小写进行比较
-    char *str_lower = strdup(str);
-    char *substr_lower = strdup(substr);
+    const unsigned char *p = (const unsigned char *)data;
+    crc = ~crc;
     
-    if (str_lower == NULL || substr_lower == NULL) {
-        if (str_lower) free(str_lower);
-        if (substr_lower) free(substr_lower);
-        return 0;
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc >> 4) ^ table[(crc ^ p[i]) & 0x0F];
+        crc = (crc >> 4) ^ table[(crc ^ (p[i] >> 4)) & 0x0F];
     }
     
-    to_lower_case(str_lower);
-    to_lower_case(substr_lower);
-    
-    int result = strstr(str_lower, substr_lower) != NULL;
-    
-    free(str_lower);
-    free(substr_lower);
-    
-    return result;
+    return ~crc;
 }
 
+#ifdef HAVE_HW_CRC32C
 /**
- * @brief 将CSV行解析为字段数组
- * @param line CSV行
- * @param fields 用于存储字段的数组
- * @param max_fields 最大字段数
- * @return 解析出的字段数
+ * @brief 使用SSE4.2指令计算CRC32C（输入输出均为取反后的中间值）
+ * @param crc 中间值
+ * @param p 数据
+ * @param len 数据长度
+ * @return 中间值
  */
-int parse_csv_line(const char *line, char **fields, int max_fields) {
-    if (line == NULL || fields == NULL || max_fields <= 0) {
-        return 0;
-    }
-    
-    int field_count = 0;
-    const char *p = line;
-    const char *field_start = p;
-    int in_quotes = 0;
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hardware(uint32_t crc, const unsigned char *p, size_t len) {
+    uint64_t crc64 = crc;
     
-    // 为每个字段分配内存
-    for (int i = 0; i < max_fields; i++) {
-        fields[i] = (char *)malloc(strlen(line) + 1);
-        if (fields[i] == NULL) {
-            // 释放已分配的内存
-            for (int j = 0; j < i; j++) {
-                free(fields[j]);
-                fields[j] = NULL;
-            }
-            return 0;
-        }
-        fields[i][0] = '\0';
+    while (len >= 8) {
+        uint64_t value;
+        memcpy(&value, p, sizeof(value));
+        crc64 = _mm_crc32_u64(crc64, value);
+        p += 8;
+        len -= 8;
     }
     
-    while (*p && field_count < max_fields) {
-        if (*p == '"') {
-            // 处理引号
-            in_quotes = !in_quotes;
-        } else if (*p == ',' && !in_quotes) {
-            // 字段结束
-            int len = p - field_start;
-            strncpy(fields[field_count], field_start, len);
-            fields[field_count][len] = '\0';
-            
-            // 去除引号
-            if (fields[field_count][0] == '"' && fields[field_count][len - 1] == '"') {
-                memmove(fields[field_count], fields[field_count] + 1, len - 2);
-                fields[field_count][len - 2] = '\0';
-            }
-            
-            field_count++;
-            field_start = p + 1;
-        }
-        
+    crc = (uint32_t)crc64;
+    while (len > 0) {
+        crc = _mm_crc32_u8(crc, *p);
         p++;
+        len--;
     }
     
-    // 处理最后一个字段
-    if (field_count < max_fields) {
-        int len = p - field_start;
-        strncpy(fields[field_count], field_start, len);
-        fields[field_count][len] = '\0';
-        
-        // 去除引号
-        if (fields[field_count][0] == '"' && fields[field_count][len - 1] == '"') {
-            memmove(fields[field_count], fields[field_count] + 1, len - 2);
-            fields[field_count][len - 2] = '\0';
-        }
-        
-        field_count++;
-    }
-    
-    return field_count;
+    return crc;
 }
+#endif
 
 /**
- * @brief 将字段数组转换为CSV行
- * @param fields 字段数组
- * @param num_fields 字段数
- * @param line 用于存储CSV行的字符串
- * @param size line的大小
+ * @brief 计算CRC32C（Castagnoli）校验和，支持SSE4.2的CPU上使用硬件指令
+ * @param crc 之前数据的校验和，首次计算传0
+ * @param data 数据
+ * @param len 数据长度
+ * @return 累计的校验和
  */
-void fields_to_csv_line(char **fields, int num_fields, char *line, size_t size) {
-    if (fields == NULL || line == NULL || size == 0 || num_fields <= 0) {
-        return;
-    }
+uint32_t crc32c_compute(uint32_t crc, const void *data, size_t len) {
+    // 按半字节查表（多项式0x82F63B78）
+    static const uint32_t table[16] = {
+        0x00000000, 0x105EC76F, 0x20BD8EDE, 0x30E349B1,
+        0x417B1DBC, 0x5125DAD3, 0x61C69362, 0x7198540D,
+        0x82F63B78, 0x92A8FC17, 0xA24BB5A6, 0xB21572C9,
+        0xC38D26C4, 0xD3D3E1AB, 0xE330A81A, 0xF36E6F75
+    };
     
-    line[0] = '\0';
-    size_t pos = 0;
+    const unsigned char *p = (const unsigned char *)data;
+    crc = ~crc;
     
-    for (int i = 0; i < num_fields; i++) {
-        // 检查字段是否需要引号（包含逗号、引号或空白字符）
-        int need_quotes = 0;
-        if (fields[i] != NULL) {
-            for (int j = 0; fields[i][j]; j++) {
-                if (fields[i][j] == ',' || fields[i][j] == '"' || isspace(fields[i][j])) {
-                    need_quotes = 1;
-                    break;
-                }
-            }
-        }
-        
-        // 添加字段
-        if (need_quotes) {
-            // 添加带引号的字段
-            int len = snprintf(line + pos, size - pos, "\"%s\"", fields[i] != NULL ? fields[i] : "");
-            if (len < 0 || (size_t)len >= size - pos) {
-                // 缓冲区不足
-                break;
-            }
-            pos += len;
-        } else {
-            // 添加不带引号的字段
-            int len = snprintf(line + pos, size - pos, "%s", fields[i] != NULL ? fields[i] : "");
-            if (len < 0 || (size_t)len >= size - pos) {
-                // 缓冲区不足
-                break;
-            }
-            pos += len;
-        }
-        
-        // 添加逗号（除了最后一个字段）
-        if (i < num_fields - 1) {
-            if (pos < size - 1) {
-                line[pos++] = ',';
-                line[pos] = '\0';
-            } else {
-                // 缓冲区不足
-                break;
-            }
-        }
+#ifdef HAVE_HW_CRC32C
+    if (__builtin_cpu_supports("sse4.2")) {
+        return ~crc32c_hardware(crc, p, len);
     }
+#endif
+    
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc >> 4) ^ table[(crc ^ p[i]) & 0x0F];
+        crc = (crc >> 4) ^ table[(crc ^ (p[i] >> 4)) & 0x0F];
+    }
+    
+    return ~crc;
+}
+
+/**
+ * @brief 获取单调递增的时钟读数，用于计算耗时
+ * @return 毫秒数（起点不固定，只能用于求差）
+ */
+double monotonic_ms() {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+#endif
+}
+
+/**
+ * @brief 获取可用的CPU核心数
+ * @return 核心数，无法获取时返回1
+ */
+int cpu_count() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
 }
\ No newline at end of file
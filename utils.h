@@ -10,6 +10,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <stdint.h>
 
 /**
  * @brief 生成唯一ID
@@ -77,7 +78,7 @@ void to_lower_case(char *str);
 void trim(char *str);
 
 /**
- * @brief 检查字符串是否包含子串（不区分大小写）
+ * @brief 检查字符串是否包含子串（不区分大小写，按UTF-8字符折叠，不分配内存）
  * @param str 要检查的字符串
  * @param substr 子串
  * @return 包含返回1，不包含返回0
@@ -85,21 +86,33 @@ void trim(char *str);
 int contains_ignore_case(const char *str, const char *substr);
 
 /**
- * @brief 将CSV行解析为字段数组
- * @param line CSV行
- * @param fields 用于存储字段的数组
- * @param max_fields 最大字段数
- * @return 解析出的字段数
+ * @brief 计算CRC32校验和
+ * @param crc 之前数据的校验和，首次计算传0
+ * @param data 数据
+ * @param len 数据长度
+ * @return 累计的校验和
  */
-int parse_csv_line(const char *line, char **fields, int max_fields);
+uint32_t crc32_compute(uint32_t crc, const void *data, size_t len);
 
 /**
- * @brief 将字段数组转换为CSV行
- * @param fields 字段数组
- * @param num_fields 字段数
- * @param line 用于存储CSV行的字符串
- * @param size line的大小
+ * @brief 计算CRC32C（Castagnoli）校验和，支持SSE4.2的CPU上使用硬件指令
+ * @param crc 之前数据的校验和，首次计算传0
+ * @param data 数据
+ * @param len 数据长度
+ * @return 累计的校验和
  */
-void fields_to_csv_line(char **fields, int num_fields, char *line, size_t size);
+uint32_t crc32c_compute(uint32_t crc, const void *data, size_t len);
+
+/**
+ * @brief 获取单调递增的时钟读数，用于计算耗时
+ * @return 毫秒数（起点不固定，只能用于求差）
+ */
+double monotonic_ms();
+
+/**
+ * @brief 获取可用的CPU核心数
+ * @return 核心数，无法获取时返回1
+ */
+int cpu_count();
 
 #endif /* UTILS_H */
\ No newline at end of file